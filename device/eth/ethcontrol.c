@@ -24,6 +24,7 @@ devcall ethcontrol(
 {
 	struct ethcblk *ethptr; /* Ethertab entry pointer	*/
 	int32 retval = OK;		/* Return value of cntl function*/
+	struct ethstats *stats; /* Counters for ETH_CTRL_STATS	*/
 
 	ethptr = &ethertab[devptr->dvminor];
 
@@ -37,6 +38,61 @@ devcall ethcontrol(
 			   ETH_ADDR_LEN);
 		break;
 
+		/* Send a batch of frames as one descriptor chain */
+
+	case ETH_CTRL_TXBATCH:
+		retval = ethwritev(ethptr, (struct ethframe *)arg1, arg2);
+		break;
+
+		/* Receive into buffers of a pool from now on */
+
+	case ETH_CTRL_RXPOOL:
+		/* The frame must start on a cache line and the buffers	*/
+		/*   must be whole lines long, so the DMA engine never	*/
+		/*   writes a line that also holds other data		*/
+
+		if ((arg1 < 0) || (arg1 >= nbpools) || (arg2 < 0) ||
+			(buftab[arg1].bpsize < arg2 + PACKLEN) ||
+			((sizeof(bpid32) + arg2) & (ARMV7A_DCACHE_LINE - 1)) ||
+			((sizeof(bpid32) + buftab[arg1].bpsize) &
+			 (ARMV7A_DCACHE_LINE - 1)))
+		{
+			return SYSERR;
+		}
+		ethptr->inOffset = arg2;
+		ethptr->inPool = arg1;
+		break;
+
+		/* Exchange an empty pool buffer for a received packet */
+
+	case ETH_CTRL_RXSWAP:
+		retval = ethrxswap(ethptr, (char **)arg1);
+		break;
+
+		/* Send one frame made of pieces */
+
+	case ETH_CTRL_TXSG:
+		retval = ethtxsg(ethptr, (struct ethframe *)arg1, arg2);
+		break;
+
+		/* Set the function that frees buffers sent in place */
+
+	case ETH_CTRL_TXFREE:
+		ethptr->txFree = (status (*)(char *))arg1;
+		break;
+
+		/* Get the counters of the device */
+
+	case ETH_CTRL_STATS:
+		stats = (struct ethstats *)arg1;
+		stats->es_rxirq = ethptr->rxIrq;
+		stats->es_rxpkts = ethptr->rxPkts;
+		stats->es_rxpolls = ethptr->rxPolls;
+		stats->es_rxyields = ethptr->rxYields;
+		stats->es_txirq = ethptr->txIrq;
+		stats->es_errors = ethptr->errors;
+		break;
+
 	default:
 		return SYSERR;
 	}
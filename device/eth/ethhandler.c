@@ -12,13 +12,15 @@ interrupt ethhandler (
 {
 	struct	eth_a_csreg *csrptr;		/* Ethernet CSR pointer	*/
 	struct	eth_a_tx_desc *tdescptr;	/* Tx desc pointer	*/
-	struct	eth_a_rx_desc *rdescptr;	/* Rx desc pointer	*/
 	struct	ethcblk *ethptr = &ethertab[0];	/* Ethernet ctl blk ptr	*/
+	uint16	eop;				/* End of packet flag	*/
 
 	csrptr = (struct eth_a_csreg *)ethptr->csr;
 
 	if(xnum == ETH_AM335X_TXINT) {	/* Transmit interrupt */
 
+		ethptr->txIrq++;
+
 		/* Get pointer to first desc in queue	*/
 
 		tdescptr = (struct eth_a_tx_desc *)ethptr->txRing +
@@ -28,7 +30,7 @@ interrupt ethhandler (
 
 		resched_cntl(DEFER_START);
 
-		while(semcount(ethptr->osem) < (int32)ethptr->txRingSize) {
+		while(ethptr->txPend > 0) {
 
 			/* If desc owned by DMA, check if we need to	*/
 			/* Restart the transmission			*/
@@ -41,24 +43,40 @@ interrupt ethhandler (
 				break;
 			}
 
-			/* Acknowledge the interrupt	*/
+			/* The frame has been sent; step through all of	*/
+			/* its descriptors, up to the end of packet	*/
+
+			do {
+				eop = tdescptr->stat & ETH_AM335X_TDS_EOP;
 
-			csrptr->stateram->tx_cp[0] = (uint32)tdescptr;
+				/* Free a buffer that was sent in place	*/
+
+				if(ethptr->txRel[ethptr->txHead] != NULL) {
+					(*ethptr->txFree)(
+					    ethptr->txRel[ethptr->txHead]);
+					ethptr->txRel[ethptr->txHead] = NULL;
+				}
 
-			/* Increment the head index of the queue	*/
-			/* And go to the next descriptor in queue	*/
+				/* Acknowledge the interrupt	*/
 
-			ethptr->txHead++;
-			tdescptr++;
-			if(ethptr->txHead >= ethptr->txRingSize) {
-				ethptr->txHead = 0;
-				tdescptr = (struct eth_a_tx_desc *)
+				csrptr->stateram->tx_cp[0] = (uint32)tdescptr;
+
+				/* Increment the head index of the queue */
+				/* And go to the next descriptor in queue */
+
+				ethptr->txPend--;
+				ethptr->txHead++;
+				tdescptr++;
+				if(ethptr->txHead >= ethptr->txRingSize) {
+					ethptr->txHead = 0;
+					tdescptr = (struct eth_a_tx_desc *)
 							ethptr->txRing;
-			}
+				}
 
-			/* Signal the output semaphore */
+				/* Signal the output semaphore */
 
-			signal(ethptr->osem);
+				signal(ethptr->osem);
+			} while(!eop && (ethptr->txPend > 0));
 		}
 
 		/* Acknowledge the transmit interrupt */
@@ -71,53 +89,18 @@ interrupt ethhandler (
 	}
 	else if(xnum == ETH_AM335X_RXINT) {	/* Receive interrupt */
 
-		/* Get the pointer to last desc in the queue	*/
-
-		rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing +
-							ethptr->rxTail;
+		ethptr->rxIrq++;
 
-		/* Defer scheduling until all descriptors are processed	*/
-
-		resched_cntl(DEFER_START);
+		/* Mask the receive interrupt and wake the receiving	*/
+		/* process, which polls the ring until it is empty and	*/
+		/* then unmasks the interrupt again (see ethrxnext)	*/
 
-		while(semcount(ethptr->isem) < (int32)ethptr->rxRingSize) {
-
-			/* Check if we need to restart the DMA	*/
-
-			if(rdescptr->stat & ETH_AM335X_RDS_OWN) {
-				if(csrptr->stateram->rx_hdp[0] == 0) {
-					csrptr->stateram->rx_hdp[0] =
-							(uint32)rdescptr;
-				}
-				break;
-			}
-
-			/* Acknowledge the interrupt	*/
-
-			csrptr->stateram->rx_cp[0] = (uint32)rdescptr;
-
-			/* Increment the tail index of the queue	*/
-			/* And go to the next descriptor in the queue	*/
-
-			ethptr->rxTail++;
-			rdescptr++;
-			if(ethptr->rxTail >= ethptr->rxRingSize) {
-				ethptr->rxTail = 0;
-				rdescptr = (struct eth_a_rx_desc *)
-							ethptr->rxRing;
-			}
-
-			/* Signal the input semaphore	*/
-
-			signal(ethptr->isem);
-		}
+		csrptr->cpdma->rx_intmask_clear = 0x1;
 
 		/* Acknowledge the receive interrupt */
 
 		csrptr->cpdma->eoi_vector = 0x1;
 
-		/* Resume rescheduling	*/
-
-		resched_cntl(DEFER_STOP);
+		signal(ethptr->isem);
 	}
 }
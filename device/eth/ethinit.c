@@ -177,9 +177,9 @@ int32	ethinit	(
 	struct	ethcblk *ethptr;		/* Ethernet control blk pointer	*/
 	struct	eth_a_tx_desc *tdescptr;/* Tx descriptor pointer	*/
 	struct	eth_a_rx_desc *rdescptr;/* Rx descriptor pointer	*/
-	struct	netpacket *pktptr;	/* Packet pointer		*/
 	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer		*/
 	uint32	phyreg;			/* Variable to store PHY reg val*/
+	uint32	pace;			/* Interrupt pacing control	*/
 	int32	retval;			/* Return value			*/
 	int32	i;			/* Index variable		*/
 
@@ -273,8 +273,9 @@ int32	ethinit	(
 	/* Initialize the rx ring size field */
 	ethptr->rxRingSize = ETH_AM335X_RX_RING_SIZE;
 
-	/* Allocate memory for the rx ring */
-	ethptr->rxRing = (void*)getmem(sizeof(struct eth_a_rx_desc)*
+	/* Allocate memory for the rx ring (uncached: the DMA engine	*/
+	/*   and the CPU update adjacent descriptors in one cache line)	*/
+	ethptr->rxRing = (void*)getdmamem(sizeof(struct eth_a_rx_desc)*
 					ethptr->rxRingSize);
 	if((int32)ethptr->rxRing == SYSERR) {
 		return SYSERR;
@@ -284,8 +285,9 @@ int32	ethinit	(
 	memset((char*)ethptr->rxRing, NULLCH,
 		sizeof(struct eth_a_rx_desc)*ethptr->rxRingSize);
 
-	/* Allocate memory for rx buffers */
-	ethptr->rxBufs = (void*)getmem(ETH_BUF_SIZE *
+	/* Allocate memory for rx buffers (uncached: the buffers	*/
+	/*   are ETH_BUF_SIZE apart, so adjacent ones share lines)	*/
+	ethptr->rxBufs = (void*)getdmamem(ETH_BUF_SIZE *
 					ethptr->rxRingSize);
 	if((int32)ethptr->rxBufs == SYSERR) {
 		return SYSERR;
@@ -298,21 +300,26 @@ int32	ethinit	(
 	/* Initialize the rx ring */
 
 	rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing;
-	pktptr = (struct netpacket *)ethptr->rxBufs;
 
 	for(i = 0; i < ethptr->rxRingSize; i++) {
 		rdescptr->next = rdescptr + 1;
-		rdescptr->buffer = (uint32)pktptr->net_ethdst;
+		rdescptr->buffer = (uint32)ethptr->rxBufs + i * ETH_BUF_SIZE;
 		rdescptr->buflen = ETH_BUF_SIZE;
 		rdescptr->bufoff = 0;
 		rdescptr->stat = ETH_AM335X_RDS_OWN;
 		rdescptr++;
-		pktptr++;
 	}
 	(--rdescptr)->next = NULL;
 
 	ethptr->rxHead = 0;
 	ethptr->rxTail = 0;
+	ethptr->inPool = -1;		/* Until ETH_CTRL_RXPOOL	*/
+	ethptr->inOffset = 0;
+	ethptr->rxIrq = 0;
+	ethptr->rxPkts = 0;
+	ethptr->rxPolls = 0;
+	ethptr->rxYields = 0;
+	ethptr->rxQuota = 0;
 	ethptr->isem = semcreate(0);
 	if((int32)ethptr->isem == SYSERR) {
 		return SYSERR;
@@ -321,8 +328,8 @@ int32	ethinit	(
 	/* initialize the tx ring size */
 	ethptr->txRingSize = ETH_AM335X_TX_RING_SIZE;
 
-	/* Allocate memory for tx ring */
-	ethptr->txRing = (void*)getmem(sizeof(struct eth_a_tx_desc)*
+	/* Allocate memory for tx ring (uncached, as for the rx ring) */
+	ethptr->txRing = (void*)getdmamem(sizeof(struct eth_a_tx_desc)*
 					ethptr->txRingSize);
 	if((int32)ethptr->txRing == SYSERR) {
 		return SYSERR;
@@ -339,18 +346,27 @@ int32	ethinit	(
 		return SYSERR;
 	}
 
-	/* Zero out the tx buffers */
+	/* Zero out the tx buffers and push them out of the cache */
 	memset((char*)ethptr->txBufs, NULLCH, ETH_BUF_SIZE *
 						ethptr->txRingSize);
+	cache_flush(ethptr->txBufs, ETH_BUF_SIZE * ethptr->txRingSize);
+
+	/* Allocate the table of buffers to free after transmission */
+	ethptr->txRel = (char **)getmem(sizeof(char *) *
+					ethptr->txRingSize);
+	if((int32)ethptr->txRel == SYSERR) {
+		return SYSERR;
+	}
+	memset((char *)ethptr->txRel, NULLCH,
+			sizeof(char *) * ethptr->txRingSize);
 
 	/* Initialize the tx ring */
 
 	tdescptr = (struct eth_a_tx_desc *)ethptr->txRing;
-	pktptr = (struct netpacket *)ethptr->txBufs;
 
 	for(i = 0; i < ethptr->txRingSize; i++) {
 		tdescptr->next = NULL;
-		tdescptr->buffer = (uint32)pktptr->net_ethdst;
+		tdescptr->buffer = (uint32)ethptr->txBufs + i * ETH_BUF_SIZE;
 		tdescptr->buflen = ETH_BUF_SIZE;
 		tdescptr->bufoff = 0;
 		tdescptr->stat = (ETH_AM335X_TDS_SOP |
@@ -358,13 +374,17 @@ int32	ethinit	(
 				  ETH_AM335X_TDS_DIR |
 				  ETH_AM335X_TDS_P1);
 		tdescptr++;
-		pktptr++;
 	}
 
 	ethptr->txHead = 0;
 	ethptr->txTail = 0;
+	ethptr->txPend = 0;
+	ethptr->txIrq = 0;
+	ethptr->txFree = NULL;		/* Until ETH_CTRL_TXFREE	*/
 	ethptr->osem = semcreate(ethptr->txRingSize);
-	if((int32)ethptr->osem == SYSERR) {
+	ethptr->omutex = semcreate(1);
+	if( ((int32)ethptr->osem == SYSERR) ||
+	    ((int32)ethptr->omutex == SYSERR) ) {
 		return SYSERR;
 	}
 
@@ -395,6 +415,19 @@ int32	ethinit	(
 	csrptr->cpdma->tx_intmask_set = 0x1;
 	csrptr->cpdma->rx_intmask_set = 0x1;
 
+	/* Pace the interrupts to at most ETH_AM335X_RX_IMAX Rx and	*/
+	/* ETH_AM335X_TX_IMAX Tx interrupts per millisecond		*/
+	pace = ETH_AM335X_WRINT_PRESCALE;
+	if(ETH_AM335X_RX_IMAX > 0) {
+		csrptr->wr->c0_rx_imax = ETH_AM335X_RX_IMAX;
+		pace |= ETH_AM335X_WRINT_C0RXPACE;
+	}
+	if(ETH_AM335X_TX_IMAX > 0) {
+		csrptr->wr->c0_tx_imax = ETH_AM335X_TX_IMAX;
+		pace |= ETH_AM335X_WRINT_C0TXPACE;
+	}
+	csrptr->wr->int_ctrl = pace;
+
 	/* Route the interrupts to core 0 */
 	csrptr->wr->c0_tx_en = 0x1;
 	csrptr->wr->c0_rx_en = 0x1;
@@ -1,4 +1,4 @@
-/* ethread.c - ethread */
+/* ethread.c - ethread, ethrxnext, ethrxarm */
 
 #include <xinu.h>
 
@@ -13,22 +13,14 @@ int32	ethread	(
 	)
 {
 	struct	ethcblk *ethptr;	/* Ethernet ctl blk ptr	*/
-	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer	*/
 	struct	eth_a_rx_desc *rdescptr;/* Rx Desc. pointer	*/
-	struct	eth_a_rx_desc *prev;	/* Prev Rx desc pointer	*/
 	uint32	retval;			/* Num of bytes returned*/
 
 	ethptr = &ethertab[devptr->dvminor];
 
-	/* Get the pointer to Ethernet CSR */
-	csrptr = (struct eth_a_csreg *)ethptr->csr;
-
-	/* Wait for a packet */
-	wait(ethptr->isem);
-
-	/* Get pointer to the descriptor */
+	/* Wait for a packet and get pointer to the descriptor */
 	rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing +
-						ethptr->rxHead;
+						ethrxnext(ethptr);
 
 	/* Read the packet length */
 	retval = rdescptr->packlen;
@@ -36,28 +28,14 @@ int32	ethread	(
 		retval = count;
 	}
 
-	/* Copy the packet into user provided buffer */
+	/* Discard stale cache lines, then copy the packet into	*/
+	/*   the user provided buffer				*/
+	cache_inval((char *)rdescptr->buffer, retval);
 	memcpy((char *)buf, (char *)rdescptr->buffer, retval);
 
-	/* Initialize the descriptor for next packet */
-	rdescptr->stat = ETH_AM335X_RDS_OWN;
-	rdescptr->bufoff = 0;
-	rdescptr->buflen = ETH_BUF_SIZE;
-	rdescptr->packlen = 0;
-	rdescptr->next = NULL;
-
-	/* Insert the descriptor into Rx queue */
-	prev = (struct eth_a_rx_desc *)csrptr->stateram->rx_hdp[0];
-	if(prev == NULL) {
-		kprintf("hdp 0, adding %x\n", rdescptr);
-		csrptr->stateram->rx_hdp[0] = (uint32)rdescptr;
-	}
-	else {
-		while(prev->next != NULL) {
-			prev = prev->next;
-		}
-		prev->next = rdescptr;
-	}
+	/* Initialize the descriptor for next packet and insert	*/
+	/*   it into Rx queue					*/
+	ethrxarm(ethptr, ethptr->rxHead, (char *)rdescptr->buffer);
 
 	/* Increment the head index of rx ring */
 	ethptr->rxHead++;
@@ -67,3 +45,125 @@ int32	ethread	(
 
 	return retval;
 }
+
+/*------------------------------------------------------------------------
+ * ethrxnext - wait for the next packet in the Rx ring and return the
+ *		index of its descriptor.  While packets keep arriving,
+ *		the receiving process polls the ring with the Rx
+ *		interrupt masked and sleeps for a tick after every
+ *		ETH_AM335X_RX_BUDGET packets; once the ring is empty it
+ *		unmasks the interrupt and sleeps
+ *------------------------------------------------------------------------
+ */
+uint32	ethrxnext (
+		struct	ethcblk	*ethptr		/* Ether entry pointer	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask	*/
+	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer	*/
+	struct	eth_a_rx_desc *rdescptr;/* Rx Desc. pointer	*/
+
+	/* Get the pointer to Ethernet CSR */
+	csrptr = (struct eth_a_csreg *)ethptr->csr;
+
+	while(1) {
+
+		/* Get pointer to the oldest descriptor not yet read */
+		rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing +
+							ethptr->rxHead;
+
+		if(!(rdescptr->stat & ETH_AM335X_RDS_OWN)) {
+
+			/* A packet is ready; if this polling round	*/
+			/* has used its budget, sleep for a tick before	*/
+			/* taking it.  yield() would only run processes	*/
+			/* of the reader's priority or higher, so the	*/
+			/* lower-priority processes that consume what	*/
+			/* it reads would starve under a flood; while	*/
+			/* it sleeps, the ring absorbs (or drops) what	*/
+			/* arrives					*/
+			if(ethptr->rxQuota >= ETH_AM335X_RX_BUDGET) {
+				ethptr->rxQuota = 0;
+				ethptr->rxYields++;
+				sleepms(1);
+			}
+			ethptr->rxQuota++;
+			ethptr->rxPkts++;
+
+			/* Acknowledge the descriptor */
+			csrptr->stateram->rx_cp[0] = (uint32)rdescptr;
+
+			return ethptr->rxHead;
+		}
+
+		/* The ring is empty: restart the DMA if it stopped at	*/
+		/* the end of the queue, then unmask the Rx interrupt	*/
+		/* and sleep until it fires				*/
+		mask = disable();
+		if(csrptr->stateram->rx_hdp[0] == 0) {
+			csrptr->stateram->rx_hdp[0] = (uint32)rdescptr;
+		}
+		ethptr->rxQuota = 0;
+		ethptr->rxPolls++;
+		csrptr->cpdma->rx_intmask_set = 0x1;
+		wait(ethptr->isem);
+		restore(mask);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * ethrxarm - give an Rx descriptor back to the DMA engine with a buffer
+ *		for the next packet
+ *------------------------------------------------------------------------
+ */
+void	ethrxarm (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		uint32	index,			/* Index of Rx desc.	*/
+		char	*buf			/* Buffer for the packet*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask	*/
+	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer	*/
+	struct	eth_a_rx_desc *rdescptr;/* Rx Desc. pointer	*/
+	struct	eth_a_rx_desc *prev;	/* Prev Rx desc pointer	*/
+
+	/* Get the pointer to Ethernet CSR */
+	csrptr = (struct eth_a_csreg *)ethptr->csr;
+
+	/* Descriptors are re-armed in ring order, so the end of the	*/
+	/* Rx queue is always the ring entry before this one, and	*/
+	/* there is no need to walk the queue from rx_hdp		*/
+	rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing + index;
+	if(index == 0) {
+		index = ethptr->rxRingSize;
+	}
+	prev = (struct eth_a_rx_desc *)ethptr->rxRing + index - 1;
+
+	/* Initialize the descriptor; the driver's own buffers	*/
+	/* hold ETH_BUF_SIZE bytes, pool buffers hold a netpacket	*/
+	rdescptr->next = NULL;
+	rdescptr->buffer = (uint32)buf;
+	if(((uint32)buf - (uint32)ethptr->rxBufs) <
+				ETH_BUF_SIZE * ethptr->rxRingSize) {
+		rdescptr->buflen = ETH_BUF_SIZE;
+	}
+	else {
+		rdescptr->buflen = PACKLEN;
+	}
+	rdescptr->bufoff = 0;
+	rdescptr->packlen = 0;
+	rdescptr->stat = ETH_AM335X_RDS_OWN;
+	dsb();
+
+	mask = disable();
+	prev->next = rdescptr;
+	dsb();
+
+	/* If the DMA engine stopped before it saw the link, restart	*/
+	/* the queue at this descriptor					*/
+	if( (csrptr->stateram->rx_hdp[0] == 0) &&
+	    (rdescptr->stat & ETH_AM335X_RDS_OWN) ) {
+		csrptr->stateram->rx_hdp[0] = (uint32)rdescptr;
+	}
+	restore(mask);
+}
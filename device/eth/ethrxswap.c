@@ -0,0 +1,98 @@
+/* ethrxswap.c - ethrxswap */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethrxswap - receive a packet on TI AM335X Ethernet without copying it:
+ *		the caller's empty buffer takes the place of the DMA
+ *		buffer that holds the packet, and the DMA buffer is
+ *		handed to the caller.  The buffers come from the pool
+ *		set with ETH_CTRL_RXPOOL; the driver's own buffers are
+ *		replaced by pool buffers as they are used the first time
+ *------------------------------------------------------------------------
+ */
+int32	ethrxswap (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		char	**bufp			/* Empty buffer on entry*/
+						/*   and packet on exit	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask	*/
+	struct	eth_a_rx_desc *rdescptr;/* Rx Desc. pointer	*/
+	uint32	index;			/* Index of Rx desc.	*/
+	char	*pkt;			/* Buffer of the packet	*/
+	char	*fresh;			/* Buffer for the desc.	*/
+	uint32	retval;			/* Num of bytes returned*/
+
+	if(ethptr->inPool < 0) {
+		return SYSERR;
+	}
+
+	while(1) {
+
+		/* Wait for a packet and get pointer to the descriptor */
+		index = ethrxnext(ethptr);
+		rdescptr = (struct eth_a_rx_desc *)ethptr->rxRing + index;
+		pkt = (char *)rdescptr->buffer;
+		retval = rdescptr->packlen;
+
+		/* Advance the head index of rx ring; the descriptor	*/
+		/* is given back below before the next wait		*/
+		ethptr->rxHead++;
+		if(ethptr->rxHead >= ethptr->rxRingSize) {
+			ethptr->rxHead = 0;
+		}
+
+		/* A packet too long for a pool buffer spans several	*/
+		/* descriptors; drop it and reuse the buffers		*/
+		if( (rdescptr->stat & (ETH_AM335X_RDS_SOP |
+				       ETH_AM335X_RDS_EOP)) !=
+		    (ETH_AM335X_RDS_SOP | ETH_AM335X_RDS_EOP) ) {
+			ethptr->errors++;
+			ethrxarm(ethptr, index, pkt);
+			continue;
+		}
+		if(retval > PACKLEN) {
+			retval = PACKLEN;
+		}
+
+		/* Discard stale cache lines before the CPU reads the	*/
+		/*   packet						*/
+		cache_inval(pkt, retval);
+
+		if(((uint32)pkt - (uint32)ethptr->rxBufs) <
+				ETH_BUF_SIZE * ethptr->rxRingSize) {
+
+			/* A buffer of the driver's own: copy the packet	*/
+			/* into the caller's buffer and retire it for a	*/
+			/* pool buffer, or keep it if the pool is empty;	*/
+			/* getbuf blocks on an empty pool, so look at the	*/
+			/* pool's count first, with interrupts off so no	*/
+			/* other process can take the last buffer between	*/
+			memcpy(*bufp, pkt, retval);
+			fresh = pkt;
+			mask = disable();
+			if(semcount(buftab[ethptr->inPool].bpsem) > 0) {
+				fresh = (char *)getbuf(ethptr->inPool) +
+							ethptr->inOffset;
+			}
+			restore(mask);
+		}
+		else {
+
+			/* A pool buffer: exchange it for the caller's	*/
+			fresh = *bufp;
+			*bufp = pkt;
+		}
+
+		/* Write back and drop the cache lines of the new	*/
+		/* buffer, so no dirty line can be evicted over the	*/
+		/* packet the DMA engine writes; the frame covers	*/
+		/* whole lines (see pktbuf.h), and it must not be	*/
+		/* touched until the buffer is handed up again		*/
+		cache_flush(fresh, PACKLEN);
+		ethrxarm(ethptr, index, fresh);
+
+		return retval;
+	}
+}
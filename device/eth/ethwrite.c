@@ -1,4 +1,4 @@
-/* ethwrite.c - ethwrite */
+/* ethwrite.c - ethwrite, ethtxsg, ethtxprep, ethtxlink */
 
 #include <xinu.h>
 
@@ -13,72 +13,222 @@ int32	ethwrite (
 	)
 {
 	struct	ethcblk *ethptr;	/* Ether entry pointer	*/
-	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer	*/
-	struct	eth_a_tx_desc *tdescptr;/* Tx Desc. pointer	*/
-	struct	eth_a_tx_desc *prev;	/* Prev. Desc. pointer	*/
+	struct	ethframe piece;		/* The packet as a piece*/
 
 	ethptr = &ethertab[devptr->dvminor];
 
-	/* Get the pointer to the Ethernet CSR */
-	csrptr = (struct eth_a_csreg *)ethptr->csr;
-
-	/* Wait for an empty slot in the queue */
-	wait(ethptr->osem);
-
-	/* Get the pointer to the next descriptor */
-	tdescptr = (struct eth_a_tx_desc *)ethptr->txRing +
-							ethptr->txTail;
-
 	/* Adjust count if greater than max. possible packet size */
 	if(count > PACKLEN) {
 		count = PACKLEN;
 	}
 
-	/* Initialize the descriptor */
-	tdescptr->next = NULL;
-	tdescptr->buflen = count;
-	tdescptr->bufoff = 0;
-	tdescptr->packlen = count;
-	tdescptr->stat = (ETH_AM335X_TDS_SOP |	/* Start of packet	*/
-			  ETH_AM335X_TDS_EOP |	/* End of packet	*/
-			  ETH_AM335X_TDS_OWN |	/* Own flag set for DMA	*/
-			  ETH_AM335X_TDS_DIR |	/* Directed packet	*/
-			  ETH_AM335X_TDS_P1);	/* Output port is port1	*/
-
-	/* Copy the packet into the Tx buffer */
-	memcpy((char *)tdescptr->buffer, buf, count);
-
-	/* TODO Figure out why we need this hack	*/
-	/* This ethernet device does not send packets smaller than 60	*/
-	/* bytes; So pad a small packet to make it 60 bytes long	*/
+	/* The caller may reuse buf at once, so send a copy */
+	piece.efbuf = (char *)buf;
+	piece.eflen = count;
+	piece.efrel = NULL;
+	if(ethtxsg(ethptr, &piece, 1) == SYSERR) {
+		return SYSERR;
+	}
 
-	if(count < 60) {
-		memset((char *)tdescptr->buffer+count, 0, 60-count);
-		tdescptr->buflen = 60;
-		tdescptr->packlen = 60;
+	return count;
+}
+
+/*------------------------------------------------------------------------
+ * ethtxsg - enqueue one frame, given as a list of pieces, for
+ *		transmission on TI AM335X Ethernet; see ethtxprep
+ *------------------------------------------------------------------------
+ */
+int32	ethtxsg (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		struct	ethframe *pieces,	/* Pieces of the frame	*/
+		int32	npieces			/* Number of pieces	*/
+	)
+{
+	uint32	index;			/* Index of first desc.	*/
+	int32	ndesc;			/* Descriptors used	*/
+	int32	count;			/* Length of the frame	*/
+
+	/* Allow one writer at a time */
+	wait(ethptr->omutex);
+	index = ethptr->txTail;
+	count = ethtxprep(ethptr, pieces, npieces, &ndesc);
+	if(count != SYSERR) {
+		ethtxlink(ethptr, index, ndesc);
 	}
+	signal(ethptr->omutex);
+
+	return count;
+}
 
-	/* Insert the descriptor into Tx queue */
+/*------------------------------------------------------------------------
+ * ethtxprep - set up the Tx descriptors of one frame, given as a list
+ *		of pieces, at the tail of the ring without handing them
+ *		to the DMA engine; every piece gets a descriptor of its
+ *		own.  A piece with efrel set is sent in place and efrel
+ *		is freed by the Tx interrupt once the frame is out;
+ *		other pieces are copied into the Tx buffer of their
+ *		descriptor.  The caller holds omutex.  Return the
+ *		length of the frame
+ *------------------------------------------------------------------------
+ */
+int32	ethtxprep (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		struct	ethframe *pieces,	/* Pieces of the frame	*/
+		int32	npieces,		/* Number of pieces	*/
+		int32	*ndescp			/* Descriptors used	*/
+	)
+{
+	struct	eth_a_tx_desc *tdescptr;/* Tx Desc. pointer	*/
+	struct	eth_a_tx_desc *sop;	/* First desc. of frame	*/
+	struct	eth_a_tx_desc *last;	/* Last desc. of frame	*/
+	char	*txbuf;			/* Tx buffer of a desc.	*/
+	uint32	index;			/* Index of a desc.	*/
+	uint32	count;			/* Length of the frame	*/
+	uint32	len;			/* Length of a piece	*/
+	uint32	pad;			/* Bytes of padding	*/
+	int32	ndesc;			/* Descriptors needed	*/
+	int32	i;			/* Index into pieces	*/
 
-	if(csrptr->stateram->tx_hdp[0] == 0) {
-		/* Tx queue is empty, this desc. will be the first */
-		csrptr->stateram->tx_hdp[0] = (uint32)tdescptr;
+	if((npieces <= 0) || (npieces > ETH_TX_MAXFRAG)) {
+		return SYSERR;
 	}
-	else {
-		/* Tx queue not empty, insert at end */
-		prev = (struct eth_a_tx_desc *)
-				csrptr->stateram->tx_hdp[0];
-		while(prev->next != NULL) {
-			prev = prev->next;
+	count = 0;
+	for(i = 0; i < npieces; i++) {
+		if( (pieces[i].eflen == 0) ||
+		    ((pieces[i].efrel != NULL) && (ethptr->txFree == NULL)) ) {
+			return SYSERR;
 		}
-		prev->next = tdescptr;
+		count += pieces[i].eflen;
+	}
+	if(count > ETH_MAX_PKT_LEN) {
+		return SYSERR;
 	}
 
-	/* Increment the tail index of the Tx ring */
-	ethptr->txTail++;
-	if(ethptr->txTail >= ethptr->txRingSize) {
-		ethptr->txTail = 0;
+	/* This ethernet device does not send packets smaller than 60	*/
+	/* bytes; pad a short frame in the Tx buffer of its last piece	*/
+	/* if that piece is copied, or else with one more descriptor	*/
+	pad = 0;
+	ndesc = npieces;
+	if(count < ETH_MIN_PKT_LEN) {
+		pad = ETH_MIN_PKT_LEN - count;
+		if(pieces[npieces-1].efrel != NULL) {
+			ndesc++;
+		}
+	}
+
+	/* Wait for an empty slot in the queue for every descriptor	*/
+	for(i = 0; i < ndesc; i++) {
+		wait(ethptr->osem);
 	}
 
+	/* Initialize the descriptors; neither the DMA engine nor the	*/
+	/* interrupt handler looks at them until the frame is queued	*/
+	index = ethptr->txTail;
+	sop = (struct eth_a_tx_desc *)ethptr->txRing + index;
+	last = NULL;
+	for(i = 0; i < ndesc; i++) {
+		tdescptr = (struct eth_a_tx_desc *)ethptr->txRing + index;
+		txbuf = (char *)ethptr->txBufs + index * ETH_BUF_SIZE;
+
+		if(i == npieces) {
+			/* Padding after a piece sent in place */
+			memset(txbuf, 0, pad);
+			len = pad;
+			ethptr->txRel[index] = NULL;
+		}
+		else if(pieces[i].efrel == NULL) {
+			/* Copy the piece into the Tx buffer */
+			len = pieces[i].eflen;
+			memcpy(txbuf, pieces[i].efbuf, len);
+			if((i == npieces-1) && (ndesc == npieces)) {
+				memset(txbuf+len, 0, pad);
+				len += pad;
+			}
+			ethptr->txRel[index] = NULL;
+		}
+		else {
+			/* Send the piece from the caller's buffer */
+			txbuf = pieces[i].efbuf;
+			len = pieces[i].eflen;
+			ethptr->txRel[index] = pieces[i].efrel;
+		}
+
+		/* Write the piece back to memory before the DMA reads it */
+		cache_clean(txbuf, len);
+
+		tdescptr->next = NULL;
+		tdescptr->buffer = (uint32)txbuf;
+		tdescptr->buflen = len;
+		tdescptr->bufoff = 0;
+		tdescptr->packlen = 0;
+		tdescptr->stat = 0;
+		if(last != NULL) {
+			last->next = tdescptr;
+		}
+		last = tdescptr;
+
+		index++;
+		if(index >= ethptr->txRingSize) {
+			index = 0;
+		}
+	}
+	last->stat = ETH_AM335X_TDS_EOP;	/* End of packet	*/
+	sop->packlen = count + pad;
+	sop->stat |= (ETH_AM335X_TDS_SOP |	/* Start of packet	*/
+		      ETH_AM335X_TDS_OWN |	/* Own flag set for DMA	*/
+		      ETH_AM335X_TDS_DIR |	/* Directed packet	*/
+		      ETH_AM335X_TDS_P1);	/* Output port is port1	*/
+
+	/* Increment the tail index of the Tx ring */
+	ethptr->txTail = index;
+	*ndescp = ndesc;
+
 	return count;
 }
+
+/*------------------------------------------------------------------------
+ * ethtxlink - hand a chain of descriptors set up by ethtxprep, from
+ *		ring index first to the tail of the ring, to the DMA
+ *		engine.  The caller holds omutex
+ *------------------------------------------------------------------------
+ */
+void	ethtxlink (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		uint32	first,			/* Index of first desc.	*/
+		int32	ndesc			/* Descriptors in chain	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask	*/
+	struct	eth_a_csreg *csrptr;	/* Ethernet CSR pointer	*/
+	struct	eth_a_tx_desc *sop;	/* First desc. of chain	*/
+	struct	eth_a_tx_desc *prev;	/* End of the Tx queue	*/
+
+	/* Get the pointer to the Ethernet CSR */
+	csrptr = (struct eth_a_csreg *)ethptr->csr;
+
+	sop = (struct eth_a_tx_desc *)ethptr->txRing + first;
+	dsb();
+
+	/* Frames are queued in ring order, so the end of the Tx queue	*/
+	/* is the descriptor before the chain in the ring; link the	*/
+	/* chain after it without walking the queue from tx_hdp		*/
+	if(first == 0) {
+		prev = sop + ethptr->txRingSize - 1;
+	}
+	else {
+		prev = sop - 1;
+	}
+
+	mask = disable();
+	prev->next = sop;
+	ethptr->txPend += ndesc;
+	dsb();
+
+	/* If the DMA engine stopped before it saw the link, restart	*/
+	/* the queue at this chain					*/
+	if( (csrptr->stateram->tx_hdp[0] == 0) &&
+	    (sop->stat & ETH_AM335X_TDS_OWN) ) {
+		csrptr->stateram->tx_hdp[0] = (uint32)sop;
+	}
+	restore(mask);
+}
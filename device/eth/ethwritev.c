@@ -0,0 +1,68 @@
+/* ethwritev.c - ethwritev */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethwritev - enqueue an array of frames for transmission on TI AM335X
+ *		Ethernet, linking their descriptors into one chain that
+ *		is added to the DMA queue at once; if the ring fills,
+ *		the part of the chain built so far goes first, since a
+ *		slot is freed only after a frame is sent.  Return the
+ *		number of frames enqueued (a frame with efrel set that
+ *		is not enqueued still belongs to the caller)
+ *------------------------------------------------------------------------
+ */
+int32	ethwritev (
+		struct	ethcblk	*ethptr,	/* Ether entry pointer	*/
+		struct	ethframe *frames,	/* Frames to send	*/
+		int32	nframes			/* Number of frames	*/
+	)
+{
+	struct	eth_a_tx_desc *prev;	/* End of the chain	*/
+	uint32	first;			/* Index of the chain	*/
+	uint32	index;			/* Index of a frame	*/
+	int32	nchain;			/* Descriptors in chain	*/
+	int32	ndesc;			/* Descriptors of frame	*/
+	int32	i;			/* Index into frames	*/
+
+	if (nframes < 0) {
+		return SYSERR;
+	}
+
+	/* Hold the queue for the whole batch */
+	wait(ethptr->omutex);
+
+	first = ethptr->txTail;
+	nchain = 0;
+	for (i = 0; i < nframes; i++) {
+
+		/* A frame needs up to two slots (one for padding) */
+		if ( (nchain > 0) && (semcount(ethptr->osem) < 2) ) {
+			ethtxlink(ethptr, first, nchain);
+			nchain = 0;
+		}
+
+		index = ethptr->txTail;
+		if (ethtxprep(ethptr, &frames[i], 1, &ndesc) == SYSERR) {
+			break;
+		}
+
+		/* Link the frame after the last descriptor of the chain, */
+		/* which is the one before it in the ring		   */
+		if (nchain == 0) {
+			first = index;
+		} else {
+			prev = (struct eth_a_tx_desc *)ethptr->txRing +
+			       ((index == 0) ? ethptr->txRingSize - 1 : index - 1);
+			prev->next = (struct eth_a_tx_desc *)ethptr->txRing +
+									index;
+		}
+		nchain += ndesc;
+	}
+	if (nchain > 0) {
+		ethtxlink(ethptr, first, nchain);
+	}
+
+	signal(ethptr->omutex);
+	return i;
+}
@@ -0,0 +1,46 @@
+/* ethloopClose.c - ethloopClose */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethloopClose - close a loopback Ethernet device, discarding queued
+ *		    and held packets and waking any process that waits
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopClose (
+	  struct dentry	*devptr		/* Entry in device switch table	*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+	intmask	mask;			/* Saved interrupt mask		*/
+
+	elpptr = &elooptab[devptr->dvminor];
+
+	mask = disable();
+	if (elpptr->state != ELOOP_STATE_ALLOC) {
+		restore(mask);
+		return SYSERR;
+	}
+	elpptr->state = ELOOP_STATE_FREE;
+
+	/* Return the buffers to the pool */
+
+	while (elpptr->count > 0) {
+		freebuf(elpptr->buffer[elpptr->index]);
+		elpptr->buffer[elpptr->index] = NULL;
+		elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+		elpptr->count--;
+	}
+	if (elpptr->hold != NULL) {
+		freebuf(elpptr->hold);
+		elpptr->hold = NULL;
+		elpptr->holdlen = 0;
+	}
+
+	/* Readers that wake find the device closed */
+
+	semreset(elpptr->sem, 0);
+	semreset(elpptr->hsem, 0);
+	restore(mask);
+	return OK;
+}
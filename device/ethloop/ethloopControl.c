@@ -0,0 +1,67 @@
+/* ethloopControl.c - ethloopControl */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethloopControl - control function for a loopback Ethernet device
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopControl (
+	  struct dentry	*devptr,	/* Entry in device switch table	*/
+	  int		func,		/* Control function		*/
+	  int32		arg1,		/* Argument 1, if needed	*/
+	  int32		arg2		/* Argument 2, if needed	*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+	intmask	mask;			/* Saved interrupt mask		*/
+	int32	retval;			/* Return value			*/
+
+	elpptr = &elooptab[devptr->dvminor];
+	if (elpptr->state != ELOOP_STATE_ALLOC) {
+		return SYSERR;
+	}
+
+	switch (func) {
+
+	/* Wait for a held packet and copy it into the buffer at	*/
+	/*   arg1, which holds arg2 bytes				*/
+
+	case ELOOP_CTRL_GETHOLD:
+		wait(elpptr->hsem);
+		mask = disable();
+		if (elpptr->hold == NULL) {	/* Device was closed	*/
+			restore(mask);
+			return SYSERR;
+		}
+		retval = elpptr->holdlen;
+		if (retval > arg2) {
+			retval = arg2;
+		}
+		memcpy((char *)arg1, elpptr->hold, retval);
+		freebuf(elpptr->hold);
+		elpptr->hold = NULL;
+		elpptr->holdlen = 0;
+		restore(mask);
+		return retval;
+
+	/* Set or clear flags; return the flags as they were	*/
+
+	case ELOOP_CTRL_SETFLAG:
+		mask = disable();
+		retval = elpptr->flags;
+		elpptr->flags |= (byte)arg1;
+		restore(mask);
+		return retval;
+
+	case ELOOP_CTRL_CLRFLAG:
+		mask = disable();
+		retval = elpptr->flags;
+		elpptr->flags &= ~(byte)arg1;
+		restore(mask);
+		return retval;
+
+	default:
+		return SYSERR;
+	}
+}
@@ -0,0 +1,37 @@
+/* ethloopInit.c - ethloopInit */
+
+#include <xinu.h>
+
+struct	ethloop	elooptab[Nethloop];
+
+/*------------------------------------------------------------------------
+ * ethloopInit - initialize a loopback Ethernet device; the buffers and
+ *		   semaphores are allocated once here because a buffer
+ *		   pool cannot be released when the device is closed
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopInit (
+	  struct dentry	*devptr		/* Entry in device switch table	*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+
+	elpptr = &elooptab[devptr->dvminor];
+	memset(elpptr, 0, sizeof(struct ethloop));
+	elpptr->state = ELOOP_STATE_FREE;
+	elpptr->dev = devptr;
+
+	/* One buffer for each queue slot plus one for the hold	*/
+	/*   buffer, so a write never waits for a free buffer	*/
+
+	elpptr->poolid = mkbufpool(ELOOP_BUFSIZE, ELOOP_NBUF + 1);
+	if (elpptr->poolid == SYSERR) {
+		return SYSERR;
+	}
+	elpptr->sem = semcreate(0);
+	elpptr->hsem = semcreate(0);
+	if ( (elpptr->sem == SYSERR) || (elpptr->hsem == SYSERR) ) {
+		return SYSERR;
+	}
+	return OK;
+}
@@ -0,0 +1,34 @@
+/* ethloopOpen.c - ethloopOpen */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethloopOpen - open a loopback Ethernet device with an empty queue
+ *		   and no flags set
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopOpen (
+	  struct dentry	*devptr		/* Entry in device switch table	*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+	intmask	mask;			/* Saved interrupt mask		*/
+
+	elpptr = &elooptab[devptr->dvminor];
+
+	mask = disable();
+	if ( (elpptr->state != ELOOP_STATE_FREE) ||
+	     (elpptr->poolid == SYSERR) ) {
+		restore(mask);
+		return SYSERR;
+	}
+	elpptr->flags = 0;
+	elpptr->index = 0;
+	elpptr->count = 0;
+	elpptr->hold = NULL;
+	elpptr->holdlen = 0;
+	elpptr->nout = 0;
+	elpptr->state = ELOOP_STATE_ALLOC;
+	restore(mask);
+	return devptr->dvnum;
+}
@@ -0,0 +1,50 @@
+/* ethloopRead.c - ethloopRead */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethloopRead - wait for the oldest packet written to a loopback
+ *		   Ethernet device and copy it into the caller's buffer
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopRead (
+	  struct dentry	*devptr,	/* Entry in device switch table	*/
+	  void		*buf,		/* Buffer for the packet	*/
+	  uint32	len		/* Size of the buffer		*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+	intmask	mask;			/* Saved interrupt mask		*/
+	char	*pkt;			/* Buffer holding the packet	*/
+	uint32	pktlen;			/* Length of the packet		*/
+
+	elpptr = &elooptab[devptr->dvminor];
+	if (elpptr->state != ELOOP_STATE_ALLOC) {
+		return SYSERR;
+	}
+
+	/* Wait for a packet; a close wakes the reader with none	*/
+
+	wait(elpptr->sem);
+
+	mask = disable();
+	if ( (elpptr->state != ELOOP_STATE_ALLOC) || (elpptr->count == 0) ) {
+		restore(mask);
+		return SYSERR;
+	}
+	pkt = elpptr->buffer[elpptr->index];
+	pktlen = elpptr->pktlen[elpptr->index];
+	elpptr->buffer[elpptr->index] = NULL;
+	elpptr->index = (elpptr->index + 1) % ELOOP_NBUF;
+	elpptr->count--;
+	restore(mask);
+
+	/* Copy outside the critical section, then free the buffer	*/
+
+	if (pktlen > len) {
+		pktlen = len;
+	}
+	memcpy(buf, pkt, pktlen);
+	freebuf(pkt);
+	return pktlen;
+}
@@ -0,0 +1,91 @@
+/* ethloopWrite.c - ethloopWrite */
+
+#include <xinu.h>
+
+/*------------------------------------------------------------------------
+ * ethloopWrite - write a packet to a loopback Ethernet device; the
+ *		    packet is dropped, placed in the hold buffer, or
+ *		    queued for the next read according to the flags
+ *------------------------------------------------------------------------
+ */
+devcall	ethloopWrite (
+	  struct dentry	*devptr,	/* Entry in device switch table	*/
+	  void		*buf,		/* Packet to write		*/
+	  uint32	len		/* Length of the packet		*/
+	)
+{
+	struct	ethloop	*elpptr;	/* Pointer to control block	*/
+	intmask	mask;			/* Saved interrupt mask		*/
+	char	*pkt;			/* Buffer to hold the packet	*/
+	int32	tail;			/* Queue slot for the packet	*/
+
+	elpptr = &elooptab[devptr->dvminor];
+	if (elpptr->state != ELOOP_STATE_ALLOC) {
+		return SYSERR;
+	}
+	if ( (len < ELOOP_LINKHDRSIZE) || (len > ELOOP_BUFSIZE) ) {
+		return SYSERR;
+	}
+
+	/* Drop the packet if asked to; a drop still counts as sent	*/
+
+	mask = disable();
+	if (elpptr->flags & ELOOP_FLAG_DROPNXT) {
+		elpptr->flags &= ~ELOOP_FLAG_DROPNXT;
+		restore(mask);
+		return len;
+	}
+	if (elpptr->flags & ELOOP_FLAG_DROPALL) {
+		restore(mask);
+		return len;
+	}
+	restore(mask);
+
+	/* Copy the packet; the pool has a buffer for every queue	*/
+	/*   slot and the hold buffer, so this wait is short		*/
+
+	pkt = getbuf(elpptr->poolid);
+	if ((int32)pkt == SYSERR) {
+		return SYSERR;
+	}
+	memcpy(pkt, buf, len);
+
+	mask = disable();
+	if (elpptr->state != ELOOP_STATE_ALLOC) {
+		restore(mask);
+		freebuf(pkt);
+		return SYSERR;
+	}
+
+	/* Place the packet in the hold buffer, replacing any packet	*/
+	/*   that is already held					*/
+
+	if (elpptr->flags & ELOOP_FLAG_HOLDNXT) {
+		elpptr->flags &= ~ELOOP_FLAG_HOLDNXT;
+		if (elpptr->hold != NULL) {
+			freebuf(elpptr->hold);
+		} else {
+			signal(elpptr->hsem);
+		}
+		elpptr->hold = pkt;
+		elpptr->holdlen = len;
+		restore(mask);
+		return len;
+	}
+
+	/* Queue the packet for the next read */
+
+	if (elpptr->count >= ELOOP_NBUF) {
+		restore(mask);
+		freebuf(pkt);
+		return SYSERR;
+	}
+	tail = (elpptr->index + elpptr->count) % ELOOP_NBUF;
+	elpptr->buffer[tail] = pkt;
+	elpptr->pktlen[tail] = len;
+	elpptr->count++;
+	elpptr->nout++;
+	signal(elpptr->sem);
+	restore(mask);
+	return len;
+}
@@ -12,6 +12,11 @@ devcall	ttywrite(
 	  int32	count 			/* Count of character to write	*/
 	)
 {
+	struct	ttycblk	*typtr;		/* Pointer to tty control block	*/
+	int32	avail;			/* Free slots in output buffer	*/
+	int32	nput;			/* Chars placed without waiting	*/
+	char	ch;			/* Next character to write	*/
+
 	/* Handle negative and zero counts */
 
 	if (count < 0) {
@@ -20,10 +25,47 @@ devcall	ttywrite(
 		return OK;
 	}
 
-	/* Write count characters one at a time */
+	typtr = &ttytab[devptr->dvminor];
+
+	while (count > 0) {
+
+		/* If the output buffer is (nearly) full, write one	*/
+		/*   character with ttyputc, which waits for space	*/
+
+		avail = semcount(typtr->tyosem);
+		if (avail < 2) {
+			ttyputc(devptr, *buff++);
+			count--;
+			continue;
+		}
+
+		/* Copy as many characters as fit into the output	*/
+		/*   buffer, keeping room for a CR before a NEWLINE,	*/
+		/*   and take all of the slots from the semaphore at	*/
+		/*   once instead of waiting once per character		*/
+
+		nput = 0;
+		while ( (count > 0) && (avail - nput >= 2) ) {
+			ch = *buff++;
+			count--;
+			if ( ch==TY_NEWLINE && typtr->tyocrlf ) {
+				*typtr->tyotail++ = TY_RETURN;
+				if (typtr->tyotail >= &typtr->tyobuff[TY_OBUFLEN]) {
+					typtr->tyotail = typtr->tyobuff;
+				}
+				nput++;
+			}
+			*typtr->tyotail++ = ch;
+			if (typtr->tyotail >= &typtr->tyobuff[TY_OBUFLEN]) {
+				typtr->tyotail = typtr->tyobuff;
+			}
+			nput++;
+		}
+		semtab[typtr->tyosem].scount -= nput;
+
+		/* Start output in case device is idle */
 
-	for (; count>0 ; count--) {
-		ttyputc(devptr, *buff++);
+		ttykickout((struct uart_csreg *)devptr->dvcsr);
 	}
 	return OK;
 }
@@ -237,8 +237,36 @@ struct eth_a_wr
 	uint32 c0_tx_stat;
 	//! サブシステム コア0 MISC割り込みマスク状態レジスタ
 	uint32 c0_misc_stat;
+	//! 予約2（コア1、コア2の割り込みマスク状態レジスタ）
+	uint32 res2[8];
+	//! サブシステム コア0 1ms当たりの最大RX(受信)割り込み数レジスタ
+	uint32 c0_rx_imax;
+	//! サブシステム コア0 1ms当たりの最大TX(送信)割り込み数レジスタ
+	uint32 c0_tx_imax;
 };
 
+//! コア0 RX(受信)割り込みのペーシング許可
+#define ETH_AM335X_WRINT_C0RXPACE 0x00010000
+//! コア0 TX(送信)割り込みのペーシング許可
+#define ETH_AM335X_WRINT_C0TXPACE 0x00020000
+//! 4μsを刻むためのプリスケール値（CPSWのクロック125MHz × 4μs）
+#define ETH_AM335X_WRINT_PRESCALE 500
+
+#ifndef ETH_AM335X_RX_IMAX
+//! 1ms当たりの最大RX(受信)割り込み数（2〜63、0でペーシングしない）
+#define ETH_AM335X_RX_IMAX 16
+#endif
+
+#ifndef ETH_AM335X_TX_IMAX
+//! 1ms当たりの最大TX(送信)割り込み数（2〜63、0でペーシングしない）
+#define ETH_AM335X_TX_IMAX 8
+#endif
+
+#ifndef ETH_AM335X_RX_BUDGET
+//! 受信プロセスが1tick休眠して他のプロセスに譲るまでに、1回のポーリングで処理するパケット数
+#define ETH_AM335X_RX_BUDGET 16
+#endif
+
 /**
  * @struct eth_a_mdio
  * @brief Management Data Input/Output(MDIO)レジスタ用の構造体
@@ -29,6 +29,8 @@
 //! CPSR：プロセッサモード = セキュアモニタ
 #define ARMv7A_CPSR_SCM 0x00000016
 
+//! Coprocessor c1 - 制御レジスタBits：分岐予測の有効化
+#define ARMV7A_C1CTL_Z 0x00000800
 //! Coprocessor c1 - 制御レジスタBits：例外ベースアドレス制御
 #define ARMV7A_C1CTL_V 0x00002000
 //! Coprocessor c1 - 制御レジスタBits：命令キャッシュの有効化
@@ -40,6 +42,52 @@
 //! Coprocessor c1 - 制御レジスタBits：MMUの有効化
 #define ARMV7A_C1CTL_M 0x00000001
 
+//! Coprocessor c1 - 補助制御レジスタBits：L2キャッシュの有効化（Cortex-A8）
+#define ARMV7A_ACTLR_L2EN 0x00000002
+
+//! L1変換テーブルのエントリ数（1エントリが1MBのセクションを表す）
+#define ARMV7A_L1PT_NENT 4096
+//! セクションのサイズ（Byte）
+#define ARMV7A_SECT_SIZE 0x00100000
+//! セクションディスクリプタ：ディスクリプタ種別 = セクション
+#define ARMV7A_SECT 0x00000002
+//! セクションディスクリプタ：Bufferable（B）
+#define ARMV7A_SECT_B 0x00000004
+//! セクションディスクリプタ：Cacheable（C）
+#define ARMV7A_SECT_C 0x00000008
+//! セクションディスクリプタ：実行禁止（XN）
+#define ARMV7A_SECT_XN 0x00000010
+//! セクションディスクリプタ：特権／非特権モードともに読み書き可能（AP[1:0] = 0b11）
+#define ARMV7A_SECT_AP_RW 0x00000C00
+//! セクションディスクリプタ：TEX[2:0] = 0b001
+#define ARMV7A_SECT_TEX1 0x00001000
+//! セクションディスクリプタ：共有可能（S）
+#define ARMV7A_SECT_S 0x00010000
+//! メモリ属性：Normal、ライトバック／ライトアロケートでキャッシュ可能
+#define ARMV7A_SECT_NORMAL (ARMV7A_SECT | ARMV7A_SECT_AP_RW | ARMV7A_SECT_TEX1 | \
+							ARMV7A_SECT_C | ARMV7A_SECT_B)
+//! メモリ属性：Normal、キャッシュ不可（DMAバッファ、OCMC RAM向け）
+#define ARMV7A_SECT_NCACHE (ARMV7A_SECT | ARMV7A_SECT_AP_RW | ARMV7A_SECT_TEX1)
+//! メモリ属性：共有可能なDevice（周辺機器レジスタ向け、実行禁止）
+#define ARMV7A_SECT_DEVICE (ARMV7A_SECT | ARMV7A_SECT_AP_RW | ARMV7A_SECT_B | \
+							ARMV7A_SECT_XN)
+//! TTBR0：変換テーブルウォークをInner Cacheableで行う
+#define ARMV7A_TTBR_C 0x00000001
+//! TTBR0：変換テーブルウォークをOuter Write-Back Write-Allocateで行う
+#define ARMV7A_TTBR_RGN_WBWA 0x00000008
+//! ドメインアクセス制御：全ドメインをクライアント（ディスクリプタのAPで検査）とする
+#define ARMV7A_DACR_CLIENT 0x55555555
+
+//! データキャッシュのラインサイズ（Cortex-A8のL1/L2は64Byte）
+#define ARMV7A_DCACHE_LINE 64
+
+/**
+ * @def dsb()
+ * @brief データ同期バリア。直前までのメモリアクセスとキャッシュ操作の完了を待つ。
+ * @note DMAディスクリプタを書き換えてからDMAレジスタを操作する前に用いる。
+ */
+#define dsb() asm volatile("dsb" ::: "memory")
+
 //! 例外ベクタの開始アドレス
 #define ARMV7A_EV_START 0x4030CE00
 //! 例外ベクタの終了アドレス
@@ -52,4 +100,12 @@
 #define ARMV7A_IRQH_ADDR 0x4030CE38
 
 //! 0x80000000から始まる512MB RAMの最終アドレス
-#define MAXADDR 0xA0000000
+#define RAMEND 0xA0000000
+//! ROM（0x40000000〜）を含むセクションの開始アドレス
+#define ROMADDR 0x40000000
+//! 例外ベクタを置くOCMC RAM（0x40300000〜）を含むセクションの開始アドレス
+#define OCMCADDR 0x40300000
+//! DMA用のキャッシュ不可領域の開始アドレス（RAMの最後の1MB）
+#define DMAADDR 0x9FF00000
+//! ヒープとスタックに使用するRAMの最終アドレス（DMA用領域の直前まで）
+#define MAXADDR DMAADDR
@@ -16,12 +16,26 @@
 #define ARP_OP_REQ 1
 //! リプライオペコード
 #define ARP_OP_RPLY 2
+#ifndef ARP_SIZ
 //! キャシュ中のエントリ数
-#define ARP_SIZ 16
+#define ARP_SIZ 64
+#endif
+#ifndef ARP_HSIZ
+//! キャッシュのハッシュマップのスロット数（2のべき乗、hm_maxcount()がARP_SIZ以上となる数）
+#define ARP_HSIZ 128
+#endif
+//! 解決中のエントリ1つが保持する送信待ちパケットの最大数
+#define ARP_QSIZ 4
 //! ARPリクエストのリトライ回数
 #define ARP_RETRY 3
 //! [ms]毎のリトライタイマ
 #define ARP_TIMEOUT 300 /* Retry timer in milliseconds	*/
+//! 解決済みエントリの有効期間[ms]
+#define ARP_TTL 300000
+//! 有効期限まで残りこの時間[ms]を切ったエントリは、使われた時に更新のリクエストを送る
+#define ARP_REFRESH 30000
+//! arptimerプロセスがキャッシュを調べる周期[ms]
+#define ARP_TICK 100
 
 //! ARPキャッシュエントリ状態：スロットが未使用
 #define AR_FREE 0
@@ -29,6 +43,8 @@
 #define AR_PENDING 1
 //! ARPキャッシュエントリ状態：エントリが正常
 #define AR_RESOLVED 2
+//! ARPキャッシュエントリ状態：静的エントリ（期限切れにならない）
+#define AR_STATIC 3
 
 #pragma pack(2)
 /**
@@ -75,11 +91,39 @@ struct arpentry
 	int32 arstate;
 	//! エントリのIPアドレス
 	uint32 arpaddr;
-	//! 待機中プロセスか-1
-	pid32 arpid;
 	//! エントリのEthernetアドレス
 	byte arhaddr[ARP_HALEN];
+	//! IPアドレスをキーとするハッシュマップのノード
+	struct hmnode arnode;
+	//! フリーリストの次のエントリ、末尾は-1
+	int32 arnext;
+	//! 解決中は次の再送まで、解決済みは有効期限までの時間[ms]
+	int32 artime;
+	//! 解決中は残りの再送回数、解決済みは更新リクエストを送信済みなら1
+	int32 arretry;
+	//! 解決を待っているパケットの数
+	int32 arcount;
+	//! 解決を待っているパケット（古い順）
+	struct netpacket *arqueue[ARP_QSIZ];
+};
+
+/**
+ * @struct arpstat
+ * @brief ARPの統計情報
+ */
+struct arpstat
+{
+	//! 送信したARPリクエストの数
+	uint32 as_reqsent;
+	//! 応答が無く解決に失敗した回数
+	uint32 as_fail;
+	//! 解決待ちのキューから溢れた、または解決に失敗して破棄したパケットの数
+	uint32 as_drop;
 };
 
 //! ARPキャッシュエントリテーブル
 extern struct arpentry arpcache[];
+//! ARPの統計情報
+extern struct arpstat arpstats;
+//! ARPキャッシュと統計情報の排他制御用セマフォ（ETHER0への送信中は保持しない）
+extern sid32 arpmutex;
@@ -9,8 +9,8 @@
 #endif
 
 #ifndef BP_MAXB
-//! 最大バッファサイズ（Byte）
-#define BP_MAXB 8192
+//! 最大バッファサイズ（Byte）（IPの再構築バッファが最大長のデータグラムを保持できる大きさ）
+#define BP_MAXB 73728
 #endif
 
 //! 最小バッファサイズ（Byte）
@@ -16,6 +16,9 @@ extern int32 *sltop;
 //! プリエンプションカウンタ
 extern uint32 preempt;
 
+/* in file clkms.c */
+extern uint32 clkms(void);
+
 /**
  * @struct am335x_timer1ms
  * @brief AM335X SOCのタイマー（1[ms]）
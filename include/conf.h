@@ -32,29 +32,30 @@ extern	struct	dentry	devtab[]; /* one entry per device */
 #define GPIO3                4	/* type gpio     */
 #define NULLDEV              5	/* type null     */
 #define ETHER0               6	/* type eth      */
-#define NAMESPACE            7	/* type nam      */
-#define RDISK                8	/* type rds      */
-#define RAM0                 9	/* type ram      */
-#define RFILESYS            10	/* type rfs      */
-#define RFILE0              11	/* type rfl      */
-#define RFILE1              12	/* type rfl      */
-#define RFILE2              13	/* type rfl      */
-#define RFILE3              14	/* type rfl      */
-#define RFILE4              15	/* type rfl      */
-#define RFILE5              16	/* type rfl      */
-#define RFILE6              17	/* type rfl      */
-#define RFILE7              18	/* type rfl      */
-#define RFILE8              19	/* type rfl      */
-#define RFILE9              20	/* type rfl      */
-#define LFILESYS            21	/* type lfs      */
-#define LFILE0              22	/* type lfl      */
-#define LFILE1              23	/* type lfl      */
-#define LFILE2              24	/* type lfl      */
-#define LFILE3              25	/* type lfl      */
-#define LFILE4              26	/* type lfl      */
-#define LFILE5              27	/* type lfl      */
-#define SPI0                28	/* type spi      */
-#define SPI1                29	/* type spi      */
+#define ELOOP                7	/* type ethloop  */
+#define NAMESPACE            8	/* type nam      */
+#define RDISK                9	/* type rds      */
+#define RAM0                10	/* type ram      */
+#define RFILESYS            11	/* type rfs      */
+#define RFILE0              12	/* type rfl      */
+#define RFILE1              13	/* type rfl      */
+#define RFILE2              14	/* type rfl      */
+#define RFILE3              15	/* type rfl      */
+#define RFILE4              16	/* type rfl      */
+#define RFILE5              17	/* type rfl      */
+#define RFILE6              18	/* type rfl      */
+#define RFILE7              19	/* type rfl      */
+#define RFILE8              20	/* type rfl      */
+#define RFILE9              21	/* type rfl      */
+#define LFILESYS            22	/* type lfs      */
+#define LFILE0              23	/* type lfl      */
+#define LFILE1              24	/* type lfl      */
+#define LFILE2              25	/* type lfl      */
+#define LFILE3              26	/* type lfl      */
+#define LFILE4              27	/* type lfl      */
+#define LFILE5              28	/* type lfl      */
+#define SPI0                29	/* type spi      */
+#define SPI1                30	/* type spi      */
 
 /* Control block sizes */
 
@@ -62,6 +63,7 @@ extern	struct	dentry	devtab[]; /* one entry per device */
 #define	Ngpio	4
 #define	Ntty	1
 #define	Neth	1
+#define	Nethloop	1
 #define	Nrds	1
 #define	Nram	1
 #define	Nrfs	1
@@ -71,7 +73,7 @@ extern	struct	dentry	devtab[]; /* one entry per device */
 #define	Nnam	1
 #define	Nspi	2
 
-#define NDEVS 30
+#define NDEVS 31
 
 
 /* Configuration and Size Constants */
@@ -83,4 +85,11 @@ extern	struct	dentry	devtab[]; /* one entry per device */
 #define	IRQ_ATH_MISC IRQ_HW4	/* Misc. IRQ is wired to hardware 4	*/
 #define CLKFREQ      200000000	/* 200 MHz clock			*/
 
+#define	UDP_SLOTS    6		/* number of UDP endpoints		*/
+#define	UDP_HSIZ     64		/* UDP endpoint hash buckets (power of 2)*/
+
 #define	LF_DISK_DEV	RAM0
+
+/* Uncomment to record the owner of every getmem/getstk block	*/
+/*   (reported by "memstat --owners" and when a process is killed)	*/
+/* #define	MEMTRACK */
@@ -8,6 +8,22 @@
 #define	DNSLPORT	51525		/* Local UDP port to use	*/
 #define	DNSDATASIZ	500		/* Size of the data area	*/
 
+#ifndef	DNS_CACHESIZ
+#define	DNS_CACHESIZ	16		/* Names held in the cache	*/
+#endif
+#ifndef	DNS_QUERIES
+#define	DNS_QUERIES	4		/* Queries in flight at once	*/
+#endif
+#define	DNS_NAMLEN	128		/* Longest name, including NULL	*/
+#define	DNS_MAXTTL	86400		/* Longest time to cache an	*/
+					/*   address (secs)		*/
+#define	DNS_NEGTTL	60		/* Time to cache a missing name	*/
+					/*   when the reply has no SOA	*/
+#define	DNS_NEGMAX	900		/* Longest time to cache a	*/
+					/*   missing name (secs)	*/
+#define	DNS_TICK	100		/* Interval at which dnsd checks*/
+					/*   for lost queries (ms)	*/
+
 
 /* Format of a DNS Query/Response packet */
 
@@ -36,6 +52,13 @@ struct	dnspkt {
 
 #define	DNS_QT_A	1		/* DNS Address Type (A)		*/
 #define DNS_QT_NS	2		/* DNS Name Server Type		*/
+#define	DNS_QT_CNAME	5		/* DNS Canonical Name Type	*/
+#define	DNS_QT_SOA	6		/* DNS Start of Authority Type	*/
+
+/* RCode values */
+
+#define	DNS_RC_OK	0		/* No error			*/
+#define	DNS_RC_NXDOMAIN	3		/* Name does not exist		*/
 
 /* QClass values */
 
@@ -59,3 +82,60 @@ struct	dns_rr {
 	uint16	*rdlen;			/* Resource Record RD Length	*/
 	char	*rdata;			/* Resource Record Data area	*/
 };
+
+/* Results of parsing a Response */
+
+#define	DNS_ADDR	1		/* Response holds an address	*/
+#define	DNS_NONAME	2		/* Name or address does not exist*/
+#define	DNS_FAIL	3		/* Server could not answer	*/
+
+/* Entry in the cache of names; a negative entry records that a name	*/
+/*   has no address, so repeated lookups of it are answered locally	*/
+
+#define	DNSC_FREE	0		/* Entry is unused		*/
+#define	DNSC_ADDR	1		/* Name has the address dc_addr	*/
+#define	DNSC_NONAME	2		/* Name has no address		*/
+
+struct	dnscent	{
+	byte	dc_state;		/* DNSC_FREE, etc.		*/
+	char	dc_name[DNS_NAMLEN];	/* Name, in lower case		*/
+	uint32	dc_addr;		/* IP address in host byte order*/
+	uint32	dc_expire;		/* Time (clktime) entry expires	*/
+	uint32	dc_used;		/* Time (clktime) of last use	*/
+	uint32	dc_hits;		/* Lookups answered by the entry*/
+};
+
+/* Query in flight; every process looking up the name waits for the	*/
+/*   same query, and the last one to see the result frees it		*/
+
+#define	DNSQ_FREE	0		/* Entry is unused		*/
+#define	DNSQ_WAIT	1		/* Waiting for the Response	*/
+#define	DNSQ_DONE	2		/* Result is in the entry	*/
+
+struct	dnsquery {
+	byte	dq_state;		/* DNSQ_FREE, etc.		*/
+	char	dq_name[DNS_NAMLEN];	/* Name being looked up		*/
+	uint16	dq_id;			/* Query ID			*/
+	uint32	dq_server;		/* Name server queried		*/
+	int32	dq_tries;		/* Times the Query was sent	*/
+	int32	dq_timer;		/* Time until a resend (ms)	*/
+	int32	dq_nwait;		/* Processes waiting		*/
+	sid32	dq_sem;			/* Waiters block here		*/
+	status	dq_result;		/* OK or SYSERR once done	*/
+	uint32	dq_addr;		/* Address found		*/
+};
+
+struct	dnsstat	{
+	uint32	ds_hits;		/* Answered from the cache	*/
+	uint32	ds_neghits;		/* Answered from negative entry	*/
+	uint32	ds_misses;		/* Needed a new Query		*/
+	uint32	ds_joined;		/* Shared a Query in flight	*/
+	uint32	ds_sent;		/* Queries sent, with resends	*/
+	uint32	ds_timeouts;		/* Queries never answered	*/
+	uint32	ds_badresp;		/* Responses that were ignored	*/
+};
+
+extern	struct	dnscent	dnscache[];
+extern	struct	dnsquery dnsqtab[];
+extern	struct	dnsstat	dnsstats;
+extern	sid32	dnsmutex;
@@ -30,6 +30,8 @@ struct	etherPkt {
 					/*  frame			*/
 
 #define	ETH_MAX_PKT_LEN	( ETH_HDR_LEN + ETH_VLAN_LEN + ETH_MTU )
+#define	ETH_MIN_PKT_LEN		60	/* Shorter frames are padded	*/
+#define	ETH_TX_MAXFRAG		4	/* Max. pieces of a Tx frame	*/
 
 #define	ETH_BUF_SIZE		1518	/* 1500 MTU + 14 ETH Header + 4 bytes optional VLAN Tagging */
 
@@ -43,6 +45,49 @@ struct	etherPkt {
 /* Ethernet device control functions */
 
 #define	ETH_CTRL_GET_MAC     	1 	/* Get the MAC for this device	*/
+#define	ETH_CTRL_TXBATCH	2	/* Send an array of frames	*/
+					/*   (arg1 = struct ethframe *,	*/
+					/*    arg2 = number of frames);	*/
+					/*   returns the number sent	*/
+#define	ETH_CTRL_RXPOOL		3	/* Receive into pool buffers	*/
+					/*   (arg1 = buffer pool ID,	*/
+					/*    arg2 = offset of the frame*/
+					/*    in a buffer)		*/
+#define	ETH_CTRL_RXSWAP		4	/* Exchange an empty buffer for	*/
+					/*   the next frame received	*/
+					/*   (arg1 = char ** that holds	*/
+					/*    the empty buffer and gets	*/
+					/*    the frame)		*/
+#define	ETH_CTRL_TXSG		5	/* Send one frame made of	*/
+					/*   pieces (arg1 = struct	*/
+					/*   ethframe *, arg2 = number	*/
+					/*   of pieces)			*/
+#define	ETH_CTRL_TXFREE		6	/* Set the function that frees	*/
+					/*   a buffer sent in place	*/
+					/*   (arg1 = the function)	*/
+#define	ETH_CTRL_STATS		7	/* Get the counters of the	*/
+					/*   device (arg1 = struct	*/
+					/*   ethstats *)		*/
+
+struct	ethframe	{		/* One frame of a Tx batch, or	*/
+					/*   one piece of a Tx frame	*/
+	char	*efbuf;			/* Frame, starting at the header*/
+	uint32	eflen;			/* Length of the frame		*/
+	char	*efrel;			/* Buffer to free after efbuf	*/
+					/*   is sent in place, or NULL	*/
+					/*   to copy efbuf instead	*/
+};
+
+struct	ethstats	{		/* Counters of an Ethernet dev.	*/
+	uint32	es_rxirq;		/* Rx interrupts taken		*/
+	uint32	es_rxpkts;		/* Packets received		*/
+	uint32	es_rxpolls;		/* Polling rounds that ended	*/
+					/*   with the ring empty	*/
+	uint32	es_rxyields;		/* Polling rounds that used up	*/
+					/*   the budget			*/
+	uint32	es_txirq;		/* Tx interrupts taken		*/
+	uint32	es_errors;		/* Frames dropped by the driver	*/
+};
 
 /* Ethernet multicast */
 
@@ -85,12 +130,20 @@ struct	ethcblk	{
 	uint32	rxTail;		/* Index of current tail of Rx ring	*/
 	uint32	rxRingSize;	/* size of Rx ring descriptor array	*/
 	uint32	rxIrq;		/* Count of Rx interrupt requests       */
+	uint32	rxPkts;		/* Count of packets received		*/
+	uint32	rxPolls;	/* Polling rounds that emptied the ring	*/
+	uint32	rxYields;	/* Polling rounds cut off by the budget	*/
+	uint32	rxQuota;	/* Packets taken in this polling round	*/
 
 	void    *txRing; 	/* ptr to array of xmit ring descriptors*/
 	void    *txBufs; 	/* ptr to Tx packet buffers in memory	*/
 	uint32	txHead;		/* Index of current head of Tx ring	*/
 	uint32	txTail;		/* Index of current tail of Tx ring	*/
 	uint32	txRingSize;	/* size of Tx ring descriptor array	*/
+	uint32	txPend;		/* Tx descriptors given to the DMA	*/
+	char	**txRel;	/* Per Tx descriptor: buffer to free	*/
+				/*   when the frame has been sent	*/
+	status	(*txFree)(char *);/* Function that frees those buffers*/
 	uint32	txIrq;		/* Count of Tx interrupt requests       */
 
 	byte	devAddress[ETH_ADDR_LEN];/* MAC address 		*/
@@ -101,9 +154,12 @@ struct	ethcblk	{
 	uint32	errors;		/* Number of Ethernet errors 		*/
 	sid32	isem;		/* Semaphore for Ethernet input		*/
 	sid32	osem; 		/* Semaphore for Ethernet output	*/
+	sid32	omutex;		/* Serializes the writers of Tx ring	*/
 	uint16	istart;		/* Index of next packet in the ring     */
 
 	int16	inPool;		/* Buffer pool ID for input buffers 	*/
+				/*   (-1 until ETH_CTRL_RXPOOL)		*/
+	uint16	inOffset;	/* Offset of the frame in a pool buffer	*/
 	int16	outPool;	/* Buffer pool ID for output buffers	*/
 
 	int16 	proms; 		/* nonzero => promiscuous mode 		*/
@@ -0,0 +1,66 @@
+/**
+ * @file hashmap.h
+ * @brief 侵入型（intrusive）のオープンアドレス法ハッシュマップに関する構造体／定数を定義する。
+ * @details ノード（struct hmnode）は格納したい構造体に埋め込み、スロット配列は呼び出し側が用意する。
+ * そのため、ハッシュマップの操作でメモリの割り当ては一切発生しない。<br>
+ * 衝突は線形探索で解決し、削除時は後続のノードを詰め直す（墓標を使わない）。
+ */
+
+//! 整数キー（hnikey）を用いるハッシュマップ
+#define HM_INT 0
+//! 文字列キー（hnskey）を用いるハッシュマップ
+#define HM_STR 1
+
+/**
+ * @struct hmnode
+ * @brief ハッシュマップに格納する構造体に埋め込むノード
+ * @details 挿入前に、ハッシュマップの種類に応じてhnikeyかhnskeyを設定する。
+ */
+struct hmnode
+{
+	//! キーのハッシュ値（hm_insert()が設定する）
+	uint32 hnhash;
+	//! 整数キー（HM_INTの場合）
+	uint32 hnikey;
+	//! 文字列キー（HM_STRの場合、ノードが格納されている間は変更不可）
+	char *hnskey;
+};
+
+/**
+ * @struct hashmap
+ * @brief ハッシュマップの管理情報
+ */
+struct hashmap
+{
+	//! スロット配列（呼び出し側が用意する、長さは2のべき乗）
+	struct hmnode **hmslot;
+	//! スロット数 - 1（スロットのインデックスを求めるマスク）
+	uint32 hmmask;
+	//! 格納されているノード数
+	uint32 hmcount;
+	//! キーの種類（HM_INT／HM_STR）
+	int32 hmtype;
+};
+
+/**
+ * @def hm_count(hm)
+ * @brief ハッシュマップに格納されているノード数を返す。
+ * @param[in] hm ハッシュマップ
+ */
+#define hm_count(hm) ((hm)->hmcount)
+
+/**
+ * @def hm_maxcount(hm)
+ * @brief ハッシュマップに格納できるノード数の上限（スロット数の3/4）を返す。
+ * @param[in] hm ハッシュマップ
+ */
+#define hm_maxcount(hm) ((hm)->hmmask + 1 - (((hm)->hmmask + 1) >> 2))
+
+/* in file hashmap.c */
+extern status hm_init(struct hashmap *, struct hmnode **, uint32, int32);
+extern status hm_insert(struct hashmap *, struct hmnode *);
+extern status hm_remove(struct hashmap *, struct hmnode *);
+extern struct hmnode *hm_findint(struct hashmap *, uint32);
+extern struct hmnode *hm_findstr(struct hashmap *, const char *);
+extern struct hmnode *hm_next(struct hashmap *, uint32 *);
+extern uint32 hm_hashint(uint32);
@@ -29,3 +29,4 @@ struct	icmpentry {			/* entry in the ICMP table	*/
 };
 
 extern	struct	icmpentry icmptab[];	/* table of UDP endpoints	*/
+extern	sid32	icmpmutex;		/* protects icmptab		*/
@@ -12,6 +12,8 @@
 
 //! IP向けのICMPプロトコルタイプ
 #define IP_ICMP 1
+//! IP向けのTCPプロトコルタイプ
+#define IP_TCP 6
 //! IP向けのUDPプロトコルタイプ
 #define IP_UDP 17
 //! IPアドレスのバイト数
@@ -20,24 +22,174 @@
 #define IP_HDR_LEN 20
 //! 「IPバージョン」および「HDRの長さ」
 #define IP_VH 0x45
-//! IPアウトプットキューのサイズ
-#define IP_OQSIZ 8
+//! IPアウトプットキューの1クラス当たりの最大パケット数
+#define IP_OQSIZ 16
+//! ip_sendmany()が一度に送信できるデータグラムの最大数
+#define IP_BATCH 16
+
+//! IPアウトプットキューのクラス数
+#define IP_OQCLASSES 4
+//! 完全優先度（strict priority）で送信するクラス数（クラス0〜IP_OQSTRICT-1、番号の小さい方が優先）
+#define IP_OQSTRICT 2
+//! ネットワーク制御（DSCP CS6、CS7）のクラス
+#define IP_OQC_CTRL 0
+//! 低遅延（DSCP EF）のクラス
+#define IP_OQC_EF 1
+//! 通常のクラス（DSCPの既定値）
+#define IP_OQC_NORMAL 2
+//! バルク転送（DSCP CS1）のクラス
+#define IP_OQC_BULK 3
+
+//! キューが満杯の時、新しいパケットを捨てる
+#define IP_OQ_DROPTAIL 0
+//! キューが満杯の時、最も古いパケットを捨てる（新しい値だけが意味を持つテレメトリ等）
+#define IP_OQ_DROPHEAD 1
+
+/**
+ * @struct ipoclass
+ * @brief IPアウトプットキューの1クラス
+ * @details クラスIP_OQSTRICT以降は、Deficit Round Robin（DRR）で帯域を分け合う。
+ */
+struct ipoclass
+{
+	//! 次に送信するパケットのインデックス
+	int32 oc_head;
+	//! 次の空きスロットのインデックス
+	int32 oc_tail;
+	//! キュー内のパケット数
+	int32 oc_count;
+	//! キュー内のパケット数の上限（IP_OQSIZ以下）
+	int32 oc_limit;
+	//! 上限に達した時の動作（IP_OQ_DROPTAIL、IP_OQ_DROPHEAD）
+	int32 oc_policy;
+	//! DRRで1巡毎に与えるByte数
+	int32 oc_quantum;
+	//! DRRで送信できる残りのByte数
+	int32 oc_deficit;
+	//! キューに入れたパケット数
+	uint32 oc_enq;
+	//! キューから取り出したパケット数
+	uint32 oc_deq;
+	//! 捨てたパケット数
+	uint32 oc_drops;
+	//! 循環パケットキュー
+	struct netpacket *oc_buf[IP_OQSIZ];
+};
 
 /**
  * @struct iqentry
  * @brief ipout（IP送信）プロセスを待機している送信用IPパケットのキュー
+ * @details パケットはDSCPによってクラスに分けられ、ipoutはクラス毎のスケジューリングに従って取り出す。
  */
 struct iqentry
 {
-	//! 次に送信するパケットのインデックス
-	int32 iqhead;
-	//! 次の空きスロットのインデックス。
-	int32 iqtail;
-	//! パケット（pkts）をカウントするセマフォ
+	//! 全クラスのパケットをカウントするセマフォ
 	sid32 iqsem;
-	//! 循環パケットキュー
-	struct netpacket *iqbuf[IP_OQSIZ];
+	//! キューの排他制御用セマフォ
+	sid32 iqmutex;
+	//! 全クラスのパケット数
+	int32 iqcount;
+	//! DRRで次に調べるクラス
+	int32 iqdrr;
+	//! クラス毎のキュー
+	struct ipoclass iqclass[IP_OQCLASSES];
+	//! DSCPからクラスへの対応表
+	byte iqdscp[64];
 };
 
 //! ネットワーク送信キュー
 extern struct iqentry ipoqueue;
+
+//! フラグメントフィールドの「これ以上フラグメントあり」（MF）フラグ
+#define IP_MF 0x2000
+//! フラグメントフィールドの「フラグメント禁止」（DF）フラグ
+#define IP_DF 0x4000
+//! フラグメントフィールドのフラグメントオフセット（8Byte単位）
+#define IP_FRAGOFF 0x1fff
+//! IPデータグラムの最大長（IPヘッダを含む）
+#define IP_MAXLEN 65535
+
+#ifndef IP_REASM_SLOTS
+//! 同時に再構築できるデータグラム数（再構築バッファ数）
+#define IP_REASM_SLOTS 4
+#endif
+#ifndef IP_REASM_MAXLEN
+//! 再構築できるデータグラムの最大長（IPヘッダを含む）
+#define IP_REASM_MAXLEN IP_MAXLEN
+#endif
+#ifndef IP_REASM_TIMEOUT
+//! 最初のフラグメントの到着から再構築を諦めるまでの秒数
+#define IP_REASM_TIMEOUT 10
+#endif
+//! フラグメントテーブルのハッシュバケット数（2のべき乗）
+#define IP_REASM_HSIZ 16
+//! 受信済み範囲を記録するビットマップのワード数（8Byte単位で1ビット）
+#define IP_REASM_MAPW ((IP_REASM_MAXLEN / 8 + 32) / 32)
+
+//! 再構築スロットの状態：未使用
+#define IP_REASM_FREE 0
+//! 再構築スロットの状態：フラグメント待ち
+#define IP_REASM_USED 1
+
+/**
+ * @struct ipreasm
+ * @brief フラグメントテーブルのエントリ（再構築中のデータグラム1つ）
+ * @details 送信元、宛先、識別子、プロトコルが同じフラグメントを、ペイロードのオフセットの位置に
+ * 再構築バッファへコピーする。受信済みの範囲は8Byte単位のビットマップで記録する。
+ */
+struct ipreasm
+{
+	//! スロットの状態（IP_REASM_FREE、IP_REASM_USED）
+	int32 ir_state;
+	//! 同じハッシュバケットの次のスロット、なければ-1
+	int32 ir_next;
+	//! 送信元IPアドレス
+	uint32 ir_src;
+	//! 宛先IPアドレス
+	uint32 ir_dst;
+	//! IPデータグラムの識別子
+	uint16 ir_id;
+	//! IPプロトコル
+	byte ir_proto;
+	//! オフセット0のフラグメント（ヘッダ）を受信したか
+	bool8 ir_hashead;
+	//! ペイロードの長さ（最後のフラグメントを受信するまでは-1）
+	int32 ir_total;
+	//! 受信済みのペイロードのByte数
+	int32 ir_recvd;
+	//! 受信したフラグメントの末尾の最大値
+	int32 ir_maxend;
+	//! 再構築を諦める時刻（clktime）
+	uint32 ir_expire;
+	//! 再構築バッファ（フレーム）
+	struct netpacket *ir_pkt;
+	//! 受信済み範囲のビットマップ
+	uint32 ir_map[IP_REASM_MAPW];
+};
+
+/**
+ * @struct ipfragstat
+ * @brief フラグメント化と再構築の統計情報
+ */
+struct ipfragstat
+{
+	//! 受信したフラグメント数
+	uint32 if_fragsin;
+	//! 再構築したデータグラム数
+	uint32 if_reasm;
+	//! タイムアウトで捨てたデータグラム数
+	uint32 if_timeouts;
+	//! 既に受信した範囲と一部だけ重なるフラグメントで捨てたデータグラム数
+	uint32 if_overlaps;
+	//! スロットやバッファが足りずに捨てたフラグメント数
+	uint32 if_nobufs;
+	//! 不正な長さやオフセットで捨てたフラグメント数
+	uint32 if_badfrags;
+	//! フラグメント化して送信したデータグラム数
+	uint32 if_fragged;
+	//! 送信したフラグメント数
+	uint32 if_fragsout;
+};
+
+//! フラグメント化と再構築の統計情報
+extern struct ipfragstat ipfragstats;
@@ -71,6 +71,14 @@ typedef int32 status;
 //! 空文字
 #define NULLSTR ""
 
+/**
+ * @def containerof(ptr, type, member)
+ * @brief 構造体typeのメンバmemberへのポインタptrから、それを含む構造体へのポインタを求める。
+ * @note 侵入型（intrusive）コンテナのノードから、ノードを埋め込んだ構造体を取り出すために用いる。
+ */
+#define containerof(ptr, type, member) \
+	((type *)((char *)(ptr) - (uint32) & ((type *)0)->member))
+
 /* Universal return constants */
 
 //! 処理が成功した場合
@@ -58,6 +58,44 @@ struct memblk
 	uint32 mlength;
 };
 
+#ifdef MEMTRACK
+#ifndef MT_NENT
+//! 追跡できる割り当て済みメモリブロックの最大数
+#define MT_NENT 512
+#endif
+
+//! 追跡エントリの種別：getmem()で割り当てたヒープブロック
+#define MT_HEAP 0
+//! 追跡エントリの種別：getstk()で割り当てたスタックブロック
+#define MT_STACK 1
+
+/**
+ * @struct memtrack
+ * @brief 割り当て済みメモリブロックの所有者情報（MEMTRACK定義時のみ有効）
+ * @note ブロックの最下位アドレスをキーとするハッシュ表（線形探索法）で管理する。
+ */
+struct memtrack
+{
+	//! ブロックの最下位アドレス（未使用エントリはNULL）
+	char *mtaddr;
+	//! ブロックサイズ（8の倍数に丸めた値、Byte）
+	uint32 mtlength;
+	//! getmem()／getstk()の呼び出し元アドレス
+	uint32 mtpc;
+	//! 割り当て時刻（起動からの秒数）
+	uint32 mttime;
+	//! 割り当てたプロセスのID
+	int16 mtpid;
+	//! ブロックの種別（MT_HEAP／MT_STACK）
+	byte mtkind;
+};
+
+//! 割り当て済みメモリブロックの追跡テーブル
+extern struct memtrack memtrktab[];
+//! 追跡テーブルが満杯で記録できなかった割り当ての回数
+extern uint32 mtdropped;
+#endif
+
 //! フリーメモリリストの先頭
 extern struct memblk memlist;
 //! ヒープの開始地点
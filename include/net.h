@@ -43,6 +43,17 @@ struct	netpacket	{
 	  uint16	net_icseq;	/* ICMP sequence number		*/
 	  byte		net_icdata[1500-28];/* ICMP payload (1500-above)*/
 	 };
+	 struct {
+	  uint16	net_tcpsport;	/* TCP source protocol port	*/
+	  uint16	net_tcpdport;	/* TCP destination protocol port*/
+	  uint32	net_tcpseq;	/* TCP sequence number		*/
+	  uint32	net_tcpack;	/* TCP acknowledgement number	*/
+	  uint16	net_tcpcode;	/* TCP header length and flags	*/
+	  uint16	net_tcpwindow;	/* TCP receive window		*/
+	  uint16	net_tcpcksum;	/* TCP checksum			*/
+	  uint16	net_tcpurgptr;	/* TCP urgent pointer		*/
+	  byte		net_tcpdata[1500-40];/* TCP options and payload	*/
+	 };
 	};
 };
 #pragma pack()
@@ -67,3 +78,46 @@ struct	network	{			/* Network information		*/
 };
 
 extern	struct	network NetData;	/* Local Network Interface info	*/
+
+/* Input queues: netin sorts arriving frames into NETIQS queues, and	*/
+/*   each queue has a worker process with a priority of its own, so	*/
+/*   a burst of low-value traffic does not delay important packets	*/
+
+#ifndef	NETIQS
+#define	NETIQS		3		/* Number of input queues	*/
+#endif
+#ifndef	NETIQ_SIZ
+#define	NETIQ_SIZ	32		/* Packets per input queue (a	*/
+#endif					/*   power of 2)		*/
+#define	NETIQ_RULES	16		/* Max. classification rules	*/
+
+#define	NETIQ_HIGH	0		/* Queue for control traffic	*/
+#define	NETIQ_NORMAL	1		/* Queue for unmatched frames	*/
+#define	NETIQ_LOW	2		/* Queue for bulk traffic	*/
+
+/* Keys of classification rules; when several rules match a frame,	*/
+/*   the rule with the most specific (largest) key wins		*/
+
+#define	NETIQ_ETHTYPE	1		/* Value is an Ethernet type	*/
+#define	NETIQ_IPPROTO	2		/* Value is an IP protocol	*/
+#define	NETIQ_DSCP	3		/* Value is an IP DSCP		*/
+#define	NETIQ_UDPPORT	4		/* Value is a UDP dest. port	*/
+
+struct	netiqrule	{		/* Classification rule		*/
+	byte	nr_key;			/* NETIQ_ETHTYPE, etc.		*/
+	byte	nr_queue;		/* Queue for matching frames	*/
+	uint16	nr_value;		/* Value the key must have	*/
+};
+
+struct	netiq	{			/* Input queue			*/
+	struct	ringbuf	niq_rg;		/* Frames (netin puts, the	*/
+					/*   worker gets)		*/
+	void	*niq_buf[NETIQ_SIZ];	/* Storage for niq_rg		*/
+	sid32	niq_sem;		/* Count of frames in the queue	*/
+	pid32	niq_pid;		/* Worker process		*/
+	uint32	niq_pkts;		/* Frames enqueued		*/
+	uint32	niq_drops;		/* Frames dropped (queue full)	*/
+	uint32	niq_maxdepth;		/* Largest depth seen		*/
+};
+
+extern	struct	netiq	netiqs[];
@@ -0,0 +1,53 @@
+/* pktbuf.h - pb_buf, pb_data, pb_len, pb_next, pb_headroom,	*/
+/*	      pb_tailroom						*/
+
+/* Every network buffer starts with a pktbuf header, followed by	*/
+/*   PB_HEADROOM spare bytes and then the frame itself.  Most come	*/
+/*   from netbufpool and have room for PACKLEN bytes of frame;	*/
+/*   reassembled datagrams come from a pool of larger buffers, so	*/
+/*   the header records how much room its frame has.  The		*/
+/*   stack passes the frame (a struct netpacket *) between layers,	*/
+/*   so the header overlay works as before, and the pktbuf header	*/
+/*   records which part of the frame holds valid data.  A layer	*/
+/*   that sends pushes its header in front of the data, and a	*/
+/*   layer that receives pulls its header off.			*/
+/*									*/
+/* The Ethernet driver receives frames into these buffers by DMA,	*/
+/*   so a frame must not share a cache line with anything the CPU	*/
+/*   writes meanwhile.  The pool starts on a cache line, the pool	*/
+/*   ID that getbuf stores in front of a buffer and the pktbuf	*/
+/*   header together fill one line, and the frame is rounded up	*/
+/*   to whole lines, so every frame covers lines of its own.	*/
+
+#define	PB_HEADROOM	(ARMV7A_DCACHE_LINE - sizeof(bpid32) -		\
+			 2 * sizeof(char *) - 3 * sizeof(int32))
+					/* Bytes before the Ethernet	*/
+					/*   header			*/
+
+struct	pktbuf	{			/* Header of a network buffer	*/
+	char	*pb_data;		/* First byte of valid data	*/
+	int32	pb_len;			/* Number of bytes of valid data*/
+	int32	pb_size;		/* Bytes of room for the frame	*/
+	int32	pb_ref;			/* Number of references; shared	*/
+					/*   buffers must not be changed*/
+	struct	netpacket *pb_next;	/* Next fragment of a datagram	*/
+					/*   sent as a chain, or NULL	*/
+	byte	pb_head[PB_HEADROOM];	/* Room to prepend headers	*/
+};
+
+#define	PB_FRAMESIZ	((PACKLEN + ARMV7A_DCACHE_LINE - 1) &		\
+			 ~(ARMV7A_DCACHE_LINE - 1))
+#define	PB_BUFSIZ	(sizeof(struct pktbuf) + PB_FRAMESIZ)
+
+/* Find the header of the buffer that holds a frame */
+
+#define	pb_buf(pkt)	(((struct pktbuf *)(pkt)) - 1)
+
+/* Valid data of a frame and the space around it */
+
+#define	pb_data(pkt)	(pb_buf(pkt)->pb_data)
+#define	pb_len(pkt)	(pb_buf(pkt)->pb_len)
+#define	pb_next(pkt)	(pb_buf(pkt)->pb_next)
+#define	pb_headroom(pkt) (pb_data(pkt) - (char *)pb_buf(pkt)->pb_head)
+#define	pb_tailroom(pkt) ((char *)(pkt) + pb_buf(pkt)->pb_size -	\
+				(pb_data(pkt) + pb_len(pkt)))
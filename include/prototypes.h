@@ -12,8 +12,13 @@ extern int32 am335x_eth_init(struct ethcblk *);
 /* in file arp.c */
 extern void arp_init(void);
 extern status arp_resolve(uint32, byte[]);
+extern status arp_hold(struct netpacket *, uint32);
 extern void arp_in(struct arppacket *);
-extern int32 arp_alloc(void);
+extern int32 arp_alloc(uint32);
+extern status arp_add(uint32, byte *);
+extern status arp_delete(uint32);
+extern void arp_announce(void);
+extern process arptimer(void);
 extern void arp_ntoh(struct arppacket *);
 extern void arp_hton(struct arppacket *);
 
@@ -23,6 +28,22 @@ extern status ascdate(uint32, char *);
 /* in file bufinit.c */
 extern status bufinit(void);
 
+/* in file cache.c */
+extern void cache_clean(void *, uint32);
+extern void cache_inval(void *, uint32);
+extern void cache_flush(void *, uint32);
+extern void cache_invalall(void);
+
+/* in file cksum.c */
+extern uint16 cksum_fold(uint32);
+extern uint32 cksum_partial(char *, int32, uint32);
+extern uint16 cksum(char *, int32);
+extern uint32 cksum_copy(char *, char *, int32, uint32);
+extern uint32 cksum_combine(uint32, uint32, int32);
+extern uint32 cksum_pseudo(uint32, uint32, byte, uint16);
+extern uint16 cksum_update16(uint16, uint16, uint16);
+extern uint16 cksum_update32(uint16, uint32, uint32);
+
 /* in file chprio.c */
 extern pri16 chprio(pid32, pri16);
 
@@ -54,7 +75,10 @@ extern void ctxsw(void *, void *);
 extern uint32 getlocalip(void);
 
 /* in file dns.c */
+extern void dns_init(void);
 extern uint32 dnslookup(char *);
+extern status dns_flush(char *);
+extern process dnsd(void);
 
 /* in file dot2ip.c */
 extern uint32 dot2ip(char *, uint32 *);
@@ -70,9 +94,20 @@ extern interrupt ethhandler(uint32);
 
 /* in file ethread.c */
 extern int32 ethread(struct dentry *, void *, uint32);
+extern uint32 ethrxnext(struct ethcblk *);
+extern void ethrxarm(struct ethcblk *, uint32, char *);
+
+/* in file ethrxswap.c */
+extern int32 ethrxswap(struct ethcblk *, char **);
 
 /* in file ethwrite.c */
 extern int32 ethwrite(struct dentry *, void *, uint32);
+extern int32 ethtxsg(struct ethcblk *, struct ethframe *, int32);
+extern int32 ethtxprep(struct ethcblk *, struct ethframe *, int32, int32 *);
+extern void ethtxlink(struct ethcblk *, uint32, int32);
+
+/* in file ethwritev.c */
+extern int32 ethwritev(struct ethcblk *, struct ethframe *, int32);
 
 /* in file evec.c */
 
@@ -96,6 +131,9 @@ extern char *getbuf(bpid32);
 /* in file getc.c */
 extern syscall getc(did32);
 
+/* in file getdmamem.c */
+extern char *getdmamem(uint32);
+
 /* in file getitem.c */
 extern pid32 getfirst(qid16);
 extern pid32 getlast(qid16);
@@ -179,24 +217,55 @@ extern devcall ionull(void);
 /* in file ip.c */
 extern void ip_in(struct netpacket *);
 extern status ip_send(struct netpacket *);
+extern int32 ip_sendmany(struct netpacket *[], int32);
 extern void ip_local(struct netpacket *);
 extern status ip_out(struct netpacket *);
+extern status ip_push(struct netpacket *, byte, uint32);
 extern int32 ip_route(uint32);
 extern uint16 ipcksum(struct netpacket *);
 extern void ip_ntoh(struct netpacket *);
 extern void ip_hton(struct netpacket *);
 extern process ipout(void);
 extern status ip_enqueue(struct netpacket *);
+extern void ip_oqinit(void);
+extern status ip_oqconfig(int32, int32, int32, int32);
+extern status ip_oqmap(byte, int32);
+
+/* in file ipfrag.c */
+extern void ip_fraginit(void);
+extern struct netpacket *ip_reasm(struct netpacket *);
+extern status ip_sendfrags(byte, uint32, byte, char *, int32, char *, int32);
 
 /* in file net.c */
 extern void net_init(void);
-extern process netin(void);
+extern process netin(did32);
+extern void net_demux(struct netpacket *);
 extern process netout(void);
 extern process rawin(void);
 extern void eth_hton(struct netpacket *);
 extern void eth_ntoh(struct netpacket *);
 extern uint16 getport(void);
 
+/* in file netiq.c */
+extern void netiq_init(void);
+extern status netiq_add(byte, uint16, int32);
+extern status netiq_setprio(int32, pri16);
+extern void netiq_in(struct netpacket *);
+extern process netiq_worker(int32);
+
+/* in file pktbuf.c */
+extern struct netpacket *pb_alloc(void);
+extern void pb_init(struct netpacket *, int32);
+extern status pb_free(struct netpacket *);
+extern void pb_freechain(struct netpacket *);
+extern struct netpacket *pb_clone(struct netpacket *);
+extern struct netpacket *pb_unshare(struct netpacket *);
+extern status pb_reserve(struct netpacket *, int32);
+extern char *pb_put(struct netpacket *, int32);
+extern char *pb_push(struct netpacket *, int32);
+extern char *pb_pull(struct netpacket *, int32);
+extern status pb_trim(struct netpacket *, int32);
+
 /* in file kill.c */
 extern syscall kill(pid32);
 
@@ -299,9 +368,19 @@ extern int32 *memcmp(void *, const void *, int32);
 /* in file memset.c */
 extern void *memset(void *, const int, int32);
 
+/* in file memtrack.c */
+extern void mtadd(char *, uint32, uint32, byte);
+extern void mtremove(char *, uint32);
+extern int32 mtreport(pid32);
+extern void mtowner(char *, uint32, pid32);
+extern void mtclear(pid32);
+
 /* in file mkbufpool.c */
 extern bpid32 mkbufpool(int32, int32);
 
+/* in file mmuinit.c */
+extern void mmuinit(void);
+
 /* in file mount.c */
 extern syscall mount(char *, char *, did32);
 extern int32 namlen(char *, int32);
@@ -551,6 +630,19 @@ extern int32 insw(int32, int32, int32);
 /* in file suspend.c */
 extern syscall suspend(pid32);
 
+/* in file tcp.c */
+extern void tcp_init(void);
+extern int32 tcp_listen(uint16);
+extern int32 tcp_accept(int32, uint32);
+extern int32 tcp_connect(uint32, uint16);
+extern int32 tcp_send(int32, char *, int32);
+extern int32 tcp_recv(int32, char *, int32, uint32);
+extern status tcp_close(int32);
+extern void tcp_in(struct netpacket *);
+extern process tcptimer(void);
+extern void tcp_ntoh(struct netpacket *);
+extern void tcp_hton(struct netpacket *);
+
 /* in file ttycontrol.c */
 extern devcall ttycontrol(struct dentry *, int32, int32, int32);
 
@@ -588,9 +680,16 @@ extern void udp_in(struct netpacket *);
 extern uid32 udp_register(uint32, uint16, uint16);
 extern int32 udp_recv(uid32, char *, int32, uint32);
 extern int32 udp_recvaddr(uid32, uint32 *, uint16 *, char *, int32, uint32);
+extern int32 udp_recviov(uid32, uint32 *, uint16 *, struct udpiov *, int32, uint32);
+extern status udp_recvbuf(uid32, struct netpacket **, char **, int32 *, uint32);
+extern status udp_releasebuf(struct netpacket *);
 extern status udp_send(uid32, char *, int32);
 extern status udp_sendto(uid32, uint32, uint16, char *, int32);
+extern int32 udp_sendmany(uid32, struct udpmsg *, int32);
+extern int32 udp_recvmany(uid32, struct udpmsg *, int32, uint32);
 extern status udp_release(uid32);
+extern status udp_setcksum(uid32, int32);
+extern status udp_setdscp(uid32, byte);
 extern void udp_ntoh(struct netpacket *);
 extern void udp_hton(struct netpacket *);
 
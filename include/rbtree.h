@@ -0,0 +1,61 @@
+/**
+ * @file rbtree.h
+ * @brief 侵入型（intrusive）の赤黒木に関する構造体／定数を定義する。
+ * @details ノード（struct rbnode）は格納したい構造体に埋め込むため、木の操作でメモリの割り当ては発生しない。<br>
+ * ノードは32bitのキー（rbkey）の昇順に並び、同じキーのノードは挿入した順に並ぶ。
+ * 挿入／削除／検索はO(log n)で行える。
+ */
+
+//! 赤ノード
+#define RB_RED 0
+//! 黒ノード
+#define RB_BLACK 1
+
+/**
+ * @struct rbnode
+ * @brief 赤黒木に格納する構造体に埋め込むノード
+ * @details 挿入前にrbkeyを設定する。格納されている間はrbkeyを変更してはならない。
+ */
+struct rbnode
+{
+	//! 左の子ノード（キーが小さい側）
+	struct rbnode *rbleft;
+	//! 右の子ノード（キーが大きい側）
+	struct rbnode *rbright;
+	//! 親ノード（根の場合はNULL）
+	struct rbnode *rbparent;
+	//! ノードの色（RB_RED／RB_BLACK）
+	int32 rbcolor;
+	//! 順序を決めるキー
+	uint32 rbkey;
+};
+
+/**
+ * @struct rbtree
+ * @brief 赤黒木の管理情報
+ */
+struct rbtree
+{
+	//! 根ノード（空の場合はNULL）
+	struct rbnode *rbroot;
+	//! 格納されているノード数
+	uint32 rbcount;
+};
+
+/**
+ * @def rb_isempty(rt)
+ * @brief 赤黒木が空であればTRUEを返す。
+ * @param[in] rt 赤黒木
+ */
+#define rb_isempty(rt) ((rt)->rbroot == NULL)
+
+/* in file rbtree.c */
+extern void rb_init(struct rbtree *);
+extern void rb_insert(struct rbtree *, struct rbnode *);
+extern void rb_remove(struct rbtree *, struct rbnode *);
+extern struct rbnode *rb_find(struct rbtree *, uint32);
+extern struct rbnode *rb_ceil(struct rbtree *, uint32);
+extern struct rbnode *rb_first(struct rbtree *);
+extern struct rbnode *rb_last(struct rbtree *);
+extern struct rbnode *rb_next(struct rbnode *);
+extern struct rbnode *rb_prev(struct rbnode *);
@@ -0,0 +1,51 @@
+/**
+ * @file ringbuf.h
+ * @brief 単一生産者／単一消費者（SPSC）のリングバッファに関する構造体／マクロを定義する。
+ * @details 格納領域（ポインタの配列、長さは2のべき乗）は呼び出し側が用意する。<br>
+ * 生産者だけがrghead、消費者だけがrgtailを書き換えるため、生産者と消費者が一つずつであれば
+ * 割り込みの禁止なしに、例えば割り込みハンドラ（生産者）とプロセス（消費者）の間で使用できる。<br>
+ * インデックスは剰余を取らずに増やし続け、配列の添字にはマスクを掛けて用いる。
+ */
+
+/**
+ * @struct ringbuf
+ * @brief リングバッファの管理情報
+ */
+struct ringbuf
+{
+	//! 格納領域（長さは2のべき乗）
+	void **rgbuf;
+	//! 格納領域の長さ - 1（添字を求めるマスク）
+	uint32 rgmask;
+	//! 次に書き込む位置（生産者のみが更新する）
+	volatile uint32 rghead;
+	//! 次に読み込む位置（消費者のみが更新する）
+	volatile uint32 rgtail;
+};
+
+/**
+ * @def rg_count(rg)
+ * @brief リングバッファに格納されている要素数を返す。
+ * @param[in] rg リングバッファ
+ */
+#define rg_count(rg) ((rg)->rghead - (rg)->rgtail)
+
+/**
+ * @def rg_isempty(rg)
+ * @brief リングバッファが空であればTRUEを返す。
+ * @param[in] rg リングバッファ
+ */
+#define rg_isempty(rg) ((rg)->rghead == (rg)->rgtail)
+
+/**
+ * @def rg_isfull(rg)
+ * @brief リングバッファが満杯であればTRUEを返す。
+ * @param[in] rg リングバッファ
+ */
+#define rg_isfull(rg) (rg_count(rg) > (rg)->rgmask)
+
+/* in file ringbuf.c */
+extern status rg_init(struct ringbuf *, void **, uint32);
+extern status rg_put(struct ringbuf *, void *);
+extern void *rg_get(struct ringbuf *);
+extern void *rg_peek(struct ringbuf *);
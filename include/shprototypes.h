@@ -19,9 +19,15 @@ extern	shellcmd  xsh_date	(int32, char *[]);
 /* in file xsh_devdump.c */
 extern	shellcmd  xsh_devdump	(int32, char *[]);
 
+/* in file xsh_dns.c */
+extern	shellcmd  xsh_dns		(int32, char *[]);
+
 /* in file xsh_echo.c */
 extern	shellcmd  xsh_echo	(int32, char *[]);
 
+/* in file xsh_eloop.c */
+extern	shellcmd  xsh_eloop	(int32, char *[]);
+
 /* in file xsh_ethstat.c */
 extern	shellcmd  xsh_ethstat	(int32, char *[]);
 
@@ -40,6 +46,9 @@ extern	shellcmd  xsh_ls	(int32,	char *[]);
 /* in file xsh_led.c */
 extern	shellcmd  xsh_led	(int32, char *[]);
 
+/* in file xsh_membench.c */
+extern	shellcmd  xsh_membench	(int32, char *[]);
+
 /* in file xsh_memdump.c */
 extern	shellcmd  xsh_memdump	(int32, char *[]);
 
@@ -61,6 +70,12 @@ extern	shellcmd  xsh_ps	(int32, char *[]);
 /* in file xsh_sleep.c */
 extern	shellcmd  xsh_sleep	(int32, char *[]);
 
+/* in file xsh_tcptest.c */
+extern	shellcmd  xsh_tcptest	(int32, char *[]);
+
+/* in file xsh_tftp.c */
+extern	shellcmd  xsh_tftp	(int32, char *[]);
+
 /* in file xsh_udpdump.c */
 extern	shellcmd  xsh_udpdump	(int32, char *[]);
 
@@ -13,6 +13,8 @@ int atoi(char *);
 long atol(char *);
 void bzero(void *, int);
 void qsort(char *, unsigned int, int, int (*)(void));
+void qsort_rec(char *, unsigned int, int, int);
+void qsort_u32(unsigned int *, unsigned int);
 int rand(void);
 void srand(unsigned int);
 void *malloc(unsigned int nbytes);
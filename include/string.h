@@ -2,8 +2,10 @@
 
 extern	char	*strncpy(char *, const char *, int32);
 extern	char	*strncat(char *, const char *, int32);
+extern	int	strcmp(char *, char *);
 extern	int32	strncmp(const char *, const char *, int32);
 extern	char	*strchr(const char *, int32);
+extern	void	*memchr(const void *, int32, int32);
 extern	char	*strrchr(const char *, int32);
 extern	char	*strstr(const char *, const char *);
 extern	int32	strnlen(const char *, uint32);
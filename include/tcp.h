@@ -0,0 +1,161 @@
+/* tcp.h - Declarations pertaining to Transmission Control Protocol (TCP) */
+
+#ifndef	TCP_SLOTS
+#define	TCP_SLOTS	8		/* Connections and listeners	*/
+#endif
+#ifndef	TCP_SBSIZ
+#define	TCP_SBSIZ	16384		/* Send buffer per connection	*/
+#endif					/*   (a power of two)		*/
+#ifndef	TCP_RBSIZ
+#define	TCP_RBSIZ	16384		/* Receive buffer per connection*/
+#endif					/*   (a power of two, < 64K)	*/
+#define	TCP_OOOSIZ	8		/* Out-of-order segments held	*/
+					/*   per connection		*/
+#define	TCP_BACKLOG	4		/* Connections a listener holds	*/
+					/*   until they are accepted	*/
+
+#define	TCP_HDR_LEN	20		/* Bytes in a TCP header without*/
+					/*   options			*/
+#define	TCP_MSS		(ETH_MTU - IP_HDR_LEN - TCP_HDR_LEN)
+					/* Largest segment we receive	*/
+#define	TCP_DEFMSS	536		/* Peer MSS if it sends none	*/
+
+/* Timers, in milliseconds; tcptimer runs every TCP_TICK ms and counts	*/
+/*   the timers of each connection down				*/
+
+#define	TCP_TICK	10		/* Timer granularity		*/
+#define	TCP_RTOINIT	1000		/* RTO before an RTT is measured*/
+#define	TCP_RTOMIN	200		/* Lower bound of the RTO	*/
+#define	TCP_RTOMAX	60000		/* Upper bound of the RTO	*/
+#define	TCP_DELACK	100		/* Longest an ACK is delayed	*/
+#define	TCP_TWAIT	2000		/* Time spent in TIME-WAIT	*/
+#define	TCP_FW2TIME	30000		/* Time a closed connection	*/
+					/*   waits in FIN-WAIT-2	*/
+#define	TCP_MAXRETX	8		/* Retransmissions before a	*/
+					/*   connection is dropped	*/
+
+/* Flags in the low bits of net_tcpcode; the top 4 bits are the	*/
+/*   header length in 32-bit words					*/
+
+#define	TCPF_FIN	0x01		/* No more data from sender	*/
+#define	TCPF_SYN	0x02		/* Synchronize sequence numbers	*/
+#define	TCPF_RST	0x04		/* Reset the connection		*/
+#define	TCPF_PSH	0x08		/* Push				*/
+#define	TCPF_ACK	0x10		/* Acknowledgement is valid	*/
+#define	TCPF_URG	0x20		/* Urgent pointer is valid	*/
+
+/* Constants for the state of an entry */
+
+#define	TCPS_FREE	0		/* Entry is unused		*/
+#define	TCPS_CLOSED	1		/* Connection is gone; the user	*/
+					/*   has not closed the entry	*/
+#define	TCPS_LISTEN	2		/* Waiting for connections	*/
+#define	TCPS_SYNSENT	3		/* Active open, SYN sent	*/
+#define	TCPS_SYNRCVD	4		/* Passive open, SYN received	*/
+#define	TCPS_ESTABLISHED 5		/* Data can flow both ways	*/
+#define	TCPS_FINWAIT1	6		/* Closed by us, FIN not acked	*/
+#define	TCPS_FINWAIT2	7		/* Closed by us, FIN acked	*/
+#define	TCPS_CLOSEWAIT	8		/* Closed by the peer		*/
+#define	TCPS_CLOSING	9		/* Both closed, our FIN unacked	*/
+#define	TCPS_LASTACK	10		/* Peer closed first, then us	*/
+#define	TCPS_TIMEWAIT	11		/* Both closed, waiting for	*/
+					/*   stray segments		*/
+
+/* Comparisons of sequence numbers modulo 2^32 */
+
+#define	SEQ_LT(a, b)	((int32)((a) - (b)) < 0)
+#define	SEQ_LEQ(a, b)	((int32)((a) - (b)) <= 0)
+#define	SEQ_GT(a, b)	((int32)((a) - (b)) > 0)
+#define	SEQ_GEQ(a, b)	((int32)((a) - (b)) >= 0)
+
+struct	tcb	{			/* Entry in the TCP table	*/
+	int32	tb_state;		/* State of the entry (TCPS_)	*/
+	uint32	tb_remip;		/* Remote IP address		*/
+	uint16	tb_remport;		/* Remote protocol port number	*/
+	uint16	tb_locport;		/* Local protocol port number	*/
+	bool8	tb_user;		/* A process holds the entry	*/
+	bool8	tb_queued;		/* On its listener's accept	*/
+					/*   queue			*/
+	int32	tb_parent;		/* Listener that created the	*/
+					/*   entry, or -1		*/
+	int32	tb_error;		/* SYSERR once reset or timed	*/
+					/*   out, otherwise OK		*/
+	pid32	tb_rpid;		/* Process waiting to receive,	*/
+					/*   connect or accept, or -1	*/
+	pid32	tb_spid;		/* Process waiting to send, or -1*/
+
+	/* Send side */
+
+	uint32	tb_iss;			/* Initial send sequence number	*/
+	uint32	tb_suna;		/* Oldest unacknowledged seq.	*/
+	uint32	tb_snxt;		/* Next sequence number to send	*/
+	uint32	tb_smax;		/* Highest sequence number sent	*/
+	uint32	tb_swnd;		/* Window the peer advertised	*/
+	uint32	tb_smss;		/* Largest segment we send	*/
+	uint32	tb_cwnd;		/* Congestion window		*/
+	uint32	tb_ssthresh;		/* Slow-start threshold		*/
+	uint32	tb_recover;		/* snxt when fast recovery began*/
+	int32	tb_dupacks;		/* Duplicate ACKs in a row	*/
+	bool8	tb_inrecovery;		/* In fast recovery		*/
+	bool8	tb_finq;		/* Send a FIN after the data	*/
+	bool8	tb_finsent;		/* The FIN has been sent	*/
+	bool8	tb_finacked;		/* The FIN has been acknowledged*/
+	uint32	tb_finseq;		/* Sequence number of the FIN	*/
+	char	*tb_sbuf;		/* Send buffer: unacknowledged	*/
+					/*   and unsent data		*/
+	int32	tb_sbstart;		/* Index of the byte at tb_suna	*/
+	int32	tb_sblen;		/* Bytes in the send buffer	*/
+
+	/* Round-trip time and timers */
+
+	int32	tb_srtt;		/* Smoothed RTT (ms), 0 if none	*/
+	int32	tb_rttvar;		/* RTT variation (ms)		*/
+	int32	tb_rto;			/* Retransmission timeout (ms)	*/
+	bool8	tb_rtting;		/* A segment is being timed	*/
+	uint32	tb_rttseq;		/* Sequence number being timed	*/
+	uint32	tb_rttstart;		/* When it was sent (ms)	*/
+	int32	tb_rxtimer;		/* ms to retransmission or a	*/
+					/*   window probe, 0 if off	*/
+	int32	tb_acktimer;		/* ms to a delayed ACK, 0 if off*/
+	int32	tb_twtimer;		/* ms left in TIME-WAIT or	*/
+					/*   FIN-WAIT-2, 0 if off	*/
+	int32	tb_nretx;		/* Retransmissions in a row	*/
+
+	/* Receive side */
+
+	uint32	tb_irs;			/* Initial receive seq. number	*/
+	uint32	tb_rnxt;		/* Next sequence number expected*/
+	char	*tb_rbuf;		/* Receive buffer		*/
+	int32	tb_rbstart;		/* Index of the next byte to read*/
+	int32	tb_rblen;		/* Bytes in the receive buffer	*/
+	uint32	tb_radv;		/* Right edge of the window we	*/
+					/*   last advertised		*/
+	bool8	tb_finrcvd;		/* The peer's FIN has arrived	*/
+	int32	tb_unacked;		/* Segments received since the	*/
+					/*   last ACK we sent		*/
+	int32	tb_nooo;		/* Segments in tb_ooo		*/
+	struct	netpacket *tb_ooo[TCP_OOOSIZ];/* Out-of-order segments	*/
+
+	/* Listener */
+
+	int32	tb_nacc;		/* Connections ready to accept	*/
+	int32	tb_acceptq[TCP_BACKLOG];/* Their slots, oldest first	*/
+};
+
+extern	struct	tcb	tcbtab[];
+extern	sid32	tcpmutex;		/* Protects tcbtab and tcpstats	*/
+
+struct	tcpstat	{			/* TCP statistics		*/
+	uint32	ts_segsin;		/* Segments received		*/
+	uint32	ts_segsout;		/* Segments sent		*/
+	uint32	ts_ckdrop;		/* Segments dropped because of	*/
+					/*   a bad checksum or header	*/
+	uint32	ts_rexmit;		/* Retransmission timeouts	*/
+	uint32	ts_fastrexmit;		/* Fast retransmissions		*/
+	uint32	ts_ooo;			/* Out-of-order segments held	*/
+	uint32	ts_resets;		/* Resets sent			*/
+	uint32	ts_drops;		/* Connections dropped after	*/
+					/*   TCP_MAXRETX retransmissions*/
+};
+
+extern	struct	tcpstat	tcpstats;
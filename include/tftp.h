@@ -6,6 +6,7 @@
 #define TFTP_DATA  3   /* Data Packet     */
 #define TFTP_ACK   4   /* Acknowledgement */
 #define TFTP_ERROR 5   /* Error           */
+#define TFTP_OACK  6   /* Option Acknowledgement (RFC 2347) */
 
 /* TFTP Error Codes */
 #define TFTP_ERROR_NOT_DEFINED         0  /* Not defined, see error message (if any). */
@@ -16,6 +17,7 @@
 #define TFTP_ERROR_UNKNOWN_TRANSFER_ID 5  /* Unknown transfer ID.                     */
 #define TFTP_ERROR_FILE_EXISTS         6  /* File already exists.                     */
 #define TFTP_ERROR_NO_SUCH_USER        7  /* No such user.                            */
+#define TFTP_ERROR_OPTION              8  /* Option negotiation refused (RFC 2347).   */
 
 #define TFTP_PORT       69      /* UDP Port for TFTP            */
 #define	TFTP_MAXNAM	    64      /* Max length of a file name    */
@@ -23,6 +25,18 @@
 #define	TFTP_MAXRETRIES	3       /* Number of retranmissions     */
 #define	TFTP_WAIT       5000    /* Time to wait for reply (ms)  */
 
+/* Options requested by tftpget_mb (RFC 2348 and 7440); a server that	*/
+/*   does not know them sends 512-byte blocks one at a time		*/
+#ifndef	TFTP_BLKSIZE
+#define	TFTP_BLKSIZE    1428    /* Block size to ask for        */
+#endif
+#ifndef	TFTP_WINDOW
+#define	TFTP_WINDOW     8       /* Blocks per ACK to ask for    */
+#endif
+#define	TFTP_MINBLKSIZE 8       /* Smallest legal block size    */
+#define	TFTP_MAXBLKSIZE (UDP_MAXDATA - 4) /* Largest block in one frame */
+#define	TFTP_MAXWINDOW  UDP_QSIZ /* Largest window the UDP queue holds */
+
 /* Xinu Specific Flags */
 #define TFTP_NON_VERBOSE 0  /* Do not use verbose output */
 #define TFTP_VERBOSE     1  /* Use verbose output        */
@@ -37,7 +51,8 @@ struct	tftp_msg {
 	 /* Items in a RRQ or WRQ message */
 
 	 struct	{
-	  char	tf_filemode[TFTP_MAXNAM+10]; /* file name and mode	*/
+	  char	tf_filemode[TFTP_MAXNAM+48]; /* file name, mode and	*/
+					     /*   options		*/
 	 };
 
 	 /* Items in a Data packet */
@@ -64,4 +79,5 @@ struct	tftp_msg {
 #pragma pack()
 
 status tftpget(uint32 serverip, const char* filename, char* rcv_buf, uint32 rcv_buf_size, byte verbose);
-status tftpget_mb(uint32 serverip, const char* filename, char** rcv_bufs, uint32* rcv_buf_sizes, uint32 rcv_buf_count, byte verbose);
\ No newline at end of file
+status tftpget_mb(uint32 serverip, const char* filename, char** rcv_bufs, uint32* rcv_buf_sizes, uint32 rcv_buf_count, byte verbose);
+status tftpget_opt(uint32 serverip, const char* filename, char** rcv_bufs, uint32* rcv_buf_sizes, uint32 rcv_buf_count, int32 blksize, int32 windowsize, byte verbose);
\ No newline at end of file
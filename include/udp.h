@@ -1,8 +1,14 @@
 /* udp.h - Declarations pertaining to User Datagram Protocol (UDP) */
 
+#ifndef	UDP_SLOTS
 #define	UDP_SLOTS	6 		/* Number of open UDP endpoints */
+#endif
 #define	UDP_QSIZ	8		/* Packets enqueued per endpoint*/
 
+#ifndef	UDP_HSIZ
+#define	UDP_HSIZ	64		/* Buckets in the endpoint hash	*/
+#endif					/*   table (a power of two)	*/
+
 #define	UDP_DHCP_CPORT	68		/* Port number for DHCP client	*/
 #define	UDP_DHCP_SPORT	67		/* Port number for DHCP server	*/
 
@@ -16,6 +22,15 @@
 					/*   interface on the machine	*/
 
 #define UDP_HDR_LEN	8		/* Bytes in a UDP header	*/
+#define	UDP_MAXDATA	(ETH_MTU - IP_HDR_LEN - UDP_HDR_LEN)
+					/* Most data in one frame; more	*/
+					/*   is sent as IP fragments	*/
+
+/* Checksum options for an endpoint (see udp_setcksum) */
+
+#define	UDP_CKSUM_TX	0x01		/* Compute checksum on output	*/
+#define	UDP_CKSUM_RX	0x02		/* Verify checksum on input	*/
+#define	UDP_CKSUM_ALL	(UDP_CKSUM_TX | UDP_CKSUM_RX)
 
 struct	udpentry {			/* Entry in the UDP endpoint tbl*/
 	int32	udstate;		/* State of entry: free/used	*/
@@ -27,7 +42,43 @@ struct	udpentry {			/* Entry in the UDP endpoint tbl*/
 	int32	udtail;			/* Index of next slot to insert	*/
 	int32	udcount;		/* Count of packets enqueued	*/
 	pid32	udpid;			/* ID of waiting process	*/
+	int32	udnext;			/* Next entry on the hash chain	*/
+					/*   or the free list, or -1	*/
+	uint32	udrecvd;		/* Datagrams enqueued		*/
+	uint32	uddrop;			/* Datagrams dropped because the*/
+					/*   queue was full		*/
+	int32	udcksum;		/* Checksum options (UDP_CKSUM_)*/
+	byte	uddscp;			/* DSCP of outgoing datagrams;	*/
+					/*   selects the output class	*/
+	uint32	udckdrop;		/* Datagrams dropped because of	*/
+					/*   a bad checksum or length	*/
 	struct	netpacket *udqueue[UDP_QSIZ];/* Circular packet queue	*/
 };
 
 extern	struct	udpentry udptab[];
+extern	sid32	udpmutex;		/* Protects udptab and udpstats	*/
+
+struct	udpmsg	{			/* One message of a batch	*/
+	uint32	um_remip;		/* Remote IP address		*/
+	uint16	um_remport;		/* Remote protocol port		*/
+	char	*um_buf;		/* UDP data			*/
+	int32	um_len;			/* Length of UDP data		*/
+};
+
+struct	udpiov	{			/* One buffer of a scatter list	*/
+	char	*iov_base;		/* Start of the buffer		*/
+	int32	iov_len;		/* Length of the buffer		*/
+};
+
+struct	udpstat	{			/* UDP statistics		*/
+	uint32	us_ckdrop;		/* Datagrams dropped because of	*/
+					/*   a bad checksum or length	*/
+	uint32	us_nocksum;		/* Datagrams received without a	*/
+					/*   checksum (field is zero)	*/
+	uint32	us_nomatch;		/* Datagrams for which no	*/
+					/*   endpoint was registered	*/
+	uint32	us_qdrop;		/* Datagrams dropped because an	*/
+					/*   endpoint queue was full	*/
+};
+
+extern	struct	udpstat udpstats;
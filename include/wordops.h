@@ -0,0 +1,32 @@
+/**
+ * @file wordops.h
+ * @brief 文字列／メモリ操作関数（lib/）が4Byte（ワード）単位で処理するためのマクロを定義する。
+ * @details ワード単位の処理は、読み書きするアドレスが4Byte境界に揃っている場合に限って行う
+ * （-mno-unaligned-accessでビルドされるため）。<br>
+ * ポインタの境界からのずれは下位2bitのみを見るため、unsigned longに変換して求める
+ * （ARMでは32bit、ホストでテストする場合はポインタと同じ幅になる）。
+ */
+
+/**
+ * @def HASZERO(w)
+ * @brief ワードwの4Byteの中に0x00のByteがあれば0以外、なければ0となる。
+ */
+#define HASZERO(w) (((w) - 0x01010101) & ~(w) & 0x80808080)
+
+/**
+ * @def WREPEAT(c)
+ * @brief 1Byteの値cを4Byteに複製したワードを返す（HASZERO(w ^ WREPEAT(c))でcを含むワードを探せる）。
+ */
+#define WREPEAT(c) ((unsigned int)(unsigned char)(c) * 0x01010101)
+
+/**
+ * @def WMISALIGN(p)
+ * @brief ポインタpの4Byte境界からのずれ（0〜3）を返す。
+ */
+#define WMISALIGN(p) ((unsigned int)((unsigned long)(p) & 3))
+
+/**
+ * @def WSAMEALIGN(p, q)
+ * @brief ポインタpとqの4Byte境界からのずれが同じであれば0以外を返す（揃えた後に両方をワード単位で扱える）。
+ */
+#define WSAMEALIGN(p, q) ((((unsigned long)(p) ^ (unsigned long)(q)) & 3) == 0)
@@ -4,6 +4,7 @@
  */
 
 #include <kernel.h>
+#include <armv7a.h>
 #include <conf.h>
 #include <process.h>
 #include <queue.h>
@@ -11,6 +12,9 @@
 #include <semaphore.h>
 #include <memory.h>
 #include <bufpool.h>
+#include <hashmap.h>
+#include <rbtree.h>
+#include <ringbuf.h>
 #include <clock.h>
 #include <mark.h>
 #include <ports.h>
@@ -26,12 +30,15 @@
 #include <lfilesys.h>
 #include <spi.h>
 #include <ether.h>
+#include <ethloop.h>
 #include <net.h>
+#include <pktbuf.h>
 #include <ip.h>
 #include <arp.h>
 #include <udp.h>
 #include <dhcp.h>
 #include <icmp.h>
+#include <tcp.h>
 #include <tftp.h>
 #include <name.h>
 #include <shell.h>
@@ -43,4 +50,3 @@
 #include <am335x_control.h>
 #include <am335x_eth.h>
 #include <am335x_watchdog.h>
-#include <armv7a.h>
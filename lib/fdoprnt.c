@@ -1,60 +1,101 @@
-/* fdoprnt.c - _fdoprnt, _prtl2, _prtl8, _prtl10, _prtX16, _prtl16 */
+/* fdoprnt.c - _fdoprnt, _prtu10, _prtubase, _prtdbl, _prflush, _prputs, _prfill */
 
 #include <stdarg.h>
 
-#define	MAXSTR	80
-#define NULL    0
-
-static void _prtl10(long num, char *str);
-static void _prtl8(long num, char *str);
-static void _prtX16(long num, char *str);
-static void _prtl16(long num, char *str);
-static void _prtl2(long num, char *str);
+#define	MAXSTR		80	/* Largest field width honored		*/
+#define	NULL		0
+#define	PRECISION	6	/* Default number of digits for %f	*/
+#define	MAXPREC		9	/* Largest number of digits for %f	*/
+#define	PRBUFSIZ	128	/* Size of the local output buffer	*/
+#define	NUMSTR		40	/* Size of the number conversion area	*/
+
+/*
+ * Output state for one call of _fdoprnt.  Characters are collected in
+ * pbbuf and handed to the output function a buffer at a time, so a
+ * typical printf turns into a single device write.
+ */
+struct	prbuf	{
+	char	*pbnext;		/* Next free byte in pbbuf	*/
+	int	pbcount;		/* Characters produced so far	*/
+	int	pberror;		/* Nonzero if a flush failed	*/
+	int	(*pbfunc)(int, char *, int);	/* Flush function	*/
+	int	pbarg;			/* First argument to pbfunc	*/
+	char	pbbuf[PRBUFSIZ];	/* Output characters		*/
+};
+
+/* Two ASCII digits for each value 0 - 99, used to convert decimals	*/
+/* two digits per division instead of one				*/
+
+static const char _prdigits[] =
+	"00010203040506070809101112131415161718192021222324252627282930"
+	"31323334353637383940414243444546474849505152535455565758596061"
+	"62636465666768697071727374757677787980818283848586878889909192"
+	"93949596979899";
+
+static char *_prtu10(unsigned long num, char *end);
+static char *_prtubase(unsigned long num, int shift, const char *digits,
+			int mindig, char *end);
+static char *_prtdbl(double num, int precision, char *end);
+static void _prflush(struct prbuf *pb);
+static void _prputs(struct prbuf *pb, const char *s, int n);
+static void _prfill(struct prbuf *pb, char c, int n);
 
 /*------------------------------------------------------------------------
- *  _fdoprnt  -  Format and write output using 'func' to write characters.
- *				 (Patched for Sun3 by Shawn Ostermann.)
- *				 All arguments passed as 4 bytes, long==int.
+ *  _fdoprnt  -  Format output into a local buffer and pass the buffer to
+ *			'func' whenever it fills and once at the end.
+ *			'func' is called as (*func)(farg, buf, len) and
+ *			returns a negative value if it fails.  Returns the
+ *			number of characters produced, or -1 if any call
+ *			of 'func' failed.  All arguments passed as 4 bytes,
+ *			long==int.
  *------------------------------------------------------------------------
  */
-void	_fdoprnt(
+int	_fdoprnt(
 	  char		*fmt,			/* format string	*/
 	  va_list	ap,			/* ap list of values	*/
-	  int		(*func)(int, int),	/* char output function	*/
-	  int		farg			/* arg for char output	*/
+	  int		(*func)(int, char *, int), /* buffer output fcn	*/
+	  int		farg			/* arg for buffer output*/
 	)
 {
-    int c;
-    int i;
+    struct prbuf pb;            /* Output buffer and its state          */
+    char *run;                  /* Start of a run of literal characters */
     int f;                      /* The format character (comes after %) */
     char *str;                  /* Running pointer in string            */
-    char string[20];            /* The string str points to this output */
+    char string[NUMSTR];        /* Area for converted numbers           */
+    char *end;                  /* End of the number conversion area    */
 
-    /*  from number conversion              */
     int length;                 /* Length of string "str"               */
     char fill;                  /* Fill character (' ' or '0')          */
     int leftjust;               /* 0 = right-justified, else left-just  */
     int fmax, fmin;             /* Field specifications % MIN . MAX s   */
     int leading;                /* No. of leading/trailing fill chars   */
     char sign;                  /* Set to '-' for negative decimals     */
-    char digit1;                /* Offset to add to first numeric digit */
     long larg;
+    double darg;
+
+    pb.pbnext = pb.pbbuf;
+    pb.pbcount = 0;
+    pb.pberror = 0;
+    pb.pbfunc = func;
+    pb.pbarg = farg;
+    end = &string[NUMSTR - 1];
+    *end = '\0';
 
     for (;;)
     {
-        /* Echo characters until '%' or end of fmt string */
-        while ((c = *fmt++) != '%')
+        /* Copy characters up to the next '%' as one run */
+        for (run = fmt; *fmt != '%' && *fmt != '\0'; fmt++)
+        {;
+        }
+        _prputs(&pb, run, fmt - run);
+        if (*fmt++ == '\0')
         {
-            if (c == '\0')
-            {
-                return;
-            }
-            (*func) (farg, c);
+            break;
         }
         /* Echo "...%%..." as '%' */
         if (*fmt == '%')
         {
-            (*func) (farg, *fmt++);
+            _prputs(&pb, fmt++, 1);
             continue;
         }
         /* Check for "%-..." == Left-justified output */
@@ -70,7 +111,6 @@ void	_fdoprnt(
         if (*fmt == '*')
         {
             fmin = va_arg(ap, int);
-
             ++fmt;
         }
         else
@@ -80,7 +120,7 @@ void	_fdoprnt(
                 fmin = fmin * 10 + *fmt++ - '0';
             }
         }
-        /* Allow for maximum string width for %s */
+        /* Allow for maximum string width for %s, digits for %f */
         fmax = 0;
         if (*fmt == '.')
         {
@@ -98,19 +138,20 @@ void	_fdoprnt(
             }
         }
 
-        str = string;
         if ((f = *fmt++) == '\0')
         {
-            (*func) (farg, '%');
-            return;
+            _prputs(&pb, "%", 1);
+            break;
         }
         sign = '\0';            /* sign == '-' for negative decimal */
+        str = end;
 
         switch (f)
         {
         case 'c':
             string[0] = va_arg(ap, int);
             string[1] = '\0';
+            str = string;
             fmax = 0;
             fill = ' ';
             break;
@@ -131,59 +172,79 @@ void	_fdoprnt(
             if (larg < 0)
             {
                 sign = '-';
-                larg = -larg;
+                str = _prtu10(-(unsigned long)larg, end);
+            }
+            else
+            {
+                str = _prtu10(larg, end);
             }
-            _prtl10(larg, str);
+            fmax = 0;
             break;
 
-        case 'u':
-            digit1 = '\0';
-            /* "negative" longs in unsigned format  */
-            /* can't be computed with long division */
-            /* convert *args to "positive", digit1  */
-            /* = how much to add back afterwards    */
-            larg = va_arg(ap, long);
+        case 'f':
+            darg = va_arg(ap, double);
 
-            while (larg < 0)
+            if (darg < 0)
             {
-                larg -= 1000000000L;
-                ++digit1;
+                sign = '-';
+                darg = -darg;
             }
-            _prtl10(larg, str);
-            str[0] += digit1;
+            if (fmax <= 0 || fmax > MAXPREC)
+            {
+                fmax = PRECISION;
+            }
+            str = _prtdbl(darg, fmax, end);
             fmax = 0;
             break;
 
-        case 'o':
-            larg = va_arg(ap, long);
+        case 'u':
+            str = _prtu10(va_arg(ap, unsigned long), end);
+            fmax = 0;
+            break;
 
-            _prtl8(larg, str);
+        case 'o':
+            str = _prtubase(va_arg(ap, unsigned long), 3, "01234567", 1, end);
             fmax = 0;
             break;
 
         case 'X':
-            larg = va_arg(ap, long);
-
-            _prtX16(larg, str);
+            str = _prtubase(va_arg(ap, unsigned long), 4,
+                            "0123456789ABCDEF", 1, end);
             fmax = 0;
             break;
 
         case 'x':
-            larg = va_arg(ap, long);
-
-            _prtl16(larg, str);
+            str = _prtubase(va_arg(ap, unsigned long), 4,
+                            "0123456789abcdef", 1, end);
             fmax = 0;
             break;
 
-        case 'b':
+        case 'H':
+        case 'h':
+            /* 64-bit value passed as high word, then low word */
             larg = va_arg(ap, long);
+            str = _prtubase(va_arg(ap, unsigned long), 4,
+                            (f == 'H') ? "0123456789ABCDEF"
+                                       : "0123456789abcdef",
+                            (larg != 0) ? 8 : 1, end);
+            if (larg != 0)
+            {
+                str = _prtubase(larg, 4,
+                                (f == 'H') ? "0123456789ABCDEF"
+                                           : "0123456789abcdef",
+                                1, str);
+            }
+            fmax = 0;
+            break;
 
-            _prtl2(larg, str);
+        case 'b':
+            str = _prtubase(va_arg(ap, unsigned long), 1, "01", 1, end);
             fmax = 0;
             break;
 
         default:
-            (*func) (farg, f);
+            string[0] = f;
+            _prputs(&pb, string, 1);
             break;
         }
         for (length = 0; str[length] != '\0'; length++)
@@ -197,20 +258,14 @@ void	_fdoprnt(
         {
             fmax = 0;
         }
+        if (fmax != 0 && length > fmax)
+        {
+            length = fmax;
+        }
         leading = 0;
-        if (fmax != 0 || fmin != 0)
+        if (fmin != 0)
         {
-            if (fmax != 0)
-            {
-                if (length > fmax)
-                {
-                    length = fmax;
-                }
-            }
-            if (fmin != 0)
-            {
-                leading = fmin - length;
-            }
+            leading = fmin - length;
             if (sign == '-')
             {
                 --leading;
@@ -218,154 +273,165 @@ void	_fdoprnt(
         }
         if (sign == '-' && fill == '0')
         {
-            (*func) (farg, sign);
+            _prputs(&pb, &sign, 1);
         }
         if (leftjust == 0)
         {
-            for (i = 0; i < leading; i++)
-            {
-                (*func) (farg, fill);
-            }
+            _prfill(&pb, fill, leading);
         }
         if (sign == '-' && fill == ' ')
         {
-            (*func) (farg, sign);
-        }
-        for (i = 0; i < length; i++)
-        {
-            (*func) (farg, str[i]);
+            _prputs(&pb, &sign, 1);
         }
+        _prputs(&pb, str, length);
         if (leftjust != 0)
         {
-            for (i = 0; i < leading; i++)
-                (*func) (farg, fill);
+            _prfill(&pb, fill, leading);
         }
     }
 
+    _prflush(&pb);
+    return (pb.pberror ? -1 : pb.pbcount);
 }
 
 /*------------------------------------------------------------------------
- *  _prtl10  -  Converts long to base 10 string.
+ *  _prflush  -  Pass the buffered characters to the output function.
  *------------------------------------------------------------------------
  */
-static void	_prtl10(
-		  long		num,
-		  char		*str
+static void	_prflush(
+		  struct prbuf	*pb
 		)
 {
-    int i;
-    char temp[11];
+    int len;
 
-    temp[0] = '\0';
-    for (i = 1; i <= 10; i++)
+    len = pb->pbnext - pb->pbbuf;
+    if (len > 0 && (*pb->pbfunc) (pb->pbarg, pb->pbbuf, len) < 0)
     {
-        temp[i] = num % 10 + '0';
-        num /= 10;
+        pb->pberror = 1;
     }
-    for (i = 10; temp[i] == '0'; i--);
-    if (i == 0)
-        i++;
-    while (i >= 0)
-        *str++ = temp[i--];
+    pb->pbnext = pb->pbbuf;
 }
 
 /*------------------------------------------------------------------------
- *  _prtl8  -  Converts long to base 8 string.
+ *  _prputs  -  Append n characters to the output buffer.
  *------------------------------------------------------------------------
  */
-static void	_prtl8(
-		  long		num,
-		  char		*str
+static void	_prputs(
+		  struct prbuf	*pb,
+		  const char	*s,
+		  int		n
 		)
 {
-    int i;
-    char temp[12];
+    char *bend = &pb->pbbuf[PRBUFSIZ];
 
-    temp[0] = '\0';
-    for (i = 1; i <= 11; i++)
+    pb->pbcount += n;
+    while (n-- > 0)
     {
-        temp[i] = (num & 07) + '0';
-        num = num >> 3;
+        if (pb->pbnext >= bend)
+        {
+            _prflush(pb);
+        }
+        *pb->pbnext++ = *s++;
     }
-    temp[11] &= '3';
-    for (i = 11; temp[i] == '0'; i--);
-    if (i == 0)
-        i++;
-    while (i >= 0)
-        *str++ = temp[i--];
 }
 
 /*------------------------------------------------------------------------
- *  _prtl16  -  Converts long to lowercase hex string.
+ *  _prfill  -  Append n copies of character c to the output buffer.
  *------------------------------------------------------------------------
  */
-static void	_prtl16(
-		  long		num,
-		  char		*str
+static void	_prfill(
+		  struct prbuf	*pb,
+		  char		c,
+		  int		n
 		)
 {
-    int i;
-    char temp[9];
-
-    temp[0] = '\0';
-    for (i = 1; i <= 8; i++)
+    while (n-- > 0)
     {
-        temp[i] = "0123456789abcdef"[num & 0x0F];
-        num = num >> 4;
+        _prputs(pb, &c, 1);
     }
-    for (i = 8; temp[i] == '0'; i--);
-    if (i == 0)
-        i++;
-    while (i >= 0)
-        *str++ = temp[i--];
 }
 
 /*------------------------------------------------------------------------
- *  _prtX16  -  Converts long to uppercase hex string.
+ *  _prtu10  -  Converts unsigned long to base 10 string that ends at
+ *			'end', two digits at a time.  Returns the first digit.
  *------------------------------------------------------------------------
  */
-static void	_prtX16(
-		  long		num,
-		  char		*str
+static char	*_prtu10(
+		  unsigned long	num,
+		  char		*end
 		)
 {
-    int i;
-    char temp[9];
+    const char *pair;
 
-    temp[0] = '\0';
-    for (i = 1; i <= 8; i++)
+    while (num >= 100)
     {
-        temp[i] = "0123456789ABCDEF"[num & 0x0F];
-        num = num >> 4;
+        pair = &_prdigits[(num % 100) * 2];
+        num /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
     }
-    for (i = 8; temp[i] == '0'; i--);
-    if (i == 0)
-        i++;
-    while (i >= 0)
-        *str++ = temp[i--];
+    if (num >= 10)
+    {
+        pair = &_prdigits[num * 2];
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    else
+    {
+        *--end = num + '0';
+    }
+    return end;
 }
 
 /*------------------------------------------------------------------------
- *  _prtl2  -  Converts long to binary string.
+ *  _prtubase  -  Converts unsigned long to a base 2, 8 or 16 string (1,
+ *			3 or 4 bits per digit) of at least 'mindig' digits
+ *			that ends at 'end'.  Returns the first digit.
  *------------------------------------------------------------------------
  */
-static void	_prtl2(
-		  long		num,
-		  char		*str
+static char	*_prtubase(
+		  unsigned long	num,
+		  int		shift,
+		  const char	*digits,
+		  int		mindig,
+		  char		*end
+		)
+{
+    unsigned long mask = (1 << shift) - 1;
+
+    do
+    {
+        *--end = digits[num & mask];
+        num >>= shift;
+    } while (--mindig > 0 || num != 0);
+    return end;
+}
+
+/*------------------------------------------------------------------------
+ *  _prtdbl  -  Converts non-negative double to a decimal string with
+ *			'precision' fractional digits that ends at 'end'.
+ *------------------------------------------------------------------------
+ */
+static char	*_prtdbl(
+		  double	num,
+		  int		precision,
+		  char		*end
 		)
 {
     int i;
-    char temp[35];
+    long mp;
+    unsigned long w, p;
+
+    for (i = 0, mp = 1; i < precision; i++, mp *= 10);
+
+    w = (unsigned long)(num);
+    p = (unsigned long)((num - w) * mp);
 
-    temp[0] = '\0';
-    for (i = 1; i <= 32; i++)
+    for (i = 0; i < precision; i++)
     {
-        temp[i] = ((num % 2) == 0) ? '0' : '1';
-        num = num >> 1;
+        *--end = p % 10 + '0';
+        p /= 10;
     }
-    for (i = 32; temp[i] == '0'; i--);
-    if (i == 0)
-        i++;
-    while (i >= 0)
-        *str++ = temp[i--];
+    *--end = '.';
+    return _prtu10(w, end);
 }
@@ -1,9 +1,10 @@
-/* fprintf.c - _fdoprnt */
+/* fprintf.c - fprintf, fprwrite */
 
 #include <xinu.h>
 #include <stdarg.h>
 
-extern void _fdoprnt(char *, va_list, int (*)(did32, char), int);
+extern int _fdoprnt(char *, va_list, int (*)(int, char *, int), int);
+static int fprwrite(int, char *, int);
 
 /*------------------------------------------------------------------------
  *  fprintf  -  Print a formatted message on specified device (file).
@@ -18,11 +19,25 @@ int	fprintf(
 	)
 {
     va_list ap;
-    int putc(did32, char);
+    int n;
 
     va_start(ap, fmt);
-    _fdoprnt(fmt, ap, putc, dev);
+    n = _fdoprnt(fmt, ap, fprwrite, dev);
     va_end(ap);
 
-    return 0;
+    return (n < 0) ? -1 : 0;
+}
+
+/*------------------------------------------------------------------------
+ *  fprwrite  -  Routine called by _fdoprnt to write a buffer of output
+ *			with a single device write.
+ *------------------------------------------------------------------------
+ */
+static int	fprwrite(
+		  int		dev,
+		  char		*buf,
+		  int		len
+		)
+{
+    return write(dev, buf, len);
 }
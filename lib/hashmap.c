@@ -0,0 +1,208 @@
+/**
+ * @file hashmap.c
+ * @brief 侵入型（intrusive）のオープンアドレス法ハッシュマップを提供する。
+ */
+#include <xinu.h>
+
+/**
+ * @brief 整数キーのハッシュ値を求める。
+ * @details 黄金比に基づく乗算で上位bitの変化を下位bitに行き渡らせる（連番のキーでも散らばる）。<br>
+ * 複数のフィールドからなるキーを持つテーブル（UDPエンドポイント、IPフラグメント）も、
+ * フィールドをXORで1ワードにまとめてから本関数でバケットを求める。
+ * @param[in] key 整数キー
+ * @return ハッシュ値
+ */
+uint32 hm_hashint(uint32 key)
+{
+    key *= 0x9E3779B1;
+    return key ^ (key >> 16);
+}
+
+/**
+ * @brief 文字列キーのハッシュ値をFNV-1aで求める。
+ * @param[in] key 文字列キー
+ * @return ハッシュ値
+ */
+local uint32 hm_hashstr(const char *key)
+{
+    uint32 hash = 2166136261U;
+
+    while (*key != NULLCH)
+    {
+        hash ^= (byte)*key++;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+/**
+ * @brief ハッシュマップを空の状態で初期化する。
+ * @param[out] hm 初期化するハッシュマップ
+ * @param[in] slots スロット配列（長さnslots、呼び出し側が用意する）
+ * @param[in] nslots スロット数（2のべき乗）
+ * @param[in] type キーの種類（HM_INT／HM_STR）
+ * @return 成功時はOK、スロット数が2のべき乗でない場合やキーの種類が不正な場合はSYSERRを返す。
+ */
+status hm_init(struct hashmap *hm, struct hmnode **slots, uint32 nslots, int32 type)
+{
+    uint32 i;
+
+    if ((nslots < 2) || ((nslots & (nslots - 1)) != 0) || ((type != HM_INT) && (type != HM_STR)))
+    {
+        return SYSERR;
+    }
+    for (i = 0; i < nslots; i++)
+    {
+        slots[i] = NULL;
+    }
+    hm->hmslot = slots;
+    hm->hmmask = nslots - 1;
+    hm->hmcount = 0;
+    hm->hmtype = type;
+    return OK;
+}
+
+/**
+ * @brief ノードをハッシュマップに挿入する。
+ * @details Step1. ノードのキーからハッシュ値を求め、ノードに記録する。<br>
+ * Step2. ハッシュ値が示すスロットから空きスロットまで線形に探索し、同じキーがあれば失敗とする。<br>
+ * Step3. 見つかった空きスロットにノードを格納する。
+ * @param[in,out] hm ハッシュマップ
+ * @param[in,out] node 挿入するノード（キーは設定済みであること）
+ * @return 成功時はOK、同じキーのノードが既にある場合や上限（hm_maxcount()）に達している場合はSYSERRを返す。
+ */
+status hm_insert(struct hashmap *hm, struct hmnode *node)
+{
+    uint32 i;
+    struct hmnode *cur;
+
+    if (hm->hmcount >= hm_maxcount(hm))
+    {
+        return SYSERR;
+    }
+    if (hm->hmtype == HM_INT)
+    {
+        node->hnhash = hm_hashint(node->hnikey);
+    }
+    else
+    {
+        node->hnhash = hm_hashstr(node->hnskey);
+    }
+
+    for (i = node->hnhash & hm->hmmask; (cur = hm->hmslot[i]) != NULL; i = (i + 1) & hm->hmmask)
+    {
+        if (cur->hnhash != node->hnhash)
+        {
+            continue;
+        }
+        if ((hm->hmtype == HM_INT) ? (cur->hnikey == node->hnikey) : (strcmp(cur->hnskey, node->hnskey) == 0))
+        {
+            return SYSERR;
+        }
+    }
+    hm->hmslot[i] = node;
+    hm->hmcount++;
+    return OK;
+}
+
+/**
+ * @brief ノードをハッシュマップから削除する。
+ * @details 削除したスロットより後ろにある同じ探索列のノードを前に詰め直すため、
+ * 削除を繰り返しても探索は長くならない。
+ * @param[in,out] hm ハッシュマップ
+ * @param[in] node 削除するノード
+ * @return 成功時はOK、ノードが格納されていない場合はSYSERRを返す。
+ */
+status hm_remove(struct hashmap *hm, struct hmnode *node)
+{
+    uint32 i, j, home;
+
+    for (i = node->hnhash & hm->hmmask; hm->hmslot[i] != node; i = (i + 1) & hm->hmmask)
+    {
+        if (hm->hmslot[i] == NULL)
+        {
+            return SYSERR;
+        }
+    }
+
+    /* Shift back later nodes whose probe sequence passes through i */
+
+    for (j = (i + 1) & hm->hmmask; hm->hmslot[j] != NULL; j = (j + 1) & hm->hmmask)
+    {
+        home = hm->hmslot[j]->hnhash & hm->hmmask;
+        if (((j - home) & hm->hmmask) >= ((j - i) & hm->hmmask))
+        {
+            hm->hmslot[i] = hm->hmslot[j];
+            i = j;
+        }
+    }
+    hm->hmslot[i] = NULL;
+    hm->hmcount--;
+    return OK;
+}
+
+/**
+ * @brief 整数キーに一致するノードを検索する。
+ * @param[in] hm ハッシュマップ（HM_INT）
+ * @param[in] key 整数キー
+ * @return 見つかった場合はノード、見つからなかった場合はNULLを返す。
+ */
+struct hmnode *hm_findint(struct hashmap *hm, uint32 key)
+{
+    uint32 hash, i;
+    struct hmnode *cur;
+
+    hash = hm_hashint(key);
+    for (i = hash & hm->hmmask; (cur = hm->hmslot[i]) != NULL; i = (i + 1) & hm->hmmask)
+    {
+        if (cur->hnikey == key)
+        {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 文字列キーに一致するノードを検索する。
+ * @param[in] hm ハッシュマップ（HM_STR）
+ * @param[in] key 文字列キー
+ * @return 見つかった場合はノード、見つからなかった場合はNULLを返す。
+ */
+struct hmnode *hm_findstr(struct hashmap *hm, const char *key)
+{
+    uint32 hash, i;
+    struct hmnode *cur;
+
+    hash = hm_hashstr(key);
+    for (i = hash & hm->hmmask; (cur = hm->hmslot[i]) != NULL; i = (i + 1) & hm->hmmask)
+    {
+        if ((cur->hnhash == hash) && (strcmp(cur->hnskey, (char *)key) == 0))
+        {
+            return cur;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief ハッシュマップに格納されているノードを順に返す（順序は不定）。
+ * @details 最初の呼び出しでは*indexに0を設定しておく。反復中にノードを挿入／削除してはならない。
+ * @param[in] hm ハッシュマップ
+ * @param[in,out] index 次に調べるスロット番号
+ * @return 次のノード、全て返し終えた場合はNULLを返す。
+ */
+struct hmnode *hm_next(struct hashmap *hm, uint32 *index)
+{
+    struct hmnode *cur;
+
+    while (*index <= hm->hmmask)
+    {
+        cur = hm->hmslot[(*index)++];
+        if (cur != NULL)
+        {
+            return cur;
+        }
+    }
+    return NULL;
+}
@@ -1,4 +1,45 @@
 /**
  * @file memchr.c
- * @brief 文字をNバイト中から検索する（本ファイルは空のため、何も提供しない）。
+ * @brief 文字をNバイト中から検索する。
  */
+#include <wordops.h>
+
+/**
+ * @brief 文字をNバイト中から検索する。
+ * @details 4Byte境界に揃えた後は、文字cを4Byteに複製したワードとのXORが
+ * 0x00のByteを含むワード（文字cを含むワード）を4Byteずつ探す。
+ * @param[in] s 検索対象のByteブロック
+ * @param[in] c 検索する文字（1Byteに変換して扱う）
+ * @param[in] n 検索するサイズ（Byte）
+ * @return 文字cが見つかった場合は最初に登場した位置を示すポインタ、見つからなかった場合はNULLを返す。
+ * @note ワードの読み込みは検索範囲内で完結するため、範囲外を読む事はない。
+ */
+void *memchr(const void *s, int c, int n)
+{
+    const unsigned char *p = s;
+    const unsigned int *w;
+    unsigned int cmask;
+
+    for (; (n > 0) && (WMISALIGN(p) != 0); n--, p++)
+    {
+        if (*p == (unsigned char)c)
+        {
+            return (void *)p;
+        }
+    }
+
+    cmask = WREPEAT(c);
+    for (w = (const unsigned int *)p; (n >= 4) && !HASZERO(*w ^ cmask); n -= 4)
+    {
+        w++;
+    }
+
+    for (p = (const unsigned char *)w; n > 0; n--, p++)
+    {
+        if (*p == (unsigned char)c)
+        {
+            return (void *)p;
+        }
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
  * @file memcmp.c
  * @brief Byteブロック2個に対して、先頭からN Byte分比較する。
  */
+#include <wordops.h>
 
 /*------------------------------------------------------------------------
  *  memcmp  -  Compare two equal-size blocks of memory.  If there are no
@@ -11,6 +12,8 @@
  */
 /**
  * @brief Byteブロック2個に対して、先頭からN Byte分比較する。
+ * @details 2個のブロックが同じ4Byte境界のずれを持つ場合は、先頭を揃えてから4Byte単位で比較し、
+ * 異なるワードが見つかった時点でByte単位の比較に切り替えて最初に異なるByteを求める。
  * @param[in] s1 Byteブロックその1
  * @param[in] s2 Byteブロックその2
  * @param[in] n 比較するサイズ（Byte）
@@ -18,10 +21,37 @@
  */
 int memcmp(const void *s1, const void *s2, int n)
 {
-    const unsigned char *c1;
-    const unsigned char *c2;
+    const unsigned char *c1 = s1;
+    const unsigned char *c2 = s2;
+    const unsigned int *w1;
+    const unsigned int *w2;
 
-    for (c1 = s1, c2 = s2; n > 0; n--, c1++, c2++)
+    if ((n >= 8) && WSAMEALIGN(c1, c2))
+    {
+        /* Compare the head bytes until both blocks are aligned */
+
+        for (; WMISALIGN(c1) != 0; n--, c1++, c2++)
+        {
+            if (*c1 != *c2)
+            {
+                return ((int)*c1) - ((int)*c2);
+            }
+        }
+
+        /* Skip over equal words; a differing word is resolved below */
+
+        w1 = (const unsigned int *)c1;
+        w2 = (const unsigned int *)c2;
+        for (; (n >= 4) && (*w1 == *w2); n -= 4)
+        {
+            w1++;
+            w2++;
+        }
+        c1 = (const unsigned char *)w1;
+        c2 = (const unsigned char *)w2;
+    }
+
+    for (; n > 0; n--, c1++, c2++)
     {
         if (*c1 != *c2)
         {
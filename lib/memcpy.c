@@ -2,21 +2,91 @@
  * @file memcpy.c
  * @brief メモリAの領域（source）からメモリBの領域（Destination）にN Byteコピーする。
  */
+#include <wordops.h>
 
 /**
  * @brief メモリAの領域（source）からメモリBの領域（Destination）にN Byteコピーする。
+ * @details
+ * Step1. コピーサイズが小さい場合は、1Byteずつコピーする。<br>
+ * Step2. コピー先が4Byte境界に揃うまで、先頭を1Byteずつコピーする。<br>
+ * Step3. コピー元も4Byte境界に揃っている場合は、32Byte単位（LDM/STM）、次に4Byte単位でコピーする。<br>
+ * 　　　 コピー元が揃っていない場合は、境界に揃った2ワードを読み込み、シフトで合成して4Byte単位で書き込む。<br>
+ * Step4. 残りの末尾を1Byteずつコピーする。
  * @param[in,out] s コピー先のアドレス（Destination address）
  * @param[in] ct コピー元のアドレス（Source address）
  * @param[in] n コピーサイズ（Byte）
  * @return コピー完了後のコピー先アドレス
+ * @note -mno-unaligned-accessでビルドされるため、ワード単位のアクセスは必ず4Byte境界で行う。<br>
+ * 境界に揃ったワードの読み込みはページを跨がないため、コピー元の範囲外のByteを読んでも安全である。
  */
 void *memcpy(void *s, const void *ct, int n)
 {
-    register int i;
     char *dst = (char *)s;
-    char *src = (char *)ct;
+    const char *src = (const char *)ct;
+    unsigned int *wdst;
+    const unsigned int *wsrc;
+    unsigned int w0, w1, shift;
 
-    for (i = 0; i < n; i++)
+    if (n < 16)
+    {
+        while (n-- > 0)
+        {
+            *dst++ = *src++;
+        }
+        return s;
+    }
+
+    /* Copy the head bytes until the destination is word aligned */
+
+    while (WMISALIGN(dst) != 0)
+    {
+        *dst++ = *src++;
+        n--;
+    }
+    wdst = (unsigned int *)dst;
+
+    if (WMISALIGN(src) == 0)
+    {
+        /* Both aligned: move 32-byte bursts, then single words */
+
+        wsrc = (const unsigned int *)src;
+#if defined(__arm__)
+        for (; n >= 32; n -= 32)
+        {
+            asm volatile("ldmia %1!, {r3-r10}\n\t"
+                         "stmia %0!, {r3-r10}"
+                         : "+r"(wdst), "+r"(wsrc)
+                         :
+                         : "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "memory");
+        }
+#endif
+        for (; n >= 4; n -= 4)
+        {
+            *wdst++ = *wsrc++;
+        }
+        src = (const char *)wsrc;
+    }
+    else
+    {
+        /* Source misaligned: merge two aligned loads per store	*/
+        /* (little-endian byte order)				*/
+
+        shift = WMISALIGN(src) * 8;
+        wsrc = (const unsigned int *)(src - (shift >> 3));
+        w0 = *wsrc++;
+        for (; n >= 4; n -= 4)
+        {
+            w1 = *wsrc++;
+            *wdst++ = (w0 >> shift) | (w1 << (32 - shift));
+            w0 = w1;
+        }
+        src = (const char *)wsrc - 4 + (shift >> 3);
+    }
+
+    /* Copy the tail bytes */
+
+    dst = (char *)wdst;
+    while (n-- > 0)
     {
         *dst++ = *src++;
     }
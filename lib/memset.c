@@ -2,9 +2,12 @@
  * @file memset.c
  * @brief 指定のByteブロックに対して、同じ値をNバイト分書き込む。
  */
+#include <wordops.h>
 
 /**
  * @brief 指定のByteブロックに対して、同じ値をNバイト分書き込む。
+ * @details 先頭を4Byte境界まで1Byteずつ書き込んだ後、値を4Byteに複製したワードを
+ * 32Byte単位（STM）、4Byte単位の順に書き込み、残りの末尾を1Byteずつ書き込む。
  * @param[in,out] s Byteブロックへのポインタ（例：文字列）
  * @param[in] c 書き込む値（1Byte）
  * @param[in] n 書き込むサイズ（Byte）
@@ -12,13 +15,50 @@
  */
 void *memset(void *s, int c, int n)
 {
-    register int i;
     char *cp = (char *)s;
+    unsigned int *wp;
+    unsigned int w;
 
-    for (i = 0; i < n; i++)
+    if (n >= 16)
     {
-        *cp = (unsigned char)c;
-        cp++;
+        /* Fill the head bytes until the pointer is word aligned */
+
+        while (WMISALIGN(cp) != 0)
+        {
+            *cp++ = (unsigned char)c;
+            n--;
+        }
+
+        /* Replicate the byte into a word and store whole words */
+
+        w = WREPEAT(c);
+        wp = (unsigned int *)cp;
+#if defined(__arm__)
+        for (; n >= 32; n -= 32)
+        {
+            asm volatile("mov r3, %1\n\t"
+                         "mov r4, %1\n\t"
+                         "mov r5, %1\n\t"
+                         "mov r6, %1\n\t"
+                         "stmia %0!, {r3-r6}\n\t"
+                         "stmia %0!, {r3-r6}"
+                         : "+r"(wp)
+                         : "r"(w)
+                         : "r3", "r4", "r5", "r6", "memory");
+        }
+#endif
+        for (; n >= 4; n -= 4)
+        {
+            *wp++ = w;
+        }
+        cp = (char *)wp;
+    }
+
+    /* Fill the tail bytes */
+
+    while (n-- > 0)
+    {
+        *cp++ = (unsigned char)c;
     }
     return s;
 }
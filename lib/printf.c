@@ -1,10 +1,11 @@
-/* printf.c - printf*/
+/* printf.c - printf, prwrite */
 
 #include <xinu.h>
 #include <stdio.h>
 #include <stdarg.h>
 
-extern void _fdoprnt(char *, va_list, int (*)(did32, char), int);
+extern int _fdoprnt(char *, va_list, int (*)(int, char *, int), int);
+static int prwrite(int, char *, int);
 
 /*------------------------------------------------------------------------
  *  printf  -  standard C printf function
@@ -16,11 +17,24 @@ int	printf(
 	)
 {
     va_list ap;
-    syscall putc(did32, char);
+    int n;
 
     va_start(ap, fmt);
-    _fdoprnt((char *)fmt, ap, putc, stdout);
+    n = _fdoprnt((char *)fmt, ap, prwrite, stdout);
     va_end(ap);
 
-    return 0;
+    return n;
+}
+
+/*------------------------------------------------------------------------
+ *  prwrite  -  Routine called by _fdoprnt to write a buffer of output.
+ *------------------------------------------------------------------------
+ */
+static int	prwrite(
+		  int		dev,
+		  char		*buf,
+		  int		len
+		)
+{
+    return write(dev, buf, len);
 }
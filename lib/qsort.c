@@ -1,127 +1,259 @@
-/* qsort.c - qsort, qs1, qsexc, qstexc */
+/* qsort.c - qsort, qsort_rec, qsort_u32, qsdepth, qs1, qscmp, qsexc, qsins, qsheap, qsift, qsu1, qsuins, qsuheap, qsusift */
 
-static int (*qscmp) (char *, char *);
-static int qses;
-static void qs1(char *, char *);
-static void qsexc(char *, char *);
-static void qstexc(char *, char *, char *);
+#define	NULL	0
+#define	QSMIN	16		/* Partitions at most this long are	*/
+				/*   finished with insertion sort	*/
+
+/* State shared by the generic sort routines for one call of qsort */
+
+struct	qsctx	{
+	int	(*qsfc)(char *, char *);/* Comparison function, or NULL	*/
+	int	qskey;			/* Offset of uint32 key if NULL	*/
+	int	qses;			/* Size of an element		*/
+	int	qswords;		/* Nonzero to swap words	*/
+};
+
+static void qs1(struct qsctx *, char *, unsigned, int);
+static int qscmp(struct qsctx *, char *, char *);
+static void qsexc(struct qsctx *, char *, char *);
+static void qsins(struct qsctx *, char *, unsigned);
+static void qsheap(struct qsctx *, char *, unsigned);
+static void qsift(struct qsctx *, char *, unsigned, unsigned);
+static void qsu1(unsigned int *, unsigned, int);
+static void qsuins(unsigned int *, unsigned);
+static void qsuheap(unsigned int *, unsigned);
+static void qsusift(unsigned int *, unsigned, unsigned);
+
+/*------------------------------------------------------------------------
+ *  qsdepth  -  Compute the recursion depth allowed before an introsort
+ *		  switches to heapsort (2 * floor(log2(n)))
+ *------------------------------------------------------------------------
+ */
+static int	qsdepth(
+		  unsigned	n
+		)
+{
+    int depth;
+
+    for (depth = 0; n > 1; n >>= 1)
+    {
+        depth += 2;
+    }
+    return depth;
+}
 
 /*------------------------------------------------------------------------
- *  qsort  -  Use quicksort to sort an array
+ *  qsort  -  Sort an array with introsort: quicksort on a median-of-
+ *		  three pivot, heapsort once the recursion gets too deep,
+ *		  and insertion sort for short partitions
  *------------------------------------------------------------------------
  */
 void	qsort(
 	  char		*a,		/* Array to sort		*/
 	  unsigned	n,		/* Length of the array		*/
-	  int		es,		/* Pivot value			*/
+	  int		es,		/* Size of an element		*/
 	  int		(*fc)(char *, char *)	/* Comparison function	*/
 	)
 {
-    qscmp = fc;
-    qses = es;
-    qs1(a, a + n * es);
+    struct qsctx qs;
+
+    if (n < 2 || es <= 0)
+    {
+        return;
+    }
+    qs.qsfc = fc;
+    qs.qskey = 0;
+    qs.qses = es;
+    qs.qswords = ((((unsigned int)a | (unsigned int)es) & 3) == 0);
+    qs1(&qs, a, n, qsdepth(n));
+}
+
+/*------------------------------------------------------------------------
+ *  qsort_rec  -  Sort an array of fixed-size records in ascending order
+ *		  of the unsigned 32-bit key found at byte offset 'key' of
+ *		  each record, without calling a comparison function.  The
+ *		  array, the record size and the key offset must all be
+ *		  multiples of 4.
+ *------------------------------------------------------------------------
+ */
+void	qsort_rec(
+	  char		*a,		/* Array to sort		*/
+	  unsigned	n,		/* Number of records		*/
+	  int		es,		/* Size of a record		*/
+	  int		key		/* Offset of the key in a record*/
+	)
+{
+    struct qsctx qs;
+
+    if (n < 2 || es <= 0)
+    {
+        return;
+    }
+    qs.qsfc = NULL;
+    qs.qskey = key;
+    qs.qses = es;
+    qs.qswords = 1;
+    qs1(&qs, a, n, qsdepth(n));
+}
+
+/*------------------------------------------------------------------------
+ *  qsort_u32  -  Sort an array of unsigned 32-bit values in ascending
+ *		  order
+ *------------------------------------------------------------------------
+ */
+void	qsort_u32(
+	  unsigned int	*a,		/* Array to sort		*/
+	  unsigned	n		/* Length of the array		*/
+	)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    qsu1(a, n, qsdepth(n));
 }
 
 /*------------------------------------------------------------------------
- *  qs1  -  internal quicksort function
+ *  qs1  -  internal introsort function; recurses on the smaller side
+ *		  and loops on the larger one
  *------------------------------------------------------------------------
  */
 static void	qs1(
+		  struct qsctx	*qs,
 		  char		*a,
-		  char		*l
+		  unsigned	n,
+		  int		depth
 		)
 {
     register char *i, *j;
     register int es;
-    char *lp, *hp;
-    int c;
-    unsigned n;
+    char *m, *l;
+    unsigned nl;
 
-    es = qses;
-
-  start:
-    if ((n = l - a) <= es)
-    {
-        return;
-    }
-    n = es * (n / (2 * es));
-    hp = lp = a + n;
-    i = a;
-    j = l - es;
-    for (;;)
+    es = qs->qses;
+    while (n > QSMIN)
     {
-        if (i < lp)
+        if (depth-- == 0)
         {
-            if ((c = (*qscmp) (i, lp)) == 0)
-            {
-                qsexc(i, lp -= es);
-                continue;
-            }
-            if (c < 0)
+            qsheap(qs, a, n);
+            return;
+        }
+
+        /* Move the median of first, middle and last to a[0] */
+
+        m = a + (n / 2) * es;
+        l = a + (n - 1) * es;
+        if (qscmp(qs, m, a) < 0)
+        {
+            qsexc(qs, m, a);
+        }
+        if (qscmp(qs, l, m) < 0)
+        {
+            qsexc(qs, l, m);
+            if (qscmp(qs, m, a) < 0)
             {
-                i += es;
-                continue;
+                qsexc(qs, m, a);
             }
         }
+        qsexc(qs, a, m);
+
+        /* Partition around a[0]; both scans stop on equal keys so */
+        /*   runs of duplicates are split evenly                   */
 
-      loop:
-        if (j > hp)
+        i = a;
+        j = a + n * es;
+        for (;;)
         {
-            if ((c = (*qscmp) (hp, j)) == 0)
+            do
             {
-                qsexc(hp += es, j);
-                goto loop;
+                i += es;
             }
-            if (c > 0)
+            while (i < j && qscmp(qs, i, a) < 0);
+            do
             {
-                if (i == lp)
-                {
-                    qstexc(i, hp += es, j);
-                    i = lp += es;
-                    goto loop;
-                }
-                qsexc(i, j);
                 j -= es;
-                i += es;
-                continue;
             }
-            j -= es;
-            goto loop;
+            while (qscmp(qs, j, a) > 0);
+            if (i >= j)
+            {
+                break;
+            }
+            qsexc(qs, i, j);
         }
+        qsexc(qs, a, j);
 
-        if (i == lp)
+        nl = (j - a) / es;
+        if (nl < n - nl - 1)
         {
-            if (lp - a >= l - hp)
-            {
-                qs1(hp + es, l);
-                l = lp;
-            }
-            else
-            {
-                qs1(a, lp);
-                a = hp + es;
-            }
-            goto start;
+            qs1(qs, a, nl, depth);
+            a = j + es;
+            n = n - nl - 1;
+        }
+        else
+        {
+            qs1(qs, j + es, n - nl - 1, depth);
+            n = nl;
         }
+    }
+    qsins(qs, a, n);
+}
 
-        qstexc(j, lp -= es, i);
-        j = hp -= es;
+/*------------------------------------------------------------------------
+ *  qscmp  -  internal function that compares two elements with the
+ *		  caller's function or, for qsort_rec, by their keys
+ *------------------------------------------------------------------------
+ */
+static int	qscmp(
+		  struct qsctx	*qs,
+		  char		*i,
+		  char		*j
+		)
+{
+    unsigned int ki, kj;
+
+    if (qs->qsfc != NULL)
+    {
+        return (*qs->qsfc) (i, j);
     }
+    ki = *(unsigned int *)(i + qs->qskey);
+    kj = *(unsigned int *)(j + qs->qskey);
+    return (ki > kj) - (ki < kj);
 }
 
 /*------------------------------------------------------------------------
- *  qsexc  -  internal quicksort function
+ *  qsexc  -  internal function that exchanges two elements, a word at
+ *		  a time when the array allows it
  *------------------------------------------------------------------------
  */
 static void	qsexc(
+		  struct qsctx	*qs,
 		  char		*i,
 		  char		*j
 		)
 {
     register char *ri, *rj, c;
+    register unsigned int *wi, *wj, w;
     int n;
 
-    n = qses;
+    if (i == j)
+    {
+        return;
+    }
+    if (qs->qswords)
+    {
+        n = qs->qses >> 2;
+        wi = (unsigned int *)i;
+        wj = (unsigned int *)j;
+        do
+        {
+            w = *wi;
+            *wi++ = *wj;
+            *wj++ = w;
+        }
+        while (--n);
+        return;
+    }
+    n = qs->qses;
     ri = i;
     rj = j;
     do
@@ -134,29 +266,232 @@ static void	qsexc(
 }
 
 /*------------------------------------------------------------------------
- *  qstexc  -  internal quicksort function
+ *  qsins  -  internal insertion sort for short partitions
  *------------------------------------------------------------------------
  */
-static void	qstexc(
-		  char		*i,
-		  char		*j,
-		  char		*k
+static void	qsins(
+		  struct qsctx	*qs,
+		  char		*a,
+		  unsigned	n
 		)
 {
-    register char *ri, *rj, *rk;
-    int c;
-    int n;
+    register char *i, *j;
+    int es;
+    char *l;
 
-    n = qses;
-    ri = i;
-    rj = j;
-    rk = k;
-    do
+    es = qs->qses;
+    l = a + n * es;
+    for (i = a + es; i < l; i += es)
     {
-        c = *ri;
-        *ri++ = *rk;
-        *rk++ = *rj;
-        *rj++ = c;
+        for (j = i; j > a && qscmp(qs, j - es, j) > 0; j -= es)
+        {
+            qsexc(qs, j - es, j);
+        }
     }
-    while (--n);
+}
+
+/*------------------------------------------------------------------------
+ *  qsheap  -  internal heapsort used when the recursion gets too deep
+ *------------------------------------------------------------------------
+ */
+static void	qsheap(
+		  struct qsctx	*qs,
+		  char		*a,
+		  unsigned	n
+		)
+{
+    unsigned k;
+
+    for (k = n / 2; k > 0; k--)
+    {
+        qsift(qs, a, k - 1, n);
+    }
+    for (k = n - 1; k > 0; k--)
+    {
+        qsexc(qs, a, a + k * qs->qses);
+        qsift(qs, a, 0, k);
+    }
+}
+
+/*------------------------------------------------------------------------
+ *  qsift  -  internal function that sifts element k down a heap of n
+ *------------------------------------------------------------------------
+ */
+static void	qsift(
+		  struct qsctx	*qs,
+		  char		*a,
+		  unsigned	k,
+		  unsigned	n
+		)
+{
+    unsigned c;
+    int es;
+
+    es = qs->qses;
+    while ((c = 2 * k + 1) < n)
+    {
+        if (c + 1 < n && qscmp(qs, a + c * es, a + (c + 1) * es) < 0)
+        {
+            c++;
+        }
+        if (qscmp(qs, a + k * es, a + c * es) >= 0)
+        {
+            return;
+        }
+        qsexc(qs, a + k * es, a + c * es);
+        k = c;
+    }
+}
+
+/*------------------------------------------------------------------------
+ *  qsu1  -  internal introsort function for unsigned 32-bit values
+ *------------------------------------------------------------------------
+ */
+static void	qsu1(
+		  unsigned int	*a,
+		  unsigned	n,
+		  int		depth
+		)
+{
+    register unsigned int *i, *j;
+    register unsigned int p;
+    unsigned int t;
+    unsigned nl;
+
+    while (n > QSMIN)
+    {
+        if (depth-- == 0)
+        {
+            qsuheap(a, n);
+            return;
+        }
+
+        /* Median of first, middle and last becomes the pivot */
+
+        i = &a[n / 2];
+        j = &a[n - 1];
+        if (*i < a[0])
+        {
+            t = *i; *i = a[0]; a[0] = t;
+        }
+        if (*j < *i)
+        {
+            t = *j; *j = *i; *i = t;
+            if (*i < a[0])
+            {
+                t = *i; *i = a[0]; a[0] = t;
+            }
+        }
+        p = *i;
+        *i = a[0];
+        a[0] = p;
+
+        i = a;
+        j = a + n;
+        for (;;)
+        {
+            while (++i < j && *i < p)
+                ;
+            while (*--j > p)
+                ;
+            if (i >= j)
+            {
+                break;
+            }
+            t = *i; *i = *j; *j = t;
+        }
+        a[0] = *j;
+        *j = p;
+
+        nl = j - a;
+        if (nl < n - nl - 1)
+        {
+            qsu1(a, nl, depth);
+            a = j + 1;
+            n = n - nl - 1;
+        }
+        else
+        {
+            qsu1(j + 1, n - nl - 1, depth);
+            n = nl;
+        }
+    }
+    qsuins(a, n);
+}
+
+/*------------------------------------------------------------------------
+ *  qsuins  -  internal insertion sort for unsigned 32-bit values
+ *------------------------------------------------------------------------
+ */
+static void	qsuins(
+		  unsigned int	*a,
+		  unsigned	n
+		)
+{
+    unsigned i, j;
+    unsigned int v;
+
+    for (i = 1; i < n; i++)
+    {
+        v = a[i];
+        for (j = i; j > 0 && a[j - 1] > v; j--)
+        {
+            a[j] = a[j - 1];
+        }
+        a[j] = v;
+    }
+}
+
+/*------------------------------------------------------------------------
+ *  qsuheap  -  internal heapsort for unsigned 32-bit values
+ *------------------------------------------------------------------------
+ */
+static void	qsuheap(
+		  unsigned int	*a,
+		  unsigned	n
+		)
+{
+    unsigned k;
+    unsigned int t;
+
+    for (k = n / 2; k > 0; k--)
+    {
+        qsusift(a, k - 1, n);
+    }
+    for (k = n - 1; k > 0; k--)
+    {
+        t = a[0]; a[0] = a[k]; a[k] = t;
+        qsusift(a, 0, k);
+    }
+}
+
+/*------------------------------------------------------------------------
+ *  qsusift  -  internal function that sifts a[k] down a heap of n
+ *		  unsigned 32-bit values
+ *------------------------------------------------------------------------
+ */
+static void	qsusift(
+		  unsigned int	*a,
+		  unsigned	k,
+		  unsigned	n
+		)
+{
+    unsigned c;
+    unsigned int v;
+
+    v = a[k];
+    while ((c = 2 * k + 1) < n)
+    {
+        if (c + 1 < n && a[c] < a[c + 1])
+        {
+            c++;
+        }
+        if (v >= a[c])
+        {
+            break;
+        }
+        a[k] = a[c];
+        k = c;
+    }
+    a[k] = v;
 }
@@ -0,0 +1,442 @@
+/**
+ * @file rbtree.c
+ * @brief 侵入型（intrusive）の赤黒木を提供する。
+ */
+#include <xinu.h>
+
+/**
+ * @brief ノードxを軸に左回転する（xの右の子がxの位置に上がる）。
+ * @param[in,out] rt 赤黒木
+ * @param[in,out] x 回転の軸となるノード
+ */
+local void rb_rotleft(struct rbtree *rt, struct rbnode *x)
+{
+    struct rbnode *y = x->rbright;
+
+    x->rbright = y->rbleft;
+    if (y->rbleft != NULL)
+    {
+        y->rbleft->rbparent = x;
+    }
+    y->rbparent = x->rbparent;
+    if (x->rbparent == NULL)
+    {
+        rt->rbroot = y;
+    }
+    else if (x == x->rbparent->rbleft)
+    {
+        x->rbparent->rbleft = y;
+    }
+    else
+    {
+        x->rbparent->rbright = y;
+    }
+    y->rbleft = x;
+    x->rbparent = y;
+}
+
+/**
+ * @brief ノードxを軸に右回転する（xの左の子がxの位置に上がる）。
+ * @param[in,out] rt 赤黒木
+ * @param[in,out] x 回転の軸となるノード
+ */
+local void rb_rotright(struct rbtree *rt, struct rbnode *x)
+{
+    struct rbnode *y = x->rbleft;
+
+    x->rbleft = y->rbright;
+    if (y->rbright != NULL)
+    {
+        y->rbright->rbparent = x;
+    }
+    y->rbparent = x->rbparent;
+    if (x->rbparent == NULL)
+    {
+        rt->rbroot = y;
+    }
+    else if (x == x->rbparent->rbright)
+    {
+        x->rbparent->rbright = y;
+    }
+    else
+    {
+        x->rbparent->rbleft = y;
+    }
+    y->rbright = x;
+    x->rbparent = y;
+}
+
+/**
+ * @brief 赤黒木を空の状態で初期化する。
+ * @param[out] rt 初期化する赤黒木
+ */
+void rb_init(struct rbtree *rt)
+{
+    rt->rbroot = NULL;
+    rt->rbcount = 0;
+}
+
+/**
+ * @brief ノードを赤黒木に挿入する。
+ * @details Step1. 二分探索木としてキーの位置に赤ノードとして挿入する（同じキーの場合は右側）。<br>
+ * Step2. 赤ノードが連続しないように、色の付け替えと回転で木を修正する。
+ * @param[in,out] rt 赤黒木
+ * @param[in,out] node 挿入するノード（rbkeyは設定済みであること）
+ */
+void rb_insert(struct rbtree *rt, struct rbnode *node)
+{
+    struct rbnode *parent, *cur, *gp, *uncle;
+
+    parent = NULL;
+    for (cur = rt->rbroot; cur != NULL;)
+    {
+        parent = cur;
+        cur = (node->rbkey < cur->rbkey) ? cur->rbleft : cur->rbright;
+    }
+    node->rbparent = parent;
+    node->rbleft = node->rbright = NULL;
+    node->rbcolor = RB_RED;
+    if (parent == NULL)
+    {
+        rt->rbroot = node;
+    }
+    else if (node->rbkey < parent->rbkey)
+    {
+        parent->rbleft = node;
+    }
+    else
+    {
+        parent->rbright = node;
+    }
+    rt->rbcount++;
+
+    /* Restore the red-black properties */
+
+    while (((parent = node->rbparent) != NULL) && (parent->rbcolor == RB_RED))
+    {
+        gp = parent->rbparent;
+        if (parent == gp->rbleft)
+        {
+            uncle = gp->rbright;
+            if ((uncle != NULL) && (uncle->rbcolor == RB_RED))
+            {
+                parent->rbcolor = uncle->rbcolor = RB_BLACK;
+                gp->rbcolor = RB_RED;
+                node = gp;
+                continue;
+            }
+            if (node == parent->rbright)
+            {
+                rb_rotleft(rt, parent);
+                node = parent;
+                parent = node->rbparent;
+            }
+            parent->rbcolor = RB_BLACK;
+            gp->rbcolor = RB_RED;
+            rb_rotright(rt, gp);
+        }
+        else
+        {
+            uncle = gp->rbleft;
+            if ((uncle != NULL) && (uncle->rbcolor == RB_RED))
+            {
+                parent->rbcolor = uncle->rbcolor = RB_BLACK;
+                gp->rbcolor = RB_RED;
+                node = gp;
+                continue;
+            }
+            if (node == parent->rbleft)
+            {
+                rb_rotright(rt, parent);
+                node = parent;
+                parent = node->rbparent;
+            }
+            parent->rbcolor = RB_BLACK;
+            gp->rbcolor = RB_RED;
+            rb_rotleft(rt, gp);
+        }
+    }
+    rt->rbroot->rbcolor = RB_BLACK;
+}
+
+/**
+ * @brief 部分木uの位置を部分木vで置き換える（uの親からの参照をvに付け替える）。
+ * @param[in,out] rt 赤黒木
+ * @param[in] u 置き換えられるノード
+ * @param[in,out] v 置き換えるノード（NULL可）
+ */
+local void rb_replace(struct rbtree *rt, struct rbnode *u, struct rbnode *v)
+{
+    if (u->rbparent == NULL)
+    {
+        rt->rbroot = v;
+    }
+    else if (u == u->rbparent->rbleft)
+    {
+        u->rbparent->rbleft = v;
+    }
+    else
+    {
+        u->rbparent->rbright = v;
+    }
+    if (v != NULL)
+    {
+        v->rbparent = u->rbparent;
+    }
+}
+
+/**
+ * @brief ノードを赤黒木から削除する。
+ * @details Step1. 子が二つある場合は、後続ノード（右部分木の最小ノード）をノードの位置に移す。<br>
+ * Step2. 黒ノードが抜けた場合は、黒の数が揃うように色の付け替えと回転で木を修正する。
+ * @param[in,out] rt 赤黒木
+ * @param[in] node 削除するノード（木に格納されていること）
+ */
+void rb_remove(struct rbtree *rt, struct rbnode *node)
+{
+    struct rbnode *x, *xparent, *y, *w;
+    int32 ycolor;
+
+    y = node;
+    ycolor = y->rbcolor;
+    if (node->rbleft == NULL)
+    {
+        x = node->rbright;
+        xparent = node->rbparent;
+        rb_replace(rt, node, x);
+    }
+    else if (node->rbright == NULL)
+    {
+        x = node->rbleft;
+        xparent = node->rbparent;
+        rb_replace(rt, node, x);
+    }
+    else
+    {
+        for (y = node->rbright; y->rbleft != NULL; y = y->rbleft)
+            ;
+        ycolor = y->rbcolor;
+        x = y->rbright;
+        if (y->rbparent == node)
+        {
+            xparent = y;
+        }
+        else
+        {
+            xparent = y->rbparent;
+            rb_replace(rt, y, x);
+            y->rbright = node->rbright;
+            y->rbright->rbparent = y;
+        }
+        rb_replace(rt, node, y);
+        y->rbleft = node->rbleft;
+        y->rbleft->rbparent = y;
+        y->rbcolor = node->rbcolor;
+    }
+    rt->rbcount--;
+
+    if (ycolor != RB_BLACK)
+    {
+        return;
+    }
+
+    /* x carries an extra black; push it up or resolve it */
+
+    while ((x != rt->rbroot) && ((x == NULL) || (x->rbcolor == RB_BLACK)))
+    {
+        if (x == xparent->rbleft)
+        {
+            w = xparent->rbright;
+            if (w->rbcolor == RB_RED)
+            {
+                w->rbcolor = RB_BLACK;
+                xparent->rbcolor = RB_RED;
+                rb_rotleft(rt, xparent);
+                w = xparent->rbright;
+            }
+            if (((w->rbleft == NULL) || (w->rbleft->rbcolor == RB_BLACK)) &&
+                ((w->rbright == NULL) || (w->rbright->rbcolor == RB_BLACK)))
+            {
+                w->rbcolor = RB_RED;
+                x = xparent;
+                xparent = x->rbparent;
+                continue;
+            }
+            if ((w->rbright == NULL) || (w->rbright->rbcolor == RB_BLACK))
+            {
+                w->rbleft->rbcolor = RB_BLACK;
+                w->rbcolor = RB_RED;
+                rb_rotright(rt, w);
+                w = xparent->rbright;
+            }
+            w->rbcolor = xparent->rbcolor;
+            xparent->rbcolor = RB_BLACK;
+            w->rbright->rbcolor = RB_BLACK;
+            rb_rotleft(rt, xparent);
+        }
+        else
+        {
+            w = xparent->rbleft;
+            if (w->rbcolor == RB_RED)
+            {
+                w->rbcolor = RB_BLACK;
+                xparent->rbcolor = RB_RED;
+                rb_rotright(rt, xparent);
+                w = xparent->rbleft;
+            }
+            if (((w->rbleft == NULL) || (w->rbleft->rbcolor == RB_BLACK)) &&
+                ((w->rbright == NULL) || (w->rbright->rbcolor == RB_BLACK)))
+            {
+                w->rbcolor = RB_RED;
+                x = xparent;
+                xparent = x->rbparent;
+                continue;
+            }
+            if ((w->rbleft == NULL) || (w->rbleft->rbcolor == RB_BLACK))
+            {
+                w->rbright->rbcolor = RB_BLACK;
+                w->rbcolor = RB_RED;
+                rb_rotleft(rt, w);
+                w = xparent->rbleft;
+            }
+            w->rbcolor = xparent->rbcolor;
+            xparent->rbcolor = RB_BLACK;
+            w->rbleft->rbcolor = RB_BLACK;
+            rb_rotright(rt, xparent);
+        }
+        x = rt->rbroot;
+        break;
+    }
+    if (x != NULL)
+    {
+        x->rbcolor = RB_BLACK;
+    }
+}
+
+/**
+ * @brief キーが一致するノードのうち、最初（最も前）のノードを検索する。
+ * @param[in] rt 赤黒木
+ * @param[in] key 検索するキー
+ * @return 見つかった場合はノード、見つからなかった場合はNULLを返す。
+ */
+struct rbnode *rb_find(struct rbtree *rt, uint32 key)
+{
+    struct rbnode *node;
+
+    node = rb_ceil(rt, key);
+    if ((node != NULL) && (node->rbkey == key))
+    {
+        return node;
+    }
+    return NULL;
+}
+
+/**
+ * @brief キーがkey以上であるノードのうち、最初のノードを検索する。
+ * @param[in] rt 赤黒木
+ * @param[in] key 検索するキー
+ * @return 見つかった場合はノード、全てのノードのキーがkeyより小さい場合はNULLを返す。
+ */
+struct rbnode *rb_ceil(struct rbtree *rt, uint32 key)
+{
+    struct rbnode *cur, *best;
+
+    best = NULL;
+    for (cur = rt->rbroot; cur != NULL;)
+    {
+        if (cur->rbkey >= key)
+        {
+            best = cur;
+            cur = cur->rbleft;
+        }
+        else
+        {
+            cur = cur->rbright;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief キーが最小のノードを返す。
+ * @param[in] rt 赤黒木
+ * @return 最初のノード、木が空の場合はNULLを返す。
+ */
+struct rbnode *rb_first(struct rbtree *rt)
+{
+    struct rbnode *cur;
+
+    if ((cur = rt->rbroot) == NULL)
+    {
+        return NULL;
+    }
+    while (cur->rbleft != NULL)
+    {
+        cur = cur->rbleft;
+    }
+    return cur;
+}
+
+/**
+ * @brief キーが最大のノードを返す。
+ * @param[in] rt 赤黒木
+ * @return 最後のノード、木が空の場合はNULLを返す。
+ */
+struct rbnode *rb_last(struct rbtree *rt)
+{
+    struct rbnode *cur;
+
+    if ((cur = rt->rbroot) == NULL)
+    {
+        return NULL;
+    }
+    while (cur->rbright != NULL)
+    {
+        cur = cur->rbright;
+    }
+    return cur;
+}
+
+/**
+ * @brief 順序が次のノードを返す。
+ * @param[in] node 現在のノード
+ * @return 次のノード、nodeが最後の場合はNULLを返す。
+ */
+struct rbnode *rb_next(struct rbnode *node)
+{
+    struct rbnode *parent;
+
+    if (node->rbright != NULL)
+    {
+        for (node = node->rbright; node->rbleft != NULL; node = node->rbleft)
+            ;
+        return node;
+    }
+    while (((parent = node->rbparent) != NULL) && (node == parent->rbright))
+    {
+        node = parent;
+    }
+    return parent;
+}
+
+/**
+ * @brief 順序が前のノードを返す。
+ * @param[in] node 現在のノード
+ * @return 前のノード、nodeが最初の場合はNULLを返す。
+ */
+struct rbnode *rb_prev(struct rbnode *node)
+{
+    struct rbnode *parent;
+
+    if (node->rbleft != NULL)
+    {
+        for (node = node->rbleft; node->rbright != NULL; node = node->rbright)
+            ;
+        return node;
+    }
+    while (((parent = node->rbparent) != NULL) && (node == parent->rbleft))
+    {
+        node = parent;
+    }
+    return parent;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file ringbuf.c
+ * @brief 単一生産者／単一消費者（SPSC）のリングバッファを提供する。
+ */
+#include <xinu.h>
+
+/**
+ * @def rg_barrier()
+ * @brief 格納領域へのアクセスとインデックスの更新の順序を保証するメモリバリア。
+ */
+#if defined(__arm__)
+#define rg_barrier() asm volatile("dmb" ::: "memory")
+#else
+#define rg_barrier() asm volatile("" ::: "memory")
+#endif
+
+/**
+ * @brief リングバッファを空の状態で初期化する。
+ * @param[out] rg 初期化するリングバッファ
+ * @param[in] buf 格納領域（長さn、呼び出し側が用意する）
+ * @param[in] n 格納できる要素数（2のべき乗）
+ * @return 成功時はOK、nが2のべき乗でない場合はSYSERRを返す。
+ */
+status rg_init(struct ringbuf *rg, void **buf, uint32 n)
+{
+    if ((n == 0) || ((n & (n - 1)) != 0))
+    {
+        return SYSERR;
+    }
+    rg->rgbuf = buf;
+    rg->rgmask = n - 1;
+    rg->rghead = 0;
+    rg->rgtail = 0;
+    return OK;
+}
+
+/**
+ * @brief 要素をリングバッファの末尾に追加する（生産者のみが呼び出す）。
+ * @details 要素を書き込んでからrgheadを進めるため、消費者が書き込み途中の要素を読む事はない。
+ * @param[in,out] rg リングバッファ
+ * @param[in] item 追加する要素
+ * @return 成功時はOK、満杯の場合はSYSERRを返す。
+ */
+status rg_put(struct ringbuf *rg, void *item)
+{
+    uint32 head = rg->rghead;
+
+    if (head - rg->rgtail > rg->rgmask)
+    {
+        return SYSERR;
+    }
+    rg->rgbuf[head & rg->rgmask] = item;
+    rg_barrier();
+    rg->rghead = head + 1;
+    return OK;
+}
+
+/**
+ * @brief リングバッファの先頭から要素を取り出す（消費者のみが呼び出す）。
+ * @details 要素を読み出してからrgtailを進めるため、生産者が読み出し前の要素を上書きする事はない。
+ * @param[in,out] rg リングバッファ
+ * @return 取り出した要素、空の場合はNULLを返す。
+ */
+void *rg_get(struct ringbuf *rg)
+{
+    uint32 tail = rg->rgtail;
+    void *item;
+
+    if (tail == rg->rghead)
+    {
+        return NULL;
+    }
+    rg_barrier();
+    item = rg->rgbuf[tail & rg->rgmask];
+    rg_barrier();
+    rg->rgtail = tail + 1;
+    return item;
+}
+
+/**
+ * @brief リングバッファの先頭の要素を、取り出さずに返す（消費者のみが呼び出す）。
+ * @param[in] rg リングバッファ
+ * @return 先頭の要素、空の場合はNULLを返す。
+ */
+void *rg_peek(struct ringbuf *rg)
+{
+    uint32 tail = rg->rgtail;
+
+    if (tail == rg->rghead)
+    {
+        return NULL;
+    }
+    rg_barrier();
+    return rg->rgbuf[tail & rg->rgmask];
+}
@@ -0,0 +1,70 @@
+/* snprintf.c - snprintf, snprntf */
+
+#include <stdarg.h>
+
+/* Where snprintf is placing output and how much room is left */
+
+struct	snpdest	{
+	char	*snpnext;		/* Next byte of the output string*/
+	int	snpleft;		/* Bytes left, excluding the NUL*/
+};
+
+static int snprntf(int, char *, int);
+extern int _fdoprnt(char *, va_list, int (*func) (int, char *, int), int);
+
+/*------------------------------------------------------------------------
+ *  snprintf  -  Format arguments and place at most size-1 characters of
+ *			the output in a string, always terminated with a
+ *			NUL when size is positive.  Returns the length the
+ *			complete output would have had, so a return value
+ *			of size or more means the output was truncated.
+ *------------------------------------------------------------------------
+ */
+int	snprintf(
+	  char		*str,		/* output string		*/
+	  int		size,		/* size of output string	*/
+	  char		*fmt,		/* format string		*/
+	  ...
+	)
+{
+    va_list ap;
+    struct snpdest dest;
+    int n;
+
+    dest.snpnext = str;
+    dest.snpleft = (size > 0) ? size - 1 : 0;
+    va_start(ap, fmt);
+    n = _fdoprnt(fmt, ap, snprntf, (int)&dest);
+    va_end(ap);
+    if (size > 0)
+    {
+        *dest.snpnext = '\0';
+    }
+
+    return n;
+}
+
+/*------------------------------------------------------------------------
+ *  snprntf  -  Routine called by _fdoprnt to copy as much of a buffer of
+ *			output as still fits in the string.
+ *------------------------------------------------------------------------
+ */
+static int	snprntf(
+		  int		adest,
+		  char		*buf,
+		  int		len
+		)
+{
+    struct snpdest *dest = (struct snpdest *)adest;
+
+    if (len > dest->snpleft)
+    {
+        len = dest->snpleft;
+    }
+    dest->snpleft -= len;
+    while (len-- > 0)
+    {
+        *dest->snpnext++ = *buf++;
+    }
+    return 0;
+}
@@ -2,8 +2,8 @@
 
 #include <stdarg.h>
 
-static int sprntf(int, int);
-extern void _fdoprnt(char *, va_list, int (*func) (int, int), int);
+static int sprntf(int, char *, int);
+extern int _fdoprnt(char *, va_list, int (*func) (int, char *, int), int);
 
 /*------------------------------------------------------------------------
  *  sprintf  -  Format arguments and place output in a string.
@@ -28,16 +28,20 @@ int	sprintf(
 }
 
 /*------------------------------------------------------------------------
- *  sprntf  -  Routine called by _doprnt to handle each character.
+ *  sprntf  -  Routine called by _fdoprnt to copy a buffer of output.
  *------------------------------------------------------------------------
  */
 static int	sprntf(
 		  int		acpp,
-		  int		ac
+		  char		*buf,
+		  int		len
 		)
 {
     char **cpp = (char **)acpp;
-    char c = (char)ac;
 
-    return (*(*cpp)++ = c);
+    while (len-- > 0)
+    {
+        *(*cpp)++ = *buf++;
+    }
+    return 0;
 }
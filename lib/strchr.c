@@ -2,17 +2,40 @@
  * @file strchr.c
  * @brief 指定された文字を文字列から探し、最初にに見つかった位置をポインタで返す。
  */
+#include <wordops.h>
 
 /**
  * @brief 指定された文字を文字列から探し、最初にに見つかった位置をポインタで返す。
+ * @details 4Byte境界に揃えた後は、文字cを4Byteに複製したワードとのXORを取る事で、
+ * 「NULL終端」と「文字c」のどちらかを含むワードを4Byteずつ探す。
  * @param[in] s 探索対象の文字列
  * @param[in] c 検索文字
  * @return 文字cが見つかった場合は文字cが最初に登場した位置を示すポインタ、<br>
  * 文字cが見つからなかった場合はNULLを返す。
+ * @note ワードの読み込みは4Byte境界に揃えて行うため、ページ境界を跨ぐ事はない。
  */
 char *strchr(const char *s, int c)
 {
-    for (; *s != '\0'; s++)
+    const unsigned int *w;
+    unsigned int cmask;
+
+    for (; WMISALIGN(s) != 0; s++)
+    {
+        if (*s == (const char)c)
+        {
+            return (char *)s;
+        }
+        if (*s == '\0')
+        {
+            return 0;
+        }
+    }
+
+    cmask = WREPEAT(c);
+    for (w = (const unsigned int *)s; !HASZERO(*w) && !HASZERO(*w ^ cmask); w++)
+        ;
+
+    for (s = (const char *)w; *s != '\0'; s++)
     {
         if (*s == (const char)c)
         {
@@ -2,9 +2,13 @@
  * @file strcmp.c
  * @brief 二つの文字列を比較し、その結果を返す。
  */
+#include <wordops.h>
 
 /**
  * @brief 二つの文字列を比較し、その結果を返す。
+ * @details 二つの文字列の4Byte境界からのずれが同じ場合は、境界に揃えた後、
+ * 「内容が等しく、NULL終端を含まない」ワードを4Byteずつ読み飛ばす。
+ * 残りは1Byteずつ比較する。
  * @param[in] str1 比較対象の文字列その1
  * @param[in] str2 比較対象の文字列その2
  * @return str1 > str2の場合は1、s1 = s2の場合は0、str1 < str2の場合は-1を返す。
@@ -13,6 +17,31 @@ int strcmp(
 	char *str1,
 	char *str2)
 {
+	const unsigned int *w1, *w2;
+
+	if (WSAMEALIGN(str1, str2))
+	{
+		for (; WMISALIGN(str1) != 0; str1++, str2++)
+		{
+			if ((*str1 != *str2) || (*str1 == '\0'))
+			{
+				break;
+			}
+		}
+		if (WMISALIGN(str1) == 0)
+		{
+			w1 = (const unsigned int *)str1;
+			w2 = (const unsigned int *)str2;
+			while ((*w1 == *w2) && !HASZERO(*w1))
+			{
+				w1++;
+				w2++;
+			}
+			str1 = (char *)w1;
+			str2 = (char *)w2;
+		}
+	}
+
 	while (*str1 == *str2)
 	{
 		if (*str1 == '\0')
@@ -2,21 +2,34 @@
  * @file strlen.c
  * @brief NULL終端された文字列の長さを返す。NULL終端は長さに含まない。
  */
+#include <wordops.h>
 
 /**
  * @brief NULL終端された文字列の長さを返す。NULL終端は長さに含まない。
+ * @details 4Byte境界まで1Byteずつ調べた後、NULL終端を含むワードが見つかるまで4Byteずつ調べ、
+ * 見つかったワードの中を1Byteずつ調べて正確な位置を求める。
  * @param[in] str 長さを調べる対象の文字列
  * @return  文字列の長さを返す。NULL終端は長さに含まない。
+ * @note ワードの読み込みは4Byte境界に揃えて行うため、NULL終端より後ろを読む場合でも
+ * ページ境界を跨ぐ事はない。
  */
 int strlen(char *str)
 {
-	int len;
+	const char *p = str;
+	const unsigned int *w;
 
-	len = 0;
-
-	while (*str++ != '\0')
+	for (; WMISALIGN(p) != 0; p++)
 	{
-		len++;
+		if (*p == '\0')
+		{
+			return p - str;
+		}
 	}
-	return len;
+
+	for (w = (const unsigned int *)p; !HASZERO(*w); w++)
+		;
+
+	for (p = (const char *)w; *p != '\0'; p++)
+		;
+	return p - str;
 }
@@ -2,9 +2,12 @@
  * @file strncmp.c
  * @brief 二つの文字列を最大N byteまで比較し、その結果を返す。
  */
+#include <wordops.h>
 
 /**
  * @brief 二つの文字列を最大N byteまで比較し、その結果を返す。
+ * @details 二つの文字列の4Byte境界からのずれが同じ場合は、境界に揃えた後、
+ * 残りが4Byte以上ある間は「内容が等しく、NULL終端を含まない」ワードを読み飛ばす。
  * @param[in] s1 比較対象の文字列その1
  * @param[in] s2 比較対象の文字列その2
  * @param[in] n  比較するByte数（最大Byte）
@@ -12,6 +15,31 @@
  */
 int strncmp(char *s1, char *s2, int n)
 {
+    const unsigned int *w1, *w2;
+
+    if ((n >= 8) && WSAMEALIGN(s1, s2))
+    {
+        for (; WMISALIGN(s1) != 0; n--, s1++, s2++)
+        {
+            if (*s1 != *s2)
+            {
+                return *s1 - *s2;
+            }
+            if (*s1 == '\0')
+            {
+                return 0;
+            }
+        }
+        w1 = (const unsigned int *)s1;
+        w2 = (const unsigned int *)s2;
+        for (; (n >= 4) && (*w1 == *w2) && !HASZERO(*w1); n -= 4)
+        {
+            w1++;
+            w2++;
+        }
+        s1 = (char *)w1;
+        s2 = (char *)w2;
+    }
 
     while (--n >= 0 && *s1 == *s2++)
     {
@@ -2,11 +2,13 @@
  * @file strncpy.c
  * @brief 文字列s1に文字列s2をN文字（Byte）分コピーする。
  */
+#include <wordops.h>
 
 /**
  * @brief 文字列s1に文字列s2をN文字（Byte）分コピーする。
  * @details 自動でNULL終端（'\0'）は付与しない。<br>
- * また、N Byteコピーする前にNULL終端に達した場合、残りのByte数分をNULL終端で埋める。
+ * また、N Byteコピーする前にNULL終端に達した場合、残りのByte数分をNULL終端で埋める。<br>
+ * コピー元とコピー先の4Byte境界からのずれが同じ場合は、NULL終端を含まないワードを4Byteずつコピーする。
  * @param[in,out] s1 コピー先の文字列
  * @param[in] s2 コピー元の文字列
  * @param[in] n コピーする文字数（Byte）
@@ -16,9 +18,35 @@ char *strncpy(char *s1, const char *s2, int n)
 {
     register int i;
     register char *os1;
+    unsigned int *wd;
+    const unsigned int *ws;
 
     os1 = s1;
-    for (i = 0; i < n; i++)
+    i = 0;
+    if ((n >= 8) && WSAMEALIGN(s1, s2))
+    {
+        for (; WMISALIGN(s1) != 0; i++)
+        {
+            if (((*s1++) = (*s2++)) == '\0')
+            {
+                while (++i < n)
+                {
+                    *s1++ = '\0';
+                }
+                return os1;
+            }
+        }
+        wd = (unsigned int *)s1;
+        ws = (const unsigned int *)s2;
+        for (; (i + 4 <= n) && !HASZERO(*ws); i += 4)
+        {
+            *wd++ = *ws++;
+        }
+        s1 = (char *)wd;
+        s2 = (const char *)ws;
+    }
+
+    for (; i < n; i++)
     {
         if (((*s1++) = (*s2++)) == '\0')
         {
@@ -1,8 +1,27 @@
-/* arp.c - arp_init, arp_resolve, arp_in, arp_alloc, arp_ntoh, arp_hton	*/
+/* arp.c - arp_init, arp_resolve, arp_hold, arp_in, arp_alloc, arp_add,	*/
+/*		arp_delete, arp_announce, arptimer, arp_lookup,		*/
+/*		arp_free, arp_request, arp_ntoh, arp_hton		*/
 
 #include <xinu.h>
 
 struct	arpentry  arpcache[ARP_SIZ];	/* ARP cache			*/
+struct	arpstat	arpstats;		/* ARP statistics		*/
+sid32	arpmutex;			/* Protects the cache and stats	*/
+
+/* The cache is protected by arpmutex rather than by disabling	*/
+/*   interrupts, and the mutex is released before a frame is sent,	*/
+/*   so a write to ETHER0 never delays other users of the cache	*/
+
+/* Entries in use are in a hash map keyed on the IP address; free	*/
+/*   entries are chained through arnext from arpfree		*/
+
+local	struct	hashmap	arpmap;		/* Entries in use		*/
+local	struct	hmnode	*arpslots[ARP_HSIZ];/* Slots of arpmap		*/
+local	int32	arpfree;		/* Head of the free list	*/
+
+local	struct	arpentry *arp_lookup(uint32);
+local	void	arp_free(struct arpentry *);
+local	void	arp_request(uint32, uint32, byte *);
 
 /*------------------------------------------------------------------------
  * arp_init  -  Initialize ARP cache for an Ethernet interface
@@ -12,13 +31,22 @@ void	arp_init(void)
 {
 	int32	i;			/* ARP cache index		*/
 
-	for (i=1; i<ARP_SIZ; i++) {	/* Initialize cache to empty	*/
+	for (i=0; i<ARP_SIZ; i++) {	/* Initialize cache to empty	*/
 		arpcache[i].arstate = AR_FREE;
+		arpcache[i].arnext = i + 1;
 	}
+	arpcache[ARP_SIZ-1].arnext = -1;
+	arpfree = 0;
+
+	hm_init(&arpmap, arpslots, ARP_HSIZ, HM_INT);
+	memset((char *)&arpstats, NULLCH, sizeof(arpstats));
+	arpmutex = semcreate(1);
 }
 
 /*------------------------------------------------------------------------
- * arp_resolve  -  Use ARP to resolve an IP address to an Ethernet address
+ * arp_resolve  -  Look up the Ethernet address for an IP address without
+ *		     waiting; return OK if it is known and SYSERR if the
+ *		     caller must hold the packet with arp_hold
  *------------------------------------------------------------------------
  */
 status	arp_resolve (
@@ -26,12 +54,8 @@ status	arp_resolve (
 	 byte	mac[ETH_ADDR_LEN]	/* Array into which Ethernet	*/
 	)				/*   address should be placed	*/
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	arppacket apkt;		/* Local packet buffer		*/
-	int32	i;			/* Index into arpcache		*/
-	int32	slot;			/* ARP table slot to use	*/
 	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
-	int32	msg;			/* Message returned by recvtime	*/
+	bool8	refresh;		/* Should the entry be refreshed*/
 
 	/* Use MAC broadcast address for IP limited broadcast */
 
@@ -49,104 +73,98 @@ status	arp_resolve (
 
 	/* Ensure only one process uses ARP at a time */
 
-	mask = disable();
-
-	/* See if next hop address is already present in ARP cache */
+	wait(arpmutex);
 
-	for (i=0; i<ARP_SIZ; i++) {
-		arptr = &arpcache[i];
-		if (arptr->arstate == AR_FREE) {
-			continue;
-		}
-		if (arptr->arpaddr == nxthop) { /* Adddress is in cache	*/
-			break;
-		}
+	arptr = arp_lookup(nxthop);
+	if ( (arptr == NULL) || (arptr->arstate == AR_PENDING) ) {
+		signal(arpmutex);
+		return SYSERR;
 	}
+	memcpy(mac, arptr->arhaddr, ARP_HALEN);
 
-	if (i < ARP_SIZ) {	/* Entry was found */
-
-		/* If entry is resolved - handle and return */
-
-		if (arptr->arstate == AR_RESOLVED) {
-			memcpy(mac, arptr->arhaddr, ARP_HALEN);
-			restore(mask);
-			return OK;
-		}
-
-		/* Entry is already pending -  return error because	*/
-		/*	only one process can be	waiting at a time	*/
+	/* If the entry will expire soon, ask the host directly for	*/
+	/*   its address so the entry is refreshed before it expires	*/
 
-		if (arptr->arstate == AR_PENDING) {
-			restore(mask);
-			return SYSERR;
-		}
+	refresh = (arptr->arstate == AR_RESOLVED) &&
+		  (arptr->artime < ARP_REFRESH) && (arptr->arretry == 0);
+	if (refresh) {
+		arptr->arretry = 1;
+		arpstats.as_reqsent++;
 	}
+	signal(arpmutex);
 
-	/* IP address not in cache -  allocate a new cache entry and	*/
-	/*	send an ARP request to obtain the answer		*/
-
-	slot = arp_alloc();
-	if (slot == SYSERR) {
-		restore(mask);
-		return SYSERR;
+	if (refresh) {
+		arp_request(nxthop, NetData.ipucast, mac);
 	}
+	return OK;
+}
 
-	arptr = &arpcache[slot];
-	arptr->arstate = AR_PENDING;
-	arptr->arpaddr = nxthop;
-	arptr->arpid = currpid;
-
-	/* Hand-craft an ARP Request packet */
+/*------------------------------------------------------------------------
+ * arp_hold  -  Hold an outgoing packet until the next hop is resolved,
+ *		  sending an ARP request if one is not already pending;
+ *		  the packet is sent by arp_in when the reply arrives.  A
+ *		  chain of fragments (see ip.c) is held as one packet
+ *------------------------------------------------------------------------
+ */
+status	arp_hold (
+	 struct	netpacket *pktptr,	/* Packet to send (host order)	*/
+	 uint32	nxthop			/* Next-hop address of packet	*/
+	)
+{
+	int32	slot;			/* ARP table slot to use	*/
+	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
+	bool8	request;		/* Should a request be sent	*/
 
-	memcpy(apkt.arp_ethdst, NetData.ethbcast, ETH_ADDR_LEN);
-	memcpy(apkt.arp_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
-	apkt.arp_ethtype = ETH_ARP;	  /* Packet type is ARP		*/
-	apkt.arp_htype = ARP_HTYPE;	  /* Hardware type is Ethernet	*/
-	apkt.arp_ptype = ARP_PTYPE;	  /* Protocol type is IP	*/
-	apkt.arp_hlen = 0xff & ARP_HALEN; /* Ethernet MAC size in bytes	*/
-	apkt.arp_plen = 0xff & ARP_PALEN; /* IP address size in bytes	*/
-	apkt.arp_op = 0xffff & ARP_OP_REQ;/* ARP type is Request	*/
-	memcpy(apkt.arp_sndha, NetData.ethucast, ARP_HALEN);
-	apkt.arp_sndpa = NetData.ipucast; /* IP address of interface	*/
-	memset(apkt.arp_tarha, '\0', ARP_HALEN); /* Target HA is unknown*/
-	apkt.arp_tarpa = nxthop;	  /* Target protocol address	*/
+	/* Ensure only one process uses ARP at a time */
 
-	/* Convert ARP packet from host to net byte order */
+	wait(arpmutex);
 
-	arp_hton(&apkt);
+	arptr = arp_lookup(nxthop);
 
-	/* Convert Ethernet header from host to net byte order */
+	/* The reply may have arrived since arp_resolve was called */
 
-	eth_hton((struct netpacket *)&apkt);
+	if ( (arptr != NULL) && (arptr->arstate != AR_PENDING) ) {
+		memcpy(pktptr->net_ethdst, arptr->arhaddr, ARP_HALEN);
+		signal(arpmutex);
+		return ip_out(pktptr);
+	}
 
-	/* Send the packet ARP_RETRY times and await response */
+	/* IP address not in cache -  allocate a new cache entry and	*/
+	/*	send an ARP request to obtain the answer		*/
 
-	msg = recvclr();
-	for (i=0; i<ARP_RETRY; i++) {
-		write(ETHER0, (char *)&apkt, sizeof(struct arppacket));
-		msg = recvtime(ARP_TIMEOUT);
-		if (msg == TIMEOUT) {
-			continue;
-		} else if (msg == SYSERR) {
-			restore(mask);
+	request = FALSE;
+	if (arptr == NULL) {
+		slot = arp_alloc(nxthop);
+		if (slot == SYSERR) {
+			arpstats.as_drop++;
+			signal(arpmutex);
+			pb_freechain(pktptr);
 			return SYSERR;
-		} else {	/* entry is resolved */
-			break;
- 		}
+		}
+		arptr = &arpcache[slot];
+		arptr->arstate = AR_PENDING;
+		arptr->arretry = ARP_RETRY - 1;
+		arptr->artime = ARP_TIMEOUT;
+		arpstats.as_reqsent++;
+		request = TRUE;
 	}
 
-	/* If no response, return TIMEOUT */
+	/* Queue the packet; if the queue is full the oldest packet	*/
+	/*   is dropped in favor of the new one				*/
 
-	if (msg == TIMEOUT) {
-		arptr->arstate = AR_FREE;   /* Invalidate cache entry */
-		restore(mask);
-		return TIMEOUT;
+	if (arptr->arcount >= ARP_QSIZ) {
+		arpstats.as_drop++;
+		pb_freechain(arptr->arqueue[0]);
+		memcpy((char *)&arptr->arqueue[0], (char *)&arptr->arqueue[1],
+			(ARP_QSIZ - 1) * sizeof(struct netpacket *));
+		arptr->arcount--;
 	}
+	arptr->arqueue[arptr->arcount++] = pktptr;
+	signal(arpmutex);
 
-	/* Return hardware address */
-
-	memcpy(mac, arptr->arhaddr, ARP_HALEN);
-	restore(mask);
+	if (request) {
+		arp_request(nxthop, NetData.ipucast, NetData.ethbcast);
+	}
 	return OK;
 }
 
@@ -159,12 +177,14 @@ void	arp_in (
 	  struct arppacket *pktptr	/* Ptr to incoming packet	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	struct	arppacket apkt;		/* Local packet buffer		*/
 	int32	slot;			/* Slot in cache		*/
 	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
-	bool8	found;			/* Is the sender's address in	*/
-					/*   the cache?			*/
+	struct	netpacket *qpkts[ARP_QSIZ];/* Packets that were awaiting*/
+					/*   the reply			*/
+	int32	nq;			/* Number of packets in qpkts[]	*/
+	int32	i;			/* Index into the packet queue	*/
+	bool8	forus;			/* Is the local machine target?	*/
 
 	/* Convert packet from network order to host order */
 
@@ -174,86 +194,69 @@ void	arp_in (
 
 	if ( (pktptr->arp_htype != ARP_HTYPE) ||
 	     (pktptr->arp_ptype != ARP_PTYPE) ) {
-		freebuf((char *)pktptr);
+		pb_free((struct netpacket *)pktptr);
 		return;
 	}
 
 	/* Ensure only one process uses ARP at a time */
 
-	mask = disable();
+	wait(arpmutex);
 
-	/* Search cache for sender's IP address */
+	forus = NetData.ipvalid && (pktptr->arp_tarpa == NetData.ipucast);
 
-	found = FALSE;
-
-	for (slot=0; slot < ARP_SIZ; slot++) {
-		arptr = &arpcache[slot];
-
-		/* Skip table entries that are unused */
+	/* Search cache for sender's IP address */
 
-		if (arptr->arstate == AR_FREE) {
-			continue;
-		}
+	arptr = arp_lookup(pktptr->arp_sndpa);
 
-		/* If sender's address matches, we've found it */
+	/* Add the sender if the packet was sent to the local machine	*/
+	/*   or is a gratuitous ARP (sender and target are the same),	*/
+	/*   so hosts that announce themselves are known in advance	*/
 
-		if (arptr->arpaddr == pktptr->arp_sndpa) {
-			found = TRUE;
-			break;
+	if ( (arptr == NULL) && (pktptr->arp_sndpa != 0) &&
+	     (pktptr->arp_sndpa != NetData.ipucast) &&
+	     (forus || (pktptr->arp_sndpa == pktptr->arp_tarpa)) ) {
+		slot = arp_alloc(pktptr->arp_sndpa);
+		if (slot != SYSERR) {
+			arptr = &arpcache[slot];
 		}
 	}
 
-	if (found) {
+	nq = 0;
+	if ( (arptr != NULL) && (arptr->arstate != AR_STATIC) ) {
 
-		/* Update sender's hardware address */
+		/* Update sender's hardware address and restart aging */
 
 		memcpy(arptr->arhaddr, pktptr->arp_sndha, ARP_HALEN);
+		arptr->arstate = AR_RESOLVED;
+		arptr->artime = ARP_TTL;
+		arptr->arretry = 0;
 
-		/* If a process was waiting, inform the process */
+		/* Take the packets that were waiting for the address */
 
-		if (arptr->arstate == AR_PENDING) {
-			/* Mark resolved and notify waiting process */
-			arptr->arstate = AR_RESOLVED;
-			send(arptr->arpid, OK);
+		for (nq = 0; nq < arptr->arcount; nq++) {
+			qpkts[nq] = arptr->arqueue[nq];
+			memcpy(qpkts[nq]->net_ethdst, arptr->arhaddr,
+								ARP_HALEN);
 		}
+		arptr->arcount = 0;
 	}
+	signal(arpmutex);
 
-	/* For an ARP reply, processing is complete */
+	/* Send the waiting packets now that the cache is unlocked */
 
-	if (pktptr->arp_op == ARP_OP_RPLY) {
-		freebuf((char *)pktptr);
-		restore(mask);
-		return;
+	for (i = 0; i < nq; i++) {
+		ip_out(qpkts[i]);
 	}
 
-	/* The following is for an ARP request packet: if the local	*/
-	/*  machine is not the target or the local IP address is not	*/
-	/*  yet known, ignore the request (i.e., processing is complete)*/
+	/* For an ARP reply, processing is complete; for a request, if	*/
+	/*  the local machine is not the target or the local IP address	*/
+	/*  is not yet known, ignore the request			*/
 
-	if ((!NetData.ipvalid) ||
-			(pktptr->arp_tarpa != NetData.ipucast)) {
-		freebuf((char *)pktptr);
-		restore(mask);
+	if ( (pktptr->arp_op == ARP_OP_RPLY) || !forus ) {
+		pb_free((struct netpacket *)pktptr);
 		return;
 	}
 
-	/* Request has been sent to the local machine's address.  So,	*/
-	/*   add sender's info to cache, if not already present		*/
-
-	if (!found) {
-		slot = arp_alloc();
-		if (slot == SYSERR) {	/* Cache is full */
-			kprintf("ARP cache overflow on interface\n");
-			freebuf((char *)pktptr);
-			restore(mask);
-			return;
-		}
-		arptr = &arpcache[slot];
-		arptr->arpaddr = pktptr->arp_sndpa;
-		memcpy(arptr->arhaddr, pktptr->arp_sndha, ARP_HALEN);
-		arptr->arstate = AR_RESOLVED;
-	}
-
 	/* Hand-craft an ARP reply packet and send back to requester	*/
 
 	memcpy(apkt.arp_ethdst, pktptr->arp_sndha, ARP_HALEN);
@@ -286,44 +289,302 @@ void	arp_in (
 	/* Send the reply */
 
 	write(ETHER0, (char *)&apkt, sizeof(struct arppacket));
-	freebuf((char *)pktptr);
-	restore(mask);
+	pb_free((struct netpacket *)pktptr);
 	return;
 }
 
 /*------------------------------------------------------------------------
- * arp_alloc  -  Find a free slot or kick out an entry to create one
+ * arp_alloc  -  Allocate a cache entry for an IP address, kicking out
+ *		   the resolved entry closest to expiring if the cache is
+ *		   full (arpmutex must be held)
  *------------------------------------------------------------------------
  */
-int32	arp_alloc ()
+int32	arp_alloc (
+	 uint32	ipaddr			/* IP address for the entry	*/
+	)
 {
 	int32	slot;			/* Slot in ARP cache		*/
+	int32	victim;			/* Entry to kick out		*/
+	struct	arpentry *arptr;	/* Ptr to ARP cache entry	*/
+
+	/* Take a free slot if there is one; otherwise kick out the	*/
+	/*   resolved entry with the least time left		*/
+
+	if (arpfree < 0) {
+		victim = -1;
+		for (slot=0; slot < ARP_SIZ; slot++) {
+			if ( (arpcache[slot].arstate == AR_RESOLVED) &&
+			     ( (victim < 0) || (arpcache[slot].artime <
+						arpcache[victim].artime) ) ) {
+				victim = slot;
+			}
+		}
+		if (victim < 0) {
 
-	/* Search for a free slot */
+			/* All slots are pending or static */
 
-	for (slot=0; slot < ARP_SIZ; slot++) {
-		if (arpcache[slot].arstate == AR_FREE) {
-			memset((char *)&arpcache[slot],
-					NULLCH, sizeof(struct arpentry));
-			return slot;
+			kprintf("ARP cache size exceeded\n");
+			return SYSERR;
 		}
+		arp_free(&arpcache[victim]);
 	}
 
-	/* Search for a resolved entry */
+	slot = arpfree;
+	arptr = &arpcache[slot];
+	arpfree = arptr->arnext;
+	memset((char *)arptr, NULLCH, sizeof(struct arpentry));
+	arptr->arpaddr = ipaddr;
+	arptr->arstate = AR_RESOLVED;
+	arptr->arnode.hnikey = ipaddr;
+	hm_insert(&arpmap, &arptr->arnode);
+	return slot;
+}
 
-	for (slot=0; slot < ARP_SIZ; slot++) {
-		if (arpcache[slot].arstate == AR_RESOLVED) {
-			memset((char *)&arpcache[slot],
-					NULLCH, sizeof(struct arpentry));
-			return slot;
+/*------------------------------------------------------------------------
+ * arp_add  -  Add a static entry that never expires to the ARP cache
+ *------------------------------------------------------------------------
+ */
+status	arp_add (
+	 uint32	ipaddr,			/* IP address of the entry	*/
+	 byte	*mac			/* Ethernet address of the entry*/
+	)
+{
+	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
+	int32	slot;			/* Slot in ARP cache		*/
+	struct	netpacket *qpkts[ARP_QSIZ];/* Packets that were waiting	*/
+	int32	nq;			/* Number of packets in qpkts[]	*/
+	int32	i;			/* Index into qpkts[]		*/
+
+	wait(arpmutex);
+	arptr = arp_lookup(ipaddr);
+	if (arptr == NULL) {
+		slot = arp_alloc(ipaddr);
+		if (slot == SYSERR) {
+			signal(arpmutex);
+			return SYSERR;
 		}
+		arptr = &arpcache[slot];
 	}
+	memcpy(arptr->arhaddr, mac, ARP_HALEN);
+	arptr->arstate = AR_STATIC;
 
-	/* At this point, all slots are pending (should not happen) */
+	/* Send any packets that were waiting for the address */
 
-	kprintf("ARP cache size exceeded\n");
+	for (nq = 0; nq < arptr->arcount; nq++) {
+		qpkts[nq] = arptr->arqueue[nq];
+		memcpy(qpkts[nq]->net_ethdst, mac, ARP_HALEN);
+	}
+	arptr->arcount = 0;
+	signal(arpmutex);
+
+	for (i = 0; i < nq; i++) {
+		ip_out(qpkts[i]);
+	}
+	return OK;
+}
 
-	return SYSERR;
+/*------------------------------------------------------------------------
+ * arp_delete  -  Remove the entry for an IP address from the ARP cache
+ *------------------------------------------------------------------------
+ */
+status	arp_delete (
+	 uint32	ipaddr			/* IP address of the entry	*/
+	)
+{
+	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
+
+	wait(arpmutex);
+	arptr = arp_lookup(ipaddr);
+	if (arptr == NULL) {
+		signal(arpmutex);
+		return SYSERR;
+	}
+	arp_free(arptr);
+	signal(arpmutex);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * arp_announce  -  Broadcast a gratuitous ARP for the local address and
+ *		      start resolving the default router, so neighbors
+ *		      and the local cache are filled in before traffic
+ *		      starts
+ *------------------------------------------------------------------------
+ */
+void	arp_announce(void)
+{
+	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
+	int32	slot;			/* Slot in ARP cache		*/
+	bool8	request;		/* Should the router be asked	*/
+
+	if (!NetData.ipvalid) {
+		return;
+	}
+
+	wait(arpmutex);
+	arpstats.as_reqsent++;
+	request = FALSE;
+	if ( (NetData.iprouter != 0) &&
+	     (arp_lookup(NetData.iprouter) == NULL) ) {
+		slot = arp_alloc(NetData.iprouter);
+		if (slot != SYSERR) {
+			arptr = &arpcache[slot];
+			arptr->arstate = AR_PENDING;
+			arptr->arretry = ARP_RETRY - 1;
+			arptr->artime = ARP_TIMEOUT;
+			arpstats.as_reqsent++;
+			request = TRUE;
+		}
+	}
+	signal(arpmutex);
+
+	arp_request(NetData.ipucast, NetData.ipucast, NetData.ethbcast);
+	if (request) {
+		arp_request(NetData.iprouter, NetData.ipucast,
+							NetData.ethbcast);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * arptimer  -  Retransmit pending ARP requests and age resolved entries
+ *------------------------------------------------------------------------
+ */
+process	arptimer(void)
+{
+	struct	arpentry  *arptr;	/* Ptr to ARP cache entry	*/
+	int32	slot;			/* Slot in ARP cache		*/
+	uint32	retx[ARP_SIZ];		/* Addresses to ask for again	*/
+	int32	nretx;			/* Number of entries in retx[]	*/
+	int32	i;			/* Index into retx[]		*/
+
+	while (TRUE) {
+		sleepms(ARP_TICK);
+
+		wait(arpmutex);
+		nretx = 0;
+		for (slot=0; slot < ARP_SIZ; slot++) {
+			arptr = &arpcache[slot];
+			if ( (arptr->arstate != AR_PENDING) &&
+			     (arptr->arstate != AR_RESOLVED) ) {
+				continue;
+			}
+			arptr->artime -= ARP_TICK;
+			if (arptr->artime > 0) {
+				continue;
+			}
+
+			/* A resolved entry has expired */
+
+			if (arptr->arstate == AR_RESOLVED) {
+				arp_free(arptr);
+				continue;
+			}
+
+			/* A request has gone unanswered: retransmit it	*/
+			/*   or give up and drop the waiting packets	*/
+
+			if (arptr->arretry > 0) {
+				arptr->arretry--;
+				arptr->artime = ARP_TIMEOUT;
+				arpstats.as_reqsent++;
+				retx[nretx++] = arptr->arpaddr;
+			} else {
+				arpstats.as_fail++;
+				arpstats.as_drop += arptr->arcount;
+				arp_free(arptr);
+			}
+		}
+		signal(arpmutex);
+
+		/* Send the retransmissions with the cache unlocked */
+
+		for (i = 0; i < nretx; i++) {
+			arp_request(retx[i], NetData.ipucast,
+						NetData.ethbcast);
+		}
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * arp_lookup  -  Find the cache entry for an IP address (arpmutex must
+ *		    be held)
+ *------------------------------------------------------------------------
+ */
+local	struct	arpentry *arp_lookup (
+	 uint32	ipaddr			/* IP address to find		*/
+	)
+{
+	struct	hmnode	*node;		/* Node of the entry		*/
+
+	node = hm_findint(&arpmap, ipaddr);
+	if (node == NULL) {
+		return NULL;
+	}
+	return containerof(node, struct arpentry, arnode);
+}
+
+/*------------------------------------------------------------------------
+ * arp_free  -  Remove an entry from the hash map, drop any packets
+ *		  waiting on it, and put it on the free list (arpmutex
+ *		  must be held)
+ *------------------------------------------------------------------------
+ */
+local	void	arp_free (
+	 struct	arpentry *arptr		/* Entry to free		*/
+	)
+{
+	int32	i;			/* Index into the packet queue	*/
+
+	hm_remove(&arpmap, &arptr->arnode);
+
+	for (i = 0; i < arptr->arcount; i++) {
+		pb_freechain(arptr->arqueue[i]);
+	}
+	arptr->arcount = 0;
+	arptr->arstate = AR_FREE;
+	arptr->arnext = arpfree;
+	arpfree = arptr - arpcache;
+}
+
+/*------------------------------------------------------------------------
+ * arp_request  -  Send an ARP request for an IP address (the caller
+ *		     counts it in arpstats; arpmutex must not be held)
+ *------------------------------------------------------------------------
+ */
+local	void	arp_request (
+	 uint32	tarpa,			/* IP address to resolve	*/
+	 uint32	sndpa,			/* Sender IP address to use	*/
+	 byte	*ethdst			/* Broadcast, or the last known	*/
+					/*   address to refresh an entry*/
+	)
+{
+	struct	arppacket apkt;		/* Local packet buffer		*/
+
+	/* Hand-craft an ARP Request packet */
+
+	memcpy(apkt.arp_ethdst, ethdst, ETH_ADDR_LEN);
+	memcpy(apkt.arp_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
+	apkt.arp_ethtype = ETH_ARP;	  /* Packet type is ARP		*/
+	apkt.arp_htype = ARP_HTYPE;	  /* Hardware type is Ethernet	*/
+	apkt.arp_ptype = ARP_PTYPE;	  /* Protocol type is IP	*/
+	apkt.arp_hlen = 0xff & ARP_HALEN; /* Ethernet MAC size in bytes	*/
+	apkt.arp_plen = 0xff & ARP_PALEN; /* IP address size in bytes	*/
+	apkt.arp_op = 0xffff & ARP_OP_REQ;/* ARP type is Request	*/
+	memcpy(apkt.arp_sndha, NetData.ethucast, ARP_HALEN);
+	apkt.arp_sndpa = sndpa;		  /* IP address of interface	*/
+	memset(apkt.arp_tarha, '\0', ARP_HALEN); /* Target HA is unknown*/
+	apkt.arp_tarpa = tarpa;		  /* Target protocol address	*/
+
+	/* Convert ARP packet from host to net byte order */
+
+	arp_hton(&apkt);
+
+	/* Convert Ethernet header from host to net byte order */
+
+	eth_hton((struct netpacket *)&apkt);
+
+	write(ETHER0, (char *)&apkt, sizeof(struct arppacket));
 }
 
 /*------------------------------------------------------------------------
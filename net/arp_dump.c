@@ -17,8 +17,8 @@ void arp_dump(
 {
 	int32 i; /* Index for a MAC address	*/
 
-	kprintf("State=%d, PID=%d  IP=%08x, HW=", arptr->arstate,
-			arptr->arpid, arptr->arpaddr);
+	kprintf("State=%d, Queued=%d  IP=%08x, HW=", arptr->arstate,
+			arptr->arcount, arptr->arpaddr);
 	kprintf(" %02X", arptr->arhaddr[0]);
 	for (i = 1; i < ARP_HALEN; i++)
 	{
@@ -0,0 +1,291 @@
+/* cksum.c - cksum, cksum_partial, cksum_copy, cksum_fold,		*/
+/*		cksum_combine, cksum_pseudo, cksum_update16,		*/
+/*		cksum_update32						*/
+
+#include <xinu.h>
+
+/*
+ * The Internet checksum is the ones-complement of the ones-complement
+ * sum of 16-bit words.  The sum does not depend on byte order (RFC
+ * 1071), so the routines below add words exactly as they appear in
+ * memory and the folded result can be stored into a header without
+ * conversion.  A "partial" sum is an uncomplemented 32-bit value that
+ * can be passed back in to checksum data that is not contiguous.
+ */
+
+/*------------------------------------------------------------------------
+ *  cksum_fold  -  Fold a partial sum to 16 bits and complement it,
+ *			giving a checksum in network byte order
+ *------------------------------------------------------------------------
+ */
+uint16	cksum_fold(
+	  uint32	sum		/* Partial ones-complement sum	*/
+	)
+{
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16) (0xffff & ~sum);
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_partial  -  Add a buffer of any alignment and length to a
+ *			partial sum, 32 bytes per loop iteration
+ *------------------------------------------------------------------------
+ */
+uint32	cksum_partial(
+	  char		*buf,		/* Data to add to the sum	*/
+	  int32		len,		/* Length of data in bytes	*/
+	  uint32	sum		/* Partial sum so far		*/
+	)
+{
+	uint64	acc;			/* 32-bit words summed with the	*/
+					/*   carries kept in the top half*/
+	byte	*bp;			/* Walks the buffer byte-wise	*/
+	uint32	*wp;			/* Walks the buffer word-wise	*/
+	bool8	odd;			/* Buffer starts on an odd byte	*/
+	union {
+		uint16	w;
+		byte	b[2];
+	} pad;				/* Assembles a lone byte	*/
+
+	if (len <= 0) {
+		return sum;
+	}
+	acc = 0;
+	bp = (byte *)buf;
+
+	/* An odd start shifts every byte into the other half of	*/
+	/*   its word; sum that way and swap the result below	*/
+
+	odd = ((uint32)bp & 1);
+	if (odd) {
+		pad.b[0] = 0;
+		pad.b[1] = *bp++;
+		acc += pad.w;
+		len--;
+	}
+	if ( ((uint32)bp & 2) && (len >= 2) ) {
+		acc += *(uint16 *)bp;
+		bp += 2;
+		len -= 2;
+	}
+
+	/* Sum aligned words, eight at a time */
+
+	wp = (uint32 *)bp;
+	for (; len >= 32; len -= 32) {
+		acc += wp[0];
+		acc += wp[1];
+		acc += wp[2];
+		acc += wp[3];
+		acc += wp[4];
+		acc += wp[5];
+		acc += wp[6];
+		acc += wp[7];
+		wp += 8;
+	}
+	for (; len >= 4; len -= 4) {
+		acc += *wp++;
+	}
+	bp = (byte *)wp;
+	if (len >= 2) {
+		acc += *(uint16 *)bp;
+		bp += 2;
+		len -= 2;
+	}
+	if (len > 0) {
+		pad.b[0] = *bp;
+		pad.b[1] = 0;
+		acc += pad.w;
+	}
+
+	/* Fold to 16 bits, undo the odd-start swap, and add to sum	*/
+
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffff) + (acc >> 16);
+	acc = (acc & 0xffff) + (acc >> 16);
+	if (odd) {
+		acc = ((acc & 0xff) << 8) | ((acc >> 8) & 0xff);
+	}
+	sum += (uint32)acc;
+	if (sum < (uint32)acc) {
+		sum++;			/* End-around carry		*/
+	}
+	return sum;
+}
+
+/*------------------------------------------------------------------------
+ *  cksum  -  Compute the Internet checksum of a buffer (the result is
+ *			in network byte order; zero when verifying a buffer
+ *			that contains a correct checksum)
+ *------------------------------------------------------------------------
+ */
+uint16	cksum(
+	  char		*buf,		/* Data to checksum		*/
+	  int32		len		/* Length of data in bytes	*/
+	)
+{
+	return cksum_fold(cksum_partial(buf, len, 0));
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_copy  -  Copy a buffer and add it to a partial sum in the same
+ *			pass, so the data is only read once
+ *------------------------------------------------------------------------
+ */
+uint32	cksum_copy(
+	  char		*dst,		/* Destination of the copy	*/
+	  char		*src,		/* Data to copy and add		*/
+	  int32		len,		/* Length of data in bytes	*/
+	  uint32	sum		/* Partial sum so far		*/
+	)
+{
+	uint64	acc;			/* Sum with carries in top half	*/
+	uint32	*ws, *wd;		/* Word pointers into src, dst	*/
+	uint32	w0, w1, w2, w3;		/* Words in flight		*/
+	int32	head;			/* Bytes before src is aligned	*/
+
+	/* The fused loop needs src and dst to share word alignment	*/
+	/*   and the sum to start on an even byte; otherwise copy	*/
+	/*   and sum separately						*/
+
+	if ( (len < 16) || ((((uint32)src ^ (uint32)dst) & 3) != 0) ||
+	     ((uint32)src & 1) ) {
+		memcpy(dst, src, len);
+		return cksum_partial(src, len, sum);
+	}
+
+	head = (uint32)src & 2;
+	if (head) {
+		*(uint16 *)dst = *(uint16 *)src;
+		sum = cksum_partial(src, 2, sum);
+		src += 2;
+		dst += 2;
+		len -= 2;
+	}
+
+	acc = sum;
+	ws = (uint32 *)src;
+	wd = (uint32 *)dst;
+	for (; len >= 16; len -= 16) {
+		w0 = ws[0];
+		w1 = ws[1];
+		w2 = ws[2];
+		w3 = ws[3];
+		wd[0] = w0;
+		wd[1] = w1;
+		wd[2] = w2;
+		wd[3] = w3;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		ws += 4;
+		wd += 4;
+	}
+	for (; len >= 4; len -= 4) {
+		w0 = *ws++;
+		*wd++ = w0;
+		acc += w0;
+	}
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	sum = (uint32)acc;
+
+	/* Copy and add the last bytes */
+
+	if (len > 0) {
+		memcpy((char *)wd, (char *)ws, len);
+		sum = cksum_partial((char *)ws, len, sum);
+	}
+	return sum;
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_combine  -  Add the partial sum of a block that starts 'offset'
+ *			bytes into the data to the partial sum of the data
+ *			before it (an odd offset puts every byte of the
+ *			block in the other half of its word)
+ *------------------------------------------------------------------------
+ */
+uint32	cksum_combine(
+	  uint32	sum,		/* Partial sum of earlier data	*/
+	  uint32	part,		/* Partial sum of the block	*/
+	  int32		offset		/* Offset of the block		*/
+	)
+{
+	part = (part & 0xffff) + (part >> 16);
+	part = (part & 0xffff) + (part >> 16);
+	if (offset & 1) {
+		part = ((part & 0xff) << 8) | (part >> 8);
+	}
+	sum += part;
+	if (sum < part) {
+		sum++;			/* End-around carry		*/
+	}
+	return sum;
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_pseudo  -  Compute the partial sum of the IPv4 pseudo-header
+ *			used by UDP and TCP (arguments in host byte order)
+ *------------------------------------------------------------------------
+ */
+uint32	cksum_pseudo(
+	  uint32	src,		/* IP source address		*/
+	  uint32	dst,		/* IP destination address	*/
+	  byte		proto,		/* IP protocol			*/
+	  uint16	len		/* Length of the L4 segment	*/
+	)
+{
+	uint64	acc;			/* Sum with carries in top half	*/
+
+	acc = (uint64)htonl(src) + htonl(dst) + htons((uint16)proto) +
+							htons(len);
+
+	/* Fold twice: the first fold can carry into bit 32 again	*/
+
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	return (uint32)acc;
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_update16  -  Update a checksum after a 16-bit field changes
+ *			from 'oldval' to 'newval' without summing the
+ *			data again (RFC 1624, eqn. 3); all values are in
+ *			network byte order
+ *------------------------------------------------------------------------
+ */
+uint16	cksum_update16(
+	  uint16	ck,		/* Checksum stored in the header*/
+	  uint16	oldval,		/* Old value of the field	*/
+	  uint16	newval		/* New value of the field	*/
+	)
+{
+	uint32	sum;			/* ~HC + ~m + m'		*/
+
+	sum = (uint16)~ck + (uint16)~oldval + newval;
+	return cksum_fold(sum);
+}
+
+/*------------------------------------------------------------------------
+ *  cksum_update32  -  Update a checksum after a 32-bit field (such as
+ *			an IP address) changes; values in network byte
+ *			order
+ *------------------------------------------------------------------------
+ */
+uint16	cksum_update32(
+	  uint16	ck,		/* Checksum stored in the header*/
+	  uint32	oldval,		/* Old value of the field	*/
+	  uint32	newval		/* New value of the field	*/
+	)
+{
+	uint32	sum;			/* ~HC + ~m + m'		*/
+
+	sum = (uint16)~ck + (uint16)~(oldval & 0xffff) +
+			(uint16)~(oldval >> 16) + (newval & 0xffff) +
+			(newval >> 16);
+	return cksum_fold(sum);
+}
@@ -263,6 +263,10 @@ uint32	getlocalip(void)
 		NetData.ipvalid = TRUE;
 		udp_release(slot);
 
+		/* Announce the address and start resolving the router */
+
+		arp_announce();
+
 		/* Retrieve the boot server IP */
 		if (dot2ip((char*)dmsg_rvc.sname,
 					    &NetData.bootserver) != OK) {
@@ -1,30 +1,87 @@
-/* dns.c - dnslookup, dns_bldq, dns_geta, dns_getrname */
+/* dns.c - dns_init, dnslookup, dns_flush, dnsd, dns_cfind, dns_cadd,	*/
+/*		dns_qfind, dns_qsend, dns_qdone, dns_answer, dns_retry,	*/
+/*		dns_bldq, dns_parse, dns_rr, dns_getrname		*/
 
 #include <xinu.h>
 #include <string.h>
 #include <dns.h>
 
+struct	dnscent	dnscache[DNS_CACHESIZ];	/* Cache of names		*/
+struct	dnsquery dnsqtab[DNS_QUERIES];	/* Queries in flight		*/
+struct	dnsstat	dnsstats;		/* DNS statistics		*/
+sid32	dnsmutex;			/* Protects the tables above	*/
+
+/* All Queries go out from one UDP slot on DNSLPORT.  The process	*/
+/*   dnsd receives every Response, finds the Query it answers by its	*/
+/*   ID, caches the result and wakes the processes waiting for it.	*/
+/*   dnsd also resends Queries that go unanswered.			*/
+
+local	uid32	dnsslot;		/* UDP slot for all Queries	*/
+local	uint16	dnsid;			/* ID of the next Query		*/
+
+local	struct	dnscent *dns_cfind(char *);
+local	void	dns_cadd(char *, byte, uint32, uint32);
+local	struct	dnsquery *dns_qfind(char *);
+local	void	dns_qsend(struct dnsquery *);
+local	void	dns_qdone(struct dnsquery *, status, uint32);
+local	void	dns_answer(struct dnspkt *, int32, uint32, uint16);
+local	void	dns_retry(int32);
 local	uint32	dns_bldq(char *, char *);
-local	uint32	dns_geta(char *, struct dnspkt *);
-local	uint32	dns_getrname(char *, char *, char *);
+local	int32	dns_parse(char *, struct dnspkt *, int32, uint32 *,
+								uint32 *);
+local	char	*dns_rr(char *, char *, char *, char *, uint16 *,
+						uint32 *, char **, uint16 *);
+local	int32	dns_getrname(char *, char *, char *, char *);
 
 /*------------------------------------------------------------------------
- * dnslookup - Send a DNS Address Query and wait for the Response
+ * dns_init - Initialize the DNS cache and start dnsd
+ *------------------------------------------------------------------------
+ */
+void	dns_init(void)
+{
+	int32	i;			/* Index into the tables	*/
+
+	for (i = 0; i < DNS_CACHESIZ; i++) {
+		dnscache[i].dc_state = DNSC_FREE;
+	}
+	for (i = 0; i < DNS_QUERIES; i++) {
+		dnsqtab[i].dq_state = DNSQ_FREE;
+		dnsqtab[i].dq_sem = semcreate(0);
+		if ((int32)dnsqtab[i].dq_sem == SYSERR) {
+			panic("Cannot create DNS query semaphore");
+		}
+	}
+	memset((char *)&dnsstats, NULLCH, sizeof(dnsstats));
+	dnsid = (uint16)getticks();
+	dnsmutex = semcreate(1);
+	if ((int32)dnsmutex == SYSERR) {
+		panic("Cannot create DNS cache semaphore");
+	}
+
+	/* Accept Responses from any server on the local port */
+
+	dnsslot = udp_register(0, 0, DNSLPORT);
+	if (dnsslot == SYSERR) {
+		panic("Cannot register the DNS port");
+	}
+	resume(create(dnsd, NETSTK, NETPRIO, "dnsd", 0, NULL));
+}
+
+/*------------------------------------------------------------------------
+ * dnslookup - Find the address of a name in the cache, or send a DNS
+ *		 Address Query and wait for the Response
  *------------------------------------------------------------------------
  */
 uint32	dnslookup (
 	char	*dname	/* Domain name to be resolved	*/
 	)
 {
-	struct	dnspkt	qpkt;		/* Query Packet	buffer		*/
-	struct	dnspkt	rpkt;		/* Response Packet buffer	*/
-	uint32	nsaddr;			/* Name server IP address	*/
-	uint32	qlen;			/* Query length			*/
-	uid32	slot;			/* UDP Slot			*/
-	int32	rlen;			/* Response length		*/
-	uint32	ipaddr;			/* IP address from response	*/
-	int32	retval;			/* Return value			*/
-	int32	i;			/* Loop index			*/
+	char	name[DNS_NAMLEN];	/* Name in lower case		*/
+	struct	dnscent	*dcptr;		/* Cache entry for the name	*/
+	struct	dnsquery *dqptr;	/* Query for the name		*/
+	uint32	ipaddr;			/* IP address to return		*/
+	int32	i;			/* Index into the name		*/
+	char	ch;			/* Character of the name	*/
 
 	/* Check if we have a valid name pointer */
 
@@ -32,57 +89,393 @@ uint32	dnslookup (
 		return (uint32)SYSERR;
 	}
 
-	/* Obtain the IP address of a DNS server */
+	/* Names do not depend on case; use lower case and drop a	*/
+	/*   final dot so each name has one form in the cache		*/
+
+	for (i = 0; (dname[i] != NULLCH) && (i < DNS_NAMLEN); i++) {
+		ch = dname[i];
+		if ( (ch >= 'A') && (ch <= 'Z') ) {
+			ch += 'a' - 'A';
+		}
+		name[i] = ch;
+	}
+	if (i >= DNS_NAMLEN) {
+		return (uint32)SYSERR;
+	}
+	if ( (i > 0) && (name[i-1] == '.') ) {
+		i--;
+	}
+	if (i == 0) {
+		return (uint32)SYSERR;
+	}
+	name[i] = NULLCH;
+
+	wait(dnsmutex);
 
-	retval = getlocalip();
-	nsaddr = NetData.dnsserver;
-	if ( (retval == SYSERR) || (NetData.dnsserver == 0) ) {
+	/* Answer from the cache if the entry has not expired */
+
+	dcptr = dns_cfind(name);
+	if (dcptr != NULL) {
+		dcptr->dc_hits++;
+		dcptr->dc_used = clktime;
+		if (dcptr->dc_state == DNSC_ADDR) {
+			dnsstats.ds_hits++;
+			ipaddr = dcptr->dc_addr;
+		} else {
+			dnsstats.ds_neghits++;
+			ipaddr = (uint32)SYSERR;
+		}
+		signal(dnsmutex);
+		return ipaddr;
+	}
+
+	/* Wait for a Query already in flight for the name, or send one */
+
+	dqptr = dns_qfind(name);
+	if (dqptr != NULL) {
+		dnsstats.ds_joined++;
+	} else {
+		if (!NetData.ipvalid) {
+			signal(dnsmutex);
+			getlocalip();
+			wait(dnsmutex);
+		}
+		if ( !NetData.ipvalid || (NetData.dnsserver == 0) ) {
+			signal(dnsmutex);
 			kprintf("Cannot find a DNS server\n");
 			return (uint32)SYSERR;
+		}
+		for (i = 0; i < DNS_QUERIES; i++) {
+			if (dnsqtab[i].dq_state == DNSQ_FREE) {
+				break;
+			}
+		}
+		if (i >= DNS_QUERIES) {
+			signal(dnsmutex);
+			return (uint32)SYSERR;
+		}
+		dnsstats.ds_misses++;
+		dqptr = &dnsqtab[i];
+		dqptr->dq_state = DNSQ_WAIT;
+		strncpy(dqptr->dq_name, name, DNS_NAMLEN);
+		dqptr->dq_id = dnsid++;
+		dqptr->dq_server = NetData.dnsserver;
+		dqptr->dq_tries = 0;
+		dqptr->dq_nwait = 0;
+		dns_qsend(dqptr);
 	}
+	dqptr->dq_nwait++;
+	signal(dnsmutex);
 
-	/* Register a UDP Slot */
+	wait(dqptr->dq_sem);
 
-	slot = udp_register(nsaddr, DNSPORT, DNSLPORT);
-	if(slot == SYSERR) {
-		return (uint32)SYSERR;
+	wait(dnsmutex);
+	ipaddr = (dqptr->dq_result == OK) ? dqptr->dq_addr : (uint32)SYSERR;
+	if (--dqptr->dq_nwait == 0) {
+		dqptr->dq_state = DNSQ_FREE;
+	}
+	signal(dnsmutex);
+	return ipaddr;
+}
+
+/*------------------------------------------------------------------------
+ * dns_flush - Remove a name from the cache, or every name if the
+ *		 name is NULL; return SYSERR if the name is not cached
+ *------------------------------------------------------------------------
+ */
+status	dns_flush (
+	char	*dname			/* Name (lower case) or NULL	*/
+	)
+{
+	struct	dnscent	*dcptr;		/* Cache entry for the name	*/
+	int32	i;			/* Index into dnscache		*/
+
+	wait(dnsmutex);
+	if (dname == NULL) {
+		for (i = 0; i < DNS_CACHESIZ; i++) {
+			dnscache[i].dc_state = DNSC_FREE;
+		}
+		signal(dnsmutex);
+		return OK;
+	}
+	dcptr = dns_cfind(dname);
+	if (dcptr == NULL) {
+		signal(dnsmutex);
+		return SYSERR;
 	}
+	dcptr->dc_state = DNSC_FREE;
+	signal(dnsmutex);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * dnsd - Process that receives DNS Responses and resends lost Queries
+ *------------------------------------------------------------------------
+ */
+process	dnsd(void)
+{
+	struct	dnspkt	rpkt;		/* Response Packet buffer	*/
+	int32	rlen;			/* Response length		*/
+	uint32	remip;			/* Address of the sender	*/
+	uint16	remport;		/* Port of the sender		*/
+	uint32	last;			/* Time of the last check (ms)	*/
+	uint32	now;			/* Current time (ms)		*/
+
+	last = clkms();
+	while (TRUE) {
+		rlen = udp_recvaddr(dnsslot, &remip, &remport, (char *)&rpkt,
+					sizeof(struct dnspkt), DNS_TICK);
+
+		wait(dnsmutex);
+		if ( (rlen != SYSERR) && (rlen != TIMEOUT) ) {
+			dns_answer(&rpkt, rlen, remip, remport);
+		}
+		now = clkms();
+		if (now - last >= DNS_TICK) {
+			dns_retry(now - last);
+			last = now;
+		}
+		signal(dnsmutex);
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * dns_cfind - Find the unexpired cache entry for a name, freeing it if
+ *		 it has expired (dnsmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	struct	dnscent	*dns_cfind (
+	char	*name			/* Name in lower case		*/
+	)
+{
+	struct	dnscent	*dcptr;		/* Pointer to a cache entry	*/
+	int32	i;			/* Index into dnscache		*/
+
+	for (i = 0; i < DNS_CACHESIZ; i++) {
+		dcptr = &dnscache[i];
+		if ( (dcptr->dc_state == DNSC_FREE) ||
+		     (strcmp(dcptr->dc_name, name) != 0) ) {
+			continue;
+		}
+		if ((int32)(dcptr->dc_expire - clktime) <= 0) {
+			dcptr->dc_state = DNSC_FREE;
+			return NULL;
+		}
+		return dcptr;
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------
+ * dns_cadd - Cache the result for a name, replacing an expired entry
+ *		or else the one least recently used (dnsmutex must be
+ *		held)
+ *------------------------------------------------------------------------
+ */
+local	void	dns_cadd (
+	char	*name,			/* Name in lower case		*/
+	byte	state,			/* DNSC_ADDR or DNSC_NONAME	*/
+	uint32	ipaddr,			/* Address of the name		*/
+	uint32	ttl			/* Seconds to keep the result	*/
+	)
+{
+	struct	dnscent	*dcptr;		/* Pointer to a cache entry	*/
+	struct	dnscent	*victim;	/* Entry to replace		*/
+	int32	i;			/* Index into dnscache		*/
+
+	if (ttl == 0) {			/* Result must not be cached	*/
+		return;
+	}
+	dcptr = dns_cfind(name);
+	if (dcptr == NULL) {
+		victim = NULL;
+		for (i = 0; i < DNS_CACHESIZ; i++) {
+			dcptr = &dnscache[i];
+			if ( (dcptr->dc_state == DNSC_FREE) ||
+			     ((int32)(dcptr->dc_expire - clktime) <= 0) ) {
+				victim = dcptr;
+				break;
+			}
+			if ( (victim == NULL) ||
+			     ((int32)(dcptr->dc_used - victim->dc_used) < 0) ) {
+				victim = dcptr;
+			}
+		}
+		dcptr = victim;
+		strncpy(dcptr->dc_name, name, DNS_NAMLEN);
+		dcptr->dc_hits = 0;
+	}
+	dcptr->dc_state = state;
+	dcptr->dc_addr = ipaddr;
+	dcptr->dc_expire = clktime + ttl;
+	dcptr->dc_used = clktime;
+}
+
+/*------------------------------------------------------------------------
+ * dns_qfind - Find the Query in flight for a name (dnsmutex must be
+ *		 held)
+ *------------------------------------------------------------------------
+ */
+local	struct	dnsquery *dns_qfind (
+	char	*name			/* Name in lower case		*/
+	)
+{
+	int32	i;			/* Index into dnsqtab		*/
+
+	for (i = 0; i < DNS_QUERIES; i++) {
+		if ( (dnsqtab[i].dq_state == DNSQ_WAIT) &&
+		     (strcmp(dnsqtab[i].dq_name, name) == 0) ) {
+			return &dnsqtab[i];
+		}
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------
+ * dns_qsend - Send (or resend) the Query for an entry and start its
+ *		 timer; a resend keeps the ID, so a late Response to an
+ *		 earlier copy still counts
+ *------------------------------------------------------------------------
+ */
+local	void	dns_qsend (
+	struct	dnsquery *dqptr		/* Query to send		*/
+	)
+{
+	struct	dnspkt	qpkt;		/* Query Packet	buffer		*/
+	uint32	qlen;			/* Query length			*/
 
 	/* Build the Query message */
 
 	memset((char *)&qpkt, 0, sizeof(struct dnspkt));
 
-	qpkt.id = currpid;
+	qpkt.id = htons(dqptr->dq_id);
 	qpkt.rd = 1;
 	qpkt.qucount = htons(1);
 
-	qlen = dns_bldq(dname, qpkt.data);
+	qlen = dns_bldq(dqptr->dq_name, qpkt.data);
+
+	/* A send that fails is treated like a lost Query */
+
+	dqptr->dq_tries++;
+	dqptr->dq_timer = DNSTIMEOUT;
+	dnsstats.ds_sent++;
+	if (qlen != (uint32)SYSERR) {
+		udp_sendto(dnsslot, dqptr->dq_server, DNSPORT, (char *)&qpkt,
+									qlen);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * dns_qdone - Record the result of a Query and wake its waiters
+ *------------------------------------------------------------------------
+ */
+local	void	dns_qdone (
+	struct	dnsquery *dqptr,	/* Query that has finished	*/
+	status	result,			/* OK or SYSERR			*/
+	uint32	ipaddr			/* Address found		*/
+	)
+{
+	dqptr->dq_state = DNSQ_DONE;
+	dqptr->dq_result = result;
+	dqptr->dq_addr = ipaddr;
+	signaln(dqptr->dq_sem, dqptr->dq_nwait);
+}
+
+/*------------------------------------------------------------------------
+ * dns_answer - Handle a Response: cache it and finish its Query
+ *------------------------------------------------------------------------
+ */
+local	void	dns_answer (
+	struct	dnspkt	*rpkt,		/* Response			*/
+	int32	rlen,			/* Length of the Response	*/
+	uint32	remip,			/* Address of the sender	*/
+	uint16	remport			/* Port of the sender		*/
+	)
+{
+	struct	dnsquery *dqptr;	/* Query the Response answers	*/
+	uint32	ipaddr;			/* Address in the Response	*/
+	uint32	ttl;			/* Seconds to cache the result	*/
+	int32	i;			/* Index into dnsqtab		*/
+
+	/* Find the Query by its ID; it must come from the server	*/
+	/*   the Query was sent to					*/
+
+	dqptr = NULL;
+	if ( (rlen >= sizeof(struct dnspkt) - DNSDATASIZ) &&
+	     (remport == DNSPORT) ) {
+		for (i = 0; i < DNS_QUERIES; i++) {
+			if ( (dnsqtab[i].dq_state == DNSQ_WAIT) &&
+			     (dnsqtab[i].dq_id == ntohs(rpkt->id)) &&
+			     (dnsqtab[i].dq_server == remip) ) {
+				dqptr = &dnsqtab[i];
+				break;
+			}
+		}
+	}
+	if (dqptr == NULL) {
+		dnsstats.ds_badresp++;
+		return;
+	}
 
-	ipaddr = (uint32)SYSERR;
-	for(i = 0; (ipaddr==(uint32)SYSERR) && (i < DNSRETRY); i++) {
+	switch (dns_parse(dqptr->dq_name, rpkt, rlen, &ipaddr, &ttl)) {
 
-		/* Send the Query message */
+	    case DNS_ADDR:
+		dns_cadd(dqptr->dq_name, DNSC_ADDR, ipaddr, ttl);
+		dns_qdone(dqptr, OK, ipaddr);
+		break;
 
-		udp_send(slot, (char*)&qpkt, qlen);
+	    case DNS_NONAME:
+		dns_cadd(dqptr->dq_name, DNSC_NONAME, 0, ttl);
+		dns_qdone(dqptr, SYSERR, 0);
+		break;
 
-		/* Wait for the response */
+	    case DNS_FAIL:
+		dns_qdone(dqptr, SYSERR, 0);
+		break;
 
-		rlen = udp_recv(slot, (char*)&rpkt, sizeof(struct dnspkt),
-						DNSTIMEOUT);
-		if ( (rlen == SYSERR) || (rlen == TIMEOUT) ) {
+	    default:			/* Not a valid answer; keep	*/
+		dnsstats.ds_badresp++;	/*   waiting			*/
+		break;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * dns_retry - Run the timers of the Queries in flight, resending those
+ *		 that have not been answered and giving up after DNSRETRY
+ *		 tries
+ *------------------------------------------------------------------------
+ */
+local	void	dns_retry (
+	int32	elapsed			/* Time since the last call (ms)*/
+	)
+{
+	struct	dnsquery *dqptr;	/* Pointer to a Query		*/
+	int32	i;			/* Index into dnsqtab		*/
+
+	for (i = 0; i < DNS_QUERIES; i++) {
+		dqptr = &dnsqtab[i];
+		if (dqptr->dq_state != DNSQ_WAIT) {
+			continue;
+		}
+		dqptr->dq_timer -= elapsed;
+		if (dqptr->dq_timer > 0) {
 			continue;
 		}
-		ipaddr = dns_geta(dname, &rpkt);
+		if (dqptr->dq_tries < DNSRETRY) {
+			dns_qsend(dqptr);
+		} else {
+			dnsstats.ds_timeouts++;
+			dns_qdone(dqptr, SYSERR, 0);
+		}
 	}
-	udp_release(slot);
-	return ntohl(ipaddr);
 }
 
 /*------------------------------------------------------------------------
  * dns_bldq - Build a DNS Question and return the length of the packet
  *------------------------------------------------------------------------
  */
-uint32	dns_bldq (
+local	uint32	dns_bldq (
 	 char	*dname,			/* Domain Name			*/
 	 char	*data			/* Pointer to buffer for data	*/
 	)
@@ -149,174 +542,254 @@ uint32	dns_bldq (
 }
 
 /*------------------------------------------------------------------------
- * dns_geta - return the best IP address in the Answer Section
+ * dns_parse - Find the best IP address for a name in a Response and the
+ *		 time the result may be cached; return DNS_ADDR,
+ *		 DNS_NONAME, DNS_FAIL or SYSERR if the Response is not a
+ *		 valid answer to the Question
  *------------------------------------------------------------------------
  */
-uint32	dns_geta (
-	char	*dname,			/* Domain Name			*/
-	struct	dnspkt *rpkt		/* Pointer to a response packet	*/
+local	int32	dns_parse (
+	char	*dname,			/* Domain Name asked about	*/
+	struct	dnspkt *rpkt,		/* Pointer to a response packet	*/
+	int32	rlen,			/* Length of the Response	*/
+	uint32	*ipaddr,		/* Where to put the address	*/
+	uint32	*ttl			/* Where to put the TTL (secs)	*/
 	)
 {
-	uint16	qcount;			/* Number of Questions		*/
-	uint16	tmp16;			/* Used for endian conversion	*/
-	uint16	acount;			/* Number of Answers		*/
-	uint32	ipaddr;			/* IP address from the response	*/
+	char	*sop;			/* Start of packet		*/
+	char	*eop;			/* End of packet		*/
 	char	*dptr;			/* Data pointer			*/
-	byte	llen;			/* Label length			*/
+	char	*rdata;			/* Data of a Resource Record	*/
+	char	rname[DNS_NAMLEN];	/* Name of a Resource Record	*/
+	char	cname[DNS_NAMLEN];	/* Name the address is under	*/
+	uint16	type;			/* Type of a Resource Record	*/
+	uint16	rdlen;			/* Length of its data		*/
+	uint32	rttl;			/* TTL of a Resource Record	*/
+	uint32	minttl;			/* Smallest TTL along the chain	*/
+	uint32	tmpip;			/* Address from a record	*/
+	uint32	addr;			/* Best address so far		*/
+	int32	n;			/* Length of the name		*/
 	int32	i;			/* Loop index			*/
 
-	/* Pick up the count of questions */
-
-	memcpy((char *)&tmp16, (char *) &rpkt->qucount, 2);
-	qcount = ntohs(tmp16);
-	dptr = rpkt->data;
-
-	/* Skip qcount questions */
-
-	for(i = 0; i < qcount; i++) {
-
-		/* Get the label length */
-
-		llen = *((byte *)dptr);
+	sop = (char *)rpkt;
+	eop = sop + rlen;
+	if ( !rpkt->qr || (ntohs(rpkt->qucount) != 1) ) {
+		return SYSERR;
+	}
 
-		/* While we haven't reached the end of this domain name	*/
+	/* The Response must repeat the Question */
 
-		while(llen != 0) {
+	dptr = rpkt->data;
+	n = dns_getrname(sop, eop, dptr, rname);
+	if ( (n == SYSERR) || (strcmp(rname, dname) != 0) ||
+	     (dptr + n + 4 > eop) ) {
+		return SYSERR;
+	}
+	dptr += n + 4;
 
-			/* Pointer means end of name */
+	if ( (rpkt->rcode != DNS_RC_OK) &&
+	     (rpkt->rcode != DNS_RC_NXDOMAIN) ) {
+		return DNS_FAIL;
+	}
 
-			if(llen > 63) {
-				dptr += 2;
-				break;
+	/* Follow CNAME records from the name asked about and prefer	*/
+	/*   an address on the local net				*/
+
+	strncpy(cname, dname, DNS_NAMLEN);
+	minttl = DNS_MAXTTL;
+	addr = 0;
+	for (i = 0; i < ntohs(rpkt->ancount); i++) {
+		dptr = dns_rr(sop, eop, dptr, rname, &type, &rttl, &rdata,
+								&rdlen);
+		if (dptr == NULL) {
+			return SYSERR;
+		}
+		if (strcmp(rname, cname) != 0) {
+			continue;
+		}
+		if ( (type == DNS_QT_A) && (rdlen == 4) ) {
+			memcpy((char *)&tmpip, rdata, 4);
+			tmpip = ntohl(tmpip);
+			if ( (addr == 0) ||
+			     ((NetData.ipmask & tmpip) == NetData.ipprefix) ) {
+				addr = tmpip;
 			}
-
-			/* Move to the next label */
-
-			dptr += (llen + 1);
-			llen = *((byte *)dptr);
+		} else if (type == DNS_QT_CNAME) {
+			if (dns_getrname(sop, eop, rdata, cname) == SYSERR) {
+				return SYSERR;
+			}
+		} else {
+			continue;
 		}
-
-		/* Move to next question */
-
-		if (llen == 0) {
-			dptr += 1;
+		if (rttl < minttl) {
+			minttl = rttl;
 		}
-
-		/* Skip the type and class */
-
-		dptr += (2 + 2);
+	}
+	if ( (rpkt->rcode == DNS_RC_OK) && (addr != 0) ) {
+		*ipaddr = addr;
+		*ttl = minttl;
+		return DNS_ADDR;
 	}
 
-	/* Pick up the count of answers */
-
-	memcpy((char *)&tmp16, (char *)&rpkt->ancount, 2);
-	acount = ntohs(tmp16);
-
-	/* Set the IP address to zero */
-
-	ipaddr = 0;
-
-	/* Check each answer to see if it matches the local net */
-
-	for(i = 0; i < acount; i++) {
-
-		char	rname[1024];
-		uint16	tmptype;
-		uint32	tmpip;
-		uint16	tmplen;
-		uint32	namlen;
-
-		/* Get the name, and the number of bytes it occupied	*/
-		/*    in the packet (may be short if the name contains	*/
-		/*    pointer (e.g.,back to the question)		*/
-
-		namlen = dns_getrname( (char *)rpkt, dptr, rname);
-		dptr += namlen;
-
-		/* Verify that the answer matches and is Type A */
-
-		memcpy((char *)&tmptype, dptr, 2);
-		if( (strncmp(dname, rname, strlen(dname)) == 0) &&
-		    (ntohs(tmptype) == DNS_QT_A) ) {
-
-			/* Pick up the IP address */
+	/* The name has no address; the SOA record in the Authority	*/
+	/*   section says how long that may be cached (RFC 2308)	*/
 
-			memcpy((char *)&tmpip, dptr+10, 4);
-			if ((ipaddr == 0) ||
-				    ((NetData.ipmask&ntohl(tmpip)) ==
-					NetData.ipprefix) ) {
-				ipaddr = tmpip;
-			}
+	*ttl = DNS_NEGTTL;
+	for (i = 0; i < ntohs(rpkt->nscount); i++) {
+		dptr = dns_rr(sop, eop, dptr, rname, &type, &rttl, &rdata,
+								&rdlen);
+		if (dptr == NULL) {
+			break;
+		}
+		if (type != DNS_QT_SOA) {
+			continue;
 		}
 
+		/* Skip the MNAME and RNAME; MINIMUM is the last field */
 
-		/* Move past the type, class, and ttl fields to the length */
-
-		dptr += 8;
+		n = dns_getrname(sop, eop, rdata, rname);
+		if (n == SYSERR) {
+			break;
+		}
+		rdata += n;
+		n = dns_getrname(sop, eop, rdata, rname);
+		if ( (n == SYSERR) || (rdata + n + 20 > dptr) ) {
+			break;
+		}
+		memcpy((char *)&tmpip, rdata + n + 16, 4);
+		tmpip = ntohl(tmpip);
+		*ttl = (tmpip < rttl) ? tmpip : rttl;
+		break;
+	}
+	if (*ttl > DNS_NEGMAX) {
+		*ttl = DNS_NEGMAX;
+	}
+	return DNS_NONAME;
+}
 
-		/* Move past the length field itself (2 bytes) and data */
+/*------------------------------------------------------------------------
+ * dns_rr - Decode the Resource Record at dptr; return a pointer to the
+ *	      next one, or NULL if the record runs past the packet
+ *------------------------------------------------------------------------
+ */
+local	char	*dns_rr (
+	char	*sop,			/* Start of Packet		*/
+	char	*eop,			/* End of Packet		*/
+	char	*dptr,			/* Start of the record		*/
+	char	*rname,			/* Where to put its name	*/
+	uint16	*type,			/* Where to put its type	*/
+	uint32	*ttl,			/* Where to put its TTL (secs)	*/
+	char	**rdata,		/* Where to put its data pointer*/
+	uint16	*rdlen			/* Where to put its data length	*/
+	)
+{
+	int32	n;			/* Length of the name		*/
+	uint16	tmp16;			/* Used for endian conversion	*/
+	uint32	tmp32;			/* Used for endian conversion	*/
 
-		memcpy((char *)&tmplen, dptr, 2);
-		dptr += ntohs(tmplen) + 2;
+	n = dns_getrname(sop, eop, dptr, rname);
+	if ( (n == SYSERR) || (dptr + n + 10 > eop) ) {
+		return NULL;
+	}
+	dptr += n;
+
+	memcpy((char *)&tmp16, dptr, 2);
+	*type = ntohs(tmp16);
+	memcpy((char *)&tmp32, dptr + 4, 4);
+	*ttl = ntohl(tmp32);
+	memcpy((char *)&tmp16, dptr + 8, 2);
+	*rdlen = ntohs(tmp16);
+	*rdata = dptr + 10;
+	if (*rdata + *rdlen > eop) {
+		return NULL;
 	}
 
-	if (ipaddr != 0) {
-		return ipaddr;
-	} else {
-		return (uint32)SYSERR;
+	/* A TTL with the top bit set is treated as zero (RFC 2181) */
+
+	if (*ttl > 0x7fffffff) {
+		*ttl = 0;
+	} else if (*ttl > DNS_MAXTTL) {
+		*ttl = DNS_MAXTTL;
 	}
+	return *rdata + *rdlen;
 }
 
 /*------------------------------------------------------------------------
- * dns_getrname - Convert a domain name in a RR to a null-terminted string
+ * dns_getrname - Convert a domain name in a RR to a null-terminated
+ *		    string in lower case; return the number of bytes the
+ *		    name occupies at son, or SYSERR if it is malformed
  *------------------------------------------------------------------------
  */
-uint32	dns_getrname (
+local	int32	dns_getrname (
 	char	*sop,			/* Start of Packet		*/
+	char	*eop,			/* End of Packet		*/
 	char	*son,			/* Start of Name		*/
 	char	*dst			/* Destination buffer		*/
 	)
 {
 	byte	llen;			/* Label length			*/
-	uint16	tmpoff;			/* Temporary to hold offset	*/
-	uint16	offset;			/* Offset in host byte order	*/
-	char	*sson;			/* Saved start of name		*/
+	char	*ptr;			/* Next byte of the name	*/
+	int32	used;			/* Bytes of the name at son	*/
+	int32	dlen;			/* Characters in dst		*/
+	int32	jumps;			/* Pointers followed		*/
 	int32	i;			/* Loop index			*/
+	char	ch;			/* Character of a label		*/
 
-	/* Record initial position */
+	ptr = son;
+	used = -1;
+	dlen = 0;
+	jumps = 0;
 
-	sson = son;
+	/* Copy labels, following pointers to the rest of the name */
 
-	/* Pick up length of initial label */
-
-	llen = *son++;
-
-	/* While not at the end of the name, pick up a label */
+	while (TRUE) {
+		if (ptr >= eop) {
+			return SYSERR;
+		}
+		llen = *(byte *)ptr;
+		if (llen == 0) {
+			ptr++;
+			break;
+		}
+		if (llen > 63) {
 
-	while(llen != 0) {
+			/* A pointer ends the name at son; a loop of them	*/
+			/*   is malformed					*/
 
-		if(llen <= 63) {
-			/* Copy the label into the destination string */
-			for(i = 0; i < llen; i++) {
-				*dst++ = *son++;
+			if ( ((llen & 0xc0) != 0xc0) || (ptr + 1 >= eop) ||
+			     (++jumps > 16) ) {
+				return SYSERR;
 			}
-			*dst++ = '.';
-			llen = *son++;
-		} else {
-			/* Handle pointer to remainder of name */
-			son--;
-			memcpy( (char *)&tmpoff, son, 2);
-			offset = ntohs(tmpoff) & 0x3fff;
-			son += 2;
-			dns_getrname(sop, sop+offset, dst);
-			return (son-sson);
+			if (used < 0) {
+				used = ptr + 2 - son;
+			}
+			ptr = sop + (((llen & 0x3f) << 8) | *(byte *)(ptr+1));
+			continue;
+		}
+		if ( (ptr + 1 + llen > eop) ||
+		     (dlen + llen + 1 >= DNS_NAMLEN) ) {
+			return SYSERR;
+		}
+		for (i = 1; i <= llen; i++) {
+			ch = ptr[i];
+			if ( (ch >= 'A') && (ch <= 'Z') ) {
+				ch += 'a' - 'A';
+			}
+			dst[dlen++] = ch;
 		}
+		dst[dlen++] = '.';
+		ptr += llen + 1;
 	}
 
-	/* Null-terminate the string */
+	/* Null-terminate the string, replacing the final dot */
 
-	dst--;
-	*dst = NULLCH;
+	if (dlen > 0) {
+		dlen--;
+	}
+	dst[dlen] = NULLCH;
 
-	return (uint32)(son-sson);
+	if (used < 0) {
+		used = ptr - son;
+	}
+	return used;
 }
@@ -4,6 +4,7 @@
 #include <xinu.h>
 
 struct	icmpentry icmptab[ICMP_SLOTS];	/* Table of processes using ping*/
+sid32	icmpmutex;			/* Protects icmptab		*/
 
 /*------------------------------------------------------------------------
  * icmp_init  -  Initialize icmp table
@@ -16,6 +17,7 @@ void	icmp_init(void) {
 	for(i=0; i<ICMP_SLOTS; i++) {
 		icmptab[i].icstate = ICMP_FREE;
 	}
+	icmpmutex = semcreate(1);
 	return;
 }
 
@@ -27,19 +29,15 @@ void	icmp_in(
 	  struct netpacket *pkt		/* Pointer to incoming packet	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	int32	slot;			/* Slot in ICMP table		*/
 	struct	icmpentry *icmptr;	/* Pointer to icmptab entry	*/
-	struct	netpacket *replypkt;	/* Pointer to reply packet	*/
-
-	mask = disable();
 
 	/* Discard all ICMP messages except ping */
 
-	if ( (pkt->net_ictype != ICMP_ECHOREPLY) &&
-	     (pkt->net_ictype != ICMP_ECHOREQST)  )	{
-		freebuf((char *)pkt);
-		restore(mask);
+	if ( (pb_len(pkt) < ICMP_HDR_LEN) ||
+	     ( (pkt->net_ictype != ICMP_ECHOREPLY) &&
+	       (pkt->net_ictype != ICMP_ECHOREQST) ) ) {
+		pb_free(pkt);
 		return;
 	}
 
@@ -47,17 +45,18 @@ void	icmp_in(
 
 	if (pkt->net_ictype == ICMP_ECHOREQST) {
 
-		/* Send echo reply message */
-
-		replypkt = icmp_mkpkt(pkt->net_ipsrc,ICMP_ECHOREPLY,
-				pkt->net_icident, pkt->net_icseq,
-				(char *) &pkt->net_icdata,
-				pkt->net_iplen-IP_HDR_LEN-ICMP_HDR_LEN);
-		if ((int32)replypkt != SYSERR) {
-			ip_enqueue(replypkt);
+		/* Turn the request into the reply in the same buffer:	*/
+		/*   the ICMP message is the data of the packet, so IP	*/
+		/*   prepends new headers in place of the old ones	*/
+
+		pkt->net_ictype = ICMP_ECHOREPLY;
+		pkt->net_iccode = 0;
+		pkt->net_iccksum = 0x0000;
+		if (ip_push(pkt, IP_ICMP, pkt->net_ipsrc) == SYSERR) {
+			pb_free(pkt);
+		} else {
+			ip_enqueue(pkt);
 		}
-		freebuf((char *)pkt);
-		restore(mask);
 		return;
 	}
 
@@ -65,19 +64,20 @@ void	icmp_in(
 
 	slot = pkt->net_icident;
 	if ( (slot < 0) || (slot >= ICMP_SLOTS) ) {
-		freebuf((char *)pkt);
-		restore(mask);
+		pb_free(pkt);
 		return;
 	}
 
 	/* Verify that slot in table is in use and IP address	*/
 	/*    in incomming packet matches IP address in table	*/
 
+	wait(icmpmutex);
 	icmptr = &icmptab[slot];
 	if ( (icmptr->icstate == ICMP_FREE) ||
-	     (pkt->net_ipsrc != icmptr->icremip) ) {
-		freebuf((char *)pkt);	/* discard packet */
-		restore(mask);
+	     (pkt->net_ipsrc != icmptr->icremip) ||
+	     (icmptr->iccount >= ICMP_QSIZ) ) {
+		signal(icmpmutex);
+		pb_free(pkt);		/* discard packet */
 		return;
 	}
 
@@ -92,7 +92,7 @@ void	icmp_in(
 		icmptr->icstate = ICMP_USED;
 		send (icmptr->icpid, OK);
 	}
-	restore(mask);
+	signal(icmpmutex);
 	return;
 }
 
@@ -104,12 +104,11 @@ int32	icmp_register (
 	 uint32	remip			/* Remote IP address		*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	int32	i;			/* Index into icmptab		*/
 	int32	freeslot;		/* Index of slot to use		*/
 	struct	icmpentry *icmptr;	/* Pointer to icmptab entry	*/
 
-	mask = disable();
+	wait(icmpmutex);
 
 	/* Find a free slot in the table */
 
@@ -121,13 +120,13 @@ int32	icmp_register (
 				freeslot = i;
 			}
 		} else if (icmptr->icremip == remip) {
-			restore(mask);
+			signal(icmpmutex);
 			return SYSERR;	/* Already registered */
 		}
 	}
 	if (freeslot == -1) {  /* No free entries in table */
 
-		restore(mask);
+		signal(icmpmutex);
 		return SYSERR;
 	}
 
@@ -139,7 +138,7 @@ int32	icmp_register (
 	icmptr->iccount = 0;
 	icmptr->ichead = icmptr->ictail = 0;
 	icmptr->icpid = -1;
-	restore(mask);
+	signal(icmpmutex);
 	return freeslot;
 }
 
@@ -154,13 +153,10 @@ int32	icmp_recv (
 	 uint32	timeout			/* Time to wait in msec		*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	struct	icmpentry *icmptr;	/* Pointer to icmptab entry	*/
 	umsg32	msg;			/* Message from recvtime()	*/
 	struct	netpacket *pkt;		/* Pointer to packet being read	*/
 	int32	datalen;		/* Length of ICMP data area	*/
-	char	*icdataptr;		/* Pointer to icmp data		*/
-	int32	i;			/* Counter for data copy	*/
 
 	/* Verify that the ID is valid */
 
@@ -170,52 +166,54 @@ int32	icmp_recv (
 
 	/* Insure only one process touches the table at a time */
 
-	mask = disable();
+	wait(icmpmutex);
 
 	/* Verify that the ID has been registered and is idle */
 
 	icmptr = &icmptab[icmpid];
 	if (icmptr->icstate != ICMP_USED) {
-		restore(mask);
+		signal(icmpmutex);
 		return SYSERR;
 	}
 
+	/* Wait for a reply with the table unlocked; a message sent	*/
+	/*   before recvtime is called is kept, so it is not lost	*/
+
 	if (icmptr->iccount == 0) {		/* No packet is waiting */
 		icmptr->icstate = ICMP_RECV;
 		icmptr->icpid = currpid;
 		msg = recvclr();
+		signal(icmpmutex);
 		msg = recvtime(timeout);	/* Wait for a reply */
+		wait(icmpmutex);
 		icmptr->icstate = ICMP_USED;
-		if (msg == TIMEOUT) {
-			restore(mask);
-			return TIMEOUT;
-		} else if (msg != OK) {
-			restore(mask);
-			return SYSERR;
+		if (icmptr->iccount == 0) {
+			signal(icmpmutex);
+			return (msg == TIMEOUT) ? TIMEOUT : SYSERR;
 		}
 	}
 
 	/* Packet has arrived -- dequeue it */
 
 	pkt = icmptr->icqueue[icmptr->ichead++];
-	if (icmptr->ichead >= ICMP_SLOTS) {
+	if (icmptr->ichead >= ICMP_QSIZ) {
 		icmptr->ichead = 0;
 	}
 	icmptr->iccount--;
+	signal(icmpmutex);
 
 	/* Copy data from ICMP message into caller's buffer */
 
-	datalen = pkt->net_iplen - IP_HDR_LEN - ICMP_HDR_LEN;
-	icdataptr = (char *) &pkt->net_icdata;
-	for (i=0; i<datalen; i++) {
-		if (i >= len) {
-			break;
-		}
-		*buff++ = *icdataptr++;
+	datalen = pb_len(pkt) - ICMP_HDR_LEN;
+	if (datalen > len) {
+		datalen = len;
 	}
-	freebuf((char *)pkt);
-	restore(mask);
-	return i;
+	if (datalen < 0) {
+		datalen = 0;
+	}
+	memcpy(buff, pb_data(pkt) + ICMP_HDR_LEN, datalen);
+	pb_free(pkt);
+	return datalen;
 }
 
 /*------------------------------------------------------------------------
@@ -231,11 +229,7 @@ status	icmp_send (
 	 int32	len			/* Length of data in buffer	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	struct	netpacket *pkt;		/* Packet returned by icmp_mkpkt*/
-	int32	retval;			/* Value returned by ip_send	*/
-
-	mask = disable();
 
 	/* Form a packet to send */
 
@@ -246,14 +240,13 @@ status	icmp_send (
 
 	/* Send the packet */
 
-	retval = ip_send(pkt);
-	restore(mask);
-	return retval;
+	return ip_send(pkt);
 }
 
 
 /*------------------------------------------------------------------------
- * icmp_mkpkt  -  Make an icmp packet by filling in fields
+ * icmp_mkpkt  -  Make an icmp packet: copy in the data, then prepend
+ *		    the ICMP header and let IP prepend its headers
  *------------------------------------------------------------------------
  */
 struct	netpacket *icmp_mkpkt (
@@ -266,38 +259,38 @@ struct	netpacket *icmp_mkpkt (
 	)
 {
 	struct	netpacket *pkt;		/* pointer to packet buffer	*/
-	static	uint32	ipident=32767;	/* IP ident field		*/
+	char	*dptr;			/* Where the data go		*/
 
 	/* Allocate packet */
 
-	pkt = (struct netpacket *)getbuf(netbufpool);
+	pkt = pb_alloc();
 
 	if ((int32)pkt == SYSERR) {
 		panic("icmp_mkpkt: cannot get a network buffer\n");
 	}
 
-	/* Create icmp packet in pkt */
+	/* Leave room for the headers and copy in the data */
 
-	memcpy(pkt->net_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
-        pkt->net_ethtype = 0x800;	/* Type is IP */
-	pkt->net_ipvh = 0x45;		/* IP version and hdr length	*/
-	pkt->net_iptos = 0x00;		/* Type of service		*/
-	pkt->net_iplen= IP_HDR_LEN+ICMP_HDR_LEN+len;/* datagram length	*/
-	pkt->net_ipid = ipident++;	/* Datagram gets next IDENT	*/
-	pkt->net_ipfrag = 0x0000;	/* IP flags & fragment offset	*/
-	pkt->net_ipttl = 0xff;		/* IP time-to-live		*/
-	pkt->net_ipproto = IP_ICMP;	/* Datagram carries icmp	*/
-	pkt->net_ipcksum = 0x0000;	/* Initial checksum		*/
-	pkt->net_ipsrc = NetData.ipucast; /* IP source address	*/
-	pkt->net_ipdst = remip;		/* IP destination address	*/
+	pb_reserve(pkt, (char *)pkt->net_icdata - (char *)pkt);
+	dptr = pb_put(pkt, len);
+	if (dptr == (char *)SYSERR) {
+		pb_free(pkt);
+		return (struct netpacket *)SYSERR;
+	}
+	memcpy(dptr, buf, len);
 
+	/* Prepend the ICMP header, then the IP and Ethernet headers */
 
+	pb_push(pkt, ICMP_HDR_LEN);
 	pkt->net_ictype = type;		/* ICMP type			*/
 	pkt->net_iccode = 0;		/* Code is zero for ping	*/
 	pkt->net_iccksum = 0x0000;	/* Temporarily zero the cksum	*/
 	pkt->net_icident = ident;	/* ICMP identification		*/
 	pkt->net_icseq = seq;		/* ICMP sequence number		*/
-	memcpy(pkt->net_icdata, buf, len);
+	if (ip_push(pkt, IP_ICMP, remip) == SYSERR) {
+		pb_free(pkt);
+		return (struct netpacket *)SYSERR;
+	}
 
 	/* Return packet to caller */
 
@@ -313,47 +306,44 @@ status	icmp_release (
 	 int32	icmpid			/* Slot in icmptab to release	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	struct	icmpentry *icmptr;	/* Pointer to icmptab entry	*/
 	struct	netpacket *pkt;		/* Pointer to packet		*/
 
-	mask = disable();
+	wait(icmpmutex);
 
 	/* Check arg and insure entry in table is in use */
 
 	if ( (icmpid < 0) || (icmpid >= ICMP_SLOTS) ) {
-		restore(mask);
+		signal(icmpmutex);
 		return SYSERR;
 	}
 	icmptr = &icmptab[icmpid];
 	if (icmptr->icstate != ICMP_USED) {
-		restore(mask);
+		signal(icmpmutex);
 		return SYSERR;
 	}
 
 	/* Remove each packet from the queue and free the buffer */
 
-	resched_cntl(DEFER_START);
 	while (icmptr->iccount > 0) {
 		pkt = icmptr->icqueue[icmptr->ichead++];
-		if (icmptr->ichead >= ICMP_SLOTS) {
+		if (icmptr->ichead >= ICMP_QSIZ) {
 			icmptr->ichead = 0;
-
 		}
-		freebuf((char *)pkt);
+		pb_free(pkt);
 		icmptr->iccount--;
 	}
 
 	/* Mark the entry free */
 
 	icmptr->icstate = ICMP_FREE;
-	resched_cntl(DEFER_STOP);
-	restore(mask);
+	signal(icmpmutex);
 	return OK;
 }
 
 /*------------------------------------------------------------------------
  * icmp_cksum  -  Compute a checksum for a specified set of data bytes
+ *		     (in host byte order)
  *------------------------------------------------------------------------
  */
 uint16	icmp_cksum (
@@ -361,29 +351,7 @@ uint16	icmp_cksum (
 	 int32	buflen			/* Size of buffer in bytes	*/
 	)
 {
-	int32	scount;			/* Number of 16-bit values buf	*/
-	uint32	cksum;			/* Checksum being computed	*/
-	uint16	*sptr;			/* Walks along buffer		*/
-	uint16	word;			/* One 16-bit word		*/
-
-	/* Walk along buffer and sum all 16-bit values */
-
-	scount = buflen >> 1;		/* Divide by 2 and round down	*/
-	sptr = (uint16 *)buf;
-	cksum = 0;
-	for (; scount > 0; scount--) {
-		word = (uint32) *sptr++;
-		cksum += ntohs(word);
-	}
-
-	/* If buffer lenght is odd, add last byte */
-
-	if ( (buflen & 0x01) !=0 ) {
-		cksum += 0xFFFF & ((uint32) (*((byte *) sptr) << 8));
-	}
-	cksum += (cksum >> 16);
-        cksum = 0xffff & ~cksum;
-        return (uint16) (0xffff & cksum);
+	return ntohs(cksum(buf, buflen));
 }
 
 
@@ -1,9 +1,25 @@
-/* ip.c - ip_in, ip_send, ip_local, ip_out, ipcksum, ip_hton, ip_ntoh,	*/
-/*		 ipout, ip_enqueue					*/
+/* ip.c - ip_in, ip_send, ip_sendmany, ip_local, ip_localchain, ip_out,	*/
+/*		 ip_outchain, ip_txframes, ip_outprep, ip_push, ipcksum,	*/
+/*		 ip_hton, ip_ntoh, ipout, ip_enqueue, ip_oqinit,	*/
+/*		 ip_oqconfig, ip_oqmap, ip_oqtake, ip_oqlen		*/
 
 #include <xinu.h>
 
 struct	iqentry	ipoqueue;		/* Queue of outgoing packets	*/
+local	uint16	ipident = 1;		/* IDENT field of next datagram	*/
+
+/* The fragments of a datagram that IP fragments itself travel as a	*/
+/*   chain linked through pb_next: the chain is one entry in its	*/
+/*   class of the output queue and in the ARP hold queue, so the	*/
+/*   scheduler charges the class for the whole datagram and the	*/
+/*   fragments are held, sent or dropped together			*/
+
+local	void	ip_localchain(struct netpacket *);
+local	int32	ip_outchain(struct netpacket *, struct ethframe[], int32 *);
+local	int32	ip_txframes(struct ethframe[], int32);
+local	int32	ip_outprep(struct netpacket *);
+local	struct	netpacket *ip_oqtake(struct iqentry *);
+local	int32	ip_oqlen(struct netpacket *);
 
 /*------------------------------------------------------------------------
  * ip_in  -  Handle an IP packet that has arrived over a network
@@ -15,12 +31,13 @@ void	ip_in(
 	)
 {
 	int32	icmplen;		/* Length of ICMP message	*/
+	int32	tcplen;			/* Length of TCP segment	*/
 
 	/* Verify checksum */
 
-	if (ipcksum(pktptr) != 0) {
+	if (cksum((char *)&pktptr->net_ipvh, IP_HDR_LEN) != 0) {
 		kprintf("IP header checksum failed\n\r");
-		freebuf((char *)pktptr);
+		pb_free(pktptr);
 		return;
 	}
 
@@ -32,29 +49,62 @@ void	ip_in(
 
 	if (pktptr->net_ipvh != 0x45) {
 		kprintf("IP version failed\n\r");
-		freebuf((char *)pktptr);
+		pb_free(pktptr);
 		return;
 	}
 
+	/* Drop a datagram that is longer than the frame carrying it	*/
+
+	if ( (pktptr->net_iplen < IP_HDR_LEN) ||
+	     (pktptr->net_iplen > pb_len(pktptr) - ETH_HDR_LEN) ) {
+		pb_free(pktptr);
+		return;
+	}
+
+	/* Reassemble a fragmented datagram before its headers are	*/
+	/*   examined; only the first fragment holds them		*/
+
+	if (pktptr->net_ipfrag & (IP_MF | IP_FRAGOFF)) {
+		pktptr = ip_reasm(pktptr);
+		if (pktptr == NULL) {
+			return;
+		}
+	}
+
 	/* Verify encapsulated prototcol checksums and then convert	*/
 	/*	the encapsulated headers to host byte order		*/
 
 	switch (pktptr->net_ipproto) {
 
 	    case IP_UDP:
-		/* Skipping UDP checksum for now */
+		/* The UDP checksum is verified by udp_recv and	*/
+		/*   udp_recvaddr as they copy out the data	*/
 		udp_ntoh(pktptr);
 		break;
 
 	    case IP_ICMP:
 		icmplen = pktptr->net_iplen - IP_HDR_LEN;
-		if (icmp_cksum((char *)&pktptr->net_ictype,icmplen) != 0){
-			freebuf((char *)pktptr);
+		if (cksum((char *)&pktptr->net_ictype, icmplen) != 0){
+			pb_free(pktptr);
 			return;
 		}
 		icmp_ntoh(pktptr);
 		break;
 
+	    case IP_TCP:
+		tcplen = pktptr->net_iplen - IP_HDR_LEN;
+		if (cksum_fold(cksum_partial((char *)&pktptr->net_tcpsport,
+				tcplen, cksum_pseudo(pktptr->net_ipsrc,
+				pktptr->net_ipdst, IP_TCP, tcplen))) != 0) {
+			wait(tcpmutex);	/* Several workers run ip_in	*/
+			tcpstats.ts_ckdrop++;
+			signal(tcpmutex);
+			pb_free(pktptr);
+			return;
+		}
+		tcp_ntoh(pktptr);
+		break;
+
 	    default:
 		break;
 	}
@@ -74,7 +124,7 @@ void	ip_in(
 			ip_local(pktptr);
 			return;
 		} else {
-			freebuf((char *)pktptr);
+			pb_free(pktptr);
 			return;
 		}
 	}
@@ -89,14 +139,16 @@ void	ip_in(
 	} else {
 
 		/* Drop the packet */
-		freebuf((char *)pktptr);
+		pb_free(pktptr);
 		return;
 	}
 }
 
 
 /*------------------------------------------------------------------------
- * ip_send  -  Send an outgoing IP datagram from the local stack
+ * ip_send  -  Send an outgoing IP datagram from the local stack: deliver
+ *		 it if it is for this host, otherwise queue it for ipout
+ *		 in the class its DSCP selects
  *------------------------------------------------------------------------
  */
 
@@ -104,78 +156,113 @@ status	ip_send(
 	  struct netpacket *pktptr	/* Pointer to the packet	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	uint32	dest;			/* Destination of the datagram	*/
-	int32	retval;			/* Return value from functions	*/
-	uint32	nxthop;			/* Next-hop address		*/
-
-	mask = disable();
 
 	/* Pick up the IP destination address from the packet */
 
 	dest = pktptr->net_ipdst;
 
-	/* Loop back to local stack if destination 127.0.0.0/8 */
+	/* Loop back to local stack if destination 127.0.0.0/8 or our	*/
+	/*   IP unicast address						*/
 
-	if ((dest&0xff000000) == 0x7f000000) {
-		ip_local(pktptr);
-		restore(mask);
+	if ( ((dest&0xff000000) == 0x7f000000) ||
+	     (dest == NetData.ipucast) ) {
+		ip_localchain(pktptr);
 		return OK;
 	}
 
-	/* Loop back if the destination matches our IP unicast address	*/
+	/* ipout resolves the next hop and sends the datagram when	*/
+	/*   the scheduler reaches it					*/
 
-	if (dest == NetData.ipucast) {
-		ip_local(pktptr);
-		restore(mask);
-		return OK;
-	}
+	return ip_enqueue(pktptr);
+}
 
-	/* Broadcast if destination is 255.255.255.255 */
+/*------------------------------------------------------------------------
+ * ip_sendmany  -  Send an array of outgoing IP datagrams from the local
+ *		     stack, resolving each next hop once per run of
+ *		     datagrams that share it and handing the frames to
+ *		     the Ethernet driver in batches; return the number
+ *		     of datagrams handed on (sent, held by ARP, or
+ *		     delivered locally)
+ *------------------------------------------------------------------------
+ */
+int32	ip_sendmany(
+	  struct netpacket *pkts[],	/* Datagrams to send		*/
+	  int32	npkts			/* Number of datagrams (at most	*/
+					/*   IP_BATCH)			*/
+	)
+{
+	struct	netpacket *pktptr;	/* Datagram being examined	*/
+	struct	ethframe frames[IP_BATCH];/* Frames for the driver	*/
+	int32	nframes;		/* Number of frames in frames[]	*/
+	int32	nsent;			/* Datagrams handed on		*/
+	int32	i;			/* Index into pkts[]		*/
+	uint32	dest;			/* Destination of the datagram	*/
+	uint32	nxthop;			/* Next-hop address		*/
+	uint32	lasthop;		/* Next hop of the last datagram*/
+	byte	lastmac[ETH_ADDR_LEN];	/* MAC address for lasthop	*/
 
-	if ( (dest == IP_BCAST) ||
-	     (dest == NetData.ipbcast) ) {
-		memcpy(pktptr->net_ethdst, NetData.ethbcast,
-							ETH_ADDR_LEN);
-		retval = ip_out(pktptr);
-		restore(mask);
-		return retval;
+	if ( (npkts < 0) || (npkts > IP_BATCH) ) {
+		return SYSERR;
 	}
 
-	/* If destination is on the local network, next hop is the	*/
-	/*	destination; otherwise, next hop is default router	*/
-
-
-	if ( (dest & NetData.ipmask) == NetData.ipprefix) {
+	nframes = nsent = 0;
+	lasthop = 0;
+	for (i = 0; i < npkts; i++) {
+		pktptr = pkts[i];
+		dest = pktptr->net_ipdst;
 
-		/* Next hop is the destination itself */
-		nxthop = dest;
+		/* Loop back to local stack if destination 127.0.0.0/8	*/
+		/*   or our IP unicast address				*/
 
-	} else {
-
-		/* Next hop is default router on the network */
-		nxthop = NetData.iprouter;
+		if ( ((dest&0xff000000) == 0x7f000000) ||
+		     (dest == NetData.ipucast) ) {
+			ip_localchain(pktptr);
+			nsent++;
+			continue;
+		}
 
-	}
+		if ( (dest == IP_BCAST) ||
+		     (dest == NetData.ipbcast) ) {
+			memcpy(pktptr->net_ethdst, NetData.ethbcast,
+							ETH_ADDR_LEN);
+		} else {
+			if ( (dest & NetData.ipmask) == NetData.ipprefix) {
+				nxthop = dest;
+			} else {
+				nxthop = NetData.iprouter;
+			}
+
+			/* Resolve only when the next hop changes; ARP	*/
+			/*   holds a datagram (all of its fragments)	*/
+			/*   whose next hop is unknown			*/
+
+			if (nxthop == 0) {
+				pb_freechain(pktptr);
+				continue;
+			}
+			if ( (nxthop != lasthop) &&
+			     (arp_resolve(nxthop, lastmac) != OK) ) {
+				lasthop = 0;
+				if (arp_hold(pktptr, nxthop) == OK) {
+					nsent++;
+				}
+				continue;
+			}
+			lasthop = nxthop;
+			memcpy(pktptr->net_ethdst, lastmac, ETH_ADDR_LEN);
+		}
 
-	if (nxthop == 0) {	/* Dest. invalid or no default route	*/
-		freebuf((char *)pktptr);
-		return SYSERR;
+		ip_outchain(pktptr, frames, &nframes);
+		nsent++;
 	}
 
-	/* Resolve the next-hop address to get a MAC address */
+	/* Send the frames that did not fill a batch */
 
-	retval = arp_resolve(nxthop, pktptr->net_ethdst);
-	if (retval != OK) {
-		freebuf((char *)pktptr);
-		return SYSERR;
+	if (nframes > 0) {
+		ip_txframes(frames, nframes);
 	}
-
-	/* Send the packet */
-
-	retval = ip_out(pktptr);
-	restore(mask);
-	return retval;
+	return nsent;
 }
 
 
@@ -187,6 +274,25 @@ void	ip_local(
 	  struct netpacket *pktptr	/* Pointer to the packet	*/
 	)
 {
+	/* Fragments sent to this host over loopback are reassembled	*/
+	/*   here, since they do not pass through ip_in		*/
+
+	if (pktptr->net_ipfrag & (IP_MF | IP_FRAGOFF)) {
+		pktptr = ip_reasm(pktptr);
+		if (pktptr == NULL) {
+			return;
+		}
+	}
+
+	/* Strip the Ethernet and IP headers and any padding after the	*/
+	/*   datagram, so the data of the packet are the IP payload	*/
+
+	if ( (pb_pull(pktptr, ETH_HDR_LEN+IP_HDR_LEN) == (char *)SYSERR) ||
+	     (pb_trim(pktptr, pktptr->net_iplen - IP_HDR_LEN) == SYSERR) ) {
+		pb_free(pktptr);
+		return;
+	}
+
 	/* Use datagram contents to determine how to process */
 
 	switch (pktptr->net_ipproto) {
@@ -199,57 +305,182 @@ void	ip_local(
 		icmp_in(pktptr);
 		return;
 
+	    case IP_TCP:
+		tcp_in(pktptr);
+		return;
+
 	    default:
-		freebuf((char *)pktptr);
+		pb_free(pktptr);
 		return;
 	}
 }
 
+/*------------------------------------------------------------------------
+ * ip_localchain  -  Deliver a datagram, or each fragment of a chain,
+ *		       to the local stack
+ *------------------------------------------------------------------------
+ */
+local	void	ip_localchain(
+	  struct netpacket *pktptr	/* First frame of the chain	*/
+	)
+{
+	struct	netpacket *next;	/* Frame after pktptr		*/
+
+	while (pktptr != NULL) {
+		next = pb_next(pktptr);
+		pb_next(pktptr) = NULL;
+		ip_local(pktptr);
+		pktptr = next;
+	}
+}
+
 
 /*------------------------------------------------------------------------
- *  ip_out  -  Transmit an outgoing IP datagram
+ *  ip_out  -  Transmit an outgoing IP datagram, or each fragment of a
+ *		 chain, whose destination MAC address is filled in
  *------------------------------------------------------------------------
  */
 status	ip_out(
 	  struct netpacket *pktptr	/* Pointer to the packet	*/
 	)
 {
-	uint16	cksum;			/* Checksum in host byte order	*/
-	int32	len;			/* Length of ICMP message	*/	
+	struct	ethframe frames[IP_BATCH];/* Frames for the driver	*/
+	int32	nframes;		/* Number of frames in frames[]	*/
+	int32	ndrop;			/* Frames the driver refused	*/
+
+	/* Send packets over the Ethernet from the buffers themselves;	*/
+	/*   the driver frees each buffer once its frame has been sent	*/
+
+	nframes = 0;
+	ndrop = ip_outchain(pktptr, frames, &nframes);
+	if (nframes > 0) {
+		ndrop += nframes - ip_txframes(frames, nframes);
+	}
+	return (ndrop == 0) ? OK : SYSERR;
+}
+
+/*------------------------------------------------------------------------
+ * ip_outchain  -  Add the frames of a datagram, or of every fragment of
+ *		     a chain (which take the destination MAC address of
+ *		     the first), to an array of frames, sending the
+ *		     array whenever it fills; return the number of frames
+ *		     the driver refused
+ *------------------------------------------------------------------------
+ */
+local	int32	ip_outchain(
+	  struct netpacket *pktptr,	/* First frame of the chain	*/
+	  struct ethframe frames[],	/* Frames not yet sent		*/
+	  int32	*nframes		/* Number of frames in frames[]	*/
+	)
+{
+	struct	netpacket *next;	/* Frame after pktptr		*/
+	int32	ndrop;			/* Frames the driver refused	*/
+
+	ndrop = 0;
+	while (pktptr != NULL) {
+		next = pb_next(pktptr);
+		pb_next(pktptr) = NULL;
+		if (next != NULL) {
+			memcpy(next->net_ethdst, pktptr->net_ethdst,
+							ETH_ADDR_LEN);
+		}
+		frames[*nframes].efbuf = (char *)pktptr;
+		frames[*nframes].eflen = ip_outprep(pktptr);
+		frames[*nframes].efrel = (char *)pktptr;
+		if (++(*nframes) == IP_BATCH) {
+			ndrop += IP_BATCH - ip_txframes(frames, IP_BATCH);
+			*nframes = 0;
+		}
+		pktptr = next;
+	}
+	return ndrop;
+}
+
+/*------------------------------------------------------------------------
+ * ip_txframes  -  Hand an array of frames to the Ethernet driver as one
+ *		     batch, freeing the frames it does not take; return
+ *		     the number it took
+ *------------------------------------------------------------------------
+ */
+local	int32	ip_txframes(
+	  struct ethframe frames[],	/* Frames to send		*/
+	  int32	nframes			/* Number of frames		*/
+	)
+{
+	int32	nsent;			/* Frames the driver took	*/
+	int32	i;			/* Index into frames[]		*/
+
+	/* The driver frees the buffers once the frames are out */
+
+	nsent = control(ETHER0, ETH_CTRL_TXBATCH, (int32)frames, nframes);
+	if (nsent == SYSERR) {
+		nsent = 0;
+	}
+	for (i = nsent; i < nframes; i++) {
+		pb_free((struct netpacket *)frames[i].efbuf);
+	}
+	return nsent;
+}
+
+/*------------------------------------------------------------------------
+ * ip_outprep  -  Convert an outgoing datagram to network byte order and
+ *		    fill in its checksums; return the length of the frame
+ *------------------------------------------------------------------------
+ */
+local	int32	ip_outprep(
+	  struct netpacket *pktptr	/* Pointer to the packet	*/
+	)
+{
+	int32	len;			/* Length of ICMP message	*/
+	uint32	sum;			/* Partial TCP checksum		*/
 	int32	pktlen;			/* Length of entire packet	*/
-	int32	retval;			/* Value returned by write	*/
 
 	/* Compute total packet length */
 
 	pktlen = pktptr->net_iplen + ETH_HDR_LEN;
 
-	/* Convert encapsulated protocol to network byte order */
+	/* Convert encapsulated protocol to network byte order; only	*/
+	/*   the first fragment of a datagram holds its header		*/
 
-	switch (pktptr->net_ipproto) {
-
-	    case IP_UDP:
+	if ((pktptr->net_ipfrag & IP_FRAGOFF) == 0) {
+	    switch (pktptr->net_ipproto) {
 
-			pktptr->net_udpcksum = 0;
-			udp_hton(pktptr);
+		case IP_UDP:
 
-			/* ...skipping UDP checksum computation */
+			/* The UDP checksum was filled in by the UDP	*/
+			/*   send functions as they copied in the data	*/
 
+			udp_hton(pktptr);
 			break;
 
-	    case IP_ICMP:
+		case IP_ICMP:
 			icmp_hton(pktptr);
 
 			/* Compute ICMP checksum */
 
 			pktptr->net_iccksum = 0;
 			len = pktptr->net_iplen-IP_HDR_LEN;
-			cksum = icmp_cksum((char *)&pktptr->net_ictype,
+			pktptr->net_iccksum = cksum((char *)&pktptr->net_ictype,
 								len);
-			pktptr->net_iccksum = 0xffff & htons(cksum);
 			break;
 
-	    default:
+		case IP_TCP:
+			tcp_hton(pktptr);
+
+			/* Compute TCP checksum over the pseudo-header	*/
+			/*   (the IP addresses are still in host order)	*/
+
+			len = pktptr->net_iplen-IP_HDR_LEN;
+			pktptr->net_tcpcksum = 0;
+			sum = cksum_pseudo(pktptr->net_ipsrc,
+					pktptr->net_ipdst, IP_TCP, len);
+			pktptr->net_tcpcksum = cksum_fold(cksum_partial(
+				(char *)&pktptr->net_tcpsport, len, sum));
 			break;
+
+		default:
+			break;
+	    }
 	}
 
 	/* Convert IP fields to network byte order */
@@ -259,27 +490,65 @@ status	ip_out(
 	/* Compute IP header checksum */
 
 	pktptr->net_ipcksum = 0;
-	cksum = ipcksum(pktptr);
-	pktptr->net_ipcksum = 0xffff & htons(cksum);
+	pktptr->net_ipcksum = cksum((char *)&pktptr->net_ipvh, IP_HDR_LEN);
 
 	/* Convert Ethernet fields to network byte order */
 
 	eth_hton(pktptr);
 
-	/* Send packet over the Ethernet */
+	return pktlen;
+}
 
-	retval = write(ETHER0, (char*)pktptr, pktlen);
-	freebuf((char *)pktptr);
+/*------------------------------------------------------------------------
+ * ip_push  -  Prepend the IP and Ethernet headers to an outgoing
+ *		 datagram whose payload is the data of the packet (the
+ *		 payload must end where the header overlay puts it, so
+ *		 it starts IP_HDR_LEN bytes after the IP header)
+ *------------------------------------------------------------------------
+ */
+status	ip_push(
+	  struct netpacket *pktptr,	/* Pointer to the packet	*/
+	  byte	proto,			/* IP protocol of the payload	*/
+	  uint32 dest			/* IP destination address	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+	uint16	ident;			/* IDENT field of the datagram	*/
 
-	if (retval == SYSERR) {
+	if ( (pb_data(pktptr) != (char *)&pktptr->net_ipvh + IP_HDR_LEN) ||
+	     (pb_push(pktptr, IP_HDR_LEN) == (char *)SYSERR) ) {
 		return SYSERR;
-	} else {
-		return OK;
 	}
+
+	/* Take the next IDENT; the counter is shared by all senders	*/
+
+	mask = disable();
+	ident = ipident++;
+	restore(mask);
+
+	pktptr->net_ipvh = 0x45;	/* IP version and hdr length	*/
+	pktptr->net_iptos = 0x00;	/* Type of service		*/
+	pktptr->net_iplen = pb_len(pktptr);/* Total IP datagram length	*/
+	pktptr->net_ipid = ident;	/* Datagram gets next IDENT	*/
+	pktptr->net_ipfrag = 0x0000;	/* IP flags & fragment offset	*/
+	pktptr->net_ipttl = 0xff;	/* IP time-to-live		*/
+	pktptr->net_ipproto = proto;	/* Protocol of the payload	*/
+	pktptr->net_ipcksum = 0x0000;	/* Initial checksum		*/
+	pktptr->net_ipsrc = NetData.ipucast;/* IP source address	*/
+	pktptr->net_ipdst = dest;	/* IP destination address	*/
+
+	/* The destination MAC address is filled in when the next hop	*/
+	/*   is resolved						*/
+
+	pb_push(pktptr, ETH_HDR_LEN);
+	memcpy(pktptr->net_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
+	pktptr->net_ethtype = ETH_IP;
+	return OK;
 }
 
 /*------------------------------------------------------------------------
- * ipcksum  -  Compute the IP header checksum for a datagram
+ * ipcksum  -  Compute the IP header checksum for a datagram (in host
+ *		  byte order)
  *------------------------------------------------------------------------
  */
 
@@ -287,32 +556,7 @@ uint16	ipcksum(
 	 struct  netpacket *pkt		/* Pointer to the packet	*/
 	)
 {
-	uint16	*hptr;			/* Ptr to 16-bit header values	*/
-	int32	i;			/* Counts 16-bit values in hdr	*/
-	uint16	word;			/* One 16-bit word		*/
-	uint32	cksum;			/* Computed value of checksum	*/
-
-	hptr= (uint16 *) &pkt->net_ipvh;
-
-	/* Sum 16-bit words in the packet */
-
-	cksum = 0;
-	for (i=0; i<10; i++) {
-		word = *hptr++;
-		cksum += (uint32) htons(word);
-	}
-
-	/* Add in carry, and take the ones-complement */
-
-	cksum += (cksum >> 16);
-	cksum = 0xffff & ~cksum;
-
-	/* Use all-1s for zero */
-
-	if (cksum == 0xffff) {
-		cksum = 0;
-	}
-	return (uint16) (0xffff & cksum);
+	return ntohs(cksum((char *)&pkt->net_ipvh, IP_HDR_LEN));
 }
 
 
@@ -349,118 +593,299 @@ void 	ip_hton(
 
 
 /*------------------------------------------------------------------------
- *  ipout  -  Process that transmits IP packets from the IP output queue
+ *  ipout  -  Process that transmits IP packets from the IP output queue,
+ *		taking them in the order the class scheduler picks and
+ *		sending up to IP_BATCH of them at a time
  *------------------------------------------------------------------------
  */
 
 process	ipout(void)
 {
-	struct	netpacket *pktptr;	/* Pointer to next the packet	*/
 	struct	iqentry   *ipqptr;	/* Pointer to IP output queue	*/
-	uint32	destip;			/* Destination IP address	*/
-	uint32	nxthop;			/* Next hop IP address		*/
-	int32	retval;			/* Value returned by functions	*/
+	struct	netpacket *pktptr;	/* Pointer to next the packet	*/
+	struct	netpacket *pkts[IP_BATCH];/* Packets to send		*/
+	int32	npkts;			/* Number of packets in pkts[]	*/
 
 	ipqptr = &ipoqueue;
 
 	while(1) {
 
-		/* Obtain next packet from the IP output queue */
+		/* Wait for a packet, then take it and any others that	*/
+		/*   are already queued					*/
 
 		wait(ipqptr->iqsem);
-		pktptr = ipqptr->iqbuf[ipqptr->iqhead++];
-		if (ipqptr->iqhead >= IP_OQSIZ) {
-			ipqptr->iqhead= 0;
+		wait(ipqptr->iqmutex);
+		npkts = 0;
+		do {
+			/* The queue can hold fewer packets than iqsem	*/
+			/*   counts after ip_oqconfig lowers a limit	*/
+
+			pktptr = ip_oqtake(ipqptr);
+			if (pktptr != NULL) {
+				pkts[npkts++] = pktptr;
+			}
+		} while ( (npkts < IP_BATCH) &&
+			  (semcount(ipqptr->iqsem) > 0) &&
+			  (wait(ipqptr->iqsem) == OK) );
+		signal(ipqptr->iqmutex);
+
+		if (npkts == 0) {
+			continue;
 		}
 
-		/* Fill in the MAC source address */
+		/* Resolve the next hops and send; ARP holds a packet	*/
+		/*   whose next hop is not yet known			*/
 
-		memcpy(pktptr->net_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
-
-		/* Extract destination address from packet */
+		ip_sendmany(pkts, npkts);
+	}
+}
 
-		destip = pktptr->net_ipdst;
 
+/*------------------------------------------------------------------------
+ *  ip_enqueue  -  Deposit an outgoing IP datagram on the IP output queue
+ *		     in the class its DSCP selects; when the class is full,
+ *		     drop the new datagram or the oldest one, as the
+ *		     class's policy says
+ *------------------------------------------------------------------------
+ */
+status	ip_enqueue(
+	  struct netpacket *pktptr	/* Pointer to the packet	*/
+	)
+{
+	struct	iqentry	*iptr;		/* Ptr. to network output queue	*/
+	struct	ipoclass *ocptr;	/* Ptr. to the packet's class	*/
+	struct	netpacket *oldpkt;	/* Oldest packet of the class	*/
 
-		/* Sanity check: packets sent to ipout should *not*	*/
-		/*	contain	a broadcast address.			*/
+	/* Ensure only one process accesses output queue at a time */
 
-		if ((destip == IP_BCAST)||(destip == NetData.ipbcast)) {
-			kprintf("ipout: encountered a broadcast\n");
-			freebuf((char *)pktptr);
-			continue;
+	iptr = &ipoqueue;
+	wait(iptr->iqmutex);
+	ocptr = &iptr->iqclass[iptr->iqdscp[pktptr->net_iptos >> 2]];
+
+	if (ocptr->oc_count >= ocptr->oc_limit) {
+		ocptr->oc_drops++;
+		if (ocptr->oc_policy == IP_OQ_DROPTAIL) {
+			signal(iptr->iqmutex);
+			pb_freechain(pktptr);
+			return SYSERR;
 		}
 
-		/* Check whether destination is the local computer */
+		/* Drop the oldest packet and put the new one at the	*/
+		/*   tail; the number of queued packets does not change	*/
 
-		if (destip == NetData.ipucast) {
-			ip_local(pktptr);
-			continue;
+		oldpkt = ocptr->oc_buf[ocptr->oc_head++];
+		if (ocptr->oc_head >= IP_OQSIZ) {
+			ocptr->oc_head = 0;
+		}
+		ocptr->oc_buf[ocptr->oc_tail++] = pktptr;
+		if (ocptr->oc_tail >= IP_OQSIZ) {
+			ocptr->oc_tail = 0;
 		}
+		ocptr->oc_enq++;
+		signal(iptr->iqmutex);
+		pb_freechain(oldpkt);
+		return OK;
+	}
 
-		/* Check whether destination is on the local net */
+	/* Enqueue packet on the class's queue */
 
-		if ( (destip & NetData.ipmask) == NetData.ipprefix) {
+	ocptr->oc_buf[ocptr->oc_tail++] = pktptr;
+	if (ocptr->oc_tail >= IP_OQSIZ) {
+		ocptr->oc_tail = 0;
+	}
+	ocptr->oc_count++;
+	ocptr->oc_enq++;
+	iptr->iqcount++;
+	signal(iptr->iqmutex);
+	signal(iptr->iqsem);
+	return OK;
+}
 
-			/* Next hop is the destination itself */
+/*------------------------------------------------------------------------
+ *  ip_oqinit  -  Initialize the IP output queue: CS6 and CS7 map to the
+ *		    control class, EF to its own class, CS1 to the bulk
+ *		    class and every other DSCP to the normal class
+ *------------------------------------------------------------------------
+ */
+void	ip_oqinit(void)
+{
+	struct	iqentry	*iptr;		/* Ptr. to network output queue	*/
+	struct	ipoclass *ocptr;	/* Ptr. to a class		*/
+	int32	i;			/* Index into classes and DSCPs	*/
 
-			nxthop = destip;
-		} else {
+	iptr = &ipoqueue;
+	iptr->iqcount = 0;
+	iptr->iqdrr = IP_OQSTRICT;
+	for (i = 0; i < IP_OQCLASSES; i++) {
+		ocptr = &iptr->iqclass[i];
+		ocptr->oc_head = 0;
+		ocptr->oc_tail = 0;
+		ocptr->oc_count = 0;
+		ocptr->oc_limit = IP_OQSIZ;
+		ocptr->oc_policy = IP_OQ_DROPTAIL;
+		ocptr->oc_quantum = ETH_HDR_LEN + ETH_MTU;
+		ocptr->oc_deficit = 0;
+		ocptr->oc_enq = 0;
+		ocptr->oc_deq = 0;
+		ocptr->oc_drops = 0;
+	}
 
-			/* Next hop is default router on the network */
+	/* Normal traffic gets twice the bandwidth of bulk traffic	*/
+	/*   when both are backlogged					*/
 
-			nxthop = NetData.iprouter;
-		}
+	iptr->iqclass[IP_OQC_NORMAL].oc_quantum = 2 * (ETH_HDR_LEN + ETH_MTU);
 
-		if (nxthop == 0) {  /* Dest. invalid or no default route*/
-			freebuf((char *)pktptr);
-			continue;
-		}
+	for (i = 0; i < 64; i++) {
+		iptr->iqdscp[i] = IP_OQC_NORMAL;
+	}
+	iptr->iqdscp[48] = IP_OQC_CTRL;		/* CS6			*/
+	iptr->iqdscp[56] = IP_OQC_CTRL;		/* CS7			*/
+	iptr->iqdscp[46] = IP_OQC_EF;		/* EF			*/
+	iptr->iqdscp[8] = IP_OQC_BULK;		/* CS1			*/
+
+	iptr->iqsem = semcreate(0);
+	iptr->iqmutex = semcreate(1);
+	if( ((int32)iptr->iqsem == SYSERR) ||
+	    ((int32)iptr->iqmutex == SYSERR) ) {
+		panic("Cannot create ip output queue semaphore");
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  ip_oqconfig  -  Set the depth limit, drop policy and DRR quantum
+ *		      (ignored by the strict-priority classes) of a class
+ *------------------------------------------------------------------------
+ */
+status	ip_oqconfig(
+	  int32	class,			/* Class to configure		*/
+	  int32	limit,			/* Maximum packets, 1..IP_OQSIZ	*/
+	  int32	policy,			/* IP_OQ_DROPTAIL or _DROPHEAD	*/
+	  int32	quantum			/* Bytes per DRR round		*/
+	)
+{
+	struct	ipoclass *ocptr;	/* Ptr. to the class		*/
+	struct	netpacket *oldpkt;	/* Packet dropped by a new limit*/
 
-		/* Use ARP to resolve next-hop address */
+	if ( (class < 0) || (class >= IP_OQCLASSES) ||
+	     (limit < 1) || (limit > IP_OQSIZ) || (quantum < 1) ||
+	     ((policy != IP_OQ_DROPTAIL) && (policy != IP_OQ_DROPHEAD)) ) {
+		return SYSERR;
+	}
 
-		retval = arp_resolve(nxthop, pktptr->net_ethdst);
-		if (retval != OK) {
-			freebuf((char *)pktptr);
-			continue;
-		}
+	wait(ipoqueue.iqmutex);
+	ocptr = &ipoqueue.iqclass[class];
+	ocptr->oc_limit = limit;
+	ocptr->oc_policy = policy;
+	ocptr->oc_quantum = quantum;
 
-		/* Use ipout to Convert byte order and send */
+	/* Drop the oldest packets that no longer fit; their counts	*/
+	/*   stay in iqsem, and ipout finds nothing for them		*/
 
-		ip_out(pktptr);
+	while (ocptr->oc_count > limit) {
+		oldpkt = ocptr->oc_buf[ocptr->oc_head++];
+		if (ocptr->oc_head >= IP_OQSIZ) {
+			ocptr->oc_head = 0;
+		}
+		ocptr->oc_count--;
+		ocptr->oc_drops++;
+		ipoqueue.iqcount--;
+		pb_freechain(oldpkt);
 	}
+	signal(ipoqueue.iqmutex);
+	return OK;
 }
 
+/*------------------------------------------------------------------------
+ *  ip_oqmap  -  Send outgoing datagrams that carry a DSCP to a class
+ *------------------------------------------------------------------------
+ */
+status	ip_oqmap(
+	  byte	dscp,			/* Differentiated services code	*/
+	  int32	class			/* Class for the datagrams	*/
+	)
+{
+	if ( (dscp >= 64) || (class < 0) || (class >= IP_OQCLASSES) ) {
+		return SYSERR;
+	}
+	wait(ipoqueue.iqmutex);
+	ipoqueue.iqdscp[dscp] = class;
+	signal(ipoqueue.iqmutex);
+	return OK;
+}
 
 /*------------------------------------------------------------------------
- *  ip_enqueue  -  Deposit an outgoing IP datagram on the IP output queue
+ *  ip_oqtake  -  Remove the next packet to send from the IP output queue
+ *		    (called with iqmutex held): the classes below
+ *		    IP_OQSTRICT are served in order of priority, and the
+ *		    rest share what is left by deficit round robin
  *------------------------------------------------------------------------
  */
-status	ip_enqueue(
-	  struct netpacket *pktptr	/* Pointer to the packet	*/
+local	struct	netpacket *ip_oqtake(
+	  struct iqentry *iptr		/* Ptr. to network output queue	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	iqentry	*iptr;		/* Ptr. to network output queue	*/
+	struct	ipoclass *ocptr;	/* Ptr. to a class		*/
+	struct	netpacket *pktptr;	/* Packet taken from the queue	*/
+	int32	i;			/* Index into the classes	*/
+	int32	pktlen;			/* Length of the frame		*/
 
-	/* Ensure only one process accesses output queue at a time */
+	if (iptr->iqcount <= 0) {
+		return NULL;
+	}
 
-	mask = disable();
+	for (i = 0; i < IP_OQSTRICT; i++) {
+		if (iptr->iqclass[i].oc_count > 0) {
+			break;
+		}
+	}
 
-	/* Enqueue packet on network output queue */
+	/* Visit the round-robin classes in turn: an empty class loses	*/
+	/*   its deficit, and a class whose deficit does not cover its	*/
+	/*   first packet gets its quantum and waits for the next round	*/
+
+	while (i >= IP_OQSTRICT) {
+		ocptr = &iptr->iqclass[iptr->iqdrr];
+		if (ocptr->oc_count > 0) {
+			pktptr = ocptr->oc_buf[ocptr->oc_head];
+			pktlen = ip_oqlen(pktptr);
+			if (ocptr->oc_deficit >= pktlen) {
+				ocptr->oc_deficit -= pktlen;
+				i = iptr->iqdrr;
+				break;
+			}
+			ocptr->oc_deficit += ocptr->oc_quantum;
+		} else {
+			ocptr->oc_deficit = 0;
+		}
+		if (++iptr->iqdrr >= IP_OQCLASSES) {
+			iptr->iqdrr = IP_OQSTRICT;
+		}
+	}
 
-	iptr = &ipoqueue;
-	if (semcount(iptr->iqsem) >= IP_OQSIZ) {
-		kprintf("ipout: output queue overflow\n");
-		freebuf((char *)pktptr);
-		restore(mask);
-		return SYSERR;
+	ocptr = &iptr->iqclass[i];
+	pktptr = ocptr->oc_buf[ocptr->oc_head++];
+	if (ocptr->oc_head >= IP_OQSIZ) {
+		ocptr->oc_head = 0;
 	}
-	iptr->iqbuf[iptr->iqtail++] = pktptr;
-	if (iptr->iqtail >= IP_OQSIZ) {
-		iptr->iqtail = 0;
+	ocptr->oc_count--;
+	ocptr->oc_deq++;
+	iptr->iqcount--;
+	return pktptr;
+}
+
+/*------------------------------------------------------------------------
+ *  ip_oqlen  -  Return the number of bytes a queued datagram, or every
+ *		   fragment of a chain, puts on the wire
+ *------------------------------------------------------------------------
+ */
+local	int32	ip_oqlen(
+	  struct netpacket *pktptr	/* First frame of the chain	*/
+	)
+{
+	int32	len;			/* Bytes in the frames so far	*/
+
+	for (len = 0; pktptr != NULL; pktptr = pb_next(pktptr)) {
+		len += pktptr->net_iplen + ETH_HDR_LEN;
 	}
-	signal(iptr->iqsem);
-	restore(mask);
-	return OK;	
+	return len;
 }
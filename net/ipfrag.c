@@ -0,0 +1,385 @@
+/* ipfrag.c - ip_fraginit, ip_reasm, ip_sendfrags, ip_fraghash,	*/
+/*		ip_fragfree, ip_fragexpire				*/
+
+#include <xinu.h>
+
+struct	ipfragstat ipfragstats;		/* Fragmentation statistics	*/
+
+/* A datagram being reassembled occupies a slot of the fragment table	*/
+/*   and a buffer from ipreasmpool that can hold a datagram of	*/
+/*   IP_REASM_MAXLEN bytes; the slots and buffers are the whole memory	*/
+/*   budget of reassembly.  A completed datagram leaves its slot and	*/
+/*   goes up the stack in its buffer, which pb_free returns to the	*/
+/*   pool.  Datagrams that time out are dropped when the next	*/
+/*   fragment arrives.  The table is protected by ipfragmutex.	*/
+
+local	struct	ipreasm	ipreasmtab[IP_REASM_SLOTS];/* Fragment table	*/
+local	int32	ipreasmhash[IP_REASM_HSIZ];/* Head of each hash chain	*/
+local	bpid32	ipreasmpool;		/* Reassembly buffers		*/
+local	sid32	ipfragmutex;		/* Protects the table and stats	*/
+
+local	uint32	ip_fraghash(uint32, uint16, byte);
+local	void	ip_fragfree(struct ipreasm *, bool8);
+local	void	ip_fragexpire(void);
+
+/*------------------------------------------------------------------------
+ * ip_fraginit  -  Initialize the fragment table and allocate the
+ *		     reassembly buffers
+ *------------------------------------------------------------------------
+ */
+void	ip_fraginit(void)
+{
+	int32	i;			/* Index into the table		*/
+
+	for (i = 0; i < IP_REASM_SLOTS; i++) {
+		ipreasmtab[i].ir_state = IP_REASM_FREE;
+	}
+	for (i = 0; i < IP_REASM_HSIZ; i++) {
+		ipreasmhash[i] = -1;
+	}
+	memset((char *)&ipfragstats, NULLCH, sizeof(ipfragstats));
+
+	ipreasmpool = mkbufpool(sizeof(struct pktbuf) + ETH_HDR_LEN +
+					IP_REASM_MAXLEN, IP_REASM_SLOTS);
+	if (ipreasmpool == SYSERR) {
+		panic("Cannot allocate IP reassembly buffers");
+	}
+	ipfragmutex = semcreate(1);
+	if ((int32)ipfragmutex == SYSERR) {
+		panic("Cannot create IP fragment table semaphore");
+	}
+}
+
+/*------------------------------------------------------------------------
+ * ip_reasm  -  Add a fragment (IP header in host byte order) to the
+ *		  datagram it belongs to; return the whole datagram when
+ *		  the fragment completes it, otherwise NULL (the fragment
+ *		  is consumed in either case)
+ *------------------------------------------------------------------------
+ */
+struct	netpacket *ip_reasm(
+	  struct netpacket *pktptr	/* Fragment			*/
+	)
+{
+	struct	ipreasm	*irptr;		/* Ptr to the table entry	*/
+	struct	netpacket *whole;	/* Reassembled datagram		*/
+	int32	off;			/* Offset of the fragment's data*/
+	int32	len;			/* Length of the fragment's data*/
+	int32	end;			/* Offset just past the data	*/
+	bool8	more;			/* Other fragments follow it	*/
+	int32	slot;			/* Index into ipreasmtab	*/
+	uint32	h;			/* Hash bucket of the datagram	*/
+	int32	b;			/* Index of an 8-byte block	*/
+	int32	nset;			/* Blocks already received	*/
+
+	off = (pktptr->net_ipfrag & IP_FRAGOFF) << 3;
+	len = pktptr->net_iplen - IP_HDR_LEN;
+	end = off + len;
+	more = (pktptr->net_ipfrag & IP_MF) != 0;
+
+	wait(ipfragmutex);
+	ipfragstats.if_fragsin++;
+
+	/* Every fragment but the last carries a multiple of 8 bytes,	*/
+	/*   and the datagram must fit in a reassembly buffer		*/
+
+	if ( (len <= 0) || (more && (len & 7)) ||
+	     (end > IP_REASM_MAXLEN - IP_HDR_LEN) ) {
+		ipfragstats.if_badfrags++;
+		signal(ipfragmutex);
+		pb_free(pktptr);
+		return NULL;
+	}
+
+	ip_fragexpire();
+
+	/* Find the datagram, or start a new one */
+
+	h = ip_fraghash(pktptr->net_ipsrc, pktptr->net_ipid,
+						pktptr->net_ipproto);
+	for (slot = ipreasmhash[h]; slot >= 0; slot = irptr->ir_next) {
+		irptr = &ipreasmtab[slot];
+		if ( (irptr->ir_src == pktptr->net_ipsrc) &&
+		     (irptr->ir_dst == pktptr->net_ipdst) &&
+		     (irptr->ir_id == pktptr->net_ipid) &&
+		     (irptr->ir_proto == pktptr->net_ipproto) ) {
+			break;
+		}
+	}
+	if (slot < 0) {
+		for (slot = 0; slot < IP_REASM_SLOTS; slot++) {
+			if (ipreasmtab[slot].ir_state == IP_REASM_FREE) {
+				break;
+			}
+		}
+
+		/* A completed datagram keeps its buffer until it is	*/
+		/*   read, so a free slot may have no buffer; never	*/
+		/*   wait for one					*/
+
+		if ( (slot >= IP_REASM_SLOTS) ||
+		     (semcount(buftab[ipreasmpool].bpsem) <= 0) ) {
+			ipfragstats.if_nobufs++;
+			signal(ipfragmutex);
+			pb_free(pktptr);
+			return NULL;
+		}
+		irptr = &ipreasmtab[slot];
+		irptr->ir_pkt = (struct netpacket *)
+			((struct pktbuf *)getbuf(ipreasmpool) + 1);
+		irptr->ir_state = IP_REASM_USED;
+		irptr->ir_src = pktptr->net_ipsrc;
+		irptr->ir_dst = pktptr->net_ipdst;
+		irptr->ir_id = pktptr->net_ipid;
+		irptr->ir_proto = pktptr->net_ipproto;
+		irptr->ir_hashead = FALSE;
+		irptr->ir_total = -1;
+		irptr->ir_recvd = 0;
+		irptr->ir_maxend = 0;
+		irptr->ir_expire = clktime + IP_REASM_TIMEOUT;
+		memset((char *)irptr->ir_map, NULLCH, sizeof(irptr->ir_map));
+		irptr->ir_next = ipreasmhash[h];
+		ipreasmhash[h] = slot;
+	}
+
+	/* Ignore an exact duplicate; drop the datagram if the		*/
+	/*   fragment overlaps data already received only in part,	*/
+	/*   since the two copies need not agree			*/
+
+	nset = 0;
+	for (b = off >> 3; b <= (end - 1) >> 3; b++) {
+		if (irptr->ir_map[b >> 5] & (1 << (b & 31))) {
+			nset++;
+		}
+	}
+	if (nset == ((end - 1) >> 3) - (off >> 3) + 1) {
+		signal(ipfragmutex);
+		pb_free(pktptr);
+		return NULL;
+	}
+	if (nset > 0) {
+		ipfragstats.if_overlaps++;
+		ip_fragfree(irptr, TRUE);
+		signal(ipfragmutex);
+		pb_free(pktptr);
+		return NULL;
+	}
+
+	/* The last fragment fixes the length, and no fragment may	*/
+	/*   extend past it						*/
+
+	if (!more) {
+		if ( (irptr->ir_total >= 0) || (irptr->ir_maxend > end) ) {
+			ipfragstats.if_badfrags++;
+			ip_fragfree(irptr, TRUE);
+			signal(ipfragmutex);
+			pb_free(pktptr);
+			return NULL;
+		}
+		irptr->ir_total = end;
+	} else if ( (irptr->ir_total >= 0) && (end > irptr->ir_total) ) {
+		ipfragstats.if_badfrags++;
+		ip_fragfree(irptr, TRUE);
+		signal(ipfragmutex);
+		pb_free(pktptr);
+		return NULL;
+	}
+
+	/* Copy the data into place; the first fragment also supplies	*/
+	/*   the Ethernet and IP headers				*/
+
+	whole = irptr->ir_pkt;
+	memcpy((char *)&whole->net_ipvh + IP_HDR_LEN + off,
+		(char *)&pktptr->net_ipvh + IP_HDR_LEN, len);
+	if (off == 0) {
+		memcpy((char *)whole, (char *)pktptr, ETH_HDR_LEN+IP_HDR_LEN);
+		irptr->ir_hashead = TRUE;
+	}
+	for (b = off >> 3; b <= (end - 1) >> 3; b++) {
+		irptr->ir_map[b >> 5] |= 1 << (b & 31);
+	}
+	irptr->ir_recvd += len;
+	if (end > irptr->ir_maxend) {
+		irptr->ir_maxend = end;
+	}
+	pb_free(pktptr);
+
+	if ( !irptr->ir_hashead || (irptr->ir_recvd != irptr->ir_total) ) {
+		signal(ipfragmutex);
+		return NULL;
+	}
+
+	/* The datagram is complete: it leaves the table in its buffer	*/
+
+	whole->net_iplen = IP_HDR_LEN + irptr->ir_total;
+	whole->net_ipfrag = 0;
+	pb_init(whole, ETH_HDR_LEN + whole->net_iplen);
+	ip_fragfree(irptr, FALSE);
+	ipfragstats.if_reasm++;
+	signal(ipfragmutex);
+	return whole;
+}
+
+/*------------------------------------------------------------------------
+ * ip_sendfrags  -  Send a payload that is too long for one frame as a
+ *		      series of fragments; the payload is a transport
+ *		      header (in host byte order, like the header of an
+ *		      unfragmented datagram) followed by data.  The
+ *		      fragments are chained and queued as one datagram,
+ *		      so the class scheduler and ARP handle them together
+ *------------------------------------------------------------------------
+ */
+status	ip_sendfrags(
+	  byte	proto,			/* IP protocol of the payload	*/
+	  uint32 dest,			/* IP destination address	*/
+	  byte	tos,			/* IP type of service		*/
+	  char	*hdr,			/* Transport header		*/
+	  int32	hdrlen,			/* Length of the header		*/
+	  char	*data,			/* Data that follow the header	*/
+	  int32	len			/* Length of the data		*/
+	)
+{
+	struct	netpacket *first;	/* First fragment of the chain	*/
+	struct	netpacket *last;	/* Last fragment of the chain	*/
+	struct	netpacket *pkt;		/* Fragment being built		*/
+	char	*dptr;			/* Where the fragment's data go	*/
+	int32	total;			/* Length of the payload	*/
+	int32	off;			/* Offset of the fragment	*/
+	int32	flen;			/* Length of the fragment	*/
+	int32	n;			/* Bytes copied from the header	*/
+	uint16	ident;			/* IDENT shared by the fragments*/
+	int32	nfrags;			/* Fragments built		*/
+
+	total = hdrlen + len;
+	if ( (hdrlen < 0) || (len < 0) || (hdrlen > ETH_MTU - IP_HDR_LEN) ||
+	     (total > IP_MAXLEN - IP_HDR_LEN) ) {
+		return SYSERR;
+	}
+
+	first = last = NULL;
+	nfrags = 0;
+	ident = 0;
+	for (off = 0; off < total; off += flen) {
+		flen = total - off;
+		if (flen > ETH_MTU - IP_HDR_LEN) {
+			flen = (ETH_MTU - IP_HDR_LEN) & ~7;
+		}
+
+		pkt = pb_alloc();
+		if ((int32)pkt == SYSERR) {
+			pb_freechain(first);
+			return SYSERR;
+		}
+
+		/* Copy this fragment's part of the header and data */
+
+		pb_reserve(pkt, (char *)&pkt->net_ipvh + IP_HDR_LEN -
+							(char *)pkt);
+		dptr = pb_put(pkt, flen);
+		n = 0;
+		if (off < hdrlen) {
+			n = hdrlen - off;
+			if (n > flen) {
+				n = flen;
+			}
+			memcpy(dptr, hdr + off, n);
+		}
+		memcpy(dptr + n, data + off + n - hdrlen, flen - n);
+
+		/* Every fragment carries the IDENT of the first */
+
+		if (ip_push(pkt, proto, dest) == SYSERR) {
+			pb_free(pkt);
+			pb_freechain(first);
+			return SYSERR;
+		}
+		if (off == 0) {
+			ident = pkt->net_ipid;
+		}
+		pkt->net_ipid = ident;
+		pkt->net_iptos = tos;
+		pkt->net_ipfrag = (off >> 3) |
+				((off + flen < total) ? IP_MF : 0);
+		nfrags++;
+
+		/* Add the fragment to the end of the chain */
+
+		if (first == NULL) {
+			first = pkt;
+		} else {
+			pb_next(last) = pkt;
+		}
+		last = pkt;
+	}
+
+	wait(ipfragmutex);
+	ipfragstats.if_fragged++;
+	ipfragstats.if_fragsout += nfrags;
+	signal(ipfragmutex);
+
+	/* The chain takes one place in the output queue; ipout	*/
+	/*   resolves the next hop once for all of the fragments	*/
+
+	return ip_send(first);
+}
+
+/*------------------------------------------------------------------------
+ * ip_fraghash  -  Compute the hash bucket of a datagram
+ *------------------------------------------------------------------------
+ */
+local	uint32	ip_fraghash(
+	  uint32 src,			/* IP source address		*/
+	  uint16 id,			/* IP datagram ID		*/
+	  byte	proto			/* IP protocol			*/
+	)
+{
+	return hm_hashint(src ^ ((uint32)id << 8) ^ proto) &
+							(IP_REASM_HSIZ - 1);
+}
+
+/*------------------------------------------------------------------------
+ * ip_fragfree  -  Remove a datagram from the fragment table, freeing
+ *		     its buffer unless the datagram was completed
+ *		     (ipfragmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	void	ip_fragfree(
+	  struct ipreasm *irptr,	/* Ptr to the table entry	*/
+	  bool8	freebuffer		/* Return the buffer to the pool*/
+	)
+{
+	int32	*link;			/* Link that points to the slot	*/
+	int32	slot;			/* Index of the slot		*/
+
+	slot = irptr - ipreasmtab;
+	link = &ipreasmhash[ip_fraghash(irptr->ir_src, irptr->ir_id,
+							irptr->ir_proto)];
+	while (*link != slot) {
+		link = &ipreasmtab[*link].ir_next;
+	}
+	*link = irptr->ir_next;
+	if (freebuffer) {
+		freebuf((char *)pb_buf(irptr->ir_pkt));
+	}
+	irptr->ir_state = IP_REASM_FREE;
+}
+
+/*------------------------------------------------------------------------
+ * ip_fragexpire  -  Drop the datagrams whose time to be reassembled has
+ *		       run out (ipfragmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	void	ip_fragexpire(void)
+{
+	struct	ipreasm	*irptr;		/* Ptr to a table entry		*/
+	int32	slot;			/* Index into ipreasmtab	*/
+
+	for (slot = 0; slot < IP_REASM_SLOTS; slot++) {
+		irptr = &ipreasmtab[slot];
+		if ( (irptr->ir_state == IP_REASM_USED) &&
+		     ((int32)(clktime - irptr->ir_expire) >= 0) ) {
+			ipfragstats.if_timeouts++;
+			ip_fragfree(irptr, TRUE);
+		}
+	}
+}
@@ -1,4 +1,4 @@
-/* net.c - net_init, netin, eth_hton */
+/* net.c - net_init, netin, net_demux, eth_hton, eth_ntoh */
 
 #include <xinu.h>
 #include <stdio.h>
@@ -33,8 +33,22 @@ void	net_init (void)
 	/* Create the network buffer pool */
 
 	nbufs = UDP_SLOTS * UDP_QSIZ + ICMP_SLOTS * ICMP_QSIZ + 1;
+	nbufs += ETH_AM335X_RX_RING_SIZE;	/* Owned by the Rx ring	*/
+	nbufs += NETIQS * NETIQ_SIZ;		/* In input queues	*/
+	nbufs += IP_OQCLASSES * IP_OQSIZ;	/* In the output queue	*/
+	nbufs += TCP_SLOTS * TCP_OOOSIZ;	/* Held out of order	*/
+	nbufs += IP_MAXLEN / ((ETH_MTU - IP_HDR_LEN) & ~7) + 1;
+					/* One datagram being	*/
+					/*   fragmented		*/
+	if (nbufs > BP_MAXN) {		/* Many endpoints rarely fill	*/
+		nbufs = BP_MAXN;	/*   their queues at once	*/
+	}
+
+	netbufpool = mkbufpool(PB_BUFSIZ, nbufs);
+
+	/* Let the Ethernet driver free the buffers it sends in place */
 
-	netbufpool = mkbufpool(PACKLEN, nbufs);
+	control(ETHER0, ETH_CTRL_TXFREE, (int32)pb_free, 0);
 
 	/* Initialize the ARP cache */
 
@@ -50,73 +64,126 @@ void	net_init (void)
 
 	/* Initialize the IP output queue */
 
-	ipoqueue.iqhead = 0;
-	ipoqueue.iqtail = 0;
-	ipoqueue.iqsem = semcreate(0);
-	if((int32)ipoqueue.iqsem == SYSERR) {
-		panic("Cannot create ip output queue semaphore");
-		return;
-	}
+	ip_oqinit();
+
+	/* Initialize the IP fragment table */
+
+	ip_fraginit();
+
+	/* Initialize TCP */
+
+	tcp_init();
+
+	/* Initialize the DNS cache and resolver */
+
+	dns_init();
 
 	/* Create the IP output process */
 
 	resume(create(ipout, NETSTK, NETPRIO, "ipout", 0, NULL));
 
+	/* Create the input queues and their workers */
+
+	netiq_init();
+
 	/* Create a network input process */
 
-	resume(create(netin, NETSTK, NETPRIO, "netin", 0, NULL));
+	resume(create(netin, NETSTK, NETPRIO, "netin", 1, ETHER0));
+
+	/* Create the process that retransmits and ages ARP entries */
+
+	resume(create(arptimer, NETSTK, NETPRIO, "arptimer", 0, NULL));
 }
 
 
 /*------------------------------------------------------------------------
- * netin  -  Repeatedly read and process the next incoming packet
+ * netin  -  Repeatedly read the next incoming packet from an Ethernet
+ *		device and put it on the input queue of its class; a
+ *		device that cannot swap buffers (such as the loopback
+ *		device ELOOP) is read with a copy, and the process
+ *		exits when a read fails (the device was closed)
  *------------------------------------------------------------------------
  */
 
-process	netin ()
+process	netin (
+	  did32	dev			/* Device to read frames from	*/
+	)
 {
 	struct	netpacket *pkt;		/* Ptr to current packet	*/
 	int32	retval;			/* Return value from read	*/
+	bool8	swap;			/* Does the driver swap buffers	*/
 
-	/* Do forever: read a packet from the network and process */
+	/* Have the driver receive into network buffers, so that a	*/
+	/*   packet is exchanged for an empty buffer, not copied	*/
+
+	swap = (control(dev, ETH_CTRL_RXPOOL, netbufpool,
+				sizeof(struct pktbuf)) != SYSERR);
+	if (!swap && (dev == ETHER0)) {
+		panic("Cannot set Ethernet receive buffers\n");
+	}
+
+	/* Do forever: read a packet from the network and queue it */
 
 	while(1) {
 
-		/* Allocate a buffer */
+		/* Allocate an empty buffer for the driver */
 
-		pkt = (struct netpacket *)getbuf(netbufpool);
+		pkt = pb_alloc();
 
 		/* Obtain next packet that arrives */
 
-		retval = read(ETHER0, (char *)pkt, PACKLEN);
+		if (swap) {
+			retval = control(dev, ETH_CTRL_RXSWAP,
+							(int32)&pkt, 0);
+		} else {
+			retval = read(dev, (char *)pkt, PACKLEN);
+		}
 		if(retval == SYSERR) {
-			panic("Cannot read from Ethernet\n");
+			if (dev == ETHER0) {
+				panic("Cannot read from Ethernet\n");
+			}
+			pb_free(pkt);
+			return OK;
 		}
+		pb_init(pkt, retval);	/* The whole frame is valid	*/
 
-		/* Convert Ethernet Type to host order */
+		/* Leave the frame to the worker of its input queue */
 
-		eth_ntoh(pkt);
+		netiq_in(pkt);
+	}
+}
 
-		/* Demultiplex on Ethernet type */
+/*------------------------------------------------------------------------
+ * net_demux  -  Handle an arriving frame according to its Ethernet type
+ *------------------------------------------------------------------------
+ */
+void	net_demux(
+	  struct netpacket *pkt		/* Ptr to the frame		*/
+	)
+{
+	/* Convert Ethernet Type to host order */
 
-		switch (pkt->net_ethtype) {
+	eth_ntoh(pkt);
 
-		    case ETH_ARP:			/* Handle ARP	*/
-			arp_in((struct arppacket *)pkt);
-			continue;
+	/* Demultiplex on Ethernet type */
 
-		    case ETH_IP:			/* Handle IP	*/
-			ip_in(pkt);
-			continue;
-	
-		    case ETH_IPv6:			/* Handle IPv6	*/
-			freebuf((char *)pkt);
-			continue;
+	switch (pkt->net_ethtype) {
 
-		    default:	/* Ignore all other incoming packets	*/
-			freebuf((char *)pkt);
-			continue;
-		}
+	    case ETH_ARP:			/* Handle ARP	*/
+		arp_in((struct arppacket *)pkt);
+		return;
+
+	    case ETH_IP:			/* Handle IP	*/
+		ip_in(pkt);
+		return;
+
+	    case ETH_IPv6:			/* Handle IPv6	*/
+		pb_free(pkt);
+		return;
+
+	    default:	/* Ignore all other incoming packets	*/
+		pb_free(pkt);
+		return;
 	}
 }
 
@@ -0,0 +1,231 @@
+/* netiq.c - netiq_init, netiq_add, netiq_setprio, netiq_in,		*/
+/*		netiq_classify, netiq_worker				*/
+
+#include <xinu.h>
+
+struct	netiq	netiqs[NETIQS];		/* Input queues			*/
+local	struct	netiqrule netiqrules[NETIQ_RULES];/* Classification	*/
+local	int32	nnetiqrules;		/* Number of rules in use	*/
+
+/* Priorities of the workers, highest first.  netin runs at NETPRIO	*/
+/*   and, under a flood, never blocks on the ring; the high worker	*/
+/*   runs above it so control frames are handled as they are	*/
+/*   queued, and the others run while netin sleeps between Rx	*/
+/*   budgets (see ethrxnext)					*/
+
+local	pri16	netiqprio[NETIQS] = { NETPRIO + 10, NETPRIO - 20,
+							NETPRIO - 30 };
+
+local	int32	netiq_classify(struct netpacket *);
+
+/*------------------------------------------------------------------------
+ * netiq_init  -  Initialize the input queues, install the default
+ *		    classification rules and start the workers
+ *------------------------------------------------------------------------
+ */
+void	netiq_init(void)
+{
+	struct	netiq	*niqptr;	/* Ptr to an input queue	*/
+	int32	i;			/* Index into netiqs		*/
+	char	name[16];		/* Name of a worker		*/
+
+	nnetiqrules = 0;
+
+	/* ARP and network-control traffic (DSCP CS6 and EF) go to	*/
+	/*   the high-priority queue; everything else is normal	*/
+
+	netiq_add(NETIQ_ETHTYPE, ETH_ARP, NETIQ_HIGH);
+	netiq_add(NETIQ_DSCP, 48, NETIQ_HIGH);
+	netiq_add(NETIQ_DSCP, 46, NETIQ_HIGH);
+
+	for (i = 0; i < NETIQS; i++) {
+		niqptr = &netiqs[i];
+		rg_init(&niqptr->niq_rg, niqptr->niq_buf, NETIQ_SIZ);
+		niqptr->niq_pkts = 0;
+		niqptr->niq_drops = 0;
+		niqptr->niq_maxdepth = 0;
+		niqptr->niq_sem = semcreate(0);
+		if ((int32)niqptr->niq_sem == SYSERR) {
+			panic("Cannot create input queue semaphore");
+		}
+		sprintf(name, "netin%d", i);
+		niqptr->niq_pid = create(netiq_worker, NETSTK,
+				netiqprio[i], name, 1, i);
+		resume(niqptr->niq_pid);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * netiq_add  -  Send frames that match a key to an input queue; a rule
+ *		   with the same key and value is replaced
+ *------------------------------------------------------------------------
+ */
+status	netiq_add(
+	  byte	key,			/* NETIQ_ETHTYPE, etc.		*/
+	  uint16 value,			/* Value the key must have	*/
+	  int32	queue			/* Input queue for the frames	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+	struct	netiqrule *nrptr;	/* Ptr to a rule		*/
+	int32	i;			/* Index into netiqrules	*/
+
+	if ( (key < NETIQ_ETHTYPE) || (key > NETIQ_UDPPORT) ||
+	     (queue < 0) || (queue >= NETIQS) ) {
+		return SYSERR;
+	}
+
+	mask = disable();
+	for (i = 0; i < nnetiqrules; i++) {
+		nrptr = &netiqrules[i];
+		if ( (nrptr->nr_key == key) && (nrptr->nr_value == value) ) {
+			nrptr->nr_queue = queue;
+			restore(mask);
+			return OK;
+		}
+	}
+	if (nnetiqrules >= NETIQ_RULES) {
+		restore(mask);
+		return SYSERR;
+	}
+	nrptr = &netiqrules[nnetiqrules++];
+	nrptr->nr_key = key;
+	nrptr->nr_value = value;
+	nrptr->nr_queue = queue;
+	restore(mask);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * netiq_setprio  -  Change the priority of the worker of an input queue
+ *------------------------------------------------------------------------
+ */
+status	netiq_setprio(
+	  int32	queue,			/* Input queue			*/
+	  pri16	prio			/* New priority of its worker	*/
+	)
+{
+	if ( (queue < 0) || (queue >= NETIQS) || (prio <= 0) ) {
+		return SYSERR;
+	}
+	netiqprio[queue] = prio;
+	if (chprio(netiqs[queue].niq_pid, prio) == (pri16)SYSERR) {
+		return SYSERR;
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * netiq_in  -  Put an arriving frame on the input queue of its class,
+ *		  or drop it if that queue is full
+ *------------------------------------------------------------------------
+ */
+void	netiq_in(
+	  struct netpacket *pktptr	/* Frame in network byte order	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+	struct	netiq	*niqptr;	/* Ptr to the input queue	*/
+	uint32	depth;			/* Frames now in the queue	*/
+
+	niqptr = &netiqs[netiq_classify(pktptr)];
+
+	/* The worker is the only consumer, so the ring buffer needs	*/
+	/*   no lock against it; a netin process reads each device,	*/
+	/*   so the producers exclude each other with interrupts off	*/
+
+	mask = disable();
+	if (rg_put(&niqptr->niq_rg, pktptr) == SYSERR) {
+		niqptr->niq_drops++;
+		restore(mask);
+		pb_free(pktptr);
+		return;
+	}
+	niqptr->niq_pkts++;
+	depth = rg_count(&niqptr->niq_rg);
+	if (depth > niqptr->niq_maxdepth) {
+		niqptr->niq_maxdepth = depth;
+	}
+	restore(mask);
+	signal(niqptr->niq_sem);
+}
+
+/*------------------------------------------------------------------------
+ * netiq_classify  -  Find the input queue for a frame: the queue of the
+ *		        most specific matching rule, or NETIQ_NORMAL
+ *------------------------------------------------------------------------
+ */
+local	int32	netiq_classify(
+	  struct netpacket *pktptr	/* Frame in network byte order	*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+	uint16	val[NETIQ_UDPPORT+1];	/* Value of each key		*/
+	bool8	has[NETIQ_UDPPORT+1];	/* Whether the frame has the key*/
+	struct	netiqrule *nrptr;	/* Ptr to a rule		*/
+	byte	best;			/* Key of the best match so far	*/
+	int32	queue;			/* Queue of the best match	*/
+	int32	i;			/* Index into netiqrules	*/
+
+	/* Extract the keys the frame has */
+
+	memset((char *)has, 0, sizeof(has));
+	has[NETIQ_ETHTYPE] = TRUE;
+	val[NETIQ_ETHTYPE] = ntohs(pktptr->net_ethtype);
+	if ( (val[NETIQ_ETHTYPE] == ETH_IP) &&
+	     (pb_len(pktptr) >= ETH_HDR_LEN + IP_HDR_LEN) ) {
+		has[NETIQ_IPPROTO] = has[NETIQ_DSCP] = TRUE;
+		val[NETIQ_IPPROTO] = pktptr->net_ipproto;
+		val[NETIQ_DSCP] = pktptr->net_iptos >> 2;
+
+		/* The port is only in the first fragment, and only at	*/
+		/*   the overlay's offset if there are no IP options	*/
+
+		if ( (pktptr->net_ipproto == IP_UDP) &&
+		     (pktptr->net_ipvh == IP_VH) &&
+		     ((ntohs(pktptr->net_ipfrag) & 0x1fff) == 0) &&
+		     (pb_len(pktptr) >= ETH_HDR_LEN + IP_HDR_LEN +
+						UDP_HDR_LEN) ) {
+			has[NETIQ_UDPPORT] = TRUE;
+			val[NETIQ_UDPPORT] = ntohs(pktptr->net_udpdport);
+		}
+	}
+
+	/* Find the most specific rule that matches */
+
+	best = 0;
+	queue = NETIQ_NORMAL;
+	mask = disable();
+	for (i = 0; i < nnetiqrules; i++) {
+		nrptr = &netiqrules[i];
+		if ( (nrptr->nr_key > best) && has[nrptr->nr_key] &&
+		     (val[nrptr->nr_key] == nrptr->nr_value) ) {
+			best = nrptr->nr_key;
+			queue = nrptr->nr_queue;
+		}
+	}
+	restore(mask);
+	return queue;
+}
+
+/*------------------------------------------------------------------------
+ * netiq_worker  -  Process that handles the frames of one input queue
+ *------------------------------------------------------------------------
+ */
+process	netiq_worker(
+	  int32	queue			/* Input queue to serve		*/
+	)
+{
+	struct	netiq	*niqptr;	/* Ptr to the input queue	*/
+	struct	netpacket *pktptr;	/* Ptr to current packet	*/
+
+	niqptr = &netiqs[queue];
+	while (1) {
+		wait(niqptr->niq_sem);
+		pktptr = (struct netpacket *)rg_get(&niqptr->niq_rg);
+		if (pktptr != NULL) {
+			net_demux(pktptr);
+		}
+	}
+	return OK;
+}
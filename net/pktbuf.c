@@ -0,0 +1,263 @@
+/* pktbuf.c - pb_alloc, pb_init, pb_free, pb_freechain, pb_clone,	*/
+/*		pb_unshare, pb_reserve, pb_put, pb_push, pb_pull,	*/
+/*		pb_trim, pb_pool					*/
+
+#include <xinu.h>
+
+local	bpid32	pb_pool(struct pktbuf *);
+
+/*------------------------------------------------------------------------
+ * pb_alloc  -  Allocate a network buffer with no valid data; the data
+ *		  start at the beginning of the frame
+ *------------------------------------------------------------------------
+ */
+struct	netpacket *pb_alloc(void)
+{
+	struct	pktbuf	*pb;		/* Header of the new buffer	*/
+
+	pb = (struct pktbuf *)getbuf(netbufpool);
+	if ((int32)pb == SYSERR) {
+		return (struct netpacket *)SYSERR;
+	}
+	pb_init((struct netpacket *)(pb + 1), 0);
+	return (struct netpacket *)(pb + 1);
+}
+
+/*------------------------------------------------------------------------
+ * pb_init  -  Set the header of a buffer whose frame holds len bytes of
+ *		 valid data (for example, a frame a driver received into
+ *		 the buffer by DMA); the header is not trusted, and the
+ *		 room for the frame is found from the buffer's pool
+ *------------------------------------------------------------------------
+ */
+void	pb_init(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* Bytes of valid data		*/
+	)
+{
+	struct	pktbuf	*pb;		/* Header of the buffer		*/
+	bpid32	pool;			/* Pool of the buffer		*/
+
+	pb = pb_buf(pkt);
+	pb->pb_data = (char *)pkt;
+	pb->pb_len = len;
+
+	/* A netbufpool buffer is rounded up to whole cache lines, but	*/
+	/*   a frame in it is never longer than PACKLEN		*/
+
+	pool = pb_pool(pb);
+	if (pool == netbufpool) {
+		pb->pb_size = PACKLEN;
+	} else {
+		pb->pb_size = buftab[pool].bpsize - sizeof(struct pktbuf);
+	}
+	pb->pb_ref = 1;
+	pb->pb_next = NULL;
+}
+
+/*------------------------------------------------------------------------
+ * pb_free  -  Drop one reference to a network buffer and return the
+ *		 buffer to netbufpool when the last one is gone
+ *------------------------------------------------------------------------
+ */
+status	pb_free(
+	  struct netpacket *pkt		/* Frame in the buffer		*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+	struct	pktbuf	*pb;		/* Header of the buffer		*/
+
+	mask = disable();
+	pb = pb_buf(pkt);
+	if (pb->pb_ref <= 0) {
+		restore(mask);
+		return SYSERR;
+	}
+	if (--pb->pb_ref > 0) {
+		restore(mask);
+		return OK;
+	}
+	restore(mask);
+	return freebuf((char *)pb);
+}
+
+/*------------------------------------------------------------------------
+ * pb_freechain  -  Free a frame and the frames chained after it (the
+ *		      fragments of a datagram that travel together)
+ *------------------------------------------------------------------------
+ */
+void	pb_freechain(
+	  struct netpacket *pkt		/* First frame of the chain	*/
+	)
+{
+	struct	netpacket *next;	/* Frame after pkt		*/
+
+	while (pkt != NULL) {
+		next = pb_next(pkt);
+		pb_free(pkt);
+		pkt = next;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * pb_clone  -  Take another reference to a network buffer so a second
+ *		  consumer can read it without a copy; the buffer is
+ *		  shared until all but one of the references are freed
+ *------------------------------------------------------------------------
+ */
+struct	netpacket *pb_clone(
+	  struct netpacket *pkt		/* Frame in the buffer		*/
+	)
+{
+	intmask	mask;			/* Saved interrupt mask		*/
+
+	mask = disable();
+	pb_buf(pkt)->pb_ref++;
+	restore(mask);
+	return pkt;
+}
+
+/*------------------------------------------------------------------------
+ * pb_unshare  -  Return a buffer the caller may change: the buffer
+ *		    itself when it holds the only reference, otherwise a
+ *		    private copy from the same pool (the reference to the
+ *		    original is dropped in either case)
+ *------------------------------------------------------------------------
+ */
+struct	netpacket *pb_unshare(
+	  struct netpacket *pkt		/* Frame in the buffer		*/
+	)
+{
+	struct	netpacket *copy;	/* Frame in the private copy	*/
+	int32	offset;			/* Offset of the data		*/
+	bpid32	pool;			/* Pool of the original		*/
+
+	if (pb_buf(pkt)->pb_ref == 1) {
+		return pkt;
+	}
+
+	/* Pools other than netbufpool have few buffers; do not wait	*/
+	/*   for one while holding a reference to another		*/
+
+	pool = pb_pool(pb_buf(pkt));
+	if (pool == netbufpool) {
+		copy = pb_alloc();
+	} else if (semcount(buftab[pool].bpsem) <= 0) {
+		copy = (struct netpacket *)SYSERR;
+	} else {
+		copy = (struct netpacket *)
+			((struct pktbuf *)getbuf(pool) + 1);
+		pb_init(copy, 0);
+	}
+	if ((int32)copy != SYSERR) {
+		offset = pb_data(pkt) - (char *)pkt;
+		memcpy((char *)copy, (char *)pkt, offset + pb_len(pkt));
+		pb_data(copy) = (char *)copy + offset;
+		pb_len(copy) = pb_len(pkt);
+	}
+	pb_free(pkt);
+	return copy;
+}
+
+/*------------------------------------------------------------------------
+ * pb_reserve  -  Move the start of an empty buffer's data forward to
+ *		    leave room for headers that will be pushed later
+ *------------------------------------------------------------------------
+ */
+status	pb_reserve(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* Bytes to reserve		*/
+	)
+{
+	if ( (pb_len(pkt) != 0) || (len < 0) ||
+	     (len > pb_tailroom(pkt)) ) {
+		return SYSERR;
+	}
+	pb_data(pkt) += len;
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * pb_put  -  Extend the data at the tail; return a pointer to the new
+ *		space
+ *------------------------------------------------------------------------
+ */
+char	*pb_put(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* Bytes to add			*/
+	)
+{
+	char	*tail;			/* First byte after the data	*/
+
+	if ( (len < 0) || (len > pb_tailroom(pkt)) ) {
+		return (char *)SYSERR;
+	}
+	tail = pb_data(pkt) + pb_len(pkt);
+	pb_len(pkt) += len;
+	return tail;
+}
+
+/*------------------------------------------------------------------------
+ * pb_push  -  Extend the data at the head to make room for a header;
+ *		 return a pointer to the header
+ *------------------------------------------------------------------------
+ */
+char	*pb_push(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* Length of the header		*/
+	)
+{
+	if ( (len < 0) || (len > pb_headroom(pkt)) ) {
+		return (char *)SYSERR;
+	}
+	pb_data(pkt) -= len;
+	pb_len(pkt) += len;
+	return pb_data(pkt);
+}
+
+/*------------------------------------------------------------------------
+ * pb_pull  -  Remove a header from the head of the data; return a
+ *		 pointer to the data that follow it
+ *------------------------------------------------------------------------
+ */
+char	*pb_pull(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* Length of the header		*/
+	)
+{
+	if ( (len < 0) || (len > pb_len(pkt)) ) {
+		return (char *)SYSERR;
+	}
+	pb_data(pkt) += len;
+	pb_len(pkt) -= len;
+	return pb_data(pkt);
+}
+
+/*------------------------------------------------------------------------
+ * pb_trim  -  Shorten the data to len bytes (for example, to drop the
+ *		 padding of a minimum-size Ethernet frame)
+ *------------------------------------------------------------------------
+ */
+status	pb_trim(
+	  struct netpacket *pkt,	/* Frame in the buffer		*/
+	  int32	len			/* New length of the data	*/
+	)
+{
+	if ( (len < 0) || (len > pb_len(pkt)) ) {
+		return SYSERR;
+	}
+	pb_len(pkt) = len;
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * pb_pool  -  Return the pool of a buffer (getbuf stores the pool ID
+ *		 just before the buffer)
+ *------------------------------------------------------------------------
+ */
+local	bpid32	pb_pool(
+	  struct pktbuf	*pb		/* Header of the buffer		*/
+	)
+{
+	return *(bpid32 *)((char *)pb - sizeof(bpid32));
+}
@@ -0,0 +1,1629 @@
+/* tcp.c - tcp_init, tcp_listen, tcp_accept, tcp_connect, tcp_send,	*/
+/*		tcp_recv, tcp_close, tcp_in, tcptimer, tcp_ntoh,	*/
+/*		tcp_hton, tcp_alloc, tcp_free, tcp_term, tcp_wake,	*/
+/*		tcp_lookup, tcp_synrcvd, tcp_synsent, tcp_ack, tcp_data,*/
+/*		tcp_ooo, tcp_output, tcp_rexmit, tcp_timeout, tcp_xmit,	*/
+/*		tcp_reset, tcp_rttupdate, tcp_mss			*/
+
+#include <xinu.h>
+
+struct	tcb	tcbtab[TCP_SLOTS];	/* Table of TCP connections	*/
+struct	tcpstat	tcpstats;		/* TCP statistics		*/
+sid32	tcpmutex;			/* Protects tcbtab and tcpstats	*/
+
+/* All TCP state is protected by tcpmutex.  Segments are handed to	*/
+/*   ip_enqueue, which never calls back into TCP, so they can be	*/
+/*   sent with the table locked; a segment to this host comes back	*/
+/*   through ipout.  A process waiting in the API records its ID in	*/
+/*   the entry and is woken with a message, as with UDP.		*/
+
+/* Sending follows RFC 5681 and 6582: slow start and congestion	*/
+/*   avoidance, fast retransmit after three duplicate ACKs and	*/
+/*   NewReno fast recovery.  The RTO is estimated as in RFC 6298.	*/
+/*   The receiver holds up to TCP_OOOSIZ out-of-order segments and	*/
+/*   delays ACKs as in RFC 1122, acknowledging every second segment	*/
+/*   at once.								*/
+
+local	uint32	tcpiss;			/* Spreads initial seq. numbers	*/
+
+local	struct	tcb *tcp_alloc(void);
+local	void	tcp_free(struct tcb *);
+local	void	tcp_term(struct tcb *);
+local	void	tcp_wake(struct tcb *);
+local	struct	tcb *tcp_lookup(uint16, uint32, uint16, bool8);
+local	void	tcp_synrcvd(struct tcb *, struct netpacket *);
+local	void	tcp_synsent(struct tcb *, struct netpacket *);
+local	status	tcp_ack(struct tcb *, struct netpacket *, int32);
+local	void	tcp_data(struct tcb *, struct netpacket *, uint16);
+local	bool8	tcp_ooo(struct tcb *, uint16 *);
+local	void	tcp_output(struct tcb *);
+local	void	tcp_rexmit(struct tcb *);
+local	void	tcp_timeout(struct tcb *);
+local	void	tcp_xmit(struct tcb *, uint32, uint16, int32, int32);
+local	void	tcp_reset(struct netpacket *);
+local	void	tcp_rttupdate(struct tcb *, int32);
+local	uint16	tcp_mss(struct netpacket *);
+
+#define	tcp_rwnd(tbptr)	(TCP_RBSIZ - (tbptr)->tb_rblen)
+#define	tcp_sync(tbptr)	((tbptr)->tb_state >= TCPS_ESTABLISHED)
+
+/*------------------------------------------------------------------------
+ * tcp_init  -  Initialize the TCP table and start the timer process
+ *------------------------------------------------------------------------
+ */
+void	tcp_init(void)
+{
+	int32	i;			/* Index into the TCP table	*/
+
+	for (i = 0; i < TCP_SLOTS; i++) {
+		tcbtab[i].tb_state = TCPS_FREE;
+	}
+	memset((char *)&tcpstats, NULLCH, sizeof(tcpstats));
+	tcpiss = clkms() * 250;
+	tcpmutex = semcreate(1);
+	if ((int32)tcpmutex == SYSERR) {
+		panic("Cannot create TCP table semaphore");
+	}
+	resume(create(tcptimer, NETSTK, NETPRIO, "tcptimer", 0, NULL));
+}
+
+/*------------------------------------------------------------------------
+ * tcp_listen  -  Open a slot that accepts connections to a local port;
+ *		    return the slot or SYSERR
+ *------------------------------------------------------------------------
+ */
+int32	tcp_listen (
+	 uint16	locport			/* Local TCP protocol port	*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+
+	wait(tcpmutex);
+	if ( (locport == 0) ||
+	     (tcp_lookup(locport, 0, 0, TRUE) != NULL) ) {
+		signal(tcpmutex);
+		return SYSERR;
+	}
+	tbptr = tcp_alloc();
+	if (tbptr == NULL) {
+		signal(tcpmutex);
+		return SYSERR;
+	}
+	tbptr->tb_locport = locport;
+	tbptr->tb_user = TRUE;
+	tbptr->tb_state = TCPS_LISTEN;
+	signal(tcpmutex);
+	return tbptr - tcbtab;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_accept  -  Wait for a connection to a listening slot; return the
+ *		    slot of the connection, TIMEOUT or SYSERR
+ *------------------------------------------------------------------------
+ */
+int32	tcp_accept (
+	 int32	slot,			/* Listening slot		*/
+	 uint32	timeout			/* Time to wait in msec		*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to the listener	*/
+	struct	tcb	*cptr;		/* Pointer to the connection	*/
+	umsg32	msg;			/* Message from recvtime()	*/
+	int32	i;			/* Index into tb_acceptq	*/
+
+	if ( (slot < 0) || (slot >= TCP_SLOTS) ) {
+		return SYSERR;
+	}
+	wait(tcpmutex);
+	tbptr = &tcbtab[slot];
+	while (tbptr->tb_nacc == 0) {
+		if ( (tbptr->tb_state != TCPS_LISTEN) || !tbptr->tb_user ||
+		     (tbptr->tb_rpid != -1) ) {
+			signal(tcpmutex);
+			return SYSERR;
+		}
+		tbptr->tb_rpid = currpid;
+		msg = recvclr();
+		signal(tcpmutex);
+		msg = recvtime(timeout);
+		wait(tcpmutex);
+		tbptr->tb_rpid = -1;
+		if ( (msg == TIMEOUT) && (tbptr->tb_nacc == 0) ) {
+			signal(tcpmutex);
+			return TIMEOUT;
+		}
+	}
+
+	/* Take the oldest connection off the accept queue */
+
+	cptr = &tcbtab[tbptr->tb_acceptq[0]];
+	tbptr->tb_nacc--;
+	for (i = 0; i < tbptr->tb_nacc; i++) {
+		tbptr->tb_acceptq[i] = tbptr->tb_acceptq[i+1];
+	}
+	cptr->tb_queued = FALSE;
+	cptr->tb_parent = -1;
+	cptr->tb_user = TRUE;
+	signal(tcpmutex);
+	return cptr - tcbtab;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_connect  -  Open a connection to a remote port and wait until it
+ *		     is established; return the slot or SYSERR
+ *------------------------------------------------------------------------
+ */
+int32	tcp_connect (
+	 uint32	remip,			/* Remote IP address		*/
+	 uint16	remport			/* Remote TCP protocol port	*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	uint16	locport;		/* Local protocol port		*/
+
+	if ( (remip == 0) || (remport == 0) ) {
+		return SYSERR;
+	}
+
+	/* Segments to 127.0.0.0/8 come back from our unicast address */
+
+	if ((remip & 0xff000000) == 0x7f000000) {
+		remip = NetData.ipucast;
+	}
+
+	wait(tcpmutex);
+	do {
+		locport = getport();
+	} while (tcp_lookup(locport, remip, remport, FALSE) != NULL);
+	tbptr = tcp_alloc();
+	if (tbptr == NULL) {
+		signal(tcpmutex);
+		return SYSERR;
+	}
+	tbptr->tb_remip = remip;
+	tbptr->tb_remport = remport;
+	tbptr->tb_locport = locport;
+	tbptr->tb_user = TRUE;
+	tbptr->tb_state = TCPS_SYNSENT;
+	tbptr->tb_rttstart = clkms();
+	tcp_xmit(tbptr, tbptr->tb_iss, TCPF_SYN, 0, 0);
+	tbptr->tb_snxt = tbptr->tb_smax = tbptr->tb_iss + 1;
+	tbptr->tb_rxtimer = tbptr->tb_rto;
+
+	/* Wait until the handshake completes or fails */
+
+	while (tbptr->tb_state == TCPS_SYNSENT) {
+		tbptr->tb_rpid = currpid;
+		recvclr();
+		signal(tcpmutex);
+		receive();
+		wait(tcpmutex);
+		tbptr->tb_rpid = -1;
+	}
+	if (tbptr->tb_error != OK) {
+		tcp_free(tbptr);
+		signal(tcpmutex);
+		return SYSERR;
+	}
+	signal(tcpmutex);
+	return tbptr - tcbtab;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_send  -  Queue data on a connection, waiting for space in the
+ *		  send buffer as needed; return the number of bytes
+ *		  queued or SYSERR if the connection cannot send
+ *------------------------------------------------------------------------
+ */
+int32	tcp_send (
+	 int32	slot,			/* Slot of the connection	*/
+	 char	*buff,			/* Data to send			*/
+	 int32	len			/* Length of the data		*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	int32	done;			/* Bytes queued so far		*/
+	int32	n;			/* Bytes to queue at once	*/
+	int32	tail;			/* Index of the first free byte	*/
+
+	if ( (slot < 0) || (slot >= TCP_SLOTS) || (len < 0) ) {
+		return SYSERR;
+	}
+	wait(tcpmutex);
+	tbptr = &tcbtab[slot];
+	done = 0;
+	while (done < len) {
+		if ( !tbptr->tb_user || (tbptr->tb_error != OK) ||
+		     ( (tbptr->tb_state != TCPS_ESTABLISHED) &&
+		       (tbptr->tb_state != TCPS_CLOSEWAIT) ) ) {
+			signal(tcpmutex);
+			return SYSERR;
+		}
+
+		/* Wait for the peer to acknowledge data if the buffer	*/
+		/*   is full						*/
+
+		if (tbptr->tb_sblen == TCP_SBSIZ) {
+			tbptr->tb_spid = currpid;
+			recvclr();
+			signal(tcpmutex);
+			receive();
+			wait(tcpmutex);
+			tbptr->tb_spid = -1;
+			continue;
+		}
+
+		/* Copy as much as fits, in up to two pieces since the	*/
+		/*   buffer is circular					*/
+
+		tail = (tbptr->tb_sbstart + tbptr->tb_sblen) & (TCP_SBSIZ-1);
+		n = TCP_SBSIZ - tbptr->tb_sblen;
+		if (n > TCP_SBSIZ - tail) {
+			n = TCP_SBSIZ - tail;
+		}
+		if (n > len - done) {
+			n = len - done;
+		}
+		memcpy(tbptr->tb_sbuf + tail, buff + done, n);
+		tbptr->tb_sblen += n;
+		done += n;
+		tcp_output(tbptr);
+	}
+	signal(tcpmutex);
+	return done;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_recv  -  Receive data from a connection, waiting for some to
+ *		  arrive; return the number of bytes, 0 once the peer
+ *		  has closed, TIMEOUT or SYSERR
+ *------------------------------------------------------------------------
+ */
+int32	tcp_recv (
+	 int32	slot,			/* Slot of the connection	*/
+	 char	*buff,			/* Buffer to hold the data	*/
+	 int32	len,			/* Length of the buffer		*/
+	 uint32	timeout			/* Time to wait in msec		*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	int32	done;			/* Bytes copied so far		*/
+	int32	n;			/* Bytes to copy at once	*/
+	umsg32	msg;			/* Message from recvtime()	*/
+
+	if ( (slot < 0) || (slot >= TCP_SLOTS) || (len <= 0) ) {
+		return SYSERR;
+	}
+	wait(tcpmutex);
+	tbptr = &tcbtab[slot];
+	while (tbptr->tb_rblen == 0) {
+		if ( !tbptr->tb_user || (tbptr->tb_state == TCPS_LISTEN) ||
+		     (tbptr->tb_rpid != -1) ) {
+			signal(tcpmutex);
+			return SYSERR;
+		}
+		if (tbptr->tb_finrcvd) {
+			signal(tcpmutex);
+			return 0;
+		}
+		if ( (tbptr->tb_error != OK) ||
+		     (tbptr->tb_state == TCPS_CLOSED) ) {
+			signal(tcpmutex);
+			return SYSERR;
+		}
+		tbptr->tb_rpid = currpid;
+		msg = recvclr();
+		signal(tcpmutex);
+		msg = recvtime(timeout);
+		wait(tcpmutex);
+		tbptr->tb_rpid = -1;
+		if ( (msg == TIMEOUT) && (tbptr->tb_rblen == 0) ) {
+			signal(tcpmutex);
+			return TIMEOUT;
+		}
+	}
+
+	/* Copy out in up to two pieces */
+
+	done = 0;
+	while ( (done < len) && (tbptr->tb_rblen > 0) ) {
+		n = TCP_RBSIZ - tbptr->tb_rbstart;
+		if (n > tbptr->tb_rblen) {
+			n = tbptr->tb_rblen;
+		}
+		if (n > len - done) {
+			n = len - done;
+		}
+		memcpy(buff + done, tbptr->tb_rbuf + tbptr->tb_rbstart, n);
+		tbptr->tb_rbstart = (tbptr->tb_rbstart + n) & (TCP_RBSIZ-1);
+		tbptr->tb_rblen -= n;
+		done += n;
+	}
+
+	/* Tell the peer at once if the window has opened by enough	*/
+	/*   to matter (RFC 1122, receiver silly window avoidance)	*/
+
+	if ( tcp_sync(tbptr) && !tbptr->tb_finrcvd &&
+	     ((int32)(tbptr->tb_rnxt + tcp_rwnd(tbptr) - tbptr->tb_radv) >=
+	      ((2 * TCP_MSS < TCP_RBSIZ / 2) ? 2 * TCP_MSS : TCP_RBSIZ / 2)) ) {
+		tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+	}
+	signal(tcpmutex);
+	return done;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_close  -  Give up a slot: close a listener, or send a FIN after
+ *		   the queued data; the connection finishes closing on
+ *		   its own and the slot is freed when it is gone
+ *------------------------------------------------------------------------
+ */
+status	tcp_close (
+	 int32	slot			/* Slot to close		*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	struct	tcb	*cptr;		/* Pointer to a child connection*/
+	int32	i;			/* Index into tcbtab		*/
+
+	if ( (slot < 0) || (slot >= TCP_SLOTS) ) {
+		return SYSERR;
+	}
+	wait(tcpmutex);
+	tbptr = &tcbtab[slot];
+	if ( (tbptr->tb_state == TCPS_FREE) || !tbptr->tb_user ) {
+		signal(tcpmutex);
+		return SYSERR;
+	}
+	tbptr->tb_user = FALSE;
+
+	switch (tbptr->tb_state) {
+
+	    case TCPS_LISTEN:
+
+		/* Reset the connections nobody has accepted */
+
+		for (i = 0; i < TCP_SLOTS; i++) {
+			cptr = &tcbtab[i];
+			if ( (cptr->tb_state == TCPS_FREE) ||
+			     (cptr->tb_parent != slot) ) {
+				continue;
+			}
+			if (cptr->tb_state != TCPS_CLOSED) {
+				tcp_xmit(cptr, cptr->tb_snxt, TCPF_RST, 0, 0);
+				tcpstats.ts_resets++;
+			}
+			tcp_free(cptr);
+		}
+		tcp_wake(tbptr);
+		tcp_free(tbptr);
+		break;
+
+	    case TCPS_CLOSED:
+	    case TCPS_SYNSENT:
+		tcp_wake(tbptr);
+		tcp_free(tbptr);
+		break;
+
+	    case TCPS_ESTABLISHED:
+	    case TCPS_CLOSEWAIT:
+		tbptr->tb_state = (tbptr->tb_state == TCPS_ESTABLISHED) ?
+					TCPS_FINWAIT1 : TCPS_LASTACK;
+		tbptr->tb_finq = TRUE;
+		tcp_wake(tbptr);
+		tcp_output(tbptr);
+		break;
+
+	    default:
+		break;
+	}
+	signal(tcpmutex);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_in  -  Handle a TCP segment that has arrived (the data of the
+ *		packet are the TCP header and payload, in host byte
+ *		order)
+ *------------------------------------------------------------------------
+ */
+void	tcp_in(
+	  struct netpacket *pktptr	/* Pointer to the packet	*/
+	)
+{
+	struct	tcb	*tbptr;		/* Connection the segment is for*/
+	struct	tcb	*lptr;		/* Listener for the port	*/
+	int32	hlen;			/* Length of the TCP header	*/
+	uint16	flags;			/* TCP flags of the segment	*/
+	uint32	seq;			/* First sequence number	*/
+	int32	seglen;			/* Sequence space it occupies	*/
+	int32	rwnd;			/* Our receive window		*/
+	bool8	ok;			/* Segment is in the window	*/
+
+	hlen = (pktptr->net_tcpcode >> 12) * 4;
+	if ( (pb_len(pktptr) < TCP_HDR_LEN) || (hlen < TCP_HDR_LEN) ||
+	     (hlen > pb_len(pktptr)) ) {
+		wait(tcpmutex);
+		tcpstats.ts_ckdrop++;
+		signal(tcpmutex);
+		pb_free(pktptr);
+		return;
+	}
+	flags = pktptr->net_tcpcode & 0x3f;
+
+	wait(tcpmutex);
+	tcpstats.ts_segsin++;
+
+	tbptr = tcp_lookup(pktptr->net_tcpdport, pktptr->net_ipsrc,
+					pktptr->net_tcpsport, FALSE);
+	if (tbptr == NULL) {
+
+		/* A SYN to a listening port opens a connection;	*/
+		/*   anything else is answered with a reset		*/
+
+		lptr = tcp_lookup(pktptr->net_tcpdport, 0, 0, TRUE);
+		if ( (lptr != NULL) &&
+		     ((flags & (TCPF_SYN|TCPF_ACK|TCPF_RST)) == TCPF_SYN) ) {
+			tcp_synrcvd(lptr, pktptr);
+		} else if (flags & TCPF_RST) {
+			pb_free(pktptr);
+		} else {
+			tcp_reset(pktptr);
+		}
+		signal(tcpmutex);
+		return;
+	}
+
+	if (tbptr->tb_state == TCPS_SYNSENT) {
+		tcp_synsent(tbptr, pktptr);
+		signal(tcpmutex);
+		return;
+	}
+
+	/* A connection that is gone keeps its entry only until the	*/
+	/*   user closes it						*/
+
+	if (tbptr->tb_state == TCPS_CLOSED) {
+		if (flags & TCPF_RST) {
+			pb_free(pktptr);
+		} else {
+			tcp_reset(pktptr);
+		}
+		signal(tcpmutex);
+		return;
+	}
+
+	/* Make the data of the packet the payload of the segment */
+
+	seq = pktptr->net_tcpseq;
+	pb_pull(pktptr, hlen);
+	seglen = pb_len(pktptr) + ((flags & TCPF_SYN) ? 1 : 0) +
+					((flags & TCPF_FIN) ? 1 : 0);
+
+	/* Check that the segment overlaps the receive window (RFC 793)	*/
+
+	rwnd = tcp_rwnd(tbptr);
+	if (seglen == 0) {
+		ok = (seq == tbptr->tb_rnxt) ||
+		     ( SEQ_GEQ(seq, tbptr->tb_rnxt) &&
+		       SEQ_LT(seq, tbptr->tb_rnxt + rwnd) );
+	} else {
+		ok = (rwnd > 0) &&
+		     SEQ_LT(seq, tbptr->tb_rnxt + rwnd) &&
+		     SEQ_GT(seq + seglen, tbptr->tb_rnxt);
+	}
+	if (!ok) {
+		if (!(flags & TCPF_RST)) {
+			tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+		}
+		pb_free(pktptr);
+		signal(tcpmutex);
+		return;
+	}
+
+	/* A reset in the window ends the connection */
+
+	if (flags & TCPF_RST) {
+		tbptr->tb_error = SYSERR;
+		tcp_term(tbptr);
+		pb_free(pktptr);
+		signal(tcpmutex);
+		return;
+	}
+
+	/* A SYN in the window is answered with an ACK (RFC 5961), and	*/
+	/*   a segment without an ACK is dropped			*/
+
+	if ( (flags & TCPF_SYN) || !(flags & TCPF_ACK) ) {
+		if (flags & TCPF_SYN) {
+			tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+		}
+		pb_free(pktptr);
+		signal(tcpmutex);
+		return;
+	}
+
+	if (tcp_ack(tbptr, pktptr, seglen) == SYSERR) {
+		signal(tcpmutex);
+		return;
+	}
+	if (tbptr->tb_state == TCPS_FREE) {	/* Closed by the ACK	*/
+		pb_free(pktptr);
+		signal(tcpmutex);
+		return;
+	}
+
+	tcp_data(tbptr, pktptr, flags);
+	tcp_output(tbptr);
+	signal(tcpmutex);
+}
+
+/*------------------------------------------------------------------------
+ * tcptimer  -  Process that runs the retransmission, delayed-ACK and
+ *		  TIME-WAIT timers of every connection
+ *------------------------------------------------------------------------
+ */
+process	tcptimer(void)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	int32	slot;			/* Index into tcbtab		*/
+
+	while (TRUE) {
+		sleepms(TCP_TICK);
+
+		wait(tcpmutex);
+		for (slot = 0; slot < TCP_SLOTS; slot++) {
+			tbptr = &tcbtab[slot];
+			if ( (tbptr->tb_state == TCPS_FREE) ||
+			     (tbptr->tb_state == TCPS_LISTEN) ||
+			     (tbptr->tb_state == TCPS_CLOSED) ) {
+				continue;
+			}
+			if ( (tbptr->tb_acktimer > 0) &&
+			     ((tbptr->tb_acktimer -= TCP_TICK) <= 0) ) {
+				tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+			}
+			if ( (tbptr->tb_twtimer > 0) &&
+			     ((tbptr->tb_twtimer -= TCP_TICK) <= 0) ) {
+				tbptr->tb_twtimer = 0;
+				tcp_term(tbptr);
+				continue;
+			}
+			if ( (tbptr->tb_rxtimer > 0) &&
+			     ((tbptr->tb_rxtimer -= TCP_TICK) <= 0) ) {
+				tbptr->tb_rxtimer = 0;
+				tcp_timeout(tbptr);
+			}
+		}
+		signal(tcpmutex);
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_ntoh  -  Convert TCP header fields from net to host byte order
+ *------------------------------------------------------------------------
+ */
+void 	tcp_ntoh(
+	  struct netpacket *pktptr
+	)
+{
+	pktptr->net_tcpsport = ntohs(pktptr->net_tcpsport);
+	pktptr->net_tcpdport = ntohs(pktptr->net_tcpdport);
+	pktptr->net_tcpseq = ntohl(pktptr->net_tcpseq);
+	pktptr->net_tcpack = ntohl(pktptr->net_tcpack);
+	pktptr->net_tcpcode = ntohs(pktptr->net_tcpcode);
+	pktptr->net_tcpwindow = ntohs(pktptr->net_tcpwindow);
+	pktptr->net_tcpurgptr = ntohs(pktptr->net_tcpurgptr);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_hton  -  Convert TCP header fields from host to net byte order
+ *------------------------------------------------------------------------
+ */
+void 	tcp_hton(
+	  struct netpacket *pktptr
+	)
+{
+	pktptr->net_tcpsport = htons(pktptr->net_tcpsport);
+	pktptr->net_tcpdport = htons(pktptr->net_tcpdport);
+	pktptr->net_tcpseq = htonl(pktptr->net_tcpseq);
+	pktptr->net_tcpack = htonl(pktptr->net_tcpack);
+	pktptr->net_tcpcode = htons(pktptr->net_tcpcode);
+	pktptr->net_tcpwindow = htons(pktptr->net_tcpwindow);
+	pktptr->net_tcpurgptr = htons(pktptr->net_tcpurgptr);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_alloc  -  Allocate and initialize a free entry, with buffers;
+ *		   return NULL if there is none (tcpmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	struct	tcb *tcp_alloc(void)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	char	*bufs;			/* Send and receive buffers	*/
+	int32	slot;			/* Index into tcbtab		*/
+
+	for (slot = 0; slot < TCP_SLOTS; slot++) {
+		if (tcbtab[slot].tb_state == TCPS_FREE) {
+			break;
+		}
+	}
+	if (slot >= TCP_SLOTS) {
+		return NULL;
+	}
+	bufs = getmem(TCP_SBSIZ + TCP_RBSIZ);
+	if ((int32)bufs == SYSERR) {
+		return NULL;
+	}
+	tbptr = &tcbtab[slot];
+	memset((char *)tbptr, NULLCH, sizeof(struct tcb));
+	tbptr->tb_state = TCPS_CLOSED;
+	tbptr->tb_parent = -1;
+	tbptr->tb_error = OK;
+	tbptr->tb_rpid = -1;
+	tbptr->tb_spid = -1;
+	tbptr->tb_sbuf = bufs;
+	tbptr->tb_rbuf = bufs + TCP_SBSIZ;
+
+	tcpiss += 64000;
+	tbptr->tb_iss = tcpiss + clkms() * 250;
+	tbptr->tb_suna = tbptr->tb_snxt = tbptr->tb_smax = tbptr->tb_iss;
+	tbptr->tb_smss = TCP_DEFMSS;
+	tbptr->tb_cwnd = 2 * TCP_DEFMSS;
+	tbptr->tb_ssthresh = 65535;
+	tbptr->tb_rto = TCP_RTOINIT;
+	return tbptr;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_free  -  Return an entry and its buffers (tcpmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_free(
+	  struct tcb *tbptr		/* Entry to free		*/
+	)
+{
+	int32	i;			/* Index into tb_ooo		*/
+
+	for (i = 0; i < tbptr->tb_nooo; i++) {
+		pb_free(tbptr->tb_ooo[i]);
+	}
+	freemem(tbptr->tb_sbuf, TCP_SBSIZ + TCP_RBSIZ);
+	tbptr->tb_state = TCPS_FREE;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_term  -  End a connection: free the entry if nobody holds it,
+ *		  otherwise leave it closed for its user (tcpmutex must
+ *		  be held)
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_term(
+	  struct tcb *tbptr		/* Connection that has ended	*/
+	)
+{
+	tbptr->tb_rxtimer = tbptr->tb_acktimer = tbptr->tb_twtimer = 0;
+	if (tbptr->tb_user || tbptr->tb_queued) {
+		tbptr->tb_state = TCPS_CLOSED;
+		tcp_wake(tbptr);
+	} else {
+		tcp_free(tbptr);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * tcp_wake  -  Wake the processes waiting on an entry
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_wake(
+	  struct tcb *tbptr		/* Entry that has changed	*/
+	)
+{
+	if (tbptr->tb_rpid != -1) {
+		send(tbptr->tb_rpid, OK);
+	}
+	if (tbptr->tb_spid != -1) {
+		send(tbptr->tb_spid, OK);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * tcp_lookup  -  Find the connection with a given local port and
+ *		    remote address, or the listener for a local port
+ *		    (tcpmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	struct	tcb *tcp_lookup(
+	  uint16 locport,		/* Local TCP protocol port	*/
+	  uint32 remip,			/* Remote IP address		*/
+	  uint16 remport,		/* Remote TCP protocol port	*/
+	  bool8	listener		/* Find the listener instead	*/
+	)
+{
+	struct	tcb	*tbptr;		/* Pointer to a TCP table entry	*/
+	int32	slot;			/* Index into tcbtab		*/
+
+	for (slot = 0; slot < TCP_SLOTS; slot++) {
+		tbptr = &tcbtab[slot];
+		if ( (tbptr->tb_state == TCPS_FREE) ||
+		     (tbptr->tb_locport != locport) ) {
+			continue;
+		}
+		if (listener) {
+			if (tbptr->tb_state == TCPS_LISTEN) {
+				return tbptr;
+			}
+		} else if ( (tbptr->tb_state != TCPS_LISTEN) &&
+			    (tbptr->tb_remip == remip) &&
+			    (tbptr->tb_remport == remport) ) {
+			return tbptr;
+		}
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_synrcvd  -  Open a connection for a SYN that has arrived at a
+ *		     listener and answer it with SYN+ACK
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_synrcvd(
+	  struct tcb *lptr,		/* Listener			*/
+	  struct netpacket *pktptr	/* The SYN			*/
+	)
+{
+	struct	tcb	*tbptr;		/* The new connection		*/
+	int32	pending;		/* Connections not yet accepted	*/
+	int32	i;			/* Index into tcbtab		*/
+
+	/* Half-open and unaccepted connections count toward the	*/
+	/*   backlog							*/
+
+	pending = 0;
+	for (i = 0; i < TCP_SLOTS; i++) {
+		if ( (tcbtab[i].tb_state != TCPS_FREE) &&
+		     (tcbtab[i].tb_parent == lptr - tcbtab) ) {
+			pending++;
+		}
+	}
+	if ( (pending >= TCP_BACKLOG) || ((tbptr = tcp_alloc()) == NULL) ) {
+		pb_free(pktptr);
+		return;
+	}
+
+	tbptr->tb_remip = pktptr->net_ipsrc;
+	tbptr->tb_remport = pktptr->net_tcpsport;
+	tbptr->tb_locport = pktptr->net_tcpdport;
+	tbptr->tb_parent = lptr - tcbtab;
+	tbptr->tb_irs = pktptr->net_tcpseq;
+	tbptr->tb_rnxt = tbptr->tb_irs + 1;
+	tbptr->tb_swnd = pktptr->net_tcpwindow;
+	tbptr->tb_smss = tcp_mss(pktptr);
+	tbptr->tb_cwnd = 2 * tbptr->tb_smss;
+	tbptr->tb_state = TCPS_SYNRCVD;
+	pb_free(pktptr);
+
+	tbptr->tb_rttstart = clkms();
+	tcp_xmit(tbptr, tbptr->tb_iss, TCPF_SYN|TCPF_ACK, 0, 0);
+	tbptr->tb_snxt = tbptr->tb_smax = tbptr->tb_iss + 1;
+	tbptr->tb_rxtimer = tbptr->tb_rto;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_synsent  -  Handle a segment that arrives while our SYN awaits an
+ *		     answer
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_synsent(
+	  struct tcb *tbptr,		/* Connection being opened	*/
+	  struct netpacket *pktptr	/* Segment that arrived		*/
+	)
+{
+	uint16	flags;			/* TCP flags of the segment	*/
+
+	flags = pktptr->net_tcpcode & 0x3f;
+
+	/* An ACK must be for our SYN */
+
+	if ( (flags & TCPF_ACK) &&
+	     (pktptr->net_tcpack != tbptr->tb_iss + 1) ) {
+		if (flags & TCPF_RST) {
+			pb_free(pktptr);
+		} else {
+			tcp_reset(pktptr);
+		}
+		return;
+	}
+	if (flags & TCPF_RST) {
+		if (flags & TCPF_ACK) {		/* Connection refused	*/
+			tbptr->tb_error = SYSERR;
+			tcp_term(tbptr);
+		}
+		pb_free(pktptr);
+		return;
+	}
+	if (!(flags & TCPF_SYN)) {
+		pb_free(pktptr);
+		return;
+	}
+
+	tbptr->tb_irs = pktptr->net_tcpseq;
+	tbptr->tb_rnxt = tbptr->tb_irs + 1;
+	tbptr->tb_smss = tcp_mss(pktptr);
+	tbptr->tb_cwnd = 2 * tbptr->tb_smss;
+	tbptr->tb_swnd = pktptr->net_tcpwindow;
+
+	if (flags & TCPF_ACK) {
+		tbptr->tb_suna = tbptr->tb_iss + 1;
+		if (tbptr->tb_nretx == 0) {
+			tcp_rttupdate(tbptr, clkms() - tbptr->tb_rttstart);
+		}
+		tbptr->tb_rxtimer = 0;
+		tbptr->tb_nretx = 0;
+		tbptr->tb_state = TCPS_ESTABLISHED;
+		tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+		tcp_wake(tbptr);
+	} else {
+
+		/* Simultaneous open: answer with SYN+ACK */
+
+		tbptr->tb_state = TCPS_SYNRCVD;
+		tcp_xmit(tbptr, tbptr->tb_iss, TCPF_SYN|TCPF_ACK, 0, 0);
+	}
+	pb_free(pktptr);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_ack  -  Process the acknowledgement and window of a segment;
+ *		 return SYSERR if the segment was consumed
+ *------------------------------------------------------------------------
+ */
+local	status	tcp_ack(
+	  struct tcb *tbptr,		/* Connection			*/
+	  struct netpacket *pktptr,	/* Segment (data is the payload)*/
+	  int32	seglen			/* Sequence space it occupies	*/
+	)
+{
+	uint32	ack;			/* Acknowledgement number	*/
+	uint32	acked;			/* Sequence space acknowledged	*/
+	uint32	flight;			/* Data in flight		*/
+	struct	tcb	*lptr;		/* Listener of the connection	*/
+
+	ack = pktptr->net_tcpack;
+
+	/* The ACK of a SYN+ACK completes a passive open; the		*/
+	/*   connection waits on the listener's accept queue		*/
+
+	if (tbptr->tb_state == TCPS_SYNRCVD) {
+		if ( SEQ_LEQ(ack, tbptr->tb_suna) ||
+		     SEQ_GT(ack, tbptr->tb_snxt) ) {
+			tcp_reset(pktptr);
+			return SYSERR;
+		}
+		tbptr->tb_state = TCPS_ESTABLISHED;
+		tbptr->tb_suna++;
+		if (tbptr->tb_parent >= 0) {
+			lptr = &tcbtab[tbptr->tb_parent];
+			lptr->tb_acceptq[lptr->tb_nacc++] = tbptr - tcbtab;
+			tbptr->tb_queued = TRUE;
+			tcp_wake(lptr);
+		}
+		if (tbptr->tb_nretx == 0) {
+			tcp_rttupdate(tbptr, clkms() - tbptr->tb_rttstart);
+		}
+		tbptr->tb_nretx = 0;
+		tbptr->tb_rxtimer = 0;
+		tbptr->tb_swnd = pktptr->net_tcpwindow;
+		return OK;
+	}
+
+	/* Ignore an ACK of data we have not sent, but answer it */
+
+	if (SEQ_GT(ack, tbptr->tb_smax)) {
+		tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+		pb_free(pktptr);
+		return SYSERR;
+	}
+
+	flight = tbptr->tb_snxt - tbptr->tb_suna;
+
+	if (SEQ_LEQ(ack, tbptr->tb_suna)) {
+
+		/* A duplicate ACK: a bare ACK that does not move the	*/
+		/*   window while data are outstanding (RFC 5681)	*/
+
+		if ( (ack == tbptr->tb_suna) && (seglen == 0) &&
+		     (pktptr->net_tcpwindow == tbptr->tb_swnd) &&
+		     (tbptr->tb_swnd > 0) && (flight > 0) ) {
+			tbptr->tb_dupacks++;
+			if ( (tbptr->tb_dupacks == 3) &&
+			     !tbptr->tb_inrecovery ) {
+				tbptr->tb_ssthresh = flight / 2;
+				if (tbptr->tb_ssthresh < 2 * tbptr->tb_smss) {
+					tbptr->tb_ssthresh = 2 * tbptr->tb_smss;
+				}
+				tbptr->tb_recover = tbptr->tb_snxt;
+				tbptr->tb_inrecovery = TRUE;
+				tbptr->tb_rtting = FALSE;
+				tcp_rexmit(tbptr);
+				tbptr->tb_cwnd = tbptr->tb_ssthresh +
+							3 * tbptr->tb_smss;
+				tcpstats.ts_fastrexmit++;
+			} else if (tbptr->tb_inrecovery) {
+				tbptr->tb_cwnd += tbptr->tb_smss;
+			}
+		} else if (ack == tbptr->tb_suna) {
+			tbptr->tb_swnd = pktptr->net_tcpwindow;
+		}
+		return OK;
+	}
+
+	/* New data are acknowledged: drop them from the send buffer;	*/
+	/*   the FIN takes a sequence number but no buffer space	*/
+
+	acked = ack - tbptr->tb_suna;
+	if ( tbptr->tb_finq && (acked > tbptr->tb_sblen) ) {
+		tbptr->tb_finacked = tbptr->tb_finsent = TRUE;
+		acked = tbptr->tb_sblen;
+	}
+	tbptr->tb_sbstart = (tbptr->tb_sbstart + acked) & (TCP_SBSIZ-1);
+	tbptr->tb_sblen -= acked;
+	acked = ack - tbptr->tb_suna;
+	tbptr->tb_suna = ack;
+	if (SEQ_LT(tbptr->tb_snxt, ack)) {
+		tbptr->tb_snxt = ack;
+	}
+	tbptr->tb_swnd = pktptr->net_tcpwindow;
+	tbptr->tb_nretx = 0;
+
+	/* Time the round trip (Karn: only segments sent once) */
+
+	if ( tbptr->tb_rtting && SEQ_GT(ack, tbptr->tb_rttseq) ) {
+		tcp_rttupdate(tbptr, clkms() - tbptr->tb_rttstart);
+		tbptr->tb_rtting = FALSE;
+	}
+
+	/* Grow the congestion window, or leave fast recovery once	*/
+	/*   everything outstanding at its start is acknowledged; a	*/
+	/*   partial ACK means the next segment was lost too		*/
+
+	if (tbptr->tb_inrecovery) {
+		if (SEQ_GEQ(ack, tbptr->tb_recover)) {
+			tbptr->tb_inrecovery = FALSE;
+			tbptr->tb_dupacks = 0;
+			tbptr->tb_cwnd = tbptr->tb_ssthresh;
+		} else {
+			tcp_rexmit(tbptr);
+			tbptr->tb_cwnd -= (acked < tbptr->tb_cwnd) ?
+							acked : 0;
+			tbptr->tb_cwnd += tbptr->tb_smss;
+		}
+	} else {
+		tbptr->tb_dupacks = 0;
+		if (tbptr->tb_cwnd < tbptr->tb_ssthresh) {
+			tbptr->tb_cwnd += (acked < tbptr->tb_smss) ?
+						acked : tbptr->tb_smss;
+		} else {
+			tbptr->tb_cwnd += (tbptr->tb_smss * tbptr->tb_smss) /
+						tbptr->tb_cwnd + 1;
+		}
+	}
+	if (tbptr->tb_cwnd > 4 * TCP_SBSIZ) {
+		tbptr->tb_cwnd = 4 * TCP_SBSIZ;
+	}
+
+	tbptr->tb_rxtimer = (tbptr->tb_suna == tbptr->tb_snxt) ?
+						0 : tbptr->tb_rto;
+
+	/* The ACK of our FIN moves a closing connection on */
+
+	if (tbptr->tb_finacked) {
+		switch (tbptr->tb_state) {
+
+		    case TCPS_FINWAIT1:
+			tbptr->tb_state = TCPS_FINWAIT2;
+			if (!tbptr->tb_user) {
+				tbptr->tb_twtimer = TCP_FW2TIME;
+			}
+			break;
+
+		    case TCPS_CLOSING:
+			tbptr->tb_state = TCPS_TIMEWAIT;
+			tbptr->tb_twtimer = TCP_TWAIT;
+			break;
+
+		    case TCPS_LASTACK:
+			tcp_term(tbptr);
+			break;
+
+		    default:
+			break;
+		}
+	}
+	if (tbptr->tb_state != TCPS_FREE) {
+		tcp_wake(tbptr);
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_data  -  Take the data and FIN of a segment, and acknowledge
+ *		  them now or after a delay (the packet is consumed)
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_data(
+	  struct tcb *tbptr,		/* Connection			*/
+	  struct netpacket *pktptr,	/* Segment (data is the payload)*/
+	  uint16 flags			/* TCP flags of the segment	*/
+	)
+{
+	uint32	seq;			/* Seq. number of the data	*/
+	int32	len;			/* Length of the data		*/
+	int32	n;			/* Bytes taken			*/
+	int32	tail;			/* Index of the first free byte	*/
+	bool8	filled;			/* Held segments were taken	*/
+	bool8	now;			/* Acknowledge at once		*/
+
+	seq = pktptr->net_tcpseq;
+	len = pb_len(pktptr);
+
+	/* Only an open receive side takes data; a retransmitted FIN	*/
+	/*   is acknowledged again					*/
+
+	if ( (tbptr->tb_state != TCPS_ESTABLISHED) &&
+	     (tbptr->tb_state != TCPS_FINWAIT1) &&
+	     (tbptr->tb_state != TCPS_FINWAIT2) ) {
+		if ( (len > 0) || (flags & TCPF_FIN) ) {
+			tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+			if (tbptr->tb_state == TCPS_TIMEWAIT) {
+				tbptr->tb_twtimer = TCP_TWAIT;
+			}
+		}
+		pb_free(pktptr);
+		return;
+	}
+	if ( (len == 0) && !(flags & TCPF_FIN) ) {
+		pb_free(pktptr);
+		return;
+	}
+
+	/* Drop data that have already arrived */
+
+	if (SEQ_LT(seq, tbptr->tb_rnxt)) {
+		n = tbptr->tb_rnxt - seq;
+		if (n > len) {
+			n = len;
+		}
+		pb_pull(pktptr, n);
+		seq += n;
+		len -= n;
+	}
+
+	/* Hold a segment that leaves a gap, and send a duplicate ACK	*/
+	/*   so the sender can retransmit the missing data early	*/
+
+	if (seq != tbptr->tb_rnxt) {
+		if ( (tbptr->tb_nooo < TCP_OOOSIZ) && (len > 0) ) {
+			pktptr->net_tcpseq = seq;
+			pktptr->net_tcpcode = (pktptr->net_tcpcode & ~0x3f) |
+								flags;
+			tbptr->tb_ooo[tbptr->tb_nooo++] = pktptr;
+			tcpstats.ts_ooo++;
+		} else {
+			pb_free(pktptr);
+		}
+		tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+		return;
+	}
+
+	/* Take as much as fits; a user who has closed the connection	*/
+	/*   will not read, so the data are discarded			*/
+
+	n = tcp_rwnd(tbptr);
+	if (n > len) {
+		n = len;
+	}
+	if (!tbptr->tb_user && !tbptr->tb_queued) {
+		n = len;
+	} else if (n > 0) {
+		tail = (tbptr->tb_rbstart + tbptr->tb_rblen) & (TCP_RBSIZ-1);
+		if (tail + n <= TCP_RBSIZ) {
+			memcpy(tbptr->tb_rbuf + tail, pb_data(pktptr), n);
+		} else {
+			memcpy(tbptr->tb_rbuf + tail, pb_data(pktptr),
+							TCP_RBSIZ - tail);
+			memcpy(tbptr->tb_rbuf, pb_data(pktptr) + TCP_RBSIZ -
+					tail, n - (TCP_RBSIZ - tail));
+		}
+		tbptr->tb_rblen += n;
+	}
+	tbptr->tb_rnxt += n;
+	if (n < len) {
+		flags &= ~TCPF_FIN;		/* FIN was cut off	*/
+	}
+	pb_free(pktptr);
+
+	filled = tcp_ooo(tbptr, &flags);
+
+	/* The FIN closes the receive side */
+
+	now = filled;
+	if (flags & TCPF_FIN) {
+		tbptr->tb_rnxt++;
+		tbptr->tb_finrcvd = TRUE;
+		now = TRUE;
+		switch (tbptr->tb_state) {
+
+		    case TCPS_ESTABLISHED:
+			tbptr->tb_state = TCPS_CLOSEWAIT;
+			break;
+
+		    case TCPS_FINWAIT1:
+			tbptr->tb_state = TCPS_CLOSING;
+			break;
+
+		    case TCPS_FINWAIT2:
+			tbptr->tb_state = TCPS_TIMEWAIT;
+			tbptr->tb_twtimer = TCP_TWAIT;
+			break;
+		}
+	}
+
+	/* Acknowledge every second segment at once, others later */
+
+	if ( now || (++tbptr->tb_unacked >= 2) ) {
+		tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_ACK, 0, 0);
+	} else if (tbptr->tb_acktimer == 0) {
+		tbptr->tb_acktimer = TCP_DELACK;
+	}
+	tcp_wake(tbptr);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_ooo  -  Take held segments that the receive point has reached;
+ *		 return TRUE if any were taken (the FIN of the last one is
+ *		 added to *flags)
+ *------------------------------------------------------------------------
+ */
+local	bool8	tcp_ooo(
+	  struct tcb *tbptr,		/* Connection			*/
+	  uint16 *flags			/* Flags of the data so far	*/
+	)
+{
+	struct	netpacket *pktptr;	/* A held segment		*/
+	bool8	taken;			/* Some segment was taken	*/
+	bool8	progress;		/* Took one in this pass	*/
+	int32	i;			/* Index into tb_ooo		*/
+	int32	skip;			/* Bytes already received	*/
+	int32	n;			/* Bytes to take		*/
+	int32	tail;			/* Index of the first free byte	*/
+
+	taken = FALSE;
+	do {
+		progress = FALSE;
+		for (i = 0; i < tbptr->tb_nooo; i++) {
+			pktptr = tbptr->tb_ooo[i];
+			if (SEQ_GT(pktptr->net_tcpseq, tbptr->tb_rnxt)) {
+				continue;
+			}
+
+			/* Remove it from the list, then take what is new */
+
+			tbptr->tb_ooo[i] = tbptr->tb_ooo[--tbptr->tb_nooo];
+			progress = taken = TRUE;
+			skip = tbptr->tb_rnxt - pktptr->net_tcpseq;
+			if ( (skip > pb_len(pktptr)) ||
+			     (*flags & TCPF_FIN) ) {
+				pb_free(pktptr);
+				break;
+			}
+			n = pb_len(pktptr) - skip;
+			if (n > tcp_rwnd(tbptr)) {
+				n = tcp_rwnd(tbptr);
+			}
+			tail = (tbptr->tb_rbstart + tbptr->tb_rblen) &
+							(TCP_RBSIZ-1);
+			if (tail + n <= TCP_RBSIZ) {
+				memcpy(tbptr->tb_rbuf + tail,
+					pb_data(pktptr) + skip, n);
+			} else {
+				memcpy(tbptr->tb_rbuf + tail,
+					pb_data(pktptr) + skip,
+					TCP_RBSIZ - tail);
+				memcpy(tbptr->tb_rbuf, pb_data(pktptr) + skip +
+					TCP_RBSIZ - tail,
+					n - (TCP_RBSIZ - tail));
+			}
+			tbptr->tb_rblen += n;
+			tbptr->tb_rnxt += n;
+			if ( (n == pb_len(pktptr) - skip) &&
+			     (pktptr->net_tcpcode & TCPF_FIN) ) {
+				*flags |= TCPF_FIN;
+			}
+			pb_free(pktptr);
+			break;
+		}
+	} while (progress);
+	return taken;
+}
+
+/*------------------------------------------------------------------------
+ * tcp_output  -  Send the data (and FIN) that the send and congestion
+ *		    windows allow
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_output(
+	  struct tcb *tbptr		/* Connection			*/
+	)
+{
+	int32	off;			/* Offset of snxt in the buffer	*/
+	int32	len;			/* Data in the next segment	*/
+	int32	usable;			/* Window not yet used		*/
+	uint32	wnd;			/* Smaller of the two windows	*/
+	uint16	flags;			/* Flags of the segment		*/
+	bool8	fin;			/* Segment carries the FIN	*/
+
+	if ( (tbptr->tb_state != TCPS_ESTABLISHED) &&
+	     (tbptr->tb_state != TCPS_CLOSEWAIT) &&
+	     (tbptr->tb_state != TCPS_FINWAIT1) &&
+	     (tbptr->tb_state != TCPS_CLOSING) &&
+	     (tbptr->tb_state != TCPS_LASTACK) ) {
+		return;
+	}
+
+	while (!tbptr->tb_finsent) {
+		off = tbptr->tb_snxt - tbptr->tb_suna;
+		wnd = (tbptr->tb_swnd < tbptr->tb_cwnd) ?
+					tbptr->tb_swnd : tbptr->tb_cwnd;
+		usable = (int32)(tbptr->tb_suna + wnd - tbptr->tb_snxt);
+		len = tbptr->tb_sblen - off;
+		if (len > (int32)tbptr->tb_smss) {
+			len = tbptr->tb_smss;
+		}
+		if (len > usable) {
+			len = (usable > 0) ? usable : 0;
+		}
+		fin = tbptr->tb_finq && (off + len == tbptr->tb_sblen);
+		if ( (len == 0) && !fin ) {
+			break;
+		}
+
+		flags = TCPF_ACK;
+		if ( (len > 0) && (off + len == tbptr->tb_sblen) ) {
+			flags |= TCPF_PSH;
+		}
+		if (fin) {
+			flags |= TCPF_FIN;
+		}
+
+		/* Time one segment of new data per round trip */
+
+		if ( !tbptr->tb_rtting &&
+		     SEQ_GEQ(tbptr->tb_snxt, tbptr->tb_smax) ) {
+			tbptr->tb_rtting = TRUE;
+			tbptr->tb_rttseq = tbptr->tb_snxt;
+			tbptr->tb_rttstart = clkms();
+		}
+
+		tcp_xmit(tbptr, tbptr->tb_snxt, flags, off, len);
+		tbptr->tb_snxt += len;
+		if (fin) {
+			tbptr->tb_finsent = TRUE;
+			tbptr->tb_finseq = tbptr->tb_snxt++;
+		}
+		if (SEQ_GT(tbptr->tb_snxt, tbptr->tb_smax)) {
+			tbptr->tb_smax = tbptr->tb_snxt;
+		}
+		if (tbptr->tb_rxtimer == 0) {
+			tbptr->tb_rxtimer = tbptr->tb_rto;
+		}
+	}
+
+	/* Probe a closed window when the timer runs out */
+
+	if ( (tbptr->tb_swnd == 0) && (tbptr->tb_rxtimer == 0) &&
+	     (tbptr->tb_sblen > (int32)(tbptr->tb_snxt - tbptr->tb_suna)) ) {
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * tcp_rexmit  -  Retransmit the oldest unacknowledged segment
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_rexmit(
+	  struct tcb *tbptr		/* Connection			*/
+	)
+{
+	int32	len;			/* Data in the segment		*/
+	uint16	flags;			/* Flags of the segment		*/
+
+	len = tbptr->tb_sblen;
+	if (len > (int32)tbptr->tb_smss) {
+		len = tbptr->tb_smss;
+	}
+	flags = TCPF_ACK;
+	if ( tbptr->tb_finq && !tbptr->tb_finacked &&
+	     (len == tbptr->tb_sblen) &&
+	     SEQ_GT(tbptr->tb_smax, tbptr->tb_suna + len) ) {
+		flags |= TCPF_FIN;
+	}
+	if ( (len > 0) || (flags & TCPF_FIN) ) {
+		tcp_xmit(tbptr, tbptr->tb_suna, flags, 0, len);
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * tcp_timeout  -  Handle the expiry of the retransmission timer:
+ *		     retransmit (go back to the oldest unacknowledged
+ *		     byte and restart slow start), probe a closed window,
+ *		     or give up on the connection
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_timeout(
+	  struct tcb *tbptr		/* Connection			*/
+	)
+{
+	uint32	flight;			/* Data in flight		*/
+
+	/* A window probe: send one byte past the closed window; it	*/
+	/*   is never given up on					*/
+
+	if ( tcp_sync(tbptr) && (tbptr->tb_swnd == 0) &&
+	     (tbptr->tb_sblen > 0) && !tbptr->tb_finsent ) {
+		tbptr->tb_rto = (tbptr->tb_rto * 2 < TCP_RTOMAX) ?
+					tbptr->tb_rto * 2 : TCP_RTOMAX;
+		tcp_xmit(tbptr, tbptr->tb_suna, TCPF_ACK, 0, 1);
+		if (tbptr->tb_snxt == tbptr->tb_suna) {
+			tbptr->tb_snxt++;
+			if (SEQ_GT(tbptr->tb_snxt, tbptr->tb_smax)) {
+				tbptr->tb_smax = tbptr->tb_snxt;
+			}
+		}
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+		return;
+	}
+
+	if (++tbptr->tb_nretx > TCP_MAXRETX) {
+		tcpstats.ts_drops++;
+		tbptr->tb_error = SYSERR;
+		if (tbptr->tb_state != TCPS_SYNRCVD) {
+			tcp_xmit(tbptr, tbptr->tb_snxt, TCPF_RST|TCPF_ACK,
+								0, 0);
+		}
+		tcp_term(tbptr);
+		return;
+	}
+	tcpstats.ts_rexmit++;
+	tbptr->tb_rto = (tbptr->tb_rto * 2 < TCP_RTOMAX) ?
+				tbptr->tb_rto * 2 : TCP_RTOMAX;
+	tbptr->tb_rtting = FALSE;
+
+	if (tbptr->tb_state == TCPS_SYNSENT) {
+		tcp_xmit(tbptr, tbptr->tb_iss, TCPF_SYN, 0, 0);
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+		return;
+	}
+	if (tbptr->tb_state == TCPS_SYNRCVD) {
+		tcp_xmit(tbptr, tbptr->tb_iss, TCPF_SYN|TCPF_ACK, 0, 0);
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+		return;
+	}
+
+	/* Collapse the congestion window and resend from suna */
+
+	flight = tbptr->tb_snxt - tbptr->tb_suna;
+	tbptr->tb_ssthresh = flight / 2;
+	if (tbptr->tb_ssthresh < 2 * tbptr->tb_smss) {
+		tbptr->tb_ssthresh = 2 * tbptr->tb_smss;
+	}
+	tbptr->tb_cwnd = tbptr->tb_smss;
+	tbptr->tb_inrecovery = FALSE;
+	tbptr->tb_dupacks = 0;
+	tbptr->tb_snxt = tbptr->tb_suna;
+	if (!tbptr->tb_finacked) {
+		tbptr->tb_finsent = FALSE;
+	}
+	tcp_output(tbptr);
+	if (tbptr->tb_rxtimer == 0) {
+		tbptr->tb_rxtimer = tbptr->tb_rto;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * tcp_xmit  -  Build a segment of a connection and queue it for ipout;
+ *		  the data are len bytes at offset off of the send buffer
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_xmit(
+	  struct tcb *tbptr,		/* Connection			*/
+	  uint32 seq,			/* Sequence number		*/
+	  uint16 flags,			/* TCP flags			*/
+	  int32	off,			/* Offset of the data		*/
+	  int32	len			/* Length of the data		*/
+	)
+{
+	struct	netpacket *pkt;		/* Pointer to a packet buffer	*/
+	char	*dptr;			/* Where the data go		*/
+	int32	hlen;			/* Length of the TCP header	*/
+	int32	start;			/* Index of the data in sbuf	*/
+	uint32	wnd;			/* Window we advertise		*/
+
+	pkt = pb_alloc();
+	if ((int32)pkt == SYSERR) {
+		return;
+	}
+
+	/* A SYN carries the MSS option */
+
+	hlen = TCP_HDR_LEN + ((flags & TCPF_SYN) ? 4 : 0);
+	pb_reserve(pkt, (char *)&pkt->net_tcpsport + hlen - (char *)pkt);
+	if (len > 0) {
+		dptr = pb_put(pkt, len);
+		start = (tbptr->tb_sbstart + off) & (TCP_SBSIZ-1);
+		if (start + len <= TCP_SBSIZ) {
+			memcpy(dptr, tbptr->tb_sbuf + start, len);
+		} else {
+			memcpy(dptr, tbptr->tb_sbuf + start, TCP_SBSIZ - start);
+			memcpy(dptr + TCP_SBSIZ - start, tbptr->tb_sbuf,
+						len - (TCP_SBSIZ - start));
+		}
+	}
+
+	pb_push(pkt, hlen);
+	wnd = tcp_rwnd(tbptr);
+	pkt->net_tcpsport = tbptr->tb_locport;
+	pkt->net_tcpdport = tbptr->tb_remport;
+	pkt->net_tcpseq = seq;
+	pkt->net_tcpack = (flags & TCPF_ACK) ? tbptr->tb_rnxt : 0;
+	pkt->net_tcpcode = ((hlen / 4) << 12) | flags;
+	pkt->net_tcpwindow = (flags & TCPF_RST) ? 0 : wnd;
+	pkt->net_tcpcksum = 0x0000;	/* Filled in by ip_outprep	*/
+	pkt->net_tcpurgptr = 0;
+	if (flags & TCPF_SYN) {
+		pkt->net_tcpdata[0] = 2;	/* Maximum segment size	*/
+		pkt->net_tcpdata[1] = 4;
+		pkt->net_tcpdata[2] = TCP_MSS >> 8;
+		pkt->net_tcpdata[3] = TCP_MSS & 0xff;
+	}
+	if (ip_push(pkt, IP_TCP, tbptr->tb_remip) == SYSERR) {
+		pb_free(pkt);
+		return;
+	}
+	tcpstats.ts_segsout++;
+
+	/* An ACK that goes out covers everything received so far */
+
+	if (flags & TCPF_ACK) {
+		tbptr->tb_radv = tbptr->tb_rnxt + wnd;
+		tbptr->tb_acktimer = 0;
+		tbptr->tb_unacked = 0;
+	}
+	ip_enqueue(pkt);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_reset  -  Answer a segment with a reset, reusing its buffer (the
+ *		   header may already have been pulled off the data)
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_reset(
+	  struct netpacket *pktptr	/* Segment to answer		*/
+	)
+{
+	uint16	port;			/* Port being swapped		*/
+	uint16	flags;			/* Flags of the segment		*/
+	uint32	seglen;			/* Sequence space it occupies	*/
+
+	flags = pktptr->net_tcpcode & 0x3f;
+	seglen = (pb_data(pktptr) + pb_len(pktptr)) -
+			((char *)&pktptr->net_tcpsport +
+			 (pktptr->net_tcpcode >> 12) * 4) +
+			((flags & TCPF_SYN) ? 1 : 0) +
+			((flags & TCPF_FIN) ? 1 : 0);
+
+	port = pktptr->net_tcpsport;
+	pktptr->net_tcpsport = pktptr->net_tcpdport;
+	pktptr->net_tcpdport = port;
+	if (flags & TCPF_ACK) {
+		pktptr->net_tcpseq = pktptr->net_tcpack;
+		pktptr->net_tcpack = 0;
+		pktptr->net_tcpcode = (5 << 12) | TCPF_RST;
+	} else {
+		pktptr->net_tcpack = pktptr->net_tcpseq + seglen;
+		pktptr->net_tcpseq = 0;
+		pktptr->net_tcpcode = (5 << 12) | TCPF_RST | TCPF_ACK;
+	}
+	pktptr->net_tcpwindow = 0;
+	pktptr->net_tcpcksum = 0x0000;
+	pktptr->net_tcpurgptr = 0;
+	pb_data(pktptr) = (char *)&pktptr->net_tcpsport;
+	pb_len(pktptr) = TCP_HDR_LEN;
+	if (ip_push(pktptr, IP_TCP, pktptr->net_ipsrc) == SYSERR) {
+		pb_free(pktptr);
+		return;
+	}
+	tcpstats.ts_resets++;
+	ip_enqueue(pktptr);
+}
+
+/*------------------------------------------------------------------------
+ * tcp_rttupdate  -  Update the RTT estimate and the RTO with a new
+ *		       measurement (RFC 6298)
+ *------------------------------------------------------------------------
+ */
+local	void	tcp_rttupdate(
+	  struct tcb *tbptr,		/* Connection			*/
+	  int32	rtt			/* Measured round trip (ms)	*/
+	)
+{
+	int32	delta;			/* Error of the smoothed RTT	*/
+
+	if (rtt <= 0) {
+		rtt = 1;
+	}
+	if (tbptr->tb_srtt == 0) {
+		tbptr->tb_srtt = rtt;
+		tbptr->tb_rttvar = rtt / 2;
+	} else {
+		delta = tbptr->tb_srtt - rtt;
+		if (delta < 0) {
+			delta = -delta;
+		}
+		tbptr->tb_rttvar = (3 * tbptr->tb_rttvar + delta) / 4;
+		tbptr->tb_srtt = (7 * tbptr->tb_srtt + rtt) / 8;
+	}
+	tbptr->tb_rto = tbptr->tb_srtt +
+		((4 * tbptr->tb_rttvar > TCP_TICK) ?
+					4 * tbptr->tb_rttvar : TCP_TICK);
+	if (tbptr->tb_rto < TCP_RTOMIN) {
+		tbptr->tb_rto = TCP_RTOMIN;
+	} else if (tbptr->tb_rto > TCP_RTOMAX) {
+		tbptr->tb_rto = TCP_RTOMAX;
+	}
+}
+
+
+/*------------------------------------------------------------------------
+ * tcp_mss  -  Find the MSS option of a SYN; return the MSS to use when
+ *		 sending to its sender
+ *------------------------------------------------------------------------
+ */
+local	uint16	tcp_mss(
+	  struct netpacket *pktptr	/* SYN (header in host order)	*/
+	)
+{
+	byte	*opt;			/* Walks the options		*/
+	byte	*end;			/* End of the options		*/
+	uint16	mss;			/* MSS to use			*/
+
+	mss = TCP_DEFMSS;
+	opt = pktptr->net_tcpdata;
+	end = (byte *)&pktptr->net_tcpsport +
+				(pktptr->net_tcpcode >> 12) * 4;
+	while (opt < end) {
+		if (opt[0] == 0) {		/* End of options	*/
+			break;
+		}
+		if (opt[0] == 1) {		/* No-op		*/
+			opt++;
+			continue;
+		}
+		if ( (opt + 1 >= end) || (opt[1] < 2) ) {
+			break;
+		}
+		if ( (opt[0] == 2) && (opt[1] == 4) && (opt + 4 <= end) ) {
+			mss = (opt[2] << 8) | opt[3];
+		}
+		opt += opt[1];
+	}
+	if (mss > TCP_MSS) {
+		mss = TCP_MSS;
+	} else if (mss < 64) {
+		mss = 64;
+	}
+	return mss;
+}
@@ -4,90 +4,157 @@
 #include <stdlib.h>
 #include <string.h>
 
+local	int32	tftp_bldrrq(struct tftp_msg *, const char *, int32, int32,
+								int32);
+local	status	tftp_ack(int32, uint32, uint16, uint16);
+local	status	tftp_oack(char *, int32, int32 *, int32 *);
+
 /*------------------------------------------------------------------------
  *
- * tftp_send1  -  Internal function to send one outgoing request (RRQ or
- *		  ACK) message during a read sequence and get a matching
- *		  response (ignoring duplicates and nonsense packets)
+ * tftp_bldrrq  -  Internal function to form a Read Request, asking for
+ *		   the blksize and windowsize options if they are nonzero;
+ *		   return the length of the message
  *
  *------------------------------------------------------------------------
  */
-
-status	tftp_send1 (
-	 int32	sock,			/* UDP socket to use		*/
-	 uint32	remip,			/* Remote IP address		*/
-	 uint16	*remport,		/* Remote port to use/set	*/
-	 struct tftp_msg *msg,		/* Pointer to outgoing message	*/
-	 int32	mlen,			/* Size of ougoing message	*/
-	 struct tftp_msg *inmsg,	/* Pointer to buffer for an	*/
-					/*   incoming message		*/
-	 uint16	expected		/* Block number expected next	*/
+local	int32	tftp_bldrrq (
+	 struct tftp_msg *msg,		/* Message to fill in		*/
+	 const	char *filename,		/* Name of the file		*/
+	 int32	nlen,			/* Length of the name		*/
+	 int32	blksize,		/* Block size, or 0		*/
+	 int32	windowsize		/* Window size, or 0		*/
 	)
 {
-	int32	ret;			/* Return value	for udp_send	*/
-	int32	n;			/* Number of bytes in response	*/
-	uint32	tmp;			/* Holds IP address on receive	*/
+	char	*p;			/* Next byte of the message	*/
 
 	/*                 TFTP RRQ/WRQ Packet                  */
 	/*   2 bytes     string    1 byte     string   1 byte   */
 	/*   ------------------------------------------------   */
 	/*  | Opcode |  Filename  |   0  |    Mode    |   0  |  */
 	/*   ------------------------------------------------   */
-	
-	/*     TFTP ACK Packet       */
-	/*   2 bytes     2 bytes     */
-	/*   ---------------------   */
-	/*  | Opcode |   Block #  |  */
-	/*   ---------------------   */
 
-	/* Send the outgoing message */
-	
-	ret = udp_sendto(sock, remip, *remport, (char *) msg, mlen);
+	/* Options follow the mode as more pairs of strings (RFC 2347)	*/
 
-	if (ret == SYSERR) {
-		return SYSERR;
+	memset((char*)msg, NULLCH, sizeof(struct tftp_msg));
+	msg->tf_opcode = htons(TFTP_RRQ);
+	p = msg->tf_filemode;
+	strncpy(p, filename, nlen+1);
+	p += nlen + 1;
+
+	/* Set mode to 'octet' */
+	strncpy(p, "octet", sizeof("octet"));
+	p += sizeof("octet");
+
+	if (blksize != 0) {
+		strncpy(p, "blksize", sizeof("blksize"));
+		p += sizeof("blksize");
+		p += sprintf(p, "%d", blksize) + 1;
+	}
+	if (windowsize != 0) {
+		strncpy(p, "windowsize", sizeof("windowsize"));
+		p += sizeof("windowsize");
+		p += sprintf(p, "%d", windowsize) + 1;
 	}
+	return p - (char *)msg;
+}
 
-	/* Repeatedly read incoming messages, discarding packets that	*/
-	/*	are not valid or do not match the expected block number	*/
-	/*	(i.e., duplicates of previous packets)			*/
+/*------------------------------------------------------------------------
+ *
+ * tftp_ack  -  Internal function to send an ACK for a block
+ *
+ *------------------------------------------------------------------------
+ */
+local	status	tftp_ack (
+	 int32	sock,			/* UDP socket to use		*/
+	 uint32	remip,			/* Remote IP address		*/
+	 uint16	remport,		/* Remote port			*/
+	 uint16	blk			/* Block number to acknowledge	*/
+	)
+{
+	struct	tftp_msg msg;		/* Outgoing message		*/
 
-	while(1) {
+	/*     TFTP ACK Packet       */
+	/*   2 bytes     2 bytes     */
+	/*   ---------------------   */
+	/*  | Opcode |   Block #  |  */
+	/*   ---------------------   */
 
-		/* Read next incoming message */
+	msg.tf_opcode = htons(TFTP_ACK);
+	msg.tf_ablk = htons(blk);
+	return udp_sendto(sock, remip, remport, (char *) &msg,
+			sizeof(msg.tf_opcode) + sizeof(msg.tf_ablk));
+}
 
-		n = udp_recvaddr(sock, &tmp, remport, (char *)inmsg,
-				sizeof(struct tftp_msg), TFTP_WAIT);
-		if (n == SYSERR) {
-			return SYSERR;
-		} else if (n == TIMEOUT) {
-			kprintf("\n[tftp_send1] UDP Receive Timeout\n");
-			return TIMEOUT;
+/*------------------------------------------------------------------------
+ *
+ * tftp_oack  -  Internal function to read the options a server accepted
+ *		 in an OACK and set the block and window sizes to the
+ *		 values it chose (an option it left out is not in
+ *		 effect); return SYSERR if the OACK is not valid
+ *
+ *------------------------------------------------------------------------
+ */
+local	status	tftp_oack (
+	 char	*opts,			/* Options after the opcode	*/
+	 int32	len,			/* Length of the options	*/
+	 int32	*blksize,		/* Block size requested / used	*/
+	 int32	*windowsize		/* Window size requested / used	*/
+	)
+{
+	char	name[16];		/* Option name in lower case	*/
+	char	*end;			/* End of the options		*/
+	char	*val;			/* Value of an option		*/
+	int32	i;			/* Index into name		*/
+	int32	v;			/* Numeric value		*/
+	int32	maxblk;			/* Block size requested		*/
+	int32	maxwin;			/* Window size requested	*/
+
+	maxblk = *blksize;
+	maxwin = *windowsize;
+	*blksize = TFTP_MAXDATA;
+	*windowsize = 1;
+	end = opts + len;
+	while (opts < end) {
+
+		/* Pick up the name in lower case, then the value */
+
+		for (i = 0; (opts < end) && (*opts != NULLCH); i++) {
+			if (i < sizeof(name) - 1) {
+				name[i] = *opts;
+				if ( (name[i] >= 'A') && (name[i] <= 'Z') ) {
+					name[i] += 'a' - 'A';
+				}
+			}
+			opts++;
 		}
-
-		if (n < 4) {	/* too small to be a valid packet */
-			continue;
+		name[(i < sizeof(name)) ? i : sizeof(name) - 1] = NULLCH;
+		val = ++opts;
+		while ( (opts < end) && (*opts != NULLCH) ) {
+			opts++;
 		}
-
-		/* If Error came back, give up */
-		
-		if (ntohs(inmsg->tf_opcode) == TFTP_ERROR) {
-			kprintf("\n[tftp_send1] TFTP Error %d, %s\n",
-					ntohs(inmsg->tf_ercode),
-					inmsg->tf_ermsg );
+		if (opts >= end) {
 			return SYSERR;
 		}
+		opts++;
+		v = atoi(val);
 
-		/* If data packet matches expected block, return */
+		/* A server may lower a value but not raise it */
 
-		if ( (ntohs(inmsg->tf_opcode) == TFTP_DATA) &&
-				(ntohs(inmsg->tf_dblk) == expected)) {
-			return n;
+		if (strncmp(name, "blksize", 8) == 0) {
+			if ( (v < TFTP_MINBLKSIZE) || (v > maxblk) ) {
+				return SYSERR;
+			}
+			*blksize = v;
+		} else if (strncmp(name, "windowsize", 11) == 0) {
+			if ( (v < 1) || (v > maxwin) ) {
+				return SYSERR;
+			}
+			*windowsize = v;
+		} else {
+			return SYSERR;
 		}
-
-		/* As this point, incoming message is either invalid or	*/
-		/*	a duplicate, so ignore and try again		*/
 	}
+	return OK;
 }
 
 
@@ -123,6 +190,30 @@ status  tftpget_mb(
 	uint32	rcv_buf_count,		/* Number of buffers		*/
 	byte	verbose			/* Verbosity level		*/
 	)
+{
+	return tftpget_opt(serverip, filename, rcv_bufs, rcv_buf_sizes,
+			rcv_buf_count, TFTP_BLKSIZE, TFTP_WINDOW, verbose);
+}
+
+/*------------------------------------------------------------------------
+ *
+ * tftpget_opt  -  multibuffer TFTP with a chosen block and window size;
+ *		   the sizes are requested as options (RFC 2347, 2348 and
+ *		   7440) and the transfer falls back to 512-byte blocks
+ *		   sent one at a time if the server does not accept them
+ *
+ *------------------------------------------------------------------------
+ */
+status  tftpget_opt(
+	uint32	serverip,		/* IP address of server		*/
+	const	char* filename,		/* Name of the file to download	*/
+	char**	rcv_bufs,		/* Buffer to hold the file	*/
+	uint32*	rcv_buf_sizes,		/* Size of each buffer		*/
+	uint32	rcv_buf_count,		/* Number of buffers		*/
+	int32	blksize,		/* Block size to ask for	*/
+	int32	windowsize,		/* Blocks per ACK to ask for	*/
+	byte	verbose			/* Verbosity level		*/
+	)
 {
 	int32	nlen;			/* Length of file name		*/
 	uint16	localport;		/* Local UDP port to use	*/
@@ -135,14 +226,25 @@ status  tftpget_mb(
 	int32	filesiz;		/* Total size of downloaded file*/
 	struct	tftp_msg outmsg;	/* Outgoing message		*/
 	int32	mlen;			/* Length of outgoing mesage	*/
-	struct	tftp_msg inmsg;		/* Buffer for response message	*/
+	struct	netpacket *pkt;		/* Incoming packet		*/
+	char	*data;			/* TFTP message in the packet	*/
+	uint16	opcode;			/* Opcode of the message	*/
+	uint16	blk;			/* Block number of the message	*/
 	int32	dlen;			/* Size of data in a response	*/
+	int32	bsize;			/* Block size in use		*/
+	int32	wsize;			/* Window size in use		*/
+	int32	inwin;			/* Blocks since the last ACK	*/
+	int32	retries;		/* Timeouts in a row		*/
+	bool8	useopts;		/* RRQ carries options		*/
+	bool8	started;		/* Server has answered		*/
+	bool8	gapacked;		/* Sent an ACK for a lost block	*/
 	char*   curr_buf;		/* Current buffer being used	*/
 	uint32  curr_buf_ind;		/* Index of current buffer	*/
 	uint32  curr_used;		/* Amount used in buffer	*/
+	int32	k;			/* Bytes to copy at once	*/
 
 	/* Check args */
-	
+
 	if(filename == NULL || serverip == 0 || rcv_bufs == NULL ||
 		rcv_buf_sizes == NULL || rcv_buf_count == 0) {
 		kprintf("[TFTP GET] ERROR: Invalid argument\n");
@@ -154,12 +256,22 @@ status  tftpget_mb(
 			return SYSERR;
 		}
 	}
+	if (blksize < TFTP_MINBLKSIZE) {
+		blksize = TFTP_MINBLKSIZE;
+	} else if (blksize > TFTP_MAXBLKSIZE) {
+		blksize = TFTP_MAXBLKSIZE;
+	}
+	if (windowsize < 1) {
+		windowsize = 1;
+	} else if (windowsize > TFTP_MAXWINDOW) {
+		windowsize = TFTP_MAXWINDOW;
+	}
 
 	nlen = strnlen(filename, TFTP_MAXNAM+1);
 	if ( (nlen <= 0) || (nlen > TFTP_MAXNAM) ) {
 		return SYSERR;
 	}
-	
+
 	if(verbose & TFTP_VERBOSE) {
 		kprintf("[TFTP Get] Server: %08X File: %s\n",
 						 serverip, filename);
@@ -173,7 +285,7 @@ status  tftpget_mb(
 		kprintf("[TFTP Get] Using local port %u\n",
 						0xffff & localport);
 	}
-		
+
 	/* Register a UDP socket */
 
 	sock = udp_register(serverip, 0, localport);
@@ -182,10 +294,6 @@ status  tftpget_mb(
 		return SYSERR;
 	}
 
-	/* Clear the message buffer */
-
-	memset((char*)&outmsg, NULLCH, sizeof(outmsg));
-
 	/* Initialize the total file size to zero */
 
 	filesiz = 0;
@@ -193,57 +301,167 @@ status  tftpget_mb(
 	curr_buf = (char*)rcv_bufs[curr_buf_ind];
 	curr_used = 0;
 
-	/* Form the first message and compute length (a Read Request)	*/
-
-	outmsg.tf_opcode = htons(TFTP_RRQ);
-	strncpy(outmsg.tf_filemode, filename, nlen+1);
-	/* Set mode to 'octet' */
-	strncpy(outmsg.tf_filemode+nlen+1, "octet", sizeof("octet")+1);
-
-	/* Length is 2 opcode octets, name length, "octet" length,	*/
-	/*		and two NULLs					*/
-
-	mlen = nlen + strnlen("octet", 6) + 4;
+	/* Form the first message (a Read Request); options are sent	*/
+	/*   only when they differ from the RFC 1350 behavior, and the	*/
+	/*   transfer uses that behavior until an OACK says otherwise	*/
+
+	useopts = (blksize != TFTP_MAXDATA) || (windowsize != 1);
+	mlen = tftp_bldrrq(&outmsg, filename, nlen,
+				useopts ? blksize : 0,
+				(useopts && windowsize != 1) ? windowsize : 0);
+	bsize = TFTP_MAXDATA;
+	wsize = 1;
+	started = FALSE;
+	gapacked = FALSE;
+	inwin = 0;
+	retries = 0;
+
+	if (udp_sendto(sock, serverip, remport, (char *) &outmsg, mlen)
+							== SYSERR) {
+		kprintf("\n[TFTP Get] ERROR: TFTP Send fails\n");
+		udp_release(sock);
+		return SYSERR;
+	}
 
-	/* Repeatedly send the next request and get a response,		*/
-	/*	retransmitting a request up to TFTP_MAXRETRIES times	*/
+	/* Take blocks in order straight from the network buffers into	*/
+	/*	the caller's buffers, acknowledging the last block of	*/
+	/*	each window; a timeout resends the request or the last	*/
+	/*	ACK up to TFTP_MAXRETRIES times				*/
 
 	while(1) {
-	    for (i=0; i < TFTP_MAXRETRIES; i++) {
-		n = tftp_send1(sock, serverip, &remport, &outmsg, mlen,
-							&inmsg, expected);
-		if (n > 0) {
-			break;
-		} else if (n == SYSERR) {
-			kprintf("\n[TFTP Get] ERROR: TFTP Send fails\n");
+	    ret = udp_recvbuf(sock, &pkt, &data, &n, TFTP_WAIT);
+	    if (ret == SYSERR) {
+		kprintf("\n[TFTP Get] ERROR: TFTP Receive fails\n");
+		udp_release(sock);
+		return SYSERR;
+	    } else if (ret == TIMEOUT) {
+		if (++retries > TFTP_MAXRETRIES) {
+			kprintf("\n[TFTP Get] ERROR: Max retries %d exceeded\n",
+							TFTP_MAXRETRIES);
 			udp_release(sock);
 			return SYSERR;
-		} else if (n == TIMEOUT) {
-			continue;
-
 		}
+		if (started) {
+			tftp_ack(sock, serverip, remport, expected - 1);
+		} else {
+			udp_sendto(sock, serverip, remport,
+					(char *) &outmsg, mlen);
+		}
+		inwin = 0;
+		continue;
 	    }
-	    if (i >= TFTP_MAXRETRIES) {
-		kprintf("\n[TFTP Get] ERROR: Max retries %d exceeded\n",
-							TFTP_MAXRETRIES);
+
+	    /* Once the server has answered, only its port may send	*/
+
+	    if ( (n < 4) ||
+		 (started && (pkt->net_udpsport != remport)) ) {
+		udp_releasebuf(pkt);
+		continue;
+	    }
+	    memcpy((char *)&opcode, data, 2);
+	    opcode = ntohs(opcode);
+	    memcpy((char *)&blk, data + 2, 2);
+	    blk = ntohs(blk);
+
+	    /* If Error came back, retry without options if the	*/
+	    /*	request had them, otherwise give up			*/
+
+	    if (opcode == TFTP_ERROR) {
+		if (!started && useopts) {
+			udp_releasebuf(pkt);
+			if (verbose & TFTP_VERBOSE) {
+				kprintf("[TFTP Get] Options refused\n");
+			}
+			useopts = FALSE;
+			mlen = tftp_bldrrq(&outmsg, filename, nlen, 0, 0);
+			udp_sendto(sock, serverip, remport,
+					(char *) &outmsg, mlen);
+			retries = 0;
+			continue;
+		}
+		kprintf("\n[TFTP Get] TFTP Error %d, %s\n", blk,
+				(data[n-1] == NULLCH) ? data + 4 : "");
+		udp_releasebuf(pkt);
 		udp_release(sock);
 		return SYSERR;
 	    }
-		
+
+	    /* An OACK gives the sizes the server chose; ACK block 0	*/
+	    /*	to start the data					*/
+
+	    if (opcode == TFTP_OACK) {
+		if (!started) {
+			if (!useopts || (tftp_oack(data + 2, n - 2,
+					&blksize, &windowsize) == SYSERR)) {
+				kprintf("\n[TFTP Get] ERROR: Bad OACK\n");
+				udp_releasebuf(pkt);
+				udp_release(sock);
+				return SYSERR;
+			}
+			started = TRUE;
+			remport = pkt->net_udpsport;
+			bsize = blksize;
+			wsize = windowsize;
+			retries = 0;
+			if (verbose & TFTP_VERBOSE) {
+				kprintf("[TFTP Get] blksize %d windowsize %d\n",
+							bsize, wsize);
+			}
+			tftp_ack(sock, serverip, remport, 0);
+		}
+		udp_releasebuf(pkt);
+		continue;
+	    }
+
+	    if (opcode != TFTP_DATA) {
+		udp_releasebuf(pkt);
+		continue;
+	    }
+
+	    /* Data without an OACK means the server ignored options	*/
+
+	    if (!started) {
+		started = TRUE;
+		remport = pkt->net_udpsport;
+	    }
+
+	    /* A block past a lost one means the rest of the window	*/
+	    /*	must be resent; ACK the last block in order once, and	*/
+	    /*	ignore duplicates (the timeout recovers a lost ACK)	*/
+
+	    if (blk != expected) {
+		if ( ((uint16)(blk - expected) < 0x8000) && !gapacked ) {
+			tftp_ack(sock, serverip, remport, expected - 1);
+			gapacked = TRUE;
+			inwin = 0;
+		}
+		udp_releasebuf(pkt);
+		continue;
+	    }
+	    retries = 0;
+	    gapacked = FALSE;
+
 	    if(verbose & TFTP_VERBOSE) {
 		kprintf(".");
 	    }
 
 	    /* Compute size of data in the message */
 
-	    dlen = n - sizeof(inmsg.tf_opcode) - sizeof(inmsg.tf_dblk);
+	    dlen = n - sizeof(outmsg.tf_opcode) - sizeof(outmsg.tf_dblk);
+	    if (dlen > bsize) {
+		kprintf("\n[TFTP Get] ERROR: Block %d too long\n", blk);
+		udp_releasebuf(pkt);
+		udp_release(sock);
+		return SYSERR;
+	    }
 
-	    /* Move the contents of this block into the file buffer	*/
+	    /* Move the contents of this block into the file buffers	*/
 
-	    for (i=0; i<dlen; i++) {
+	    for (i = 0; i < dlen; i += k) {
 		if (curr_used >= rcv_buf_sizes[curr_buf_ind]) {
 			curr_buf_ind++;
 			if(curr_buf_ind >= rcv_buf_count) {
+				udp_releasebuf(pkt);
 				udp_release(sock);
 				if(verbose & TFTP_VERBOSE) {
 					kprintf("\n");
@@ -253,28 +471,27 @@ status  tftpget_mb(
 			curr_buf = (char*)rcv_bufs[curr_buf_ind];
 			curr_used = 0;
 		}
-		*curr_buf++ = inmsg.tf_data[i];
-		curr_used++;
-		filesiz++;
+		k = rcv_buf_sizes[curr_buf_ind] - curr_used;
+		if (k > dlen - i) {
+			k = dlen - i;
+		}
+		memcpy(curr_buf, data + 4 + i, k);
+		curr_buf += k;
+		curr_used += k;
+		filesiz += k;
 	    }
-
-	    /* Form an ACK */
-
-	    outmsg.tf_opcode = htons(TFTP_ACK);
-	    outmsg.tf_ablk = htons(expected);
-	    mlen = sizeof(outmsg.tf_opcode) + sizeof(outmsg.tf_ablk);
+	    udp_releasebuf(pkt);
 
 	    /* If this was the last packet, send final ACK */
 
-	    if (dlen < 512) {
-		ret = udp_sendto(sock, serverip, remport,
-					(char *) &outmsg, mlen);
+	    if (dlen < bsize) {
+		ret = tftp_ack(sock, serverip, remport, expected);
 		udp_release(sock);
-			
+
 		if(verbose & TFTP_VERBOSE) {
 			kprintf("\n");
 		}
-			
+
 		if (ret == SYSERR) {
 			kprintf("\n[TFTP GET] Error on final ack\n");
 			return SYSERR;
@@ -282,8 +499,12 @@ status  tftpget_mb(
 		return filesiz;
 	    }
 
-	    /* Move to next block and continue */
+	    /* ACK the last block of a window, and move to next block	*/
 
+	    if (++inwin >= wsize) {
+		tftp_ack(sock, serverip, remport, expected);
+		inwin = 0;
+	    }
 	    expected++;
 	}
 }
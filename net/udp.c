@@ -1,9 +1,39 @@
 /* udp.c - udp_init, udp_in, udp_register, udp_send, udp_sendto,	*/
-/*	        udp_recv, udp_recvaddr, udp_release, udp_ntoh, udp_hton	*/
+/*	        udp_sendmany, udp_recv, udp_recvaddr, udp_recviov,	*/
+/*		udp_recvbuf, udp_recvmany, udp_releasebuf, udp_nextpkt,	*/
+/*		udp_release, udp_setcksum, udp_setdscp, udp_ntoh,	*/
+/*		udp_hton, udp_hash, udp_lookup, udp_enqueue, udp_mkpkt,	*/
+/*		udp_sendfrags, udp_hdrsum, udp_copyin			*/
 
 #include <xinu.h>
 
 struct	udpentry udptab[UDP_SLOTS];	/* Table of UDP endpoints	*/
+struct	udpstat	udpstats;		/* UDP statistics		*/
+sid32	udpmutex;			/* Protects udptab and udpstats	*/
+
+/* The table is protected by udpmutex rather than by disabling	*/
+/*   interrupts; nothing here is touched by an interrupt handler,	*/
+/*   and the mutex is never held while waiting for a packet or	*/
+/*   while a datagram is being sent				*/
+
+/* Registered endpoints are chained through udnext from a hash table	*/
+/*   keyed on (local port, remote IP, remote port); free entries are	*/
+/*   chained the same way from udpfree					*/
+
+local	int32	udphash[UDP_HSIZ];	/* Head of each hash chain	*/
+local	int32	udpfree;		/* Head of the free list	*/
+
+local	uint32	udp_hash(uint16, uint32, uint16);
+local	struct	udpentry *udp_lookup(uint16, uint32, uint16);
+local	void	udp_enqueue(struct udpentry *, struct netpacket *);
+local	status	udp_mkpkt(struct netpacket *, uint16, int32, byte,
+					uint32, uint16, char *, int32);
+local	status	udp_sendfrags(uint16, int32, byte, uint32, uint16,
+						char *, int32);
+local	uint32	udp_hdrsum(struct netpacket *);
+local	int32	udp_nextpkt(uid32, uint32, struct netpacket **);
+local	int32	udp_copyin(struct udpentry *, struct netpacket *,
+						struct udpiov *, int32);
 
 /*------------------------------------------------------------------------
  * udp_init  -  Initialize all entries in the UDP endpoint table
@@ -16,7 +46,16 @@ void	udp_init(void)
 
 	for(i=0; i<UDP_SLOTS; i++) {
 		udptab[i].udstate = UDP_FREE;
+		udptab[i].udnext = i + 1;
 	}
+	udptab[UDP_SLOTS-1].udnext = -1;
+	udpfree = 0;
+
+	for(i=0; i<UDP_HSIZ; i++) {
+		udphash[i] = -1;
+	}
+	memset((char *)&udpstats, NULLCH, sizeof(udpstats));
+	udpmutex = semcreate(1);
 
 	return;
 }
@@ -30,49 +69,63 @@ void	udp_in(
 	  struct netpacket *pktptr	/* Pointer to the packet	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	int32	i;			/* Index into udptab		*/
-	struct	udpentry *udptr;	/* Pointer to a udptab entry	*/
-
+	struct	udpentry *match[4];	/* Endpoints that match		*/
+	int32	nmatch;			/* Number of entries in match[]	*/
+	int32	i;			/* Index of a lookup key	*/
+	uint16	lport;			/* Destination (local) port	*/
+	bool8	bcast;			/* Was the datagram broadcast	*/
 
 	/* Ensure only one process can access the UDP table at a time	*/
 
-	mask = disable();
-
-	for (i=0; i<UDP_SLOTS; i++) {
-	    udptr = &udptab[i];
-	    if (udptr->udstate == UDP_FREE) {
-			continue;
-	    }
-
-	    if ((pktptr->net_udpdport == udptr->udlocport)  &&
-                    ((udptr->udremport == 0) ||
-                        (pktptr->net_udpsport == udptr->udremport)) &&
-                 (  ((udptr->udremip==0)     ||
-                        (pktptr->net_ipsrc == udptr->udremip)))    ) {
+	wait(udpmutex);
 
-		/* Entry matches incoming packet */
+	/* Strip the UDP header, leaving the UDP data in the packet	*/
 
-		if (udptr->udcount < UDP_QSIZ) {
-			udptr->udcount++;
-			udptr->udqueue[udptr->udtail++] = pktptr;
-			if (udptr->udtail >= UDP_QSIZ) {
-				udptr->udtail = 0;
-			}
-			if (udptr->udstate == UDP_RECV) {
-				udptr->udstate = UDP_USED;
-				send (udptr->udpid, OK);
+	if ( (pktptr->net_udplen < UDP_HDR_LEN) ||
+	     (pktptr->net_udplen > pb_len(pktptr)) ) {
+		udpstats.us_ckdrop++;
+		signal(udpmutex);
+		pb_free(pktptr);
+		return;
+	}
+	pb_pull(pktptr, UDP_HDR_LEN);
+	pb_trim(pktptr, pktptr->net_udplen - UDP_HDR_LEN);
+
+	/* Find the most specific endpoint: a fully-specified one	*/
+	/*   first, then ones that leave the remote port and/or the	*/
+	/*   remote IP address as a wildcard (zero).  A broadcast	*/
+	/*   datagram goes to every endpoint that matches.		*/
+
+	lport = pktptr->net_udpdport;
+	bcast = (pktptr->net_ipdst == IP_BCAST) ||
+		(pktptr->net_ipdst == NetData.ipbcast);
+	nmatch = 0;
+	for (i = 0; i < 4; i++) {
+		match[nmatch] = udp_lookup(lport,
+				(i & 2) ? 0 : pktptr->net_ipsrc,
+				(i & 1) ? 0 : pktptr->net_udpsport);
+		if (match[nmatch] != NULL) {
+			nmatch++;
+			if (!bcast) {
+				break;
 			}
-			restore(mask);
-			return;
 		}
-	    }
 	}
 
-	/* No match - simply discard packet */
+	if (nmatch == 0) {		/* No match - discard packet	*/
+		udpstats.us_nomatch++;
+		signal(udpmutex);
+		pb_free(pktptr);
+		return;
+	}
+
+	/* Endpoints that receive the same broadcast share the buffer	*/
 
-	freebuf((char *) pktptr);
-	restore(mask);
+	for (i = 1; i < nmatch; i++) {
+		udp_enqueue(match[i], pb_clone(pktptr));
+	}
+	udp_enqueue(match[0], pktptr);
+	signal(udpmutex);
 	return;
 }
 
@@ -88,55 +141,46 @@ uid32	udp_register (
 	 uint16	locport			/* Local UDP protocol port	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	int32	slot;			/* Index into udptab		*/
 	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+	uint32	h;			/* Hash bucket for the entry	*/
 
 	/* Ensure only one process can access the UDP table at a time	*/
 
-	mask = disable();
-
-	/* See if request already registered */
+	wait(udpmutex);
 
-	for (slot=0; slot<UDP_SLOTS; slot++) {
-		udptr = &udptab[slot];
-		if (udptr->udstate == UDP_FREE) {
-			continue;
-		}
-
-		/* Look at this entry in table */
-
-		if ( (remport == udptr->udremport) &&
-		     (locport == udptr->udlocport) &&
-		     (remip   == udptr->udremip  ) ) {
-
-			/* Request is already in the table */
+	/* See if request already registered or the table is full */
 
-			restore(mask);
-			return SYSERR;
-		}
+	if ( (udp_lookup(locport, remip, remport) != NULL) ||
+	     (udpfree < 0) ) {
+		signal(udpmutex);
+		return SYSERR;
 	}
 
-	/* Find a free slot and allocate it */
+	/* Take a slot from the free list and add it to its hash chain */
 
-	for (slot=0; slot<UDP_SLOTS; slot++) {
-		udptr = &udptab[slot];
-		if (udptr->udstate != UDP_FREE) {
-			continue;
-		}
-		udptr->udlocport = locport;
-		udptr->udremport = remport;
-		udptr->udremip = remip;
-		udptr->udcount = 0;
-		udptr->udhead = udptr->udtail = 0;
-		udptr->udpid = -1;
-		udptr->udstate = UDP_USED;
-		restore(mask);
-		return slot;
-	}
-
-	restore(mask);
-	return SYSERR;
+	slot = udpfree;
+	udptr = &udptab[slot];
+	udpfree = udptr->udnext;
+
+	h = udp_hash(locport, remip, remport);
+	udptr->udnext = udphash[h];
+	udphash[h] = slot;
+
+	udptr->udlocport = locport;
+	udptr->udremport = remport;
+	udptr->udremip = remip;
+	udptr->udcount = 0;
+	udptr->udhead = udptr->udtail = 0;
+	udptr->udpid = -1;
+	udptr->udcksum = UDP_CKSUM_ALL;
+	udptr->uddscp = 0;
+	udptr->udckdrop = 0;
+	udptr->udrecvd = 0;
+	udptr->uddrop = 0;
+	udptr->udstate = UDP_USED;
+	signal(udpmutex);
+	return slot;
 }
 
 /*------------------------------------------------------------------------
@@ -150,108 +194,162 @@ int32	udp_recv (
 	 uint32	timeout			/* Read timeout in msec		*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
-	umsg32	msg;			/* Message from recvtime()	*/
-	struct	netpacket *pkt;		/* Pointer to packet being read	*/
-	int32	i;			/* Counts bytes copied		*/
-	int32	msglen;			/* Length of UDP data in packet	*/
-	char	*udataptr;		/* Pointer to UDP data		*/
-
-	/* Ensure only one process can access the UDP table at a time	*/
-
-	mask = disable();
+	struct	udpiov iov;		/* Describes the caller's buffer*/
 
-	/* Verify that the slot is valid */
-
-	if ((slot < 0) || (slot >= UDP_SLOTS)) {
-		restore(mask);
-		return SYSERR;
-	}
+	iov.iov_base = buff;
+	iov.iov_len = len;
+	return udp_recviov(slot, NULL, NULL, &iov, 1, timeout);
+}
 
-	/* Get pointer to table entry */
+/*------------------------------------------------------------------------
+ * udp_recvaddr  -  Receive a UDP packet and record the sender's address
+ *------------------------------------------------------------------------
+ */
+int32	udp_recvaddr (
+	 uid32	slot,			/* Slot in table to use		*/
+	 uint32	*remip,			/* Loc for remote IP address	*/
+	 uint16	*remport,		/* Loc for remote protocol port	*/
+	 char   *buff,			/* Buffer to hold UDP data	*/
+	 int32	len,			/* Length of buffer		*/
+	 uint32	timeout			/* Read timeout in msec		*/
+	)
+{
+	struct	udpiov iov;		/* Describes the caller's buffer*/
 
-	udptr = &udptab[slot];
+	iov.iov_base = buff;
+	iov.iov_len = len;
+	return udp_recviov(slot, remip, remport, &iov, 1, timeout);
+}
 
-	/* Verify that the slot has been registered and is valid */
+/*------------------------------------------------------------------------
+ * udp_recviov  -  Receive a UDP packet, scattering the data across a
+ *		     list of buffers, and optionally record the sender's
+ *		     address; return the number of bytes stored
+ *------------------------------------------------------------------------
+ */
+int32	udp_recviov (
+	 uid32	slot,			/* Slot in table to use		*/
+	 uint32	*remip,			/* Loc for remote IP address	*/
+					/*   (NULL if not wanted)	*/
+	 uint16	*remport,		/* Loc for remote protocol port	*/
+					/*   (NULL if not wanted)	*/
+	 struct	udpiov *iov,		/* Buffers to hold UDP data	*/
+	 int32	niov,			/* Number of buffers		*/
+	 uint32	timeout			/* Read timeout in msec		*/
+	)
+{
+	struct	netpacket *pkt;		/* Pointer to packet being read	*/
+	int32	msglen;			/* Length of UDP data copied	*/
+	int32	retval;			/* Value returned by udp_nextpkt*/
 
-	if (udptr->udstate != UDP_USED) {
-		restore(mask);
+	if (niov < 0) {
 		return SYSERR;
 	}
 
-	/* Wait for a packet to arrive */
+	/* Wait for a packet to arrive; datagrams that fail the	*/
+	/*   checksum are dropped and the wait starts again	*/
 
-	if (udptr->udcount == 0) {		/* No packet is waiting	*/
-		udptr->udstate = UDP_RECV;
-		udptr->udpid = currpid;
-		msg = recvclr();
-		msg = recvtime(timeout);	/* Wait for a packet	*/
-		udptr->udstate = UDP_USED;
-		if (msg == TIMEOUT) {
-			restore(mask);
-			return TIMEOUT;
-		} else if (msg != OK) {
-			restore(mask);
-			return SYSERR;
+	do {
+		retval = udp_nextpkt(slot, timeout, &pkt);
+		if (retval != OK) {
+			return retval;
 		}
-	}
 
-	/* Packet has arrived -- dequeue it */
+		/* Copy UDP data from packet into caller's buffers	*/
+		/*   and verify the checksum in the same pass	*/
 
-	pkt = udptr->udqueue[udptr->udhead++];
-	if (udptr->udhead >= UDP_QSIZ) {
-		udptr->udhead = 0;
-	}
-	udptr->udcount--;
+		msglen = udp_copyin(&udptab[slot], pkt, iov, niov);
+		if (msglen != SYSERR) {
 
-	/* Copy UDP data from packet into caller's buffer */
+			/* Record sender's IP address and UDP port */
+
+			if (remip != NULL) {
+				*remip = pkt->net_ipsrc;
+			}
+			if (remport != NULL) {
+				*remport = pkt->net_udpsport;
+			}
+		}
+		pb_free(pkt);
+	} while (msglen == SYSERR);
 
-	msglen = pkt->net_udplen - UDP_HDR_LEN;
-	udataptr = (char *)pkt->net_udpdata;
-	if (len < msglen) {
-		msglen = len;
-	}
-	for (i=0; i<msglen; i++) {
-		*buff++ = *udataptr++;
-	}
-	freebuf((char *)pkt);
-	restore(mask);
 	return msglen;
 }
 
 /*------------------------------------------------------------------------
- * udp_recvaddr  -  Receive a UDP packet and record the sender's address
+ * udp_recvbuf  -  Receive a UDP packet without copying the data: hand
+ *		     the caller the network buffer itself, which must be
+ *		     returned with udp_releasebuf (a broadcast buffer may
+ *		     be shared with other endpoints, so the caller must
+ *		     not change it; see pb_unshare)
  *------------------------------------------------------------------------
  */
-int32	udp_recvaddr (
+status	udp_recvbuf (
 	 uid32	slot,			/* Slot in table to use		*/
-	 uint32	*remip,			/* Loc for remote IP address	*/
-	 uint16	*remport,		/* Loc for remote protocol port	*/
-	 char   *buff,			/* Buffer to hold UDP data	*/
-	 int32	len,			/* Length of buffer		*/
+	 struct	netpacket **pktptr,	/* Loc for the packet (headers	*/
+					/*   are in host byte order)	*/
+	 char	**data,			/* Loc for pointer to UDP data	*/
+	 int32	*len,			/* Loc for length of UDP data	*/
 	 uint32	timeout			/* Read timeout in msec		*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
-	umsg32	msg;			/* Message from recvtime()	*/
 	struct	netpacket *pkt;		/* Pointer to packet being read	*/
-	int32	msglen;			/* Length of UDP data in packet	*/
-	int32	i;			/* Counts bytes copied		*/
-	char	*udataptr;		/* Pointer to UDP data		*/
+	int32	retval;			/* Value returned by udp_nextpkt*/
 
-	/* Ensure only one process can access the UDP table at a time	*/
+	/* Wait for a packet with a good checksum */
+
+	do {
+		retval = udp_nextpkt(slot, timeout, &pkt);
+		if (retval != OK) {
+			return retval;
+		}
+		if (udp_copyin(&udptab[slot], pkt, NULL, 0) != SYSERR) {
+			break;
+		}
+		pb_free(pkt);
+	} while (TRUE);
+
+	*pktptr = pkt;
+	*data = pb_data(pkt);
+	*len = pb_len(pkt);
+	return OK;
+}
 
-	mask = disable();
+/*------------------------------------------------------------------------
+ * udp_releasebuf  -  Return a buffer obtained from udp_recvbuf
+ *------------------------------------------------------------------------
+ */
+status	udp_releasebuf (
+	 struct	netpacket *pkt		/* Packet from udp_recvbuf	*/
+	)
+{
+	return pb_free(pkt);
+}
+
+/*------------------------------------------------------------------------
+ * udp_nextpkt  -  Wait for a packet to arrive on a UDP endpoint and
+ *		     dequeue it; return OK, TIMEOUT or SYSERR
+ *------------------------------------------------------------------------
+ */
+local	int32	udp_nextpkt (
+	 uid32	slot,			/* Slot in table to use		*/
+	 uint32	timeout,		/* Read timeout in msec		*/
+	 struct	netpacket **pktptr	/* Loc for the packet		*/
+	)
+{
+	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+	umsg32	msg;			/* Message from recvtime()	*/
 
 	/* Verify that the slot is valid */
 
 	if ((slot < 0) || (slot >= UDP_SLOTS)) {
-		restore(mask);
 		return SYSERR;
 	}
 
+	/* Ensure only one process can access the UDP table at a time	*/
+
+	wait(udpmutex);
+
 	/* Get pointer to table entry */
 
 	udptr = &udptab[slot];
@@ -259,54 +357,43 @@ int32	udp_recvaddr (
 	/* Verify that the slot has been registered and is valid */
 
 	if (udptr->udstate != UDP_USED) {
-		restore(mask);
+		signal(udpmutex);
 		return SYSERR;
 	}
 
-	/* Wait for a packet to arrive */
+	/* Wait for a packet to arrive.  The table is unlocked while	*/
+	/*   waiting; a message that udp_in sends before recvtime is	*/
+	/*   called is kept, so the wakeup cannot be lost		*/
 
-	if (udptr->udcount == 0) {		/* No packet is waiting */
+	if (udptr->udcount == 0) {		/* No packet is waiting	*/
 		udptr->udstate = UDP_RECV;
 		udptr->udpid = currpid;
 		msg = recvclr();
+		signal(udpmutex);
 		msg = recvtime(timeout);	/* Wait for a packet	*/
-		udptr->udstate = UDP_USED;
-		if (msg == TIMEOUT) {
-			restore(mask);
-			return TIMEOUT;
-		} else if (msg != OK) {
-			restore(mask);
+		wait(udpmutex);
+		if (udptr->udstate == UDP_RECV) {
+			udptr->udstate = UDP_USED;
+		} else if (udptr->udstate != UDP_USED) {
+			signal(udpmutex);	/* Released meanwhile	*/
 			return SYSERR;
 		}
+		if (udptr->udcount == 0) {
+			signal(udpmutex);
+			return (msg == TIMEOUT) ? TIMEOUT : SYSERR;
+		}
 	}
 
-	/* Packet has arrived -- dequeue it */
+	/* Packet has arrived -- dequeue it.  The packet now belongs	*/
+	/*   to the caller, so its data can be read without the lock	*/
 
-	pkt = udptr->udqueue[udptr->udhead++];
+	*pktptr = udptr->udqueue[udptr->udhead++];
 	if (udptr->udhead >= UDP_QSIZ) {
 		udptr->udhead = 0;
 	}
-
-	/* Record sender's IP address and UDP port number */
-
-	*remip = pkt->net_ipsrc;
-	*remport = pkt->net_udpsport;
-
 	udptr->udcount--;
-
-	/* Copy UDP data from packet into caller's buffer */
-
-	msglen = pkt->net_udplen - UDP_HDR_LEN;
-	udataptr = (char *)pkt->net_udpdata;
-	if (len < msglen) {
-		msglen = len;
-	}
-	for (i=0; i<msglen; i++) {
-		*buff++ = *udataptr++;
-	}
-	freebuf((char *)pkt);
-	restore(mask);
-	return msglen;
+	signal(udpmutex);
+	return OK;
 }
 
 /*------------------------------------------------------------------------
@@ -319,182 +406,253 @@ status	udp_send (
 	 int32	len			/* Length of data in buffer	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	netpacket *pkt;		/* Pointer to packet buffer	*/
-	int32	pktlen;			/* Total packet length		*/
-	static	uint16 ident = 1;	/* Datagram IDENT field		*/
-	char	*udataptr;		/* Pointer to UDP data		*/
-	uint32	remip;			/* Remote IP address to use	*/
-	uint16	remport;		/* Remote protocol port to use	*/
-	uint16	locport;		/* Local protocol port to use	*/
-	uint32	locip;			/* Local IP address taken from	*/
-					/*   the interface		*/
-	struct	udpentry *udptr;	/* Pointer to table entry	*/
+	return udp_sendto(slot, 0, 0, buff, len);
+}
 
-	/* Ensure only one process can access the UDP table at a time	*/
 
-	mask = disable();
+/*------------------------------------------------------------------------
+ * udp_sendto  -  Send a UDP packet to a specified destination (a zero
+ *		    remote IP address means the remote address of the
+ *		    slot)
+ *------------------------------------------------------------------------
+ */
+status	udp_sendto (
+	 uid32	slot,			/* UDP table slot to use	*/
+	 uint32	remip,			/* Remote IP address to use	*/
+	 uint16	remport,		/* Remote protocol port to use	*/
+	 char   *buff,			/* Buffer of UDP data		*/
+	 int32	len			/* Length of data in buffer	*/
+	)
+{
+	struct	netpacket *pkt;		/* Pointer to a packet buffer	*/
+	struct	udpentry *udptr;	/* Pointer to a UDP table entry	*/
+	uint16	locport;		/* Local protocol port to use	*/
+	int32	options;		/* Checksum options of the slot	*/
+	byte	dscp;			/* DSCP of the slot		*/
 
 	/* Verify that the slot is valid */
 
 	if ( (slot < 0) || (slot >= UDP_SLOTS) ) {
-		restore(mask);
 		return SYSERR;
 	}
 
-	/* Get pointer to table entry */
+	/* Copy what is needed from the table entry, so the table is	*/
+	/*   not locked while the datagram is built and sent		*/
 
+	wait(udpmutex);
 	udptr = &udptab[slot];
 
 	/* Verify that the slot has been registered and is valid */
 
 	if (udptr->udstate == UDP_FREE) {
-		restore(mask);
+		signal(udpmutex);
 		return SYSERR;
 	}
+	if (remip == 0) {
+		remip = udptr->udremip;
+		remport = udptr->udremport;
+	}
+	locport = udptr->udlocport;
+	options = udptr->udcksum;
+	dscp = udptr->uddscp;
+	signal(udpmutex);
 
-	/* Verify that the slot has a specified remote address */
+	/* Verify that there is a remote address to send to */
 
-	remip = udptr->udremip;
 	if (remip == 0) {
-		restore(mask);
 		return SYSERR;
 	}
 
-	locip = NetData.ipucast;
-	remport = udptr->udremport;
-	locport = udptr->udlocport;
+	/* Data that do not fit in one frame are sent as fragments */
+
+	if (len > UDP_MAXDATA) {
+		return udp_sendfrags(locport, options, dscp, remip, remport,
+								buff, len);
+	}
 
 	/* Allocate a network buffer to hold the packet */
 
-	pkt = (struct netpacket *)getbuf(netbufpool);
+	pkt = pb_alloc();
 
 	if ((int32)pkt == SYSERR) {
-		restore(mask);
 		return SYSERR;
 	}
 
-	/* Compute packet length as UDP data size + fixed header size	*/
-
-	pktlen = ((char *)&pkt->net_udpdata - (char *)pkt) + len;
-
-	/* Create a UDP packet in pkt */
-
-	memcpy((char *)pkt->net_ethsrc,NetData.ethucast,ETH_ADDR_LEN);
-	pkt->net_ethtype = 0x0800;	/* Type is IP			*/
-	pkt->net_ipvh = 0x45;		/* IP version and hdr length	*/
-	pkt->net_iptos = 0x00;		/* Type of service		*/
-	pkt->net_iplen= pktlen - ETH_HDR_LEN;/* Total IP datagram length*/
-	pkt->net_ipid = ident++;	/* Datagram gets next IDENT	*/
-	pkt->net_ipfrag = 0x0000;	/* IP flags & fragment offset	*/
-	pkt->net_ipttl = 0xff;		/* IP time-to-live		*/
-	pkt->net_ipproto = IP_UDP;	/* Datagram carries UDP		*/
-	pkt->net_ipcksum = 0x0000;	/* initial checksum		*/
-	pkt->net_ipsrc = locip;		/* IP source address		*/
-	pkt->net_ipdst = remip;		/* IP destination address	*/
+	/* Create UDP packet in pkt */
 
-	pkt->net_udpsport = locport;	/* Local UDP protocol port	*/
-	pkt->net_udpdport = remport;	/* Remote UDP protocol port	*/
-	pkt->net_udplen = (uint16)(UDP_HDR_LEN+len); /* UDP length	*/
-	pkt->net_udpcksum = 0x0000;	/* Ignore UDP checksum		*/
-	udataptr = (char *) pkt->net_udpdata;
-	for (; len>0; len--) {
-		*udataptr++ = *buff++;
+	if (udp_mkpkt(pkt, locport, options, dscp, remip, remport, buff,
+							len) == SYSERR) {
+		pb_free(pkt);
+		return SYSERR;
 	}
 
-	/* Call ipsend to send the datagram */
+	/* Call ipsend to queue the datagram in its output class */
 
 	ip_send(pkt);
-	restore(mask);
 	return OK;
 }
 
 
 /*------------------------------------------------------------------------
- * udp_sendto  -  Send a UDP packet to a specified destination
+ * udp_sendmany  -  Send an array of UDP messages, validating the slot
+ *		      once per call; ipout sends the queued datagrams to
+ *		      the driver in batches; return the number of messages
+ *		      sent
  *------------------------------------------------------------------------
  */
-status	udp_sendto (
+int32	udp_sendmany (
 	 uid32	slot,			/* UDP table slot to use	*/
-	 uint32	remip,			/* Remote IP address to use	*/
-	 uint16	remport,		/* Remote protocol port to use	*/
-	 char   *buff,			/* Buffer of UDP data		*/
-	 int32	len			/* Length of data in buffer	*/
+	 struct	udpmsg *msgs,		/* Messages to send; a zero	*/
+					/*   um_remip means the remote	*/
+					/*   address of the slot	*/
+	 int32	nmsgs			/* Number of messages		*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
-	struct	netpacket *pkt;		/* Pointer to a packet buffer	*/
-	int32	pktlen;			/* Total packet length		*/
-	static	uint16 ident = 1;	/* Datagram IDENT field		*/
+	int32	nsent;			/* Messages sent so far		*/
 	struct	udpentry *udptr;	/* Pointer to a UDP table entry	*/
-	char	*udataptr;		/* Pointer to UDP data		*/
-
-	/* Ensure only one process can access the UDP table at a time	*/
+	struct	udpmsg *mptr;		/* Message being sent		*/
+	struct	netpacket *pkt;		/* Pointer to a packet buffer	*/
+	uint32	remip;			/* Remote IP address to use	*/
+	uint16	remport;		/* Remote protocol port to use	*/
+	uint32	slotip;			/* Remote IP address of the slot*/
+	uint16	slotport;		/* Remote port of the slot	*/
+	uint16	locport;		/* Local protocol port to use	*/
+	int32	options;		/* Checksum options of the slot	*/
+	byte	dscp;			/* DSCP of the slot		*/
 
-	mask = disable();
+	/* Verify that the slot is valid and registered, and copy what	*/
+	/*   is needed from the table entry				*/
 
-	/* Verify that the slot is valid */
-
-	if ( (slot < 0) || (slot >= UDP_SLOTS) ) {
-		restore(mask);
+	if ( (slot < 0) || (slot >= UDP_SLOTS) || (nmsgs < 0) ) {
 		return SYSERR;
 	}
-
-	/* Get pointer to table entry */
-
+	wait(udpmutex);
 	udptr = &udptab[slot];
-
-	/* Verify that the slot has been registered and is valid */
-
 	if (udptr->udstate == UDP_FREE) {
-		restore(mask);
+		signal(udpmutex);
 		return SYSERR;
 	}
+	slotip = udptr->udremip;
+	slotport = udptr->udremport;
+	locport = udptr->udlocport;
+	options = udptr->udcksum;
+	dscp = udptr->uddscp;
+	signal(udpmutex);
+
+	/* Build and queue each datagram; stop at a message that	*/
+	/*   cannot be sent						*/
+
+	for (nsent = 0; nsent < nmsgs; nsent++) {
+		mptr = &msgs[nsent];
+		remip = mptr->um_remip;
+		remport = mptr->um_remport;
+		if (remip == 0) {
+			remip = slotip;
+			remport = slotport;
+		}
+		if (remip == 0) {
+			break;
+		}
+		if (mptr->um_len > UDP_MAXDATA) {
+			if (udp_sendfrags(locport, options, dscp, remip,
+					remport, mptr->um_buf, mptr->um_len)
+							== SYSERR) {
+				break;
+			}
+			continue;
+		}
+		pkt = pb_alloc();
+		if ((int32)pkt == SYSERR) {
+			break;
+		}
+		if (udp_mkpkt(pkt, locport, options, dscp, remip, remport,
+				mptr->um_buf, mptr->um_len) == SYSERR) {
+			pb_free(pkt);
+			break;
+		}
 
-	/* Allocate a network buffer to hold the packet */
+		/* As with udp_send, a datagram IP cannot deliver or	*/
+		/*   that its output class drops is not an error	*/
 
-	pkt = (struct netpacket *)getbuf(netbufpool);
+		ip_send(pkt);
+	}
+	return nsent;
+}
 
-	if ((int32)pkt == SYSERR) {
-		restore(mask);
+/*------------------------------------------------------------------------
+ * udp_recvmany  -  Receive up to nmsgs UDP messages, waiting only for
+ *		      the first and taking any others that are already
+ *		      queued; return the number of messages received
+ *------------------------------------------------------------------------
+ */
+int32	udp_recvmany (
+	 uid32	slot,			/* Slot in table to use		*/
+	 struct	udpmsg *msgs,		/* Messages; on input um_buf and*/
+					/*   um_len give each buffer,	*/
+					/*   on output um_len is the	*/
+					/*   data length and um_remip,	*/
+					/*   um_remport the sender	*/
+	 int32	nmsgs,			/* Number of messages		*/
+	 uint32	timeout			/* Read timeout in msec		*/
+	)
+{
+	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+	struct	netpacket *pkts[IP_BATCH];/* Packets taken from queue	*/
+	int32	npkts;			/* Packets in pkts[]		*/
+	int32	nrecv;			/* Messages received		*/
+	int32	retval;			/* Value returned by udp_nextpkt*/
+	int32	i;			/* Index into pkts[]		*/
+	struct	udpmsg *mptr;		/* Message being filled in	*/
+	struct	udpiov iov;		/* Describes a message buffer	*/
+
+	if (nmsgs <= 0) {
 		return SYSERR;
 	}
+	if (nmsgs > IP_BATCH) {
+		nmsgs = IP_BATCH;
+	}
 
-	/* Compute packet length as UDP data size + fixed header size	*/
-
-	pktlen = ((char *)&pkt->net_udpdata - (char *)pkt) + len;
+	nrecv = 0;
+	while (nrecv == 0) {
 
-	/* Create UDP packet in pkt */
+		/* Wait for the first packet, then take the others that	*/
+		/*   are queued with one pass through the lock		*/
 
-	memcpy((char *)pkt->net_ethsrc,NetData.ethucast,ETH_ADDR_LEN);
-        pkt->net_ethtype = 0x0800;	/* Type is IP */
-	pkt->net_ipvh = 0x45;		/* IP version and hdr length	*/
-	pkt->net_iptos = 0x00;		/* Type of service		*/
-	pkt->net_iplen= pktlen - ETH_HDR_LEN;/* total IP datagram length*/
-	pkt->net_ipid = ident++;	/* Datagram gets next IDENT	*/
-	pkt->net_ipfrag = 0x0000;	/* IP flags & fragment offset	*/
-	pkt->net_ipttl = 0xff;		/* IP time-to-live		*/
-	pkt->net_ipproto = IP_UDP;	/* Datagram carries UDP		*/
-	pkt->net_ipcksum = 0x0000;	/* Initial checksum		*/
-	pkt->net_ipsrc = NetData.ipucast;/* IP source address		*/
-	pkt->net_ipdst = remip;		/* IP destination address	*/
-	pkt->net_udpsport = udptr->udlocport;/* local UDP protocol port	*/
-	pkt->net_udpdport = remport;	/* Remote UDP protocol port	*/
-	pkt->net_udplen = (uint16)(UDP_HDR_LEN+len); /* UDP length	*/
-	pkt->net_udpcksum = 0x0000;	/* Ignore UDP checksum		*/
-	udataptr = (char *) pkt->net_udpdata;
-	for (; len>0; len--) {
-		*udataptr++ = *buff++;
+		retval = udp_nextpkt(slot, timeout, &pkts[0]);
+		if (retval != OK) {
+			return retval;
+		}
+		udptr = &udptab[slot];
+		wait(udpmutex);
+		for (npkts = 1; (npkts < nmsgs) && (udptr->udcount > 0);
+							npkts++) {
+			pkts[npkts] = udptr->udqueue[udptr->udhead++];
+			if (udptr->udhead >= UDP_QSIZ) {
+				udptr->udhead = 0;
+			}
+			udptr->udcount--;
+		}
+		signal(udpmutex);
+
+		/* Copy the data out; drop datagrams with bad checksums	*/
+
+		for (i = 0; i < npkts; i++) {
+			mptr = &msgs[nrecv];
+			iov.iov_base = mptr->um_buf;
+			iov.iov_len = mptr->um_len;
+			retval = udp_copyin(udptr, pkts[i], &iov, 1);
+			if (retval != SYSERR) {
+				mptr->um_len = retval;
+				mptr->um_remip = pkts[i]->net_ipsrc;
+				mptr->um_remport = pkts[i]->net_udpsport;
+				nrecv++;
+			}
+			pb_free(pkts[i]);
+		}
 	}
-
-	/* Call ipsend to send the datagram */
-
-	ip_send(pkt);
-	restore(mask);
-	return OK;
+	return nrecv;
 }
 
-
 /*------------------------------------------------------------------------
  * udp_release  -  Release a previously-registered UDP slot
  *------------------------------------------------------------------------
@@ -503,21 +661,20 @@ status	udp_release (
 	 uid32	slot			/* Table slot to release	*/
 	)
 {
-	intmask	mask;			/* Saved interrupt mask		*/
 	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
 	struct	netpacket *pkt;		/* pointer to packet being read	*/
-
-	/* Ensure only one process can access the UDP table at a time	*/
-
-	mask = disable();
+	int32	*prev;			/* Link that points to the entry*/
 
 	/* Verify that the slot is valid */
 
 	if ( (slot < 0) || (slot >= UDP_SLOTS) ) {
-		restore(mask);
 		return SYSERR;
 	}
 
+	/* Ensure only one process can access the UDP table at a time	*/
+
+	wait(udpmutex);
+
 	/* Get pointer to table entry */
 
 	udptr = &udptab[slot];
@@ -525,27 +682,359 @@ status	udp_release (
 	/* Verify that the slot has been registered and is valid */
 
 	if (udptr->udstate == UDP_FREE) {
-		restore(mask);
+		signal(udpmutex);
 		return SYSERR;
 	}
 
-	/* Defer rescheduling to prevent freebuf from switching context	*/
+	/* Unlink the entry from its hash chain and free it */
+
+	prev = &udphash[udp_hash(udptr->udlocport, udptr->udremip,
+							udptr->udremport)];
+	while (*prev != slot) {
+		prev = &udptab[*prev].udnext;
+	}
+	*prev = udptr->udnext;
+	udptr->udnext = udpfree;
+	udpfree = slot;
+
+	/* Free the queued packets and wake a process that is waiting	*/
 
-	resched_cntl(DEFER_START);
 	while (udptr->udcount > 0) {
 		pkt = udptr->udqueue[udptr->udhead++];
 		if (udptr->udhead >= UDP_QSIZ) {
 			udptr->udhead = 0;
 		}
-		freebuf((char *)pkt);
+		pb_free(pkt);
 		udptr->udcount--;
 	}
+	if (udptr->udstate == UDP_RECV) {
+		send(udptr->udpid, SYSERR);
+	}
 	udptr->udstate = UDP_FREE;
-	resched_cntl(DEFER_STOP);
-	restore(mask);
+	signal(udpmutex);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * udp_setcksum  -  Choose whether a UDP endpoint computes checksums on
+ *		      output and verifies them on input
+ *------------------------------------------------------------------------
+ */
+status	udp_setcksum (
+	 uid32	slot,			/* Table slot to change		*/
+	 int32	options			/* UDP_CKSUM_TX and/or _RX	*/
+	)
+{
+	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+
+	if ( (slot < 0) || (slot >= UDP_SLOTS) ||
+	     ((options & ~UDP_CKSUM_ALL) != 0) ) {
+		return SYSERR;
+	}
+	wait(udpmutex);
+	udptr = &udptab[slot];
+	if (udptr->udstate == UDP_FREE) {
+		signal(udpmutex);
+		return SYSERR;
+	}
+	udptr->udcksum = options;
+	signal(udpmutex);
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * udp_setdscp  -  Set the DSCP of the datagrams a UDP endpoint sends,
+ *		     which selects their IP output class
+ *------------------------------------------------------------------------
+ */
+status	udp_setdscp (
+	 uid32	slot,			/* Table slot to change		*/
+	 byte	dscp			/* Differentiated services code	*/
+	)
+{
+	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+
+	if ( (slot < 0) || (slot >= UDP_SLOTS) || (dscp >= 64) ) {
+		return SYSERR;
+	}
+	wait(udpmutex);
+	udptr = &udptab[slot];
+	if (udptr->udstate == UDP_FREE) {
+		signal(udpmutex);
+		return SYSERR;
+	}
+	udptr->uddscp = dscp;
+	signal(udpmutex);
 	return OK;
 }
 
+/*------------------------------------------------------------------------
+ * udp_hash  -  Compute the hash bucket for an endpoint key
+ *------------------------------------------------------------------------
+ */
+local	uint32	udp_hash (
+	 uint16	locport,		/* Local UDP protocol port	*/
+	 uint32	remip,			/* Remote IP address or zero	*/
+	 uint16	remport			/* Remote port or zero		*/
+	)
+{
+	return hm_hashint(remip ^ ((uint32)remport << 16) ^ locport) &
+							(UDP_HSIZ - 1);
+}
+
+/*------------------------------------------------------------------------
+ * udp_lookup  -  Find the endpoint registered with exactly the given
+ *		    key (udpmutex must be held)
+ *------------------------------------------------------------------------
+ */
+local	struct	udpentry *udp_lookup (
+	 uint16	locport,		/* Local UDP protocol port	*/
+	 uint32	remip,			/* Remote IP address or zero	*/
+	 uint16	remport			/* Remote port or zero		*/
+	)
+{
+	int32	slot;			/* Index into udptab		*/
+	struct	udpentry *udptr;	/* Pointer to udptab entry	*/
+
+	for (slot = udphash[udp_hash(locport, remip, remport)]; slot >= 0;
+						slot = udptr->udnext) {
+		udptr = &udptab[slot];
+		if ( (udptr->udlocport == locport) &&
+		     (udptr->udremip == remip) &&
+		     (udptr->udremport == remport) ) {
+			return udptr;
+		}
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------
+ * udp_enqueue  -  Add an incoming datagram to the queue of an endpoint
+ *		     and wake a waiting process (udpmutex must be
+ *		     held)
+ *------------------------------------------------------------------------
+ */
+local	void	udp_enqueue (
+	 struct	udpentry *udptr,	/* Endpoint receiving the packet*/
+	 struct	netpacket *pktptr	/* Pointer to the packet	*/
+	)
+{
+	if (udptr->udcount >= UDP_QSIZ) {	/* Queue is full	*/
+		udptr->uddrop++;
+		udpstats.us_qdrop++;
+		pb_free(pktptr);
+		return;
+	}
+
+	udptr->udcount++;
+	udptr->udrecvd++;
+	udptr->udqueue[udptr->udtail++] = pktptr;
+	if (udptr->udtail >= UDP_QSIZ) {
+		udptr->udtail = 0;
+	}
+	if (udptr->udstate == UDP_RECV) {
+		udptr->udstate = UDP_USED;
+		send (udptr->udpid, OK);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * udp_mkpkt  -  Build an outgoing UDP datagram in an empty buffer: copy
+ *		   the data in, computing its checksum in the same pass,
+ *		   then prepend the UDP header and let IP prepend its
+ *		   headers
+ *------------------------------------------------------------------------
+ */
+local	status	udp_mkpkt (
+	 struct	netpacket *pkt,		/* Buffer for the datagram	*/
+	 uint16	locport,		/* Local UDP protocol port	*/
+	 int32	options,		/* Checksum options (UDP_CKSUM_)*/
+	 byte	dscp,			/* DSCP of the datagram		*/
+	 uint32	remip,			/* Remote IP address to use	*/
+	 uint16	remport,		/* Remote protocol port to use	*/
+	 char	*buff,			/* Buffer of UDP data		*/
+	 int32	len			/* Length of data in buffer	*/
+	)
+{
+	char	*dptr;			/* Where the data go		*/
+	uint32	sum;			/* Partial checksum of the data	*/
+	uint16	ck;			/* Checksum (network byte order)*/
+
+	/* Leave room for the headers and copy in the data */
+
+	pb_reserve(pkt, (char *)pkt->net_udpdata - (char *)pkt);
+	dptr = pb_put(pkt, len);
+	if (dptr == (char *)SYSERR) {
+		return SYSERR;
+	}
+	sum = 0;
+	if (options & UDP_CKSUM_TX) {
+		sum = cksum_copy(dptr, buff, len, 0);
+	} else {
+		memcpy(dptr, buff, len);
+	}
+
+	/* Prepend the UDP header, then the IP and Ethernet headers */
+
+	pb_push(pkt, UDP_HDR_LEN);
+	pkt->net_udpsport = locport;	/* Local UDP protocol port	*/
+	pkt->net_udpdport = remport;	/* Remote UDP protocol port	*/
+	pkt->net_udplen = (uint16)(UDP_HDR_LEN+len); /* UDP length	*/
+	pkt->net_udpcksum = 0x0000;	/* No UDP checksum		*/
+	if (ip_push(pkt, IP_UDP, remip) == SYSERR) {
+		return SYSERR;
+	}
+	pkt->net_iptos = dscp << 2;	/* Selects the output class	*/
+
+	/* The pseudo-header is complete, so the checksum can be	*/
+	/*   finished; a computed checksum of zero is sent as all ones	*/
+
+	if (options & UDP_CKSUM_TX) {
+		ck = cksum_fold(cksum_combine(udp_hdrsum(pkt), sum, 0));
+		pkt->net_udpcksum = (ck == 0) ? 0xffff : ck;
+	}
+	return OK;
+}
+
+/*------------------------------------------------------------------------
+ * udp_sendfrags  -  Send a UDP datagram whose data do not fit in one
+ *		       frame: compute the checksum over all of the data,
+ *		       then let IP send the datagram as fragments
+ *------------------------------------------------------------------------
+ */
+local	status	udp_sendfrags (
+	 uint16	locport,		/* Local UDP protocol port	*/
+	 int32	options,		/* Checksum options (UDP_CKSUM_)*/
+	 byte	dscp,			/* DSCP of the datagram		*/
+	 uint32	remip,			/* Remote IP address to use	*/
+	 uint16	remport,		/* Remote protocol port to use	*/
+	 char	*buff,			/* Buffer of UDP data		*/
+	 int32	len			/* Length of data in buffer	*/
+	)
+{
+	uint16	hdr[UDP_HDR_LEN/2];	/* UDP header in host byte order*/
+	uint16	nhdr[UDP_HDR_LEN/2];	/* Header in network byte order	*/
+	uint32	sum;			/* Partial checksum		*/
+	uint16	ck;			/* Checksum (network byte order)*/
+
+	if (len > IP_MAXLEN - IP_HDR_LEN - UDP_HDR_LEN) {
+		return SYSERR;
+	}
+
+	hdr[0] = locport;		/* Local UDP protocol port	*/
+	hdr[1] = remport;		/* Remote UDP protocol port	*/
+	hdr[2] = (uint16)(UDP_HDR_LEN+len); /* UDP length		*/
+	hdr[3] = 0x0000;		/* No UDP checksum		*/
+	if (options & UDP_CKSUM_TX) {
+		nhdr[0] = htons(hdr[0]);
+		nhdr[1] = htons(hdr[1]);
+		nhdr[2] = htons(hdr[2]);
+		nhdr[3] = 0x0000;
+		sum = cksum_pseudo(NetData.ipucast, remip, IP_UDP, hdr[2]);
+		sum = cksum_partial((char *)nhdr, UDP_HDR_LEN, sum);
+		sum = cksum_partial(buff, len, sum);
+		ck = cksum_fold(sum);
+		hdr[3] = (ck == 0) ? 0xffff : ck;
+	}
+	return ip_sendfrags(IP_UDP, remip, dscp << 2, (char *)hdr,
+						UDP_HDR_LEN, buff, len);
+}
+
+/*------------------------------------------------------------------------
+ * udp_hdrsum  -  Compute the partial checksum of the pseudo-header and
+ *		    the UDP header (ports and length in host byte order)
+ *------------------------------------------------------------------------
+ */
+local	uint32	udp_hdrsum (
+	 struct	netpacket *pkt		/* Packet with headers filled in*/
+	)
+{
+	uint64	acc;			/* Sum with carries in top half	*/
+
+	/* The pseudo-header sum can be close to 2^32, so the header	*/
+	/*   words are added in 64 bits and the carries folded back	*/
+
+	acc = (uint64)cksum_pseudo(pkt->net_ipsrc, pkt->net_ipdst, IP_UDP,
+							pkt->net_udplen);
+	acc += htons(pkt->net_udpsport);
+	acc += htons(pkt->net_udpdport);
+	acc += htons(pkt->net_udplen);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	return (uint32)acc;
+}
+
+/*------------------------------------------------------------------------
+ * udp_copyin  -  Copy the data of an incoming datagram to a list of
+ *		    buffers and verify its checksum in the same pass;
+ *		    return the number of bytes copied, or SYSERR if the
+ *		    checksum is wrong
+ *------------------------------------------------------------------------
+ */
+local	int32	udp_copyin (
+	 struct	udpentry *udptr,	/* Endpoint receiving the data	*/
+	 struct	netpacket *pkt,		/* Datagram (host byte order)	*/
+	 struct	udpiov *iov,		/* Buffers to hold UDP data	*/
+	 int32	niov			/* Number of buffers (0 to only	*/
+					/*   verify the checksum)	*/
+	)
+{
+	int32	msglen;			/* Length of UDP data in packet	*/
+	int32	left;			/* Data not yet copied		*/
+	int32	n;			/* Bytes copied to one buffer	*/
+	char	*dptr;			/* Next data byte to copy	*/
+	bool8	verify;			/* Should the checksum be tested*/
+	uint32	sum;			/* Partial checksum		*/
+
+	msglen = pb_len(pkt);
+
+	/* A zero checksum field means the sender did not compute one */
+
+	verify = (udptr->udcksum & UDP_CKSUM_RX) && (pkt->net_udpcksum != 0);
+	if (pkt->net_udpcksum == 0) {
+		wait(udpmutex);
+		udpstats.us_nocksum++;
+		signal(udpmutex);
+	}
+
+	/* Each buffer is summed as it is filled; a buffer of odd	*/
+	/*   length shifts the data that follow it to the other half	*/
+	/*   of their words, which cksum_combine accounts for		*/
+
+	sum = verify ? udp_hdrsum(pkt) : 0;
+	dptr = pb_data(pkt);
+	left = msglen;
+	for (; (niov > 0) && (left > 0); iov++, niov--) {
+		n = (iov->iov_len < left) ? iov->iov_len : left;
+		if (n <= 0) {
+			continue;
+		}
+		if (verify) {
+			sum = cksum_combine(sum, cksum_copy(iov->iov_base,
+				dptr, n, 0), msglen - left);
+		} else {
+			memcpy(iov->iov_base, dptr, n);
+		}
+		dptr += n;
+		left -= n;
+	}
+	if (!verify) {
+		return msglen - left;
+	}
+
+	sum = cksum_combine(sum, cksum_partial(dptr, left, 0),
+							msglen - left);
+	sum = cksum_partial((char *)&pkt->net_udpcksum, 2, sum);
+	if (cksum_fold(sum) != 0) {
+		wait(udpmutex);
+		udptr->udckdrop++;
+		udpstats.us_ckdrop++;
+		signal(udpmutex);
+		return SYSERR;
+	}
+	return msglen - left;
+}
+
 /*------------------------------------------------------------------------
  * udp_ntoh  -  Convert UDP header fields from net to host byte order
  *------------------------------------------------------------------------
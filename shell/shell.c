@@ -14,16 +14,21 @@ const	struct	cmdent	cmdtab[] = {
 	{"clear",	TRUE,	xsh_clear},
 	{"date",	FALSE,	xsh_date},
 	{"devdump",	FALSE,	xsh_devdump},
+	{"dns",		FALSE,	xsh_dns},
 	{"echo",	FALSE,	xsh_echo},
+	{"eloop",	FALSE,	xsh_eloop},
 	{"exit",	TRUE,	xsh_exit},
 	{"help",	FALSE,	xsh_help},
 	{"kill",	TRUE,	xsh_kill},
+	{"membench",	FALSE,	xsh_membench},
 	{"memdump",	FALSE,	xsh_memdump},
 	{"memstat",	FALSE,	xsh_memstat},
 	{"netinfo",	FALSE,	xsh_netinfo},
 	{"ping",	FALSE,	xsh_ping},
 	{"ps",		FALSE,	xsh_ps},
 	{"sleep",	FALSE,	xsh_sleep},
+	{"tcptest",	FALSE,	xsh_tcptest},
+	{"tftp",	FALSE,	xsh_tftp},
 	{"udp",		FALSE,	xsh_udpdump},
 	{"udpecho",	FALSE,	xsh_udpecho},
 	{"udpeserver",	FALSE,	xsh_udpeserver},
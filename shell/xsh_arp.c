@@ -5,23 +5,68 @@
 #include <string.h>
 
 static	void	arp_dmp();
+static	status	arp_mac(char *, byte *);
 /*------------------------------------------------------------------------
- * xsh_arp - display the current ARP cache for an interface
+ * xsh_arp - display the current ARP cache for an interface, or add or
+ *		delete a static entry
  *------------------------------------------------------------------------
  */
 shellcmd xsh_arp(int nargs, char *args[])
 {
+	uint32	ipaddr;			/* IP address of an entry	*/
+	byte	mac[ETH_ADDR_LEN];	/* Ethernet address of an entry	*/
+
 	/* For argument '--help', emit help about the 'arp' command	*/
 
 	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
-		printf("Use: %s\n\n", args[0]);
+		printf("Use: %s [-s IP MAC | -d IP]\n\n", args[0]);
 		printf("Description:\n");
 		printf("\tDisplays information from the ARP cache\n");
 		printf("Options:\n");
-		printf("\t--help\t display this help and exit\n");
+		printf("\t-s IP MAC\t add a static entry (MAC is ");
+		printf("xx:xx:xx:xx:xx:xx)\n");
+		printf("\t-d IP\t\t delete the entry for IP\n");
+		printf("\t--help\t\t display this help and exit\n");
+		return 0;
+	}
+
+	/* Add a static entry */
+
+	if (nargs == 4 && strncmp(args[1], "-s", 3) == 0) {
+		if ( (dot2ip(args[2], &ipaddr) == SYSERR) ||
+		     (arp_mac(args[3], mac) == SYSERR) ) {
+			fprintf(stderr, "%s: invalid address\n", args[0]);
+			return 1;
+		}
+		if (arp_add(ipaddr, mac) == SYSERR) {
+			fprintf(stderr, "%s: ARP cache is full\n", args[0]);
+			return 1;
+		}
 		return 0;
 	}
 
+	/* Delete an entry */
+
+	if (nargs == 3 && strncmp(args[1], "-d", 3) == 0) {
+		if (dot2ip(args[2], &ipaddr) == SYSERR) {
+			fprintf(stderr, "%s: invalid address\n", args[0]);
+			return 1;
+		}
+		if (arp_delete(ipaddr) == SYSERR) {
+			fprintf(stderr, "%s: no entry for %s\n", args[0],
+								args[2]);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (nargs > 1) {
+		fprintf(stderr, "%s: invalid arguments\n", args[0]);
+		fprintf(stderr, "Try '%s --help' for more information\n",
+				args[0]);
+		return 1;
+	}
+
 	/* Dump the Entire ARP cache */
 	printf("\n");
 	arp_dmp();
@@ -29,6 +74,42 @@ shellcmd xsh_arp(int nargs, char *args[])
 	return 0;
 }
 
+/*------------------------------------------------------------------------
+ * arp_mac - convert a string of the form xx:xx:xx:xx:xx:xx to a MAC
+ *------------------------------------------------------------------------
+ */
+static	status	arp_mac (
+	  char	*str,			/* string to convert		*/
+	  byte	*mac			/* location for the address	*/
+	)
+{
+	int32	i, j;			/* index of byte and of digit	*/
+	int32	val;			/* value of one byte		*/
+	char	ch;			/* next character		*/
+
+	for (i = 0; i < ETH_ADDR_LEN; i++) {
+		val = 0;
+		for (j = 0; j < 2; j++) {
+			ch = *str++;
+			if (ch >= '0' && ch <= '9') {
+				val = 16 * val + (ch - '0');
+			} else if (ch >= 'a' && ch <= 'f') {
+				val = 16 * val + (ch - 'a' + 10);
+			} else if (ch >= 'A' && ch <= 'F') {
+				val = 16 * val + (ch - 'A' + 10);
+			} else {
+				return SYSERR;
+			}
+		}
+		mac[i] = (byte)val;
+		ch = *str++;
+		if (ch != ((i < ETH_ADDR_LEN - 1) ? ':' : NULLCH)) {
+			return SYSERR;
+		}
+	}
+	return OK;
+}
+
 
 /*------------------------------------------------------------------------
  * arp_dmp - dump the ARP cache
@@ -42,8 +123,8 @@ static	void arp_dmp ()
 	/* Print entries from the ARP table */
 
 	printf("ARP cache:\n");
-	printf("   State Pid    IP Address    Hardware Address\n");
-	printf("   ----- --- --------------- -----------------\n");
+	printf("   State  TTL Q    IP Address    Hardware Address\n");
+	printf("   ----- ---- - --------------- -----------------\n");
 	for (i = 0; i < ARP_SIZ; i++) {
 		arptr = &arpcache[i];
 		if (arptr->arstate == AR_FREE) {
@@ -52,24 +133,32 @@ static	void arp_dmp ()
 		switch(arptr->arstate) {
 		    case AR_PENDING:	printf("   PEND "); break;
 		    case AR_RESOLVED:	printf("   RESLV"); break;
+		    case AR_STATIC:	printf("   STATC"); break;
 		    default:		printf("   ?????"); break;
 		}
-		if (arptr->arstate == AR_PENDING) {
-			printf("%4d ", arptr->arpid);
+		if (arptr->arstate == AR_RESOLVED) {
+			printf(" %4d", arptr->artime / 1000);
 		} else {
 			printf("     ");
 		}
+		printf(" %1d ", arptr->arcount);
 		printf("%3d.", (arptr->arpaddr & 0xFF000000) >> 24);
 		printf("%3d.", (arptr->arpaddr & 0x00FF0000) >> 16);
 		printf("%3d.", (arptr->arpaddr & 0x0000FF00) >> 8);
 		printf("%3d",  (arptr->arpaddr & 0x000000FF));
 
+		if (arptr->arstate == AR_PENDING) {
+			printf(" (incomplete)\n");
+			continue;
+		}
 		printf(" %02X", arptr->arhaddr[0]);
 		for (j = 1; j < ARP_HALEN; j++) {
 			printf(":%02X", arptr->arhaddr[j]);
 		}
 		printf("\n");
 	}
+	printf("\nRequests sent: %d   Failed: %d   Packets dropped: %d\n",
+		arpstats.as_reqsent, arpstats.as_fail, arpstats.as_drop);
 	printf("\n");
 	return;
 }
@@ -0,0 +1,127 @@
+/* xsh_dns.c - xsh_dns */
+
+#include <xinu.h>
+#include <stdio.h>
+#include <string.h>
+#include <dns.h>
+
+static	void	dns_dmp();
+
+/*------------------------------------------------------------------------
+ * xsh_dns - display the DNS cache, flush it, or look up a name
+ *------------------------------------------------------------------------
+ */
+shellcmd xsh_dns(int nargs, char *args[])
+{
+	uint32	ipaddr;			/* Address of a name		*/
+	char	str[20];		/* Address in dotted decimal	*/
+
+	/* For argument '--help', emit help about the 'dns' command	*/
+
+	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
+		printf("Use: %s [NAME | -f [NAME]]\n\n", args[0]);
+		printf("Description:\n");
+		printf("\tDisplays the DNS cache, or looks up a name\n");
+		printf("Options:\n");
+		printf("\tNAME\t\t look up NAME and print its address\n");
+		printf("\t-f [NAME]\t remove NAME (or every name) from the ");
+		printf("cache\n");
+		printf("\t--help\t\t display this help and exit\n");
+		return 0;
+	}
+
+	/* Flush the cache or one name */
+
+	if ( (nargs == 2 || nargs == 3) && strncmp(args[1], "-f", 3) == 0) {
+		if (dns_flush((nargs == 3) ? args[2] : NULL) == SYSERR) {
+			fprintf(stderr, "%s: %s is not cached\n", args[0],
+								args[2]);
+			return 1;
+		}
+		return 0;
+	}
+
+	/* Look up a name */
+
+	if (nargs == 2) {
+		ipaddr = dnslookup(args[1]);
+		if (ipaddr == (uint32)SYSERR) {
+			fprintf(stderr, "%s: cannot resolve %s\n", args[0],
+								args[1]);
+			return 1;
+		}
+		sprintf(str, "%d.%d.%d.%d", (ipaddr >> 24) & 0xff,
+			(ipaddr >> 16) & 0xff, (ipaddr >> 8) & 0xff,
+			ipaddr & 0xff);
+		printf("%s is %s\n", args[1], str);
+		return 0;
+	}
+
+	if (nargs > 1) {
+		fprintf(stderr, "%s: invalid arguments\n", args[0]);
+		fprintf(stderr, "Try '%s --help' for more information\n",
+				args[0]);
+		return 1;
+	}
+
+	/* Dump the entire DNS cache */
+	printf("\n");
+	dns_dmp();
+
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * dns_dmp - dump the DNS cache, the queries in flight and the counters
+ *------------------------------------------------------------------------
+ */
+static	void dns_dmp ()
+{
+	int32	i;			/* index into the tables	*/
+	struct	dnscent	*dcptr;		/* pointer to entry in cache	*/
+	struct	dnsquery *dqptr;	/* pointer to a query		*/
+	int32	ttl;			/* seconds until entry expires	*/
+	char	str[20];		/* address in dotted decimal	*/
+
+	printf("DNS cache:\n");
+	printf("   State    TTL  Hits    IP Address    Name\n");
+	printf("   ------ ----- ----- --------------- ----\n");
+	for (i = 0; i < DNS_CACHESIZ; i++) {
+		dcptr = &dnscache[i];
+		if (dcptr->dc_state == DNSC_FREE) {
+			continue;
+		}
+		ttl = (int32)(dcptr->dc_expire - clktime);
+		if (ttl <= 0) {
+			continue;
+		}
+		if (dcptr->dc_state == DNSC_ADDR) {
+			sprintf(str, "%d.%d.%d.%d",
+				(dcptr->dc_addr >> 24) & 0xff,
+				(dcptr->dc_addr >> 16) & 0xff,
+				(dcptr->dc_addr >> 8) & 0xff,
+				dcptr->dc_addr & 0xff);
+			printf("   ADDR  ");
+		} else {
+			strncpy(str, "-", sizeof(str));
+			printf("   NONAME");
+		}
+		printf(" %5d %5d %-15s %s\n", ttl, dcptr->dc_hits, str,
+							dcptr->dc_name);
+	}
+
+	for (i = 0; i < DNS_QUERIES; i++) {
+		dqptr = &dnsqtab[i];
+		if (dqptr->dq_state == DNSQ_WAIT) {
+			printf("   Query %d for %s: try %d, %d waiting\n",
+				dqptr->dq_id, dqptr->dq_name,
+				dqptr->dq_tries, dqptr->dq_nwait);
+		}
+	}
+
+	printf("\n%u hits, %u negative hits, %u misses, %u shared\n",
+		dnsstats.ds_hits, dnsstats.ds_neghits, dnsstats.ds_misses,
+		dnsstats.ds_joined);
+	printf("%u queries sent, %u timed out, %u responses ignored\n",
+		dnsstats.ds_sent, dnsstats.ds_timeouts, dnsstats.ds_badresp);
+}
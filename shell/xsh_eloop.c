@@ -0,0 +1,247 @@
+/* xsh_eloop.c - xsh_eloop, eloop_pass */
+
+#include <xinu.h>
+#include <stdio.h>
+#include <string.h>
+
+extern	int	atoi(char *);
+
+#define	ELOOP_TESTPORT	7777		/* UDP port the frames go to	*/
+#define	ELOOP_TESTCOUNT	1000		/* Default number of frames	*/
+#define	ELOOP_TESTSIZE	1024		/* Default bytes of UDP data	*/
+#define	ELOOP_TESTWAIT	1000		/* Longest wait for a frame (ms)*/
+
+local	int32	eloop_pass(uid32, struct netpacket *, int32, int32, int32,
+					int32, bool8, int32 *, int32 *);
+
+/*------------------------------------------------------------------------
+ * xsh_eloop - shell command that pushes UDP frames through the loopback
+ *		 Ethernet device: a netin process reads ELOOP, so each
+ *		 frame written takes the receive path (input queues,
+ *		 ip_in, udp_in) without the PHY or the wire; frames can
+ *		 be dropped on the way, and the last one is held and
+ *		 read back to check the hold buffer.  The frames are
+ *		 received in place with udp_recvbuf and, with -c, a
+ *		 second time with the copying udp_recv to compare
+ *------------------------------------------------------------------------
+ */
+shellcmd xsh_eloop(int nargs, char *args[])
+{
+	struct	netpacket pkt;		/* Frame to write		*/
+	char	held[ELOOP_BUFSIZE];	/* Frame read from the hold	*/
+	int32	count;			/* Frames to write		*/
+	int32	size;			/* Bytes of UDP data per frame	*/
+	int32	dropevery;		/* Drop every Nth frame (0: no)	*/
+	int32	framelen;		/* Bytes in a frame		*/
+	uid32	slot;			/* UDP endpoint			*/
+	pid32	reader;			/* netin process reading ELOOP	*/
+	bool8	compare;		/* Also receive with udp_recv	*/
+	bool8	copy;			/* This pass uses udp_recv	*/
+	bool8	intact;			/* Every pass got every frame	*/
+	int32	written;		/* Frames written		*/
+	int32	expected;		/* Frames that should arrive	*/
+	int32	arrived;		/* Frames that arrived intact	*/
+	int32	i;			/* Index of a frame		*/
+	uint32	start;			/* Time the first frame went	*/
+	uint32	elapsed;		/* Duration in msec		*/
+	int32	retval;			/* Return value			*/
+
+	/* For argument '--help', emit help about the 'eloop' command	*/
+
+	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
+		printf("Use: %s [-c] [COUNT [SIZE [DROP]]]\n\n", args[0]);
+		printf("Description:\n");
+		printf("\tWrite UDP frames to the loopback Ethernet device\n");
+		printf("\tELOOP, receive them through the network stack\n");
+		printf("\tand report the rate\n");
+		printf("Options:\n");
+		printf("\t-c:\talso receive them with the copying udp_recv\n");
+		printf("\t\tand report both rates\n");
+		printf("\tCOUNT:\tnumber of frames (default %d)\n",
+							ELOOP_TESTCOUNT);
+		printf("\tSIZE:\tbytes of UDP data (default %d)\n",
+							ELOOP_TESTSIZE);
+		printf("\tDROP:\thave ELOOP drop every DROPth frame\n");
+		printf("\t--help\t display this help and exit\n");
+		return 0;
+	}
+	compare = (nargs >= 2) && (strncmp(args[1], "-c", 3) == 0);
+	if (compare) {			/* Drop -c, keeping the name	*/
+		args[1] = args[0];
+		args++;
+		nargs--;
+	}
+	if (nargs > 4) {
+		fprintf(stderr, "%s: invalid number of argument(s)\n", args[0]);
+		fprintf(stderr, "Try '%s --help' for more information\n",
+				args[0]);
+		return 1;
+	}
+	count = (nargs >= 2) ? atoi(args[1]) : ELOOP_TESTCOUNT;
+	size = (nargs >= 3) ? atoi(args[2]) : ELOOP_TESTSIZE;
+	dropevery = (nargs == 4) ? atoi(args[3]) : 0;
+	if ( (count <= 0) || (size < 0) || (size > UDP_MAXDATA) ||
+	     (dropevery < 0) ) {
+		fprintf(stderr, "%s: invalid argument\n", args[0]);
+		return 1;
+	}
+	if (!NetData.ipvalid) {
+		fprintf(stderr, "%s: no IP address\n", args[0]);
+		return 1;
+	}
+
+	/* Build a frame from this host to itself in network byte order */
+
+	framelen = ETH_HDR_LEN + IP_HDR_LEN + UDP_HDR_LEN + size;
+	memcpy(pkt.net_ethdst, NetData.ethucast, ETH_ADDR_LEN);
+	memcpy(pkt.net_ethsrc, NetData.ethucast, ETH_ADDR_LEN);
+	pkt.net_ethtype = htons(ETH_IP);
+	pkt.net_ipvh = 0x45;
+	pkt.net_iptos = 0x00;
+	pkt.net_iplen = htons(IP_HDR_LEN + UDP_HDR_LEN + size);
+	pkt.net_ipid = 0;
+	pkt.net_ipfrag = 0;
+	pkt.net_ipttl = 0xff;
+	pkt.net_ipproto = IP_UDP;
+	pkt.net_ipcksum = 0;
+	pkt.net_ipsrc = htonl(NetData.ipucast);
+	pkt.net_ipdst = htonl(NetData.ipucast);
+	pkt.net_ipcksum = cksum((char *)&pkt.net_ipvh, IP_HDR_LEN);
+	pkt.net_udpsport = htons(ELOOP_TESTPORT);
+	pkt.net_udpdport = htons(ELOOP_TESTPORT);
+	pkt.net_udplen = htons(UDP_HDR_LEN + size);
+	pkt.net_udpcksum = 0;		/* No UDP checksum		*/
+	for (i = 0; i < size; i++) {
+		pkt.net_udpdata[i] = (byte)i;
+	}
+
+	/* Open the device, register the port and start a netin	*/
+	/*   process that reads the device until it is closed	*/
+
+	if (open(ELOOP, NULL, NULL) == SYSERR) {
+		fprintf(stderr, "%s: cannot open ELOOP\n", args[0]);
+		return 1;
+	}
+	slot = udp_register(0, 0, ELOOP_TESTPORT);
+	if (slot == SYSERR) {
+		fprintf(stderr, "%s: cannot register UDP port %d\n",
+					args[0], ELOOP_TESTPORT);
+		close(ELOOP);
+		return 1;
+	}
+	reader = create(netin, NETSTK, NETPRIO, "netloop", 1, ELOOP);
+	if (reader == SYSERR) {
+		udp_release(slot);
+		close(ELOOP);
+		return 1;
+	}
+	resume(reader);
+
+	/* Receive the frames in place and, to compare, with a copy	*/
+
+	intact = TRUE;
+	for (copy = FALSE; copy <= compare; copy++) {
+		start = clkms();
+		arrived = eloop_pass(slot, &pkt, framelen, size, count,
+					dropevery, copy, &written, &expected);
+		elapsed = clkms() - start;
+		if (elapsed == 0) {
+			elapsed = 1;
+		}
+		printf("%s: %d frames written, %d dropped by ELOOP, "
+			"%d of %d arrived intact\n",
+			copy ? "udp_recv" : "udp_recvbuf", written,
+			written - expected, arrived, expected);
+		printf("%d ms (%d frames/s, %d KB/s of UDP data)\n", elapsed,
+			(int32)((uint64)arrived * 1000 / elapsed),
+			(int32)(((uint64)arrived * size * 1000 / elapsed) /
+									1024));
+		if (arrived != expected) {
+			intact = FALSE;
+		}
+	}
+
+	/* Hold one frame and read it back from the hold buffer */
+
+	control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_HOLDNXT, 0);
+	write(ELOOP, (char *)&pkt, framelen);
+	retval = control(ELOOP, ELOOP_CTRL_GETHOLD, (int32)held, sizeof(held));
+	if ( (retval == framelen) &&
+	     (memcmp(held, (char *)&pkt, framelen) == 0) ) {
+		printf("Held frame read back intact\n");
+	} else {
+		printf("Held frame was not read back intact\n");
+	}
+
+	/* Closing the device ends the netin process that reads it */
+
+	udp_release(slot);
+	close(ELOOP);
+	return intact ? 0 : 1;
+}
+
+/*------------------------------------------------------------------------
+ * eloop_pass - write frames to ELOOP and receive them, with at most
+ *		UDP_QSIZ in flight so the endpoint's queue never
+ *		overflows; return the number that arrived intact
+ *------------------------------------------------------------------------
+ */
+local	int32	eloop_pass(
+	  uid32	slot,			/* UDP endpoint			*/
+	  struct netpacket *pkt,	/* Frame to write		*/
+	  int32	framelen,		/* Bytes in the frame		*/
+	  int32	size,			/* Bytes of UDP data		*/
+	  int32	count,			/* Frames to write		*/
+	  int32	dropevery,		/* Drop every Nth frame (0: no)	*/
+	  bool8	copy,			/* Receive with udp_recv	*/
+	  int32	*written,		/* Frames written		*/
+	  int32	*expected		/* Frames that should arrive	*/
+	)
+{
+	char	buf[UDP_MAXDATA];	/* Data copied by udp_recv	*/
+	struct	netpacket *rpkt;	/* Frame received in place	*/
+	char	*data;			/* UDP data of the frame	*/
+	int32	len;			/* Length of the UDP data	*/
+	int32	inflight;		/* Frames written, not received	*/
+	int32	arrived;		/* Frames that arrived intact	*/
+	int32	i;			/* Index of a frame		*/
+
+	inflight = *expected = arrived = 0;
+	for (i = 0; i < count; i++) {
+		if ( (dropevery > 0) && ((i % dropevery) == dropevery - 1) ) {
+			control(ELOOP, ELOOP_CTRL_SETFLAG, ELOOP_FLAG_DROPNXT,
+									0);
+		} else {
+			(*expected)++;
+			inflight++;
+		}
+		if (write(ELOOP, (char *)pkt, framelen) == SYSERR) {
+			fprintf(stderr, "eloop: write failed\n");
+			break;
+		}
+		while ( (inflight >= UDP_QSIZ) ||
+			((i == count - 1) && (inflight > 0)) ) {
+			inflight--;
+			if (copy) {
+				len = udp_recv(slot, buf, sizeof(buf),
+							ELOOP_TESTWAIT);
+				if ( (len == size) && (memcmp(buf,
+					     pkt->net_udpdata, size) == 0) ) {
+					arrived++;
+				}
+				continue;
+			}
+			if (udp_recvbuf(slot, &rpkt, &data, &len,
+						ELOOP_TESTWAIT) != OK) {
+				continue;
+			}
+			if ( (len == size) &&
+			     (memcmp(data, pkt->net_udpdata, size) == 0) ) {
+				arrived++;
+			}
+			udp_releasebuf(rpkt);
+		}
+	}
+	*written = i;
+	return arrived;
+}
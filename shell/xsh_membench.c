@@ -0,0 +1,180 @@
+/* xsh_membench.c - xsh_membench, membench_rate, membench_switcher */
+
+#include <xinu.h>
+#include <stdio.h>
+#include <string.h>
+
+extern	int	atoi(char *);
+
+#define	MEMBENCH_KB	1024		/* Default buffer size (4 times	*/
+					/*   the AM335x's 256 KB L2)	*/
+#define	MEMBENCH_BYTES	(64*1024*1024)	/* Bytes moved per measurement	*/
+#define	MEMBENCH_YIELDS	100000		/* Yields made by each process	*/
+
+local	void	membench_rate(char *, uint32, uint32);
+local	process	membench_switcher(sid32, sid32, int32);
+
+/*------------------------------------------------------------------------
+ * xsh_membench - shell command that times memcpy and memset over a
+ *		    buffer larger than the L2 cache, and the cost of a
+ *		    context switch between two processes that yield to
+ *		    each other, so the effect of the cache settings can
+ *		    be measured on a board
+ *------------------------------------------------------------------------
+ */
+shellcmd xsh_membench(int nargs, char *args[])
+{
+	int32	kbytes;			/* Buffer size in KB		*/
+	uint32	nbytes;			/* Buffer size in bytes		*/
+	char	*src, *dst;		/* Buffers			*/
+	uint32	rounds, r;		/* Passes over the buffers	*/
+	uint32	start;			/* Time a measurement started	*/
+	uint32	elapsed;		/* Duration in msec		*/
+	sid32	go;			/* Starts the switchers		*/
+	sid32	done;			/* Signaled as each one ends	*/
+	pid32	pid1, pid2;		/* Switching processes		*/
+	pri16	prio;			/* Priority of the switchers	*/
+
+	/* For argument '--help', emit help about the command	*/
+
+	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
+		printf("Use: %s [KBYTES]\n\n", args[0]);
+		printf("Description:\n");
+		printf("\tTime memcpy and memset over a buffer larger\n");
+		printf("\tthan the L2 cache, and a context switch between\n");
+		printf("\ttwo processes of equal priority that yield to\n");
+		printf("\teach other\n");
+		printf("Options:\n");
+		printf("\tKBYTES:\tbuffer size in KB (default %d)\n",
+							MEMBENCH_KB);
+		printf("\t--help\t display this help and exit\n");
+		return 0;
+	}
+
+	/* Parse the arguments */
+
+	kbytes = MEMBENCH_KB;
+	if (nargs == 2) {
+		kbytes = atoi(args[1]);
+	} else if (nargs > 2) {
+		fprintf(stderr, "%s: invalid number of argument(s)\n", args[0]);
+		fprintf(stderr, "Try '%s --help' for more information\n",
+				args[0]);
+		return 1;
+	}
+	if ( (kbytes <= 0) || (kbytes > MEMBENCH_BYTES / 1024) ) {
+		fprintf(stderr, "%s: invalid buffer size\n", args[0]);
+		return 1;
+	}
+	nbytes = (uint32)kbytes * 1024;
+
+	/* Bandwidth: each measurement moves MEMBENCH_BYTES in total */
+
+	src = getmem(nbytes);
+	if ((int32)src == SYSERR) {
+		fprintf(stderr, "%s: out of memory\n", args[0]);
+		return 1;
+	}
+	dst = getmem(nbytes);
+	if ((int32)dst == SYSERR) {
+		freemem(src, nbytes);
+		fprintf(stderr, "%s: out of memory\n", args[0]);
+		return 1;
+	}
+	memset(src, 0x5a, nbytes);
+	memset(dst, 0xa5, nbytes);
+	rounds = MEMBENCH_BYTES / nbytes;
+
+	start = clkms();
+	for (r = 0; r < rounds; r++) {
+		memcpy(dst, src, nbytes);
+	}
+	membench_rate("memcpy", rounds * nbytes, clkms() - start);
+
+	start = clkms();
+	for (r = 0; r < rounds; r++) {
+		memset(dst, r, nbytes);
+	}
+	membench_rate("memset", rounds * nbytes, clkms() - start);
+
+	freemem(dst, nbytes);
+	freemem(src, nbytes);
+
+	/* Context switch: two processes above the shell wait for	*/
+	/*   signaln to make both ready at once, then yield to each	*/
+	/*   other; the shell runs again only when both have ended	*/
+
+	go = semcreate(0);
+	done = semcreate(0);
+	if ( ((int32)go == SYSERR) || ((int32)done == SYSERR) ) {
+		fprintf(stderr, "%s: cannot create semaphores\n", args[0]);
+		return 1;
+	}
+	prio = getprio(getpid()) + 1;
+	pid1 = create(membench_switcher, 1024, prio, "switch1", 3,
+					go, done, MEMBENCH_YIELDS);
+	pid2 = create(membench_switcher, 1024, prio, "switch2", 3,
+					go, done, MEMBENCH_YIELDS);
+	if ( (pid1 == SYSERR) || (pid2 == SYSERR) ) {
+		if (pid1 != SYSERR) {
+			kill(pid1);
+		}
+		semdelete(done);
+		semdelete(go);
+		fprintf(stderr, "%s: cannot create processes\n", args[0]);
+		return 1;
+	}
+	resume(pid1);
+	resume(pid2);
+
+	start = clkms();
+	signaln(go, 2);
+	wait(done);
+	wait(done);
+	elapsed = clkms() - start;
+	semdelete(done);
+	semdelete(go);
+
+	printf("%-8s %d switches in %d ms (%d ns each)\n", "yield",
+		2 * MEMBENCH_YIELDS, elapsed,
+		(int32)((uint64)elapsed * 1000000 / (2 * MEMBENCH_YIELDS)));
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * membench_rate - print the rate of one bandwidth measurement
+ *------------------------------------------------------------------------
+ */
+local	void	membench_rate(
+	  char	*name,			/* Function that was timed	*/
+	  uint32 nbytes,		/* Bytes it moved		*/
+	  uint32 elapsed		/* Duration in msec		*/
+	)
+{
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+	printf("%-8s %d bytes in %d ms (%d MB/s)\n", name, nbytes, elapsed,
+			(int32)((uint64)nbytes * 1000 / elapsed / 1000000));
+}
+
+/*------------------------------------------------------------------------
+ * membench_switcher - wait to be started, yield the CPU a number of
+ *			 times, then signal the shell
+ *------------------------------------------------------------------------
+ */
+local	process	membench_switcher(
+	  sid32	go,			/* Semaphore to start on	*/
+	  sid32	done,			/* Semaphore to signal		*/
+	  int32	nyields			/* Number of yields		*/
+	)
+{
+	int32	i;			/* Counts yields		*/
+
+	wait(go);
+	for (i = 0; i < nyields; i++) {
+		yield();
+	}
+	signal(done);
+	return OK;
+}
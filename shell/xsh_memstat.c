@@ -6,6 +6,7 @@
 
 static	void	printMemUse(void);
 static	void	printFreeList(void);
+static	void	printOwners(void);
 
 /*------------------------------------------------------------------------
  * xsh_memstat - Print statistics about memory use and dump the free list
@@ -17,15 +18,24 @@ shellcmd xsh_memstat(int nargs, char *args[])
 	/* For argument '--help', emit help about the 'memstat' command	*/
 
 	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
-		printf("use: %s \n\n", args[0]);
+		printf("use: %s [--owners]\n\n", args[0]);
 		printf("Description:\n");
 		printf("\tDisplays the current memory use and prints the\n");
 		printf("\tfree list.\n");
 		printf("Options:\n");
+		printf("\t--owners\tsummarize allocated blocks by call\n");
+		printf("\t\t\tsite and process (needs MEMTRACK)\n");
 		printf("\t--help\t\tdisplay this help and exit\n");
 		return 0;
 	}
 
+	/* For argument '--owners', summarize who holds the heap	*/
+
+	if (nargs == 2 && strncmp(args[1], "--owners", 9) == 0) {
+		printOwners();
+		return 0;
+	}
+
 	/* Check for valid number of arguments */
 
 	if (nargs > 1) {
@@ -64,6 +74,68 @@ static void printFreeList(void)
 	printf("\n");
 }
 
+/*------------------------------------------------------------------------
+ * printOwners - Summarize allocated blocks by call site and process
+ *------------------------------------------------------------------------
+ */
+static void printOwners(void)
+{
+#ifdef MEMTRACK
+	int32	i, j;			/* Indexes into tracking table	*/
+	int32	nblks;			/* Blocks for one site and pid	*/
+	uint32	nbytes;			/* Bytes for one site and pid	*/
+	uint32	total = 0;		/* Total bytes tracked		*/
+	struct	memtrack *mtptr;	/* Entry that starts a group	*/
+	struct	memtrack *other;	/* Entry compared to the group	*/
+
+	printf("Call site   Pid  Kind   Blocks       Bytes\n");
+	printf("----------  ---  -----  ------  ----------\n");
+
+	/* Print each (call site, pid) pair once, at its first entry	*/
+
+	for (i = 0; i < MT_NENT; i++) {
+		mtptr = &memtrktab[i];
+		if (mtptr->mtaddr == NULL) {
+			continue;
+		}
+		for (j = 0; j < i; j++) {
+			other = &memtrktab[j];
+			if (other->mtaddr != NULL && other->mtpc == mtptr->mtpc
+					&& other->mtpid == mtptr->mtpid) {
+				break;
+			}
+		}
+		if (j < i) {		/* Group was already printed	*/
+			continue;
+		}
+		nblks = 0;
+		nbytes = 0;
+		for (j = i; j < MT_NENT; j++) {
+			other = &memtrktab[j];
+			if (other->mtaddr != NULL && other->mtpc == mtptr->mtpc
+					&& other->mtpid == mtptr->mtpid) {
+				nblks++;
+				nbytes += other->mtlength;
+			}
+		}
+		printf("0x%08x  %3d  %s  %6d  %10d\n", mtptr->mtpc,
+			mtptr->mtpid,
+			mtptr->mtkind == MT_STACK ? "stack" : "heap ",
+			nblks, nbytes);
+		total += nbytes;
+	}
+	printf("%d bytes tracked", total);
+	if (mtdropped > 0) {
+		printf(", %d allocations not tracked (table full)",
+			mtdropped);
+	}
+	printf("\n");
+#else
+	fprintf(stderr, "memstat: memory tracking is not configured\n");
+	fprintf(stderr, "Define MEMTRACK in the Configuration file\n");
+#endif
+}
+
 extern void start(void);
 extern void *_end;
 
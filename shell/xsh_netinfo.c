@@ -19,6 +19,12 @@ shellcmd xsh_netinfo(int nargs, char *args[]) {
 	uint32	dserver;		/* DNS server address in binary	*/
 	char	str[40];		/* Temporary used for formatting*/
 	uint32	ipmask;			/* Subnet mask in binary	*/
+	struct	ethstats estats;	/* Counters of the Ethernet	*/
+	uint64	ipp;			/* Rx interrupts per 100 pkts.	*/
+	struct	netiq	*niqptr;	/* Ptr to an input queue	*/
+	struct	ipoclass *ocptr;	/* Ptr to an output class	*/
+	int32	i;			/* Index into netiqs, classes	*/
+	int32	n;			/* TCP slots in use		*/
 
 	/* Output info for '--help' argument */
 
@@ -140,5 +146,73 @@ shellcmd xsh_netinfo(int nargs, char *args[]) {
 	0xff & NetData.ethbcast[4],
 	0xff & NetData.ethbcast[5]);
 
+	/* Ethernet receive counters, with interrupts per packet to	*/
+	/*	show how well interrupts are mitigated under load	*/
+
+	if (control(ETHER0, ETH_CTRL_STATS, (int32)&estats, 0) == SYSERR) {
+		return OK;
+	}
+	printf("   %-16s  %u\n", "Rx packets:", estats.es_rxpkts);
+	printf("   %-16s  %u", "Rx interrupts:", estats.es_rxirq);
+	if (estats.es_rxpkts > 0) {
+		ipp = ((uint64)estats.es_rxirq * 100) / estats.es_rxpkts;
+		printf("  (%u.%02u per packet)", (uint32)(ipp / 100),
+						(uint32)(ipp % 100));
+	}
+	printf("\n");
+	printf("   %-16s  %u  (%u cut off by the budget)\n",
+		"Rx poll rounds:", estats.es_rxpolls, estats.es_rxyields);
+	printf("   %-16s  %u\n", "Tx interrupts:", estats.es_txirq);
+	printf("   %-16s  %u\n", "Driver drops:", estats.es_errors);
+
+	/* Input queues: priority of the worker, depth and drops */
+
+	for (i = 0; i < NETIQS; i++) {
+		niqptr = &netiqs[i];
+		sprintf(str, "Input queue %d:", i);
+		printf("   %-16s  prio %d, depth %u (max %u), %u pkts, "
+			"%u drops\n", str, getprio(niqptr->niq_pid),
+			rg_count(&niqptr->niq_rg), niqptr->niq_maxdepth,
+			niqptr->niq_pkts, niqptr->niq_drops);
+	}
+
+	/* Output classes: depth and limit, and packets queued, sent	*/
+	/*   and dropped						*/
+
+	for (i = 0; i < IP_OQCLASSES; i++) {
+		ocptr = &ipoqueue.iqclass[i];
+		sprintf(str, "Output class %d:", i);
+		printf("   %-16s  depth %d/%d, %u enq, %u deq, %u drops\n",
+			str, ocptr->oc_count, ocptr->oc_limit,
+			ocptr->oc_enq, ocptr->oc_deq, ocptr->oc_drops);
+	}
+
+	/* Fragmentation and reassembly */
+
+	printf("   %-16s  %u datagrams in %u fragments\n", "Fragmented:",
+		ipfragstats.if_fragged, ipfragstats.if_fragsout);
+	printf("   %-16s  %u datagrams from %u fragments\n", "Reassembled:",
+		ipfragstats.if_reasm, ipfragstats.if_fragsin);
+	printf("   %-16s  %u timed out, %u overlapped, %u bad, "
+		"%u no buffer\n", "Reasm drops:",
+		ipfragstats.if_timeouts, ipfragstats.if_overlaps,
+		ipfragstats.if_badfrags, ipfragstats.if_nobufs);
+
+	/* TCP segments and connections in use */
+
+	n = 0;
+	for (i = 0; i < TCP_SLOTS; i++) {
+		if (tcbtab[i].tb_state != TCPS_FREE) {
+			n++;
+		}
+	}
+	printf("   %-16s  %u in, %u out, %u retransmitted (%u fast)\n",
+		"TCP segments:", tcpstats.ts_segsin, tcpstats.ts_segsout,
+		tcpstats.ts_rexmit, tcpstats.ts_fastrexmit);
+	printf("   %-16s  %d of %d slots, %u out of order, %u bad, "
+		"%u resets, %u aborted\n", "TCP:", n, TCP_SLOTS,
+		tcpstats.ts_ooo, tcpstats.ts_ckdrop, tcpstats.ts_resets,
+		tcpstats.ts_drops);
+
 	return OK;
 }
@@ -0,0 +1,99 @@
+/* xsh_tftp.c - xsh_tftp */
+
+#include <xinu.h>
+#include <stdio.h>
+#include <string.h>
+
+extern	int	atoi(char *);
+
+#define	TFTP_TESTBUFS	8		/* Buffers in the caller's list	*/
+#define	TFTP_TESTBUFSIZ	(256*1024)	/* Size of each buffer		*/
+
+/*------------------------------------------------------------------------
+ * xsh_tftp - shell command that downloads a file with TFTP into a list
+ *		of buffers and reports the time the transfer took
+ *------------------------------------------------------------------------
+ */
+shellcmd xsh_tftp(int nargs, char *args[])
+{
+	uint32	serverip;		/* TFTP server address		*/
+	char	*bufs[TFTP_TESTBUFS];	/* Buffers to hold the file	*/
+	uint32	sizes[TFTP_TESTBUFS];	/* Size of each buffer		*/
+	int32	blksize;		/* Block size to ask for	*/
+	int32	windowsize;		/* Window size to ask for	*/
+	int32	filesiz;		/* Bytes received		*/
+	uint32	start;			/* Time the transfer started	*/
+	uint32	elapsed;		/* Duration in msec		*/
+	int32	i;			/* Index into bufs		*/
+
+	/* For argument '--help', emit help about the 'tftp' command	*/
+
+	if (nargs == 2 && strncmp(args[1], "--help", 7) == 0) {
+		printf("Use: %s SERVERIP FILE [BLKSIZE [WINDOW]]\n\n",
+								args[0]);
+		printf("Description:\n");
+		printf("\tDownload a file with TFTP and report the time\n");
+		printf("\ttaken (the data are discarded)\n");
+		printf("Options:\n");
+		printf("\tSERVERIP:\tIP address in dotted decimal\n");
+		printf("\tBLKSIZE:\tblock size to ask for (default %d;\n",
+							TFTP_BLKSIZE);
+		printf("\t\t\t512 with WINDOW 1 sends no options)\n");
+		printf("\tWINDOW:\t\tblocks per ACK to ask for (default %d)\n",
+							TFTP_WINDOW);
+		printf("\t--help\t\t display this help and exit\n");
+		return 0;
+	}
+
+	if ( (nargs < 3) || (nargs > 5) ) {
+		fprintf(stderr, "%s: invalid number of argument(s)\n", args[0]);
+		fprintf(stderr, "Try '%s --help' for more information\n",
+				args[0]);
+		return 1;
+	}
+	if (dot2ip(args[1], &serverip) == SYSERR) {
+		fprintf(stderr, "%s: invalid IP address argument\n", args[0]);
+		return 1;
+	}
+	blksize = (nargs >= 4) ? atoi(args[3]) : TFTP_BLKSIZE;
+	windowsize = (nargs == 5) ? atoi(args[4]) : TFTP_WINDOW;
+
+	/* Use a list of buffers, as the boot loader does */
+
+	for (i = 0; i < TFTP_TESTBUFS; i++) {
+		bufs[i] = getmem(TFTP_TESTBUFSIZ);
+		if ((int32)bufs[i] == SYSERR) {
+			fprintf(stderr, "%s: out of memory\n", args[0]);
+			while (--i >= 0) {
+				freemem(bufs[i], TFTP_TESTBUFSIZ);
+			}
+			return 1;
+		}
+		sizes[i] = TFTP_TESTBUFSIZ;
+	}
+
+	start = clkms();
+
+	filesiz = tftpget_opt(serverip, args[2], bufs, sizes, TFTP_TESTBUFS,
+				blksize, windowsize, TFTP_NON_VERBOSE);
+
+	elapsed = clkms() - start;
+
+	for (i = 0; i < TFTP_TESTBUFS; i++) {
+		freemem(bufs[i], TFTP_TESTBUFSIZ);
+	}
+
+	if (filesiz == SYSERR) {
+		fprintf(stderr, "%s: transfer failed\n", args[0]);
+		return 1;
+	}
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+	printf("%d bytes in %d ms (%d KB/s)\n", filesiz, elapsed,
+			(int32)(((uint64)filesiz * 1000 / elapsed) / 1024));
+	if (filesiz >= TFTP_TESTBUFS * TFTP_TESTBUFSIZ) {
+		printf("(the file filled the buffers and was cut short)\n");
+	}
+	return 0;
+}
@@ -13,11 +13,14 @@ shellcmd xsh_udpdump(int nargs, char *args[])
 	int32	i;			/* index into udptab		*/
 	char	*udpstate[] = {		/* names for entry states	*/
 		"free ", "used ", "recv "};
+	char	*ckopts[] = {		/* names for checksum options	*/
+		"none", "tx", "rx", "both"};
 	struct	udpentry *uptr;		/* ptr to entry in udptab	*/
 	uint32	remip;			/* variables to hold the info	*/
 	int32	r1,r2,r3,r4;		/* from an entry for printing	*/
 	int32	remprt, locprt;
 	int32	state;
+	int32	nused;			/* number of slots in use	*/
 	pid32	pid;
 
 
@@ -43,20 +46,23 @@ shellcmd xsh_udpdump(int nargs, char *args[])
 
 	/* Print header for items from UDP table */
 
-	printf("%5s %5s %5s    %9s    %8s %8s %3s %4s\n",
-		"Entry", "Iface", "State", "Remote IP", "Rem Port",
-		"Loc Port", "Pid", "Pkts");
-	printf("%5s %5s %5s %15s %8s %8s %3s %4s\n",
-		"-----", "-----", "-----", "---------------", "--------",
-		"--------", "---", "----");
+	printf("%5s %5s    %9s    %8s %8s %3s %4s %4s %5s %8s %6s\n",
+		"Entry", "State", "Remote IP", "Rem Port", "Loc Port",
+		"Pid", "Pkts", "Ck", "Bad", "Received", "Qdrop");
+	printf("%5s %5s %15s %8s %8s %3s %4s %4s %5s %8s %6s\n",
+		"-----", "-----", "---------------", "--------",
+		"--------", "---", "----", "----", "-----", "--------",
+		"------");
 
 	/* Output information for each valid entry in udptab */
+
+	nused = 0;
 	for (i = 0; i < UDP_SLOTS; i++) {
 	    uptr = &udptab[i];
 	    if (uptr->udstate == UDP_FREE) {  /* skip unused slots	*/
-		printf("%3d   ---- slot is free ---\n", i);
 		continue;
 	    }
+	    nused++;
 	    remip = uptr->udremip;
 	    r1 = (remip >> 24) & 0xff;
 	    r2 = (remip >> 16) & 0xff;
@@ -66,9 +72,15 @@ shellcmd xsh_udpdump(int nargs, char *args[])
 	    locprt = uptr->udlocport;
 	    pid = uptr->udpid;
 	    state = uptr->udstate;
-	    printf("  %4s %3d.%3d.%3d.%3d %5d    %6d%5d%6d\n",
-	      udpstate[state], r1, r2, r3, r4, remprt, locprt, pid,
-							uptr->udcount);
+	    printf("%5d %5s %3d.%3d.%3d.%3d %8d %8d %3d %4d %4s %5d %8d %6d\n",
+	      i, udpstate[state], r1, r2, r3, r4, remprt, locprt, pid,
+	      uptr->udcount, ckopts[uptr->udcksum & UDP_CKSUM_ALL],
+	      uptr->udckdrop, uptr->udrecvd, uptr->uddrop);
 	}
+	printf("\n%d of %d slots in use\n", nused, UDP_SLOTS);
+	printf("Bad checksum drops: %d   Received without checksum: %d\n",
+		udpstats.us_ckdrop, udpstats.us_nocksum);
+	printf("No endpoint: %d   Queue full: %d\n",
+		udpstats.us_nomatch, udpstats.us_qdrop);
 	return 0;
 }
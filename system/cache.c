@@ -0,0 +1,115 @@
+/**
+ * @file cache.c
+ * @brief データキャッシュの保守（クリーン／無効化）を行うAPIを提供する。
+ * @details DMAを行うデバイスドライバは、キャッシュ可能なバッファに対して以下の順で保守操作を行う。<br>
+ * 　・デバイスがメモリから読む（送信）前：CPUが書いた内容を cache_clean() でメモリに書き戻す。<br>
+ * 　・デバイスがメモリに書いた（受信）後：CPUが読む前に cache_inval() で古いキャッシュラインを捨てる。<br>
+ * アドレス指定（MVA）の操作はPoint of Coherencyまで作用するため、L1とL2の両方が対象となる。
+ */
+#include <xinu.h>
+
+/**
+ * @brief 指定範囲のデータキャッシュをクリーンする（ダーティなラインをメモリに書き戻す）。
+ * @param[in] addr 範囲の開始アドレス
+ * @param[in] len 範囲の長さ（Byte）
+ */
+void cache_clean(void *addr, uint32 len)
+{
+	uint32 line, end; /* Current cache line and end of range	*/
+
+	line = (uint32)addr & ~(ARMV7A_DCACHE_LINE - 1);
+	end = (uint32)addr + len;
+	for (; line < end; line += ARMV7A_DCACHE_LINE)
+	{
+		asm volatile("MCR p15, 0, %0, c7, c10, 1\t\n" ::"r"(line)); /* DCCMVAC */
+	}
+	dsb();
+}
+
+/**
+ * @brief 指定範囲のデータキャッシュを無効化する（次の読み込みでメモリから取り直す）。
+ * @details 範囲の先頭と末尾が部分的にかかるラインは、範囲外のデータを失わないように
+ * クリーンしてから無効化する。
+ * @param[in] addr 範囲の開始アドレス
+ * @param[in] len 範囲の長さ（Byte）
+ */
+void cache_inval(void *addr, uint32 len)
+{
+	uint32 line, end; /* Current cache line and end of range	*/
+
+	line = (uint32)addr & ~(ARMV7A_DCACHE_LINE - 1);
+	end = (uint32)addr + len;
+	for (; line < end; line += ARMV7A_DCACHE_LINE)
+	{
+		if ((line < (uint32)addr) || (line + ARMV7A_DCACHE_LINE > end))
+		{
+			asm volatile("MCR p15, 0, %0, c7, c14, 1\t\n" ::"r"(line)); /* DCCIMVAC */
+		}
+		else
+		{
+			asm volatile("MCR p15, 0, %0, c7, c6, 1\t\n" ::"r"(line)); /* DCIMVAC */
+		}
+	}
+	dsb();
+}
+
+/**
+ * @brief 指定範囲のデータキャッシュをクリーンしてから無効化する。
+ * @param[in] addr 範囲の開始アドレス
+ * @param[in] len 範囲の長さ（Byte）
+ */
+void cache_flush(void *addr, uint32 len)
+{
+	uint32 line, end; /* Current cache line and end of range	*/
+
+	line = (uint32)addr & ~(ARMV7A_DCACHE_LINE - 1);
+	end = (uint32)addr + len;
+	for (; line < end; line += ARMV7A_DCACHE_LINE)
+	{
+		asm volatile("MCR p15, 0, %0, c7, c14, 1\t\n" ::"r"(line)); /* DCCIMVAC */
+	}
+	dsb();
+}
+
+/**
+ * @brief 全レベルのデータキャッシュをSet/Way指定で無効化する（書き戻しは行わない）。
+ * @details CLIDRからデータキャッシュを持つレベルを調べ、レベル毎にCCSIDRから
+ * セット数、ウェイ数、ラインサイズを求めて全ラインを無効化する。
+ * @note データキャッシュを有効化する前に、mmuinit()から呼び出される。
+ */
+void cache_invalall(void)
+{
+	uint32 clidr;		 /* Cache level ID register		*/
+	uint32 ccsidr;		 /* Cache size ID register		*/
+	uint32 level;		 /* Cache level (0 = L1)		*/
+	uint32 linesh;		 /* log2 of the line size in bytes	*/
+	uint32 nways, nsets; /* Geometry of the cache level	*/
+	uint32 waysh;		 /* Bit position of the way number	*/
+	uint32 way, set;	 /* Loop indexes			*/
+
+	asm volatile("MRC p15, 1, %0, c0, c0, 1\t\n"
+				 : "=r"(clidr));
+	for (level = 0; level < ((clidr >> 24) & 0x7); level++)
+	{
+		if (((clidr >> (level * 3)) & 0x7) < 2)
+		{
+			continue; /* No data cache at this level	*/
+		}
+		asm volatile("MCR p15, 2, %0, c0, c0, 0\n\tisb" ::"r"(level << 1));
+		asm volatile("MRC p15, 1, %0, c0, c0, 0\t\n"
+					 : "=r"(ccsidr));
+		linesh = (ccsidr & 0x7) + 4;
+		nways = ((ccsidr >> 3) & 0x3FF) + 1;
+		nsets = ((ccsidr >> 13) & 0x7FFF) + 1;
+		waysh = (nways > 1) ? __builtin_clz(nways - 1) : 0;
+		for (way = 0; way < nways; way++)
+		{
+			for (set = 0; set < nsets; set++)
+			{
+				asm volatile("MCR p15, 0, %0, c7, c6, 2\t\n" /* DCISW */
+							 ::"r"((way << waysh) | (set << linesh) | (level << 1)));
+			}
+		}
+	}
+	dsb();
+}
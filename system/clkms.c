@@ -0,0 +1,22 @@
+/**
+ * @file clkms.c
+ * @brief 起動からの経過時間をミリ秒単位で取得する。
+ */
+#include <xinu.h>
+
+/**
+ * @brief 起動からの経過時間をミリ秒単位で取得する。
+ * @details clktime（秒）とcount1000（最後の秒からのミリ秒）はクロック割り込みで更新されるため、
+ * 割り込み禁止状態で両方を読み、途中で繰り上がった値を組み合わせないようにする。
+ * @return 起動からの経過時間[ms]（約49日で一周する）
+ */
+uint32 clkms(void)
+{
+	intmask mask; /* Saved interrupt mask		*/
+	uint32 now;	  /* Time in ms			*/
+
+	mask = disable();
+	now = clktime * 1000 + count1000;
+	restore(mask);
+	return now;
+}
@@ -68,162 +68,169 @@ struct	dentry	devtab[NDEVS] =
 	  (void *)ioerr, (void *)ioerr, (void *)ethcontrol,
 	  (void *)0x0, (void *)ethhandler, 0 },
 
+/* ELOOP is ethloop */
+	{ 7, 0, "ELOOP",
+	  (void *)ethloopInit, (void *)ethloopOpen, (void *)ethloopClose,
+	  (void *)ethloopRead, (void *)ethloopWrite, (void *)ioerr,
+	  (void *)ioerr, (void *)ioerr, (void *)ethloopControl,
+	  (void *)0x0, (void *)ionull, 0 },
+
 /* NAMESPACE is nam */
-	{ 7, 0, "NAMESPACE",
+	{ 8, 0, "NAMESPACE",
 	  (void *)naminit, (void *)namopen, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)0x0, (void *)ioerr, 0 },
 
 /* RDISK is rds */
-	{ 8, 0, "RDISK",
+	{ 9, 0, "RDISK",
 	  (void *)rdsinit, (void *)rdsopen, (void *)rdsclose,
 	  (void *)rdsread, (void *)rdswrite, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)rdscontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RAM0 is ram */
-	{ 9, 0, "RAM0",
+	{ 10, 0, "RAM0",
 	  (void *)raminit, (void *)ramopen, (void *)ramclose,
 	  (void *)ramread, (void *)ramwrite, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILESYS is rfs */
-	{ 10, 0, "RFILESYS",
+	{ 11, 0, "RFILESYS",
 	  (void *)rfsinit, (void *)rfsopen, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)rfscontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE0 is rfl */
-	{ 11, 0, "RFILE0",
+	{ 12, 0, "RFILE0",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE1 is rfl */
-	{ 12, 1, "RFILE1",
+	{ 13, 1, "RFILE1",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE2 is rfl */
-	{ 13, 2, "RFILE2",
+	{ 14, 2, "RFILE2",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE3 is rfl */
-	{ 14, 3, "RFILE3",
+	{ 15, 3, "RFILE3",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE4 is rfl */
-	{ 15, 4, "RFILE4",
+	{ 16, 4, "RFILE4",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE5 is rfl */
-	{ 16, 5, "RFILE5",
+	{ 17, 5, "RFILE5",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE6 is rfl */
-	{ 17, 6, "RFILE6",
+	{ 18, 6, "RFILE6",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE7 is rfl */
-	{ 18, 7, "RFILE7",
+	{ 19, 7, "RFILE7",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE8 is rfl */
-	{ 19, 8, "RFILE8",
+	{ 20, 8, "RFILE8",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* RFILE9 is rfl */
-	{ 20, 9, "RFILE9",
+	{ 21, 9, "RFILE9",
 	  (void *)rflinit, (void *)ioerr, (void *)rflclose,
 	  (void *)rflread, (void *)rflwrite, (void *)rflseek,
 	  (void *)rflgetc, (void *)rflputc, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILESYS is lfs */
-	{ 21, 0, "LFILESYS",
+	{ 22, 0, "LFILESYS",
 	  (void *)lfsinit, (void *)lfsopen, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)ioerr, (void *)ioerr, (void *)ioerr,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE0 is lfl */
-	{ 22, 0, "LFILE0",
+	{ 23, 0, "LFILE0",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE1 is lfl */
-	{ 23, 1, "LFILE1",
+	{ 24, 1, "LFILE1",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE2 is lfl */
-	{ 24, 2, "LFILE2",
+	{ 25, 2, "LFILE2",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE3 is lfl */
-	{ 25, 3, "LFILE3",
+	{ 26, 3, "LFILE3",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE4 is lfl */
-	{ 26, 4, "LFILE4",
+	{ 27, 4, "LFILE4",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* LFILE5 is lfl */
-	{ 27, 5, "LFILE5",
+	{ 28, 5, "LFILE5",
 	  (void *)lflinit, (void *)ioerr, (void *)lflclose,
 	  (void *)lflread, (void *)lflwrite, (void *)lflseek,
 	  (void *)lflgetc, (void *)lflputc, (void *)lflcontrol,
 	  (void *)0x0, (void *)ionull, 0 },
 
 /* SPI0 is spi */
-	{ 28, 0, "SPI0",
+	{ 29, 0, "SPI0",
 	  (void *)spiinit, (void *)ionull, (void *)ionull,
 	  (void *)ionull, (void *)ionull, (void *)ionull,
 	  (void *)ionull, (void *)ionull, (void *)spicontrol,
 	  (void *)0x48030000, (void *)ionull, 0 },
 
 /* SPI1 is spi */
-	{ 29, 1, "SPI1",
+	{ 30, 1, "SPI1",
 	  (void *)spiinit, (void *)ionull, (void *)ionull,
 	  (void *)ionull, (void *)ionull, (void *)ionull,
 	  (void *)ionull, (void *)ionull, (void *)spicontrol,
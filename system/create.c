@@ -24,7 +24,7 @@ local int newpid();
  * 　・スタックが確保できなかった場合<br>
  * 　・全てのプロセスがFREE状態ではなかった場合（使用中だった場合）<br>
  * 　・引数のプロセス優先度が1より小さかった場合<br>
- * Step4. アクティブプロセス数を１増やす。
+ * Step4. アクティブプロセス数を１増やす。MEMTRACK定義時は、スタックの所有者をcreate()の呼び出し元と新しいプロセスに付け替える。
  * Step5. プロセステーブルエントリを以下の状態で初期化する。<br>
  * 　・プロセス状態 = サスペンド<br>
  * 　・プロセス優先度 = 引数で指定した優先度<br>
@@ -75,6 +75,11 @@ pid32 create(void *procaddr, uint32 ssize, pri16 priority, char *name, uint32 na
 
 	prcount++;
 	prptr = &proctab[pid];
+#ifdef MEMTRACK
+	/* Charge the stack to create's caller and the new process	*/
+	mtowner((char *)saddr - (uint32)roundmb(ssize) + sizeof(uint32),
+			(uint32)__builtin_return_address(0), pid);
+#endif
 
 	/* initialize process table entry for new process */
 	prptr->prstate = PR_SUSP; /* initial state is suspended	*/
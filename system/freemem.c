@@ -72,6 +72,9 @@ syscall freemem(char *blkaddr, uint32 nbytes)
 	}
 
 	memlist.mlength += nbytes;
+#ifdef MEMTRACK
+	mtremove(blkaddr, nbytes);
+#endif
 
 	/* Either coalesce with previous block or add to free list */
 
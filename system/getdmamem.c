@@ -0,0 +1,36 @@
+/**
+ * @file getdmamem.c
+ * @brief キャッシュ不可のDMA用領域からメモリを割り当てる。
+ */
+#include <xinu.h>
+
+//! DMA用領域の次の未使用アドレス
+local uint32 dmanext = DMAADDR;
+
+/**
+ * @brief キャッシュ不可のDMA用領域（DMAADDR〜RAMEND）からメモリを割り当てる。
+ * @details DMAディスクリプタのように、CPUとデバイスが同じキャッシュライン内の別々の位置を
+ * 同時に書き換えるデータを置くために用いる。割り当てはキャッシュラインの倍数で行う。
+ * @param[in] nbytes 必要なメモリサイズ（Byte）
+ * @return 成功時は割り当てたメモリのアドレスを返し、以下の場合はSYSERRを返す。<br>
+ * 　・要求サイズが0の場合<br>
+ * 　・DMA用領域の空きが足りない場合
+ * @note デバイスの初期化時に一度だけ割り当てる事を想定しているため、解放はできない。
+ */
+char *getdmamem(uint32 nbytes)
+{
+	intmask mask; /* Saved interrupt mask		*/
+	char *blk;	  /* Address of allocated block	*/
+
+	mask = disable();
+	nbytes = (nbytes + ARMV7A_DCACHE_LINE - 1) & ~(ARMV7A_DCACHE_LINE - 1);
+	if ((nbytes == 0) || (nbytes > RAMEND - dmanext))
+	{
+		restore(mask);
+		return (char *)SYSERR;
+	}
+	blk = (char *)dmanext;
+	dmanext += nbytes;
+	restore(mask);
+	return blk;
+}
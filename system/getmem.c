@@ -20,7 +20,8 @@
  * @param[in] nbytes 必要なメモリサイズ（Byte）
  * @return 成功時はユーザ要求サイズ分のメモリへのアドレスを返し、「要求されたメモリのByte数が0の場合」や<br>
  * 「メモリに空きがない場合」はSYSERRを返す。
- * @note フリーメモリブロックはリンクリストで保持され、各ブロックはアドレスの昇順で管理されている。
+ * @note フリーメモリブロックはリンクリストで保持され、各ブロックはアドレスの昇順で管理されている。<br>
+ * MEMTRACK定義時は、割り当てたブロックを呼び出し元アドレスと共に追跡テーブルへ登録する。
  */
 char *getmem(uint32 nbytes)
 {
@@ -45,6 +46,10 @@ char *getmem(uint32 nbytes)
 		{ /* Block is exact match	*/
 			prev->mnext = curr->mnext;
 			memlist.mlength -= nbytes;
+#ifdef MEMTRACK
+			mtadd((char *)curr, nbytes,
+				  (uint32)__builtin_return_address(0), MT_HEAP);
+#endif
 			restore(mask);
 			return (char *)(curr);
 		}
@@ -56,6 +61,10 @@ char *getmem(uint32 nbytes)
 			leftover->mnext = curr->mnext;
 			leftover->mlength = curr->mlength - nbytes;
 			memlist.mlength -= nbytes;
+#ifdef MEMTRACK
+			mtadd((char *)curr, nbytes,
+				  (uint32)__builtin_return_address(0), MT_HEAP);
+#endif
 			restore(mask);
 			return (char *)(curr);
 		}
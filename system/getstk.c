@@ -21,6 +21,7 @@
  * @return 成功時はスタック（メモリブロックの最上位アドレス）を返し、以下の場合はSYSERRを返す。<br>
  * 　・要求メモリサイズが0の場合<br>
  * 　・要求メモリサイズを確保できなかった場合
+ * @note MEMTRACK定義時は、割り当てたブロックを呼び出し元アドレスと共に追跡テーブルへ登録する。
  */
 char *getstk(uint32 nbytes)
 {
@@ -68,6 +69,9 @@ char *getstk(uint32 nbytes)
 		fits = (struct memblk *)((uint32)fits + fits->mlength);
 	}
 	memlist.mlength -= nbytes;
+#ifdef MEMTRACK
+	mtadd((char *)fits, nbytes, (uint32)__builtin_return_address(0), MT_STACK);
+#endif
 	restore(mask);
 	return (char *)((uint32)fits + nbytes - sizeof(uint32));
 }
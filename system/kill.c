@@ -16,6 +16,7 @@
  * Step4. 親プロセスに終了させるプロセスのIDを通知する。<br>
  * Step5. XINU Shell用に確保したSTDIN(標準入力)／STDOUT(標準出力)／STDERR(標準エラー)用のディスクリプタを閉じる。<br>
  * Step6. 終了させるプロセスが使用していたスタックメモリを解放する。<br>
+ * 　　　 MEMTRACK定義時は、プロセスが解放せずに保持しているメモリブロックを報告し、追跡テーブルから取り除く。<br>
  * Step7. 終了させるプロセスの状態に応じて、以下の処理を行う。<br>
  * 　・実行中の場合、FREE状態に移行し、再スケジューリングを行う（二度と戻ってこない）。<br>
  * 　・SLEEP状態やタイムアウト／メッセージ到着待ちの場合、休眠キューから終了させるプロセスを取り除く。<br>
@@ -52,6 +53,10 @@ syscall kill(pid32 pid)
 		close(prptr->prdesc[i]);
 	}
 	freestk(prptr->prstkbase, prptr->prstklen);
+#ifdef MEMTRACK
+	mtreport(pid); /* Report blocks the process never freed	*/
+	mtclear(pid);  /* Forget them before the pid is reused	*/
+#endif
 
 	switch (prptr->prstate)
 	{
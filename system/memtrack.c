@@ -0,0 +1,252 @@
+/**
+ * @file memtrack.c
+ * @brief 割り当て済みメモリブロックの所有者（呼び出し元、プロセス、サイズ、時刻）を追跡する。
+ * @note Configurationファイルで MEMTRACK を定義した場合のみ有効となる。
+ */
+#include <xinu.h>
+
+#ifdef MEMTRACK
+
+//! 割り当て済みメモリブロックの追跡テーブル
+struct memtrack memtrktab[MT_NENT];
+//! 追跡テーブルが満杯で記録できなかった割り当ての回数
+uint32 mtdropped;
+//! 追跡テーブルの使用中エントリ数（空きエントリを常に1つ以上残す）
+local int32 mtcount;
+
+/**
+ * @brief ブロックアドレスから追跡テーブルの探索開始位置を求める。
+ * @param[in] blkaddr ブロックの最下位アドレス
+ * @return 追跡テーブルのインデックス
+ * @note ブロックは8Byte境界に揃っているため、下位3bitを捨ててから剰余を取る。
+ */
+local int32 mthash(char *blkaddr)
+{
+	return (int32)(((uint32)blkaddr >> 3) % MT_NENT);
+}
+
+/**
+ * @brief 追跡テーブルのエントリを空け、線形探索の連続性を保つために後続エントリを前方に詰める。
+ * @param[in] i 空けるエントリのインデックス
+ * @note 空きエントリが常に1つ以上あるため、後続エントリの走査は必ず終了する。
+ */
+local void mtdelete(int32 i)
+{
+	int32 j, home; /* Indexes used to probe the table	*/
+
+	j = i;
+	while (TRUE)
+	{
+		if (++j >= MT_NENT)
+		{
+			j = 0;
+		}
+		if (memtrktab[j].mtaddr == NULL)
+		{
+			break;
+		}
+		home = mthash(memtrktab[j].mtaddr);
+		if ((i <= j) ? ((i < home) && (home <= j)) : ((i < home) || (home <= j)))
+		{
+			continue; /* Entry is still reachable	*/
+		}
+		memtrktab[i] = memtrktab[j];
+		i = j;
+	}
+	memtrktab[i].mtaddr = NULL;
+	mtcount--;
+}
+
+/**
+ * @brief ブロックアドレスに対応する追跡テーブルのエントリを探す。
+ * @param[in] blkaddr ブロックの最下位アドレス
+ * @return エントリのインデックス、登録されていない場合はSYSERR
+ */
+local int32 mtfind(char *blkaddr)
+{
+	int32 i, n; /* Probe index and probe count	*/
+
+	i = mthash(blkaddr);
+	for (n = 0; n < MT_NENT; n++)
+	{
+		if (memtrktab[i].mtaddr == NULL)
+		{
+			break; /* Block was never recorded	*/
+		}
+		if (memtrktab[i].mtaddr == blkaddr)
+		{
+			return i;
+		}
+		if (++i >= MT_NENT)
+		{
+			i = 0;
+		}
+	}
+	return SYSERR;
+}
+
+/**
+ * @brief 割り当てたメモリブロックを追跡テーブルに登録する。
+ * @details 使用中エントリがMT_NENT-1個に達している場合は登録せず、mtdroppedを加算する
+ * （空きエントリを残さないと、mtremove()での後続エントリの走査が終了しなくなる）。
+ * @param[in] blkaddr ブロックの最下位アドレス
+ * @param[in] nbytes ブロックサイズ（8の倍数に丸めた値）
+ * @param[in] pc getmem()／getstk()の呼び出し元アドレス
+ * @param[in] kind ブロックの種別（MT_HEAP／MT_STACK）
+ * @note 割り込み禁止状態で呼び出す事。
+ */
+void mtadd(char *blkaddr, uint32 nbytes, uint32 pc, byte kind)
+{
+	int32 i;		  /* Probe index			*/
+	struct memtrack *mtptr; /* Ptr to table entry		*/
+
+	if (mtcount >= MT_NENT - 1)
+	{
+		mtdropped++;
+		return;
+	}
+	i = mthash(blkaddr);
+	while (memtrktab[i].mtaddr != NULL)
+	{
+		if (++i >= MT_NENT)
+		{
+			i = 0;
+		}
+	}
+	mtptr = &memtrktab[i];
+	mtptr->mtaddr = blkaddr;
+	mtptr->mtlength = nbytes;
+	mtptr->mtpc = pc;
+	mtptr->mttime = clktime;
+	mtptr->mtpid = (int16)currpid;
+	mtptr->mtkind = kind;
+	mtcount++;
+}
+
+/**
+ * @brief 解放されたメモリ範囲を追跡テーブルから取り除く。
+ * @details ブロック先頭から一部だけが解放された場合は、残りの部分を同じ所有者で再登録する。
+ * @param[in] blkaddr 解放するブロックの最下位アドレス
+ * @param[in] nbytes 解放するサイズ（8の倍数に丸めた値）
+ * @note 割り込み禁止状態で呼び出す事。
+ */
+void mtremove(char *blkaddr, uint32 nbytes)
+{
+	int32 i;		   /* Index of the entry		*/
+	struct memtrack entry; /* Copy of the entry being removed	*/
+
+	i = mtfind(blkaddr);
+	if (i == SYSERR)
+	{
+		return; /* Block was never recorded	*/
+	}
+	entry = memtrktab[i];
+	mtdelete(i);
+
+	/* Keep the remainder of a partially freed block	*/
+
+	if (nbytes < entry.mtlength)
+	{
+		i = mthash(entry.mtaddr + nbytes);
+		while (memtrktab[i].mtaddr != NULL)
+		{
+			if (++i >= MT_NENT)
+			{
+				i = 0;
+			}
+		}
+		memtrktab[i] = entry;
+		memtrktab[i].mtaddr += nbytes;
+		memtrktab[i].mtlength -= nbytes;
+		mtcount++;
+	}
+}
+
+/**
+ * @brief 登録済みのブロックの所有者を付け替える。
+ * @details create()がgetstk()で割り当てたスタックを、create()の呼び出し元と新しいプロセスに帰属させる
+ * （スタックは新しいプロセスの終了時にkill()が解放する）。
+ * @param[in] blkaddr ブロックの最下位アドレス
+ * @param[in] pc 所有者とする呼び出し元アドレス
+ * @param[in] pid 所有者とするプロセスのID
+ * @note 割り込み禁止状態で呼び出す事。
+ */
+void mtowner(char *blkaddr, uint32 pc, pid32 pid)
+{
+	int32 i; /* Index of the entry		*/
+
+	i = mtfind(blkaddr);
+	if (i != SYSERR)
+	{
+		memtrktab[i].mtpc = pc;
+		memtrktab[i].mtpid = (int16)pid;
+	}
+}
+
+/**
+ * @brief 指定プロセスのエントリを追跡テーブルから全て取り除く。
+ * @details kill()からmtreport()の後に呼び出し、再利用されたPIDが古いブロックを引き継がないようにする。<br>
+ * エントリを詰めると後続エントリが現在位置に移るため、取り除いた位置は再度調べる
+ * （詰める処理は後続エントリを前方にしか移さないため、未走査のエントリを飛ばす事はない）。
+ * @param[in] pid 対象プロセスのID
+ * @note 割り込み禁止状態で呼び出す事。
+ */
+void mtclear(pid32 pid)
+{
+	int32 i; /* Index into tracking table	*/
+
+	i = 0;
+	while (i < MT_NENT)
+	{
+		if ((memtrktab[i].mtaddr != NULL) && (memtrktab[i].mtpid == pid))
+		{
+			mtdelete(i);
+			continue;
+		}
+		i++;
+	}
+}
+
+/**
+ * @brief 指定プロセスが割り当てたまま保持しているメモリブロックをコンソールに出力する。
+ * @details kill()からプロセス終了時に呼び出され、解放漏れの調査に用いる。
+ * @param[in] pid 対象プロセスのID
+ * @return 保持しているブロック数
+ * @note 割り込み禁止状態で呼び出す事（出力にはkprintf()を用いる）。
+ */
+int32 mtreport(pid32 pid)
+{
+	int32 i;		  /* Index into tracking table	*/
+	int32 nblks;	  /* Number of blocks still held	*/
+	uint32 nbytes;	  /* Number of bytes still held	*/
+	struct memtrack *mtptr; /* Ptr to table entry		*/
+
+	nblks = 0;
+	nbytes = 0;
+	for (i = 0; i < MT_NENT; i++)
+	{
+		mtptr = &memtrktab[i];
+		if ((mtptr->mtaddr == NULL) || (mtptr->mtpid != pid))
+		{
+			continue;
+		}
+		if (nblks == 0)
+		{
+			kprintf("pid %d (%s) exits holding:\n", pid,
+					proctab[pid].prname);
+		}
+		kprintf("  0x%08x %8d bytes %s from pc 0x%08x at %d s\n",
+				mtptr->mtaddr, mtptr->mtlength,
+				mtptr->mtkind == MT_STACK ? "stack" : "heap ",
+				mtptr->mtpc, mtptr->mttime);
+		nblks++;
+		nbytes += mtptr->mtlength;
+	}
+	if (nblks > 0)
+	{
+		kprintf("  %d blocks, %d bytes total\n", nblks, nbytes);
+	}
+	return nblks;
+}
+
+#endif
@@ -16,7 +16,8 @@
  * 　・割り当て済みのバッファプール数が最大数を超えた場合<br>
  * Step3. 要求されたバッファサイズを4の倍数で丸める。<br>
  * Step4. 要求されたバッファサイズ + バッファプールID分のメモリをバッファ数分、割り当てる。<br>
- * メモリ確保に失敗した場合は割り込み状態を復元し、処理を終了する。
+ * メモリ確保に失敗した場合は割り込み状態を復元し、処理を終了する。<br>
+ * プールの先頭はキャッシュライン境界に揃える（DMAで受信するバッファがラインを他のデータと共有しないようにするため）。
  * Step5. 新しいバッファプールIDを割り当て、バッファプールの総数を1増加させる。<br>
  * Step6. 割り当てたバッファとバッファプールをリンクする。<br>
  * Step7. 割り当てたバッファにセマフォを割り当てる。<br>
@@ -41,6 +42,8 @@ bpid32 mkbufpool(int32 bufsiz, int32 numbufs)
 	bpid32 poolid;		   /* ID of pool that is created	*/
 	struct bpentry *bpptr; /* Pointer to entry in buftab	*/
 	char *buf;			   /* Pointer to memory for buffer	*/
+	char *mem;			   /* Memory obtained from getmem	*/
+	uint32 memsiz;		   /* Size of the memory		*/
 
 	mask = disable();
 	if (bufsiz < BP_MINB || bufsiz > BP_MAXB || numbufs < 1 || numbufs > BP_MAXN || nbpools >= NBPOOLS)
@@ -52,19 +55,26 @@ bpid32 mkbufpool(int32 bufsiz, int32 numbufs)
 
 	bufsiz = ((bufsiz + 3) & (~3));
 
-	buf = (char *)getmem(numbufs * (bufsiz + sizeof(bpid32)));
-	if ((int32)buf == SYSERR)
+	/* Start the pool on a cache line; a pool whose buffers are	*/
+	/*   a whole number of lines long then never shares a line	*/
+	/*   with other data					*/
+
+	memsiz = numbufs * (bufsiz + sizeof(bpid32)) + ARMV7A_DCACHE_LINE;
+	mem = (char *)getmem(memsiz);
+	if ((int32)mem == SYSERR)
 	{
 		restore(mask);
 		return (bpid32)SYSERR;
 	}
+	buf = (char *)(((uint32)mem + ARMV7A_DCACHE_LINE - 1) &
+				   ~(ARMV7A_DCACHE_LINE - 1));
 	poolid = nbpools++;
 	bpptr = &buftab[poolid];
 	bpptr->bpnext = (struct bpentry *)buf;
 	bpptr->bpsize = bufsiz;
 	if ((bpptr->bpsem = semcreate(numbufs)) == SYSERR)
 	{
-		freemem(buf, numbufs * (bufsiz + sizeof(bpid32)));
+		freemem(mem, memsiz);
 		nbpools--;
 		restore(mask);
 		return (bpid32)SYSERR;
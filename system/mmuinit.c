@@ -0,0 +1,80 @@
+/**
+ * @file mmuinit.c
+ * @brief フラットなセクションマッピングの変換テーブルを作成し、MMUとL1/L2データキャッシュを有効化する。
+ */
+#include <xinu.h>
+
+//! L1変換テーブル（4096エントリ × 1MBセクション、16KB境界に配置する必要がある）
+uint32 l1pagetab[ARMV7A_L1PT_NENT] __attribute__((aligned(16384)));
+
+/**
+ * @brief 仮想アドレスと物理アドレスが一致するセクションエントリを設定する。
+ * @param[in] start 開始アドレス（1MB境界）
+ * @param[in] end 終了アドレス（1MB境界、この値は含まない）
+ * @param[in] attr セクションの属性（ARMV7A_SECT_NORMAL／ARMV7A_SECT_NCACHE／ARMV7A_SECT_DEVICE）
+ */
+local void mapsect(uint32 start, uint32 end, uint32 attr)
+{
+	uint32 addr; /* Base address of current section	*/
+
+	for (addr = start; addr != end; addr += ARMV7A_SECT_SIZE)
+	{
+		l1pagetab[addr >> 20] = addr | attr;
+	}
+}
+
+/**
+ * @brief フラットなセクションマッピングの変換テーブルを作成し、MMUとL1/L2データキャッシュを有効化する。
+ * @details
+ * Step1. 変換テーブルを以下のように作成する（仮想アドレス = 物理アドレス）。<br>
+ * 　・0x00000000〜0x7FFFFFFF：周辺機器レジスタ用のDevice（実行禁止）<br>
+ * 　・ROMとOCMC RAM（例外ベクタ）のセクション：キャッシュ不可のNormal<br>
+ * 　・0x80000000〜DMAADDR：キャッシュ可能なNormal（カーネル、ヒープ、スタック）<br>
+ * 　・DMAADDR〜RAMEND：キャッシュ不可のNormal（CPDMAディスクリプタ用）<br>
+ * 　・RAMEND以降：未マップ（アクセスするとアボートになる）<br>
+ * Step2. 古い内容が残らないように、命令キャッシュ、分岐予測器、TLB、データキャッシュを無効化する。<br>
+ * Step3. 変換テーブルのアドレスとドメインアクセス制御を設定する。<br>
+ * Step4. L2キャッシュを有効化し、MMU、データキャッシュ、分岐予測を有効化する。
+ * @note platinit()から、ヒープやデバイスを使用し始める前に一度だけ呼び出される。
+ */
+void mmuinit(void)
+{
+	uint32 reg; /* Value of a CP15 register	*/
+
+	/* Build the flat (identity) section map */
+
+	mapsect(0x00000000, 0x80000000, ARMV7A_SECT_DEVICE);
+	mapsect(ROMADDR, ROMADDR + ARMV7A_SECT_SIZE, ARMV7A_SECT_NCACHE);
+	mapsect(OCMCADDR, OCMCADDR + ARMV7A_SECT_SIZE, ARMV7A_SECT_NCACHE);
+	mapsect(0x80000000, DMAADDR, ARMV7A_SECT_NORMAL);
+	mapsect(DMAADDR, RAMEND, ARMV7A_SECT_NCACHE);
+
+	/* Discard any stale cache and TLB contents */
+
+	asm volatile("MCR p15, 0, %0, c7, c5, 0\t\n" ::"r"(0)); /* ICIALLU	*/
+	asm volatile("MCR p15, 0, %0, c7, c5, 6\t\n" ::"r"(0)); /* BPIALL	*/
+	asm volatile("MCR p15, 0, %0, c8, c7, 0\t\n" ::"r"(0)); /* TLBIALL	*/
+	cache_invalall();
+
+	/* Install the table and make every domain a client */
+
+	asm volatile("MCR p15, 0, %0, c2, c0, 2\t\n" ::"r"(0)); /* TTBCR	*/
+	asm volatile("MCR p15, 0, %0, c2, c0, 0\t\n" ::"r"((uint32)l1pagetab | ARMV7A_TTBR_C | ARMV7A_TTBR_RGN_WBWA));
+	asm volatile("MCR p15, 0, %0, c3, c0, 0\t\n" ::"r"(ARMV7A_DACR_CLIENT));
+
+	/* Enable the unified L2 cache */
+
+	asm volatile("MRC p15, 0, %0, c1, c0, 1\t\n"
+				 : "=r"(reg));
+	reg |= ARMV7A_ACTLR_L2EN;
+	asm volatile("MCR p15, 0, %0, c1, c0, 1\t\n" ::"r"(reg));
+
+	/* Turn on the MMU, the data cache and branch prediction */
+
+	asm volatile("dsb\n\tisb" ::: "memory");
+	asm volatile("MRC p15, 0, %0, c1, c0, 0\t\n"
+				 : "=r"(reg));
+	reg |= ARMV7A_C1CTL_M | ARMV7A_C1CTL_C | ARMV7A_C1CTL_Z | ARMV7A_C1CTL_I;
+	asm volatile("MCR p15, 0, %0, c1, c0, 0\t\n" ::"r"(reg));
+	asm volatile("isb" ::: "memory");
+}
@@ -50,6 +50,10 @@ void	platinit(void)
 
 	counterinit();
 
+	/* Enable the MMU and the L1/L2 data caches */
+
+	mmuinit();
+
 	/* Pad control for CONSOLE */
 
 	am335x_padctl(UART0_PADRX_ADDR,
@@ -0,0 +1,229 @@
+/* bench_ds.c - main, bench_hashmap, bench_rbtree, bench_ringbuf,
+		bench_producer, bench_report */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "hosttest.h"
+#include <xinu.h>
+
+#define	BENCH_RGITEMS	10000000	/* Items passed through a ring	*/
+#define	BENCH_RGSIZE	256		/* Elements of the ring		*/
+
+struct	benchitem {			/* Entry of the maps and trees	*/
+	struct	hmnode	hnode;		/* Node of a hash map		*/
+	struct	rbnode	rnode;		/* Node of a red-black tree	*/
+};
+
+static	volatile uintptr_t sink;	/* Keeps results from being	*/
+					/*   optimized away		*/
+
+static	void	bench_hashmap(uint32);
+static	void	bench_rbtree(uint32);
+static	void	bench_ringbuf(void);
+static	void	*bench_producer(void *);
+static	void	bench_report(const char *, uint32, double, uint32);
+
+/*------------------------------------------------------------------------
+ * main - time the hash map, red-black tree and ring buffer in lib/
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	uint32	n;			/* Number of entries		*/
+
+	printf("%-28s %8s %10s\n", "operation", "entries", "ns/op");
+	for (n = 256; n <= 65536; n *= 16) {
+		bench_hashmap(n);
+	}
+	for (n = 256; n <= 65536; n *= 16) {
+		bench_rbtree(n);
+	}
+	bench_ringbuf();
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * bench_hashmap - time inserting, finding and removing random integer
+ *		     keys in a map of nslots slots filled to its limit
+ *------------------------------------------------------------------------
+ */
+static	void	bench_hashmap(
+		  uint32	nslots	/* Slots of the map		*/
+		)
+{
+	struct	hashmap	hm;		/* Map being timed		*/
+	struct	hmnode	**slots;	/* Its slots			*/
+	struct	benchitem *items;	/* Its entries			*/
+	uint32	n;			/* Number of entries		*/
+	uint32	i;			/* Index of an entry		*/
+	uint32	rounds, r;		/* Repetitions of each phase	*/
+	double	t[4];			/* Time of each phase		*/
+	double	start;			/* Start of a phase		*/
+
+	slots = malloc(nslots * sizeof(*slots));
+	hm_init(&hm, slots, nslots, HM_INT);
+	n = hm_maxcount(&hm);
+	items = malloc(n * sizeof(*items));
+
+	/* Store odd keys only, so that looking up even keys misses */
+
+	for (i = 0; i < n; i++) {
+		items[i].hnode.hnikey = test_rand() | 1;
+	}
+	rounds = 4000000 / n;
+	t[0] = t[1] = t[2] = t[3] = 0;
+	for (r = 0; r < rounds; r++) {
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			hm_insert(&hm, &items[i].hnode);
+		}
+		t[0] += test_now() - start;
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			sink += (uintptr_t)hm_findint(&hm,
+						items[i].hnode.hnikey);
+		}
+		t[1] += test_now() - start;
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			sink += (uintptr_t)hm_findint(&hm,
+						items[i].hnode.hnikey - 1);
+		}
+		t[2] += test_now() - start;
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			hm_remove(&hm, &items[i].hnode);
+		}
+		t[3] += test_now() - start;
+	}
+	bench_report("hm_insert", n, t[0], rounds * n);
+	bench_report("hm_findint (hit)", n, t[1], rounds * n);
+	bench_report("hm_findint (miss)", n, t[2], rounds * n);
+	bench_report("hm_remove", n, t[3], rounds * n);
+	free(items);
+	free(slots);
+}
+
+/*------------------------------------------------------------------------
+ * bench_rbtree - time inserting, finding, walking and removing n
+ *		    random keys
+ *------------------------------------------------------------------------
+ */
+static	void	bench_rbtree(
+		  uint32	n	/* Number of entries		*/
+		)
+{
+	struct	rbtree	rt;		/* Tree being timed		*/
+	struct	rbnode	*node;		/* Node of a walk		*/
+	struct	benchitem *items;	/* Its entries			*/
+	uint32	i;			/* Index of an entry		*/
+	uint32	rounds, r;		/* Repetitions of each phase	*/
+	double	t[4];			/* Time of each phase		*/
+	double	start;			/* Start of a phase		*/
+
+	items = malloc(n * sizeof(*items));
+	for (i = 0; i < n; i++) {
+		items[i].rnode.rbkey = test_rand();
+	}
+	rb_init(&rt);
+	rounds = 2000000 / n;
+	t[0] = t[1] = t[2] = t[3] = 0;
+	for (r = 0; r < rounds; r++) {
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			rb_insert(&rt, &items[i].rnode);
+		}
+		t[0] += test_now() - start;
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			sink += (uintptr_t)rb_find(&rt, items[i].rnode.rbkey);
+		}
+		t[1] += test_now() - start;
+		start = test_now();
+		for (node = rb_first(&rt); node != NULL; node = rb_next(node)) {
+			sink += node->rbkey;
+		}
+		t[2] += test_now() - start;
+		start = test_now();
+		for (i = 0; i < n; i++) {
+			rb_remove(&rt, &items[i].rnode);
+		}
+		t[3] += test_now() - start;
+	}
+	bench_report("rb_insert", n, t[0], rounds * n);
+	bench_report("rb_find", n, t[1], rounds * n);
+	bench_report("rb_first/rb_next", n, t[2], rounds * n);
+	bench_report("rb_remove", n, t[3], rounds * n);
+	free(items);
+}
+
+/*------------------------------------------------------------------------
+ * bench_ringbuf - time passing items through a ring within a thread
+ *		     and from one thread to another
+ *------------------------------------------------------------------------
+ */
+static	void	bench_ringbuf(void)
+{
+	static	void	*slots[BENCH_RGSIZE];
+	static	struct	ringbuf	rg;	/* Ring being timed		*/
+	pthread_t producer;		/* Thread that puts items	*/
+	uintptr_t i;			/* Item				*/
+	double	start;			/* Start of a phase		*/
+
+	rg_init(&rg, slots, BENCH_RGSIZE);
+	start = test_now();
+	for (i = 1; i <= BENCH_RGITEMS; i++) {
+		rg_put(&rg, (void *)i);
+		sink += (uintptr_t)rg_get(&rg);
+	}
+	bench_report("rg_put+rg_get (1 thread)", BENCH_RGSIZE,
+				test_now() - start, BENCH_RGITEMS);
+
+	start = test_now();
+	pthread_create(&producer, NULL, bench_producer, &rg);
+	for (i = 0; i < BENCH_RGITEMS; ) {
+		if (rg_get(&rg) != NULL) {
+			i++;
+		} else {
+			sched_yield();
+		}
+	}
+	pthread_join(producer, NULL);
+	bench_report("rg_put/rg_get (2 threads)", BENCH_RGSIZE,
+				test_now() - start, BENCH_RGITEMS);
+}
+
+/*------------------------------------------------------------------------
+ * bench_producer - put BENCH_RGITEMS items, retrying when full
+ *------------------------------------------------------------------------
+ */
+static	void	*bench_producer(
+		  void		*arg	/* Ring to put into		*/
+		)
+{
+	struct	ringbuf	*rg = arg;	/* Ring to put into		*/
+	uintptr_t i;			/* Item				*/
+
+	for (i = 1; i <= BENCH_RGITEMS; i++) {
+		while (rg_put(rg, (void *)i) != OK) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+/*------------------------------------------------------------------------
+ * bench_report - print the time per operation of one phase
+ *------------------------------------------------------------------------
+ */
+static	void	bench_report(
+		  const char	*name,	/* Operation timed		*/
+		  uint32	entries,/* Size of the structure	*/
+		  double	secs,	/* Total time			*/
+		  uint32	ops	/* Number of operations		*/
+		)
+{
+	printf("%-28s %8u %10.1f\n", name, entries, secs * 1e9 / ops);
+}
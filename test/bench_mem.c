@@ -0,0 +1,157 @@
+/* bench_mem.c - main, bench_rounds, bench_cpy, bench_set, bench_cmp,
+		host_memcpy, host_memset, host_memcmp */
+
+#include <string.h>
+#include "hosttest.h"
+#include <xinu.h>
+#include "xinulib.h"
+
+#define	BENCH_MAXSIZE	65536		/* Largest block timed		*/
+#define	BENCH_BYTES	(64*1024*1024)	/* Bytes moved per measurement	*/
+#define	BENCH_MAXROUNDS	(4*1024*1024)	/* Calls per measurement at most*/
+
+/* Buffers start on a 64-byte boundary; the misaligned columns use	*/
+/*   a source one byte past it					*/
+
+static	unsigned char	src[BENCH_MAXSIZE + 64] __attribute__((aligned(64)));
+static	unsigned char	dst[BENCH_MAXSIZE + 64] __attribute__((aligned(64)));
+
+static	volatile int	sink;		/* Keeps results from being	*/
+					/*   optimized away		*/
+
+static	int32	bench_rounds(int32);
+static	double	bench_cpy(void *(*)(void *, const void *, int), int32, int32);
+static	double	bench_set(void *(*)(void *, int, int), int32);
+static	double	bench_cmp(int (*)(const void *, const void *, int), int32);
+
+/* The host's functions are called out of line, as the library's are,	*/
+/*   so the compiler cannot drop or merge the calls it times		*/
+
+static	void	*host_memcpy(void *, const void *, int)
+					__attribute__((noinline));
+static	void	*host_memset(void *, int, int) __attribute__((noinline));
+static	int	host_memcmp(const void *, const void *, int)
+					__attribute__((noinline));
+
+/*------------------------------------------------------------------------
+ * main - time memcpy, memset and memcmp in lib/ against the host's
+ *	    C library for blocks of 1 byte to 64 KB
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	int32	n;			/* Size of a block		*/
+
+	memset(src, 0x5a, sizeof(src));
+	memset(dst, 0x5a, sizeof(dst));
+	printf("ns per call; \"+1\" copies from a source one byte past a "
+		"word boundary\n");
+	printf("%6s %9s %9s %9s %9s %9s %9s %9s\n", "bytes",
+		"memcpy", "memcpy+1", "host", "memset", "host",
+		"memcmp", "host");
+	for (n = 1; n <= BENCH_MAXSIZE; n *= 2) {
+		printf("%6d %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", n,
+			bench_cpy(xinu_memcpy, n, 0),
+			bench_cpy(xinu_memcpy, n, 1),
+			bench_cpy(host_memcpy, n, 0),
+			bench_set(xinu_memset, n),
+			bench_set(host_memset, n),
+			bench_cmp(xinu_memcmp, n),
+			bench_cmp(host_memcmp, n));
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * bench_rounds - return the number of calls to time for a block size
+ *------------------------------------------------------------------------
+ */
+static	int32	bench_rounds(
+		  int32		n	/* Size of a block		*/
+		)
+{
+	return (BENCH_BYTES / n < BENCH_MAXROUNDS) ?
+				BENCH_BYTES / n : BENCH_MAXROUNDS;
+}
+
+/*------------------------------------------------------------------------
+ * bench_cpy - return the time of one copy of n bytes
+ *------------------------------------------------------------------------
+ */
+static	double	bench_cpy(
+		  void	*(*fn)(void *, const void *, int), /* Copy to time*/
+		  int32		n,	/* Size of a block		*/
+		  int32		off	/* Offset of the source		*/
+		)
+{
+	int32	rounds, r;		/* Calls to make		*/
+	double	start;			/* Time the calls started	*/
+
+	rounds = bench_rounds(n);
+	start = test_now();
+	for (r = 0; r < rounds; r++) {
+		fn(dst, src + off, n);
+	}
+	return (test_now() - start) * 1e9 / rounds;
+}
+
+/*------------------------------------------------------------------------
+ * bench_set - return the time of one fill of n bytes
+ *------------------------------------------------------------------------
+ */
+static	double	bench_set(
+		  void	*(*fn)(void *, int, int), /* Fill to time	*/
+		  int32		n	/* Size of a block		*/
+		)
+{
+	int32	rounds, r;		/* Calls to make		*/
+	double	start;			/* Time the calls started	*/
+
+	rounds = bench_rounds(n);
+	start = test_now();
+	for (r = 0; r < rounds; r++) {
+		fn(dst, r, n);
+	}
+	return (test_now() - start) * 1e9 / rounds;
+}
+
+/*------------------------------------------------------------------------
+ * bench_cmp - return the time of one comparison of n equal bytes
+ *------------------------------------------------------------------------
+ */
+static	double	bench_cmp(
+		  int	(*fn)(const void *, const void *, int), /* Compare */
+		  int32		n	/* Size of a block		*/
+		)
+{
+	int32	rounds, r;		/* Calls to make		*/
+	double	start;			/* Time the calls started	*/
+
+	memset(dst, 0x5a, n);
+	rounds = bench_rounds(n);
+	start = test_now();
+	for (r = 0; r < rounds; r++) {
+		sink += fn(dst, src, n);
+	}
+	return (test_now() - start) * 1e9 / rounds;
+}
+
+/*------------------------------------------------------------------------
+ * host_memcpy, host_memset, host_memcmp - call the host's C library
+ *					     through the library's types
+ *------------------------------------------------------------------------
+ */
+static	void	*host_memcpy(void *s, const void *ct, int n)
+{
+	return memcpy(s, ct, n);
+}
+
+static	void	*host_memset(void *s, int c, int n)
+{
+	return memset(s, c, n);
+}
+
+static	int	host_memcmp(const void *s1, const void *s2, int n)
+{
+	return memcmp(s1, s2, n);
+}
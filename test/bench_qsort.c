@@ -0,0 +1,212 @@
+/* bench_qsort.c - main, bq_fill, bq_run, bq_sorted, bq_cmp, bq_hostcmp */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hosttest.h"
+#include "xinulib.h"
+
+#define	BQ_MAXN		100000		/* Largest array sorted		*/
+#define	BQ_ELEMENTS	2000000		/* Elements sorted per timing	*/
+
+/* Inputs */
+
+#define	BQ_RANDOM	0		/* Random values		*/
+#define	BQ_SORTED	1		/* Already in order		*/
+#define	BQ_REVERSED	2		/* In reverse order		*/
+#define	BQ_DUPS		3		/* Random values, 16 distinct	*/
+#define	BQ_NINPUTS	4
+
+/* Sorts */
+
+#define	BQ_QSORT	0		/* qsort with a compare function*/
+#define	BQ_U32		1		/* qsort_u32			*/
+#define	BQ_REC		2		/* qsort_rec on 8-byte records	*/
+#define	BQ_HOST		3		/* The host's qsort		*/
+#define	BQ_NSORTS	4
+
+struct	bqrec	{			/* Record sorted by qsort_rec	*/
+	unsigned int	key;		/* Key				*/
+	unsigned int	data;		/* Original position		*/
+};
+
+static	const char	*inputs[] = { "random", "sorted", "reversed",
+					"16 values" };
+static	unsigned int	orig[BQ_MAXN];	/* Input before sorting		*/
+static	unsigned int	work[BQ_MAXN];	/* Array of values sorted	*/
+static	struct	bqrec	recs[BQ_MAXN];	/* Array of records sorted	*/
+static	unsigned long	ncmps;		/* Comparisons made		*/
+
+static	void	bq_fill(int, int);
+static	double	bq_run(int, int, int, double *);
+static	int	bq_sorted(int, int);
+static	int	bq_cmp(char *, char *);
+static	int	bq_hostcmp(const void *, const void *);
+
+/*------------------------------------------------------------------------
+ * main - time the sorts in lib/qsort.c, and the host's qsort, on
+ *	    random, sorted, reversed and duplicate-heavy inputs
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	int	n;			/* Length of the array		*/
+	int	in;			/* Input			*/
+	int	s;			/* Sort				*/
+	int	errors;			/* Results out of order		*/
+	double	cmps;			/* Comparisons per element	*/
+
+	errors = 0;
+	printf("ns per element; \"cmp/n\" counts compare calls of qsort\n");
+	printf("%-10s %7s %9s %7s %9s %9s %9s\n", "input", "n", "qsort",
+		"cmp/n", "qsort_u32", "qsort_rec", "host");
+	for (n = 1000; n <= BQ_MAXN; n *= 10) {
+		for (in = 0; in < BQ_NINPUTS; in++) {
+			printf("%-10s %7d", inputs[in], n);
+			printf(" %9.1f", bq_run(BQ_QSORT, in, n, &cmps));
+			printf(" %7.1f", cmps);
+			printf(" %9.1f", bq_run(BQ_U32, in, n, NULL));
+			printf(" %9.1f", bq_run(BQ_REC, in, n, NULL));
+			printf(" %9.1f\n", bq_run(BQ_HOST, in, n, NULL));
+			for (s = 0; s < BQ_NSORTS; s++) {
+				bq_fill(in, n);
+				bq_run(s, -1, n, NULL);
+				errors += !bq_sorted(s, n);
+			}
+		}
+	}
+	if (errors != 0) {
+		printf("%d sorts left their input out of order\n", errors);
+		return 1;
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * bq_fill - make an input of n values in orig
+ *------------------------------------------------------------------------
+ */
+static	void	bq_fill(
+		  int		in,	/* Kind of input		*/
+		  int		n	/* Number of values		*/
+		)
+{
+	int	i;			/* Index into orig		*/
+
+	for (i = 0; i < n; i++) {
+		switch (in) {
+		case BQ_RANDOM:	 orig[i] = test_rand();		break;
+		case BQ_SORTED:	 orig[i] = i;			break;
+		case BQ_REVERSED: orig[i] = n - i;		break;
+		default:	 orig[i] = test_rand() % 16;	break;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------
+ * bq_run - time one sort on an input and return ns per element; an
+ *	      input of -1 sorts what orig holds once, untimed
+ *------------------------------------------------------------------------
+ */
+static	double	bq_run(
+		  int		sort,	/* Sort to run			*/
+		  int		in,	/* Kind of input, or -1		*/
+		  int		n,	/* Number of values		*/
+		  double	*cmps	/* Comparisons per element, or	*/
+					/*   NULL			*/
+		)
+{
+	int	rounds, r;		/* Sorts to time		*/
+	int	i;			/* Index into the arrays	*/
+	double	start, total;		/* Times			*/
+
+	rounds = (in < 0) ? 1 : BQ_ELEMENTS / n;
+	total = 0;
+	ncmps = 0;
+	for (r = 0; r < rounds; r++) {
+		if (in >= 0) {
+			bq_fill(in, n);
+		}
+		for (i = 0; i < n; i++) {
+			work[i] = orig[i];
+			recs[i].key = orig[i];
+			recs[i].data = i;
+		}
+		start = test_now();
+		switch (sort) {
+		case BQ_QSORT:
+			xinu_qsort((char *)work, n, sizeof(work[0]), bq_cmp);
+			break;
+		case BQ_U32:
+			qsort_u32(work, n);
+			break;
+		case BQ_REC:
+			qsort_rec((char *)recs, n, sizeof(recs[0]), 0);
+			break;
+		default:
+			qsort(work, n, sizeof(work[0]), bq_hostcmp);
+		}
+		total += test_now() - start;
+	}
+	if (cmps != NULL) {
+		*cmps = (double)ncmps / rounds / n;
+	}
+	return total * 1e9 / rounds / n;
+}
+
+/*------------------------------------------------------------------------
+ * bq_sorted - check that a sort left a permutation of orig in order
+ *------------------------------------------------------------------------
+ */
+static	int	bq_sorted(
+		  int		sort,	/* Sort that ran		*/
+		  int		n	/* Number of values		*/
+		)
+{
+	static	unsigned int	want[BQ_MAXN];	/* orig, sorted		*/
+	int	i;			/* Index into the arrays	*/
+
+	memcpy(want, orig, n * sizeof(want[0]));
+	qsort(want, n, sizeof(want[0]), bq_hostcmp);
+	for (i = 0; i < n; i++) {
+		if (sort == BQ_REC) {
+			if ( (recs[i].key != want[i]) ||
+			     (orig[recs[i].data] != recs[i].key) ) {
+				return 0;
+			}
+		} else if (work[i] != want[i]) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*------------------------------------------------------------------------
+ * bq_cmp - compare two values for the library's qsort, counting calls
+ *------------------------------------------------------------------------
+ */
+static	int	bq_cmp(
+		  char		*a,	/* First value			*/
+		  char		*b	/* Second value			*/
+		)
+{
+	unsigned int	x = *(unsigned int *)a;
+	unsigned int	y = *(unsigned int *)b;
+
+	ncmps++;
+	return (x > y) - (x < y);
+}
+
+/*------------------------------------------------------------------------
+ * bq_hostcmp - compare two values for the host's qsort
+ *------------------------------------------------------------------------
+ */
+static	int	bq_hostcmp(
+		  const void	*a,	/* First value			*/
+		  const void	*b	/* Second value			*/
+		)
+{
+	unsigned int	x = *(const unsigned int *)a;
+	unsigned int	y = *(const unsigned int *)b;
+
+	return (x > y) - (x < y);
+}
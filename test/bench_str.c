@@ -0,0 +1,137 @@
+/* bench_str.c - main, bs_run */
+
+#include <string.h>
+#include "hosttest.h"
+#include "xinulib.h"
+
+#define	BS_MAXLEN	4096		/* Longest string timed		*/
+#define	BS_BYTES	(64*1024*1024)	/* Bytes scanned per measurement*/
+#define	BS_MAXROUNDS	(4*1024*1024)	/* Calls per measurement at most*/
+
+/* Functions */
+
+#define	BS_STRLEN	0
+#define	BS_STRCHR	1
+#define	BS_STRCMP	2
+#define	BS_STRNCMP	3
+#define	BS_STRNCPY	4
+#define	BS_MEMCHR	5
+#define	BS_NFUNCS	6
+
+/* Each function has the word-at-a-time version in lib/ first and the	*/
+/*   byte-at-a-time version it replaced second				*/
+
+static	const char	*names[] = { "strlen", "strchr", "strcmp",
+					"strncmp", "strncpy", "memchr" };
+static	int	(*bs_strlen[])(char *) = { xinu_strlen, ref_strlen };
+static	char	*(*bs_strchr[])(const char *, int) =
+					{ xinu_strchr, ref_strchr };
+static	int	(*bs_strcmp[])(char *, char *) = { xinu_strcmp, ref_strcmp };
+static	int	(*bs_strncmp[])(char *, char *, int) =
+					{ xinu_strncmp, ref_strncmp };
+static	char	*(*bs_strncpy[])(char *, const char *, int) =
+					{ xinu_strncpy, ref_strncpy };
+static	void	*(*bs_memchr[])(const void *, int, int) =
+					{ xinu_memchr, ref_memchr };
+
+/* Strings start on a 64-byte boundary; the misaligned rows use ones	*/
+/*   that start a byte past it					*/
+
+static	char	sa[BS_MAXLEN + 64] __attribute__((aligned(64)));
+static	char	sb[BS_MAXLEN + 64] __attribute__((aligned(64)));
+static	char	sd[BS_MAXLEN + 64] __attribute__((aligned(64)));
+
+static	volatile unsigned long sink;	/* Keeps results from being	*/
+					/*   optimized away		*/
+
+static	double	bs_run(int, int, int, int);
+
+/*------------------------------------------------------------------------
+ * main - time the word-at-a-time string routines in lib/ against the
+ *	    byte-at-a-time versions they replaced, on strings of 1 byte
+ *	    to 4 KB, aligned and not
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	int	fn;			/* Function			*/
+	int	n;			/* Length of the strings	*/
+	int	off;			/* Offset of the strings	*/
+	double	word, byte;		/* Times of the two versions	*/
+
+	printf("ns per call; the strings match to their end, and strchr\n");
+	printf("and memchr look for a byte they do not have\n");
+	printf("%-8s %6s %4s %9s %9s %7s\n", "function", "bytes", "off",
+		"word", "byte", "speedup");
+	for (fn = 0; fn < BS_NFUNCS; fn++) {
+		for (n = 1; n <= BS_MAXLEN; n *= 4) {
+			for (off = 0; off <= 1; off++) {
+				word = bs_run(fn, 0, n, off);
+				byte = bs_run(fn, 1, n, off);
+				printf("%-8s %6d %4d %9.1f %9.1f %6.2fx\n",
+					names[fn], n, off, word, byte,
+					byte / word);
+			}
+		}
+	}
+	return 0;
+}
+
+/*------------------------------------------------------------------------
+ * bs_run - return the time of one call of a version of a function on
+ *	      strings of n bytes
+ *------------------------------------------------------------------------
+ */
+static	double	bs_run(
+		  int		fn,	/* Function to time		*/
+		  int		ref,	/* 0 for lib/, 1 for byte-wise	*/
+		  int		n,	/* Length of the strings	*/
+		  int		off	/* Offset of the strings	*/
+		)
+{
+	char	*a, *b, *d;		/* Strings and destination	*/
+	int	rounds, r;		/* Calls to make		*/
+	double	start;			/* Time the calls started	*/
+
+	a = sa + off;
+	b = sb + off;
+	d = sd + off;
+	memset(a, 'x', n);
+	memset(b, 'x', n);
+	a[n] = b[n] = '\0';
+
+	rounds = (BS_BYTES / n < BS_MAXROUNDS) ? BS_BYTES / n : BS_MAXROUNDS;
+	start = test_now();
+	switch (fn) {
+	case BS_STRLEN:
+		for (r = 0; r < rounds; r++) {
+			sink += bs_strlen[ref](a);
+		}
+		break;
+	case BS_STRCHR:
+		for (r = 0; r < rounds; r++) {
+			sink += (unsigned long)bs_strchr[ref](a, 'y');
+		}
+		break;
+	case BS_STRCMP:
+		for (r = 0; r < rounds; r++) {
+			sink += bs_strcmp[ref](a, b);
+		}
+		break;
+	case BS_STRNCMP:
+		for (r = 0; r < rounds; r++) {
+			sink += bs_strncmp[ref](a, b, n + 1);
+		}
+		break;
+	case BS_STRNCPY:
+		for (r = 0; r < rounds; r++) {
+			sink += (unsigned long)bs_strncpy[ref](d, a, n + 1);
+		}
+		break;
+	default:
+		for (r = 0; r < rounds; r++) {
+			sink += (unsigned long)bs_memchr[ref](a, 'y', n);
+		}
+	}
+	return (test_now() - start) * 1e9 / rounds;
+}
@@ -0,0 +1,62 @@
+/* hosttest.h - check, test_rand, test_now, test_done */
+
+/* Helpers shared by the host tests and benchmarks; each program is	*/
+/*   one source file, so the state here is local to it		*/
+
+#include <stdio.h>
+#include <time.h>
+
+static	int	nchecks;		/* Number of checks made	*/
+static	int	nfailed;		/* Number of checks that failed	*/
+static	unsigned int test_seed = 2463534242U; /* State of test_rand	*/
+
+/*------------------------------------------------------------------------
+ * check - count a check and report it if its condition does not hold
+ *------------------------------------------------------------------------
+ */
+#define	check(cond)							\
+	do {								\
+		nchecks++;						\
+		if (!(cond)) {						\
+			nfailed++;					\
+			printf("%s:%d: check failed: %s\n",		\
+				__FILE__, __LINE__, #cond);		\
+		}							\
+	} while (0)
+
+/*------------------------------------------------------------------------
+ * test_rand - return the next number of a repeatable xorshift sequence
+ *------------------------------------------------------------------------
+ */
+static	inline	unsigned int test_rand(void)
+{
+	test_seed ^= test_seed << 13;
+	test_seed ^= test_seed >> 17;
+	test_seed ^= test_seed << 5;
+	return test_seed;
+}
+
+/*------------------------------------------------------------------------
+ * test_now - return a monotonic time in seconds
+ *------------------------------------------------------------------------
+ */
+static	inline	double	test_now(void)
+{
+	struct	timespec ts;		/* Current time			*/
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*------------------------------------------------------------------------
+ * test_done - report the checks of a test program and return its
+ *		 exit status
+ *------------------------------------------------------------------------
+ */
+static	inline	int	test_done(
+			  const char	*name	/* Name of the program	*/
+			)
+{
+	printf("%s: %d checks, %d failed\n", name, nchecks, nfailed);
+	return (nfailed == 0) ? 0 : 1;
+}
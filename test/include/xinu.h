@@ -0,0 +1,17 @@
+/* xinu.h - host stand-in for include/xinu.h */
+
+/* The tests under test/ compile library sources from lib/ with the	*/
+/*   host's compiler.  Those sources include <xinu.h>, which finds	*/
+/*   this file: it supplies the kernel types and the headers of the	*/
+/*   library code only, and leaves the host's own headers (stdio.h,	*/
+/*   string.h) in place of the kernel's.				*/
+
+#include <string.h>
+
+#undef	NULL				/* kernel.h defines NULL and EOF*/
+#undef	EOF
+
+#include "../../include/kernel.h"
+#include "../../include/hashmap.h"
+#include "../../include/rbtree.h"
+#include "../../include/ringbuf.h"
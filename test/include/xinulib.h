@@ -0,0 +1,29 @@
+/* xinulib.h - library functions that the host's C library also has */
+
+/* The Makefile compiles each of these from lib/ with its name given	*/
+/*   the prefix xinu_, so a test can call both versions		*/
+
+extern	void	*xinu_memcpy(void *, const void *, int);
+extern	void	*xinu_memset(void *, int, int);
+extern	int	xinu_memcmp(const void *, const void *, int);
+extern	int	xinu_strlen(char *);
+extern	char	*xinu_strchr(const char *, int);
+extern	int	xinu_strcmp(char *, char *);
+extern	int	xinu_strncmp(char *, char *, int);
+extern	char	*xinu_strncpy(char *, const char *, int);
+extern	void	*xinu_memchr(const void *, int, int);
+extern	void	xinu_qsort(char *, unsigned, int, int (*)(char *, char *));
+
+/* qsort.c also has these, whose names the host's library lacks */
+
+extern	void	qsort_rec(char *, unsigned, int, int);
+extern	void	qsort_u32(unsigned int *, unsigned);
+
+/* ref_str.c has the byte-at-a-time versions of the string routines	*/
+
+extern	int	ref_strlen(char *);
+extern	char	*ref_strchr(const char *, int);
+extern	int	ref_strcmp(char *, char *);
+extern	int	ref_strncmp(char *, char *, int);
+extern	char	*ref_strncpy(char *, const char *, int);
+extern	void	*ref_memchr(const void *, int, int);
@@ -0,0 +1,88 @@
+/* ref_str.c - ref_strlen, ref_strchr, ref_strcmp, ref_strncmp,
+		ref_strncpy, ref_memchr */
+
+#include "xinulib.h"
+
+/* These are the routines as lib/ had them before they worked a word	*/
+/*   at a time; memchr was an empty stub, so its version is new.	*/
+/*   They are compiled as the library is, so the compiler does not	*/
+/*   turn their loops into calls of the host's functions		*/
+
+int	ref_strlen(char *str)
+{
+	int	len;
+
+	len = 0;
+	while (*str++ != '\0') {
+		len++;
+	}
+	return len;
+}
+
+char	*ref_strchr(const char *s, int c)
+{
+	for (; *s != '\0'; s++) {
+		if (*s == (const char)c) {
+			return (char *)s;
+		}
+	}
+	if ((const char)c == *s) {
+		return (char *)s;
+	}
+	return 0;
+}
+
+int	ref_strcmp(char *str1, char *str2)
+{
+	while (*str1 == *str2) {
+		if (*str1 == '\0') {
+			return 0;
+		}
+		str1++;
+		str2++;
+	}
+	if (*str1 < *str2) {
+		return -1;
+	} else {
+		return 1;
+	}
+}
+
+int	ref_strncmp(char *s1, char *s2, int n)
+{
+	while (--n >= 0 && *s1 == *s2++) {
+		if (*s1++ == '\0') {
+			return 0;
+		}
+	}
+	return (n < 0 ? 0 : *s1 - *--s2);
+}
+
+char	*ref_strncpy(char *s1, const char *s2, int n)
+{
+	int	i;
+	char	*os1;
+
+	os1 = s1;
+	for (i = 0; i < n; i++) {
+		if (((*s1++) = (*s2++)) == '\0') {
+			while (++i < n) {
+				*s1++ = '\0';
+			}
+			return os1;
+		}
+	}
+	return os1;
+}
+
+void	*ref_memchr(const void *s, int c, int n)
+{
+	const unsigned char *p = s;
+
+	for (; n > 0; n--, p++) {
+		if (*p == (unsigned char)c) {
+			return (void *)p;
+		}
+	}
+	return 0;
+}
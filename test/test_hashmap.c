@@ -0,0 +1,222 @@
+/* test_hashmap.c - main, hmt_init, hmt_full, hmt_churn, hmt_str, hmt_count */
+
+#include "hosttest.h"
+#include <xinu.h>
+
+#define	HMT_SLOTS	1024		/* Slots of the larger maps	*/
+#define	HMT_KEYS	512		/* Key range of the churn test	*/
+
+struct	hmtitem	{			/* Entry stored in a test map	*/
+	struct	hmnode	node;		/* Node of the map		*/
+	int32	stored;			/* Nonzero while in the map	*/
+	char	name[16];		/* String key			*/
+};
+
+static	struct	hmnode	*slots[HMT_SLOTS];
+static	struct	hmtitem	items[HMT_SLOTS];
+
+static	void	hmt_init(void);
+static	void	hmt_full(void);
+static	void	hmt_churn(uint32);
+static	void	hmt_str(void);
+static	uint32	hmt_count(struct hashmap *);
+
+/*------------------------------------------------------------------------
+ * main - check the hash map in lib/hashmap.c
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	hmt_init();
+	hmt_full();
+	hmt_churn(16);			/* Small map: long clusters and	*/
+	hmt_churn(64);			/*   wrap-around at the end	*/
+	hmt_churn(HMT_SLOTS);
+	hmt_str();
+	return test_done("test_hashmap");
+}
+
+/*------------------------------------------------------------------------
+ * hmt_init - check that hm_init accepts only valid arguments
+ *------------------------------------------------------------------------
+ */
+static	void	hmt_init(void)
+{
+	struct	hashmap	hm;		/* Map under test		*/
+
+	check(hm_init(&hm, slots, 0, HM_INT) == SYSERR);
+	check(hm_init(&hm, slots, 1, HM_INT) == SYSERR);
+	check(hm_init(&hm, slots, 24, HM_INT) == SYSERR);
+	check(hm_init(&hm, slots, 16, 2) == SYSERR);
+	check(hm_init(&hm, slots, 16, HM_STR) == OK);
+	check(hm_init(&hm, slots, HMT_SLOTS, HM_INT) == OK);
+	check(hm_count(&hm) == 0);
+	check(hm_maxcount(&hm) == HMT_SLOTS * 3 / 4);
+}
+
+/*------------------------------------------------------------------------
+ * hmt_full - fill a map to its limit, then empty it in a random order
+ *------------------------------------------------------------------------
+ */
+static	void	hmt_full(void)
+{
+	struct	hashmap	hm;		/* Map under test		*/
+	struct	hmtitem	extra;		/* Entry past the limit		*/
+	uint32	max;			/* Most entries the map holds	*/
+	uint32	order[HMT_SLOTS];	/* Order of removal		*/
+	uint32	i, j, t;		/* Indexes			*/
+
+	hm_init(&hm, slots, HMT_SLOTS, HM_INT);
+	max = hm_maxcount(&hm);
+	for (i = 0; i < max; i++) {
+		items[i].node.hnikey = i * 7919;
+		check(hm_insert(&hm, &items[i].node) == OK);
+	}
+	check(hm_count(&hm) == max);
+	extra.node.hnikey = 0xffffffff;
+	check(hm_insert(&hm, &extra.node) == SYSERR);
+	for (i = 0; i < max; i++) {
+		check(hm_findint(&hm, i * 7919) == &items[i].node);
+	}
+	check(hm_findint(&hm, 1) == NULL);
+	check(hmt_count(&hm) == max);
+
+	/* A key already present is refused */
+
+	hm_remove(&hm, &items[0].node);
+	extra.node.hnikey = 7919;
+	check(hm_insert(&hm, &extra.node) == SYSERR);
+	check(hm_insert(&hm, &items[0].node) == OK);
+
+	/* Remove in a random order, checking the rest each time */
+
+	for (i = 0; i < max; i++) {
+		order[i] = i;
+	}
+	for (i = max - 1; i > 0; i--) {
+		j = test_rand() % (i + 1);
+		t = order[i]; order[i] = order[j]; order[j] = t;
+	}
+	for (i = 0; i < max; i++) {
+		check(hm_remove(&hm, &items[order[i]].node) == OK);
+		check(hm_remove(&hm, &items[order[i]].node) == SYSERR);
+		check(hm_findint(&hm, order[i] * 7919) == NULL);
+		if ((i % 64) == 0) {
+			for (j = i + 1; j < max; j++) {
+				check(hm_findint(&hm, order[j] * 7919) ==
+						&items[order[j]].node);
+			}
+		}
+	}
+	check(hm_count(&hm) == 0);
+	check(hmt_count(&hm) == 0);
+}
+
+/*------------------------------------------------------------------------
+ * hmt_churn - insert and remove random keys and compare the map with
+ *		 a flag per key after every step
+ *------------------------------------------------------------------------
+ */
+static	void	hmt_churn(
+		  uint32	nslots	/* Slots of the map		*/
+		)
+{
+	struct	hashmap	hm;		/* Map under test		*/
+	struct	hmnode	*found;		/* Result of a lookup		*/
+	uint32	step;			/* Step of the test		*/
+	uint32	key;			/* Key changed in this step	*/
+	uint32	nstored;		/* Entries in the map		*/
+	int32	bad;			/* Mismatches in this step	*/
+
+	hm_init(&hm, slots, nslots, HM_INT);
+	for (key = 0; key < HMT_KEYS; key++) {
+		items[key].node.hnikey = key;
+		items[key].stored = 0;
+	}
+	nstored = 0;
+	for (step = 0; step < 20000; step++) {
+		key = test_rand() % HMT_KEYS;
+		if (items[key].stored) {
+			check(hm_remove(&hm, &items[key].node) == OK);
+			items[key].stored = 0;
+			nstored--;
+		} else if (nstored < hm_maxcount(&hm)) {
+			check(hm_insert(&hm, &items[key].node) == OK);
+			items[key].stored = 1;
+			nstored++;
+		} else {
+			check(hm_insert(&hm, &items[key].node) == SYSERR);
+		}
+
+		/* Every key must be found exactly when it is stored */
+
+		bad = 0;
+		for (key = 0; key < HMT_KEYS; key++) {
+			found = hm_findint(&hm, key);
+			if (found != (items[key].stored ?
+					&items[key].node : NULL)) {
+				bad++;
+			}
+		}
+		check(bad == 0);
+		check(hm_count(&hm) == nstored);
+	}
+	check(hmt_count(&hm) == nstored);
+}
+
+/*------------------------------------------------------------------------
+ * hmt_str - check a map with string keys
+ *------------------------------------------------------------------------
+ */
+static	void	hmt_str(void)
+{
+	struct	hashmap	hm;		/* Map under test		*/
+	struct	hmtitem	dup;		/* Entry with a repeated key	*/
+	char	name[16];		/* Key to look up		*/
+	uint32	n;			/* Number of entries		*/
+	uint32	i;			/* Index of an entry		*/
+
+	hm_init(&hm, slots, 256, HM_STR);
+	n = hm_maxcount(&hm);
+	for (i = 0; i < n; i++) {
+		snprintf(items[i].name, sizeof(items[i].name), "host%u", i);
+		items[i].node.hnskey = items[i].name;
+		check(hm_insert(&hm, &items[i].node) == OK);
+	}
+	strcpy(dup.name, "host7");
+	dup.node.hnskey = dup.name;
+	check(hm_insert(&hm, &dup.node) == SYSERR);
+
+	/* Look up through a different copy of each key */
+
+	for (i = 0; i < n; i++) {
+		snprintf(name, sizeof(name), "host%u", i);
+		check(hm_findstr(&hm, name) == &items[i].node);
+	}
+	check(hm_findstr(&hm, "host") == NULL);
+	check(hm_findstr(&hm, "") == NULL);
+	for (i = 0; i < n; i += 2) {
+		check(hm_remove(&hm, &items[i].node) == OK);
+	}
+	for (i = 0; i < n; i++) {
+		check(hm_findstr(&hm, items[i].name) ==
+				((i & 1) ? &items[i].node : NULL));
+	}
+}
+
+/*------------------------------------------------------------------------
+ * hmt_count - count the entries hm_next visits
+ *------------------------------------------------------------------------
+ */
+static	uint32	hmt_count(
+		  struct hashmap *hm	/* Map to walk			*/
+		)
+{
+	uint32	index;			/* Position of the walk		*/
+	uint32	n;			/* Entries seen			*/
+
+	index = 0;
+	for (n = 0; hm_next(hm, &index) != NULL; n++)
+		;
+	return n;
+}
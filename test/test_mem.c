@@ -0,0 +1,263 @@
+/* test_mem.c - main, memt_sizes, memt_fill, memt_memcpy, memt_memset,
+		memt_memcmp, memt_differ, memt_sign */
+
+#include "hosttest.h"
+#include <xinu.h>
+#include "xinulib.h"
+
+#define	MEMT_MAXOFF	8		/* Offsets 0..7: every alignment*/
+					/*   of a word, both ways	*/
+#define	MEMT_ALLSIZE	512		/* Every size up to this is used*/
+#define	MEMT_MAXSIZE	65536		/* Largest size used		*/
+#define	MEMT_GUARD	16		/* Bytes checked past each end	*/
+#define	MEMT_BUFSIZ	(MEMT_MAXSIZE + MEMT_MAXOFF + 2 * MEMT_GUARD)
+
+/* Buffers start on a 64-byte boundary, so an offset is an alignment */
+
+static	unsigned char	src[MEMT_BUFSIZ] __attribute__((aligned(64)));
+static	unsigned char	dst[MEMT_BUFSIZ] __attribute__((aligned(64)));
+static	unsigned char	ref[MEMT_BUFSIZ] __attribute__((aligned(64)));
+
+static	int32	sizes[MEMT_ALLSIZE + 64];	/* Sizes to check	*/
+static	int32	nsizes;				/* Entries in sizes	*/
+
+static	void	memt_sizes(void);
+static	void	memt_fill(unsigned char *, int32, uint32);
+static	void	memt_memcpy(void);
+static	void	memt_memset(void);
+static	void	memt_memcmp(void);
+static	int32	memt_differ(unsigned char *, unsigned char *, int32, int32);
+static	int32	memt_sign(int32);
+
+/*------------------------------------------------------------------------
+ * main - check memcpy, memset and memcmp in lib/ for every pairing of
+ *	    size and alignment
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	memt_sizes();
+	memt_memcpy();
+	memt_memset();
+	memt_memcmp();
+	return test_done("test_mem");
+}
+
+/*------------------------------------------------------------------------
+ * memt_sizes - list every size up to MEMT_ALLSIZE and the sizes next
+ *		  to each larger power of two
+ *------------------------------------------------------------------------
+ */
+static	void	memt_sizes(void)
+{
+	int32	n;			/* Size				*/
+
+	nsizes = 0;
+	for (n = 0; n <= MEMT_ALLSIZE; n++) {
+		sizes[nsizes++] = n;
+	}
+	for (n = 2 * MEMT_ALLSIZE; n <= MEMT_MAXSIZE; n *= 2) {
+		sizes[nsizes++] = n - 1;
+		sizes[nsizes++] = n;
+		if (n < MEMT_MAXSIZE) {
+			sizes[nsizes++] = n + 1;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------
+ * memt_fill - fill a buffer with bytes that differ from their
+ *		 neighbours and from one seed to the next
+ *------------------------------------------------------------------------
+ */
+static	void	memt_fill(
+		  unsigned char	*buf,	/* Buffer to fill		*/
+		  int32		len,	/* Its length			*/
+		  uint32	seed	/* Varies the contents		*/
+		)
+{
+	int32	i;			/* Index into buf		*/
+
+	for (i = 0; i < len; i++) {
+		buf[i] = (unsigned char)(i * 7 + seed * 13 + (i >> 8));
+	}
+}
+
+/*------------------------------------------------------------------------
+ * memt_memcpy - copy between every pair of alignments and check the
+ *		   copy and the bytes around it
+ *------------------------------------------------------------------------
+ */
+static	void	memt_memcpy(void)
+{
+	int32	s, so, doff;		/* Size and the two offsets	*/
+	int32	n;			/* Size of this copy		*/
+	int32	total;			/* Bytes checked in dst		*/
+	unsigned char *from, *to;	/* Ends of the copy		*/
+	int32	bad;			/* Wrong bytes seen		*/
+
+	memt_fill(src, MEMT_BUFSIZ, 1);
+	bad = 0;
+	for (s = 0; s < nsizes; s++) {
+		n = sizes[s];
+		total = n + MEMT_MAXOFF + 2 * MEMT_GUARD;
+		for (so = 0; so < MEMT_MAXOFF; so++) {
+			for (doff = 0; doff < MEMT_MAXOFF; doff++) {
+				from = src + MEMT_GUARD + so;
+				to = dst + MEMT_GUARD + doff;
+				memt_fill(dst, total, n + so);
+				memcpy(ref, dst, total);
+				memcpy(ref + MEMT_GUARD + doff, from, n);
+				if ( (xinu_memcpy(to, from, n) != to) ||
+				     (memcmp(dst, ref, total) != 0) ) {
+					if (bad++ == 0) {
+						printf("memcpy fails: size %d, "
+							"offsets %d, %d\n",
+							n, so, doff);
+					}
+				}
+			}
+		}
+	}
+	check(bad == 0);
+}
+
+/*------------------------------------------------------------------------
+ * memt_memset - fill at every alignment and check the fill and the
+ *		   bytes around it
+ *------------------------------------------------------------------------
+ */
+static	void	memt_memset(void)
+{
+	static	int32	values[] = { 0x00, 0x5a, 0x80, 0xff, 0x1a5, -1 };
+	int32	s, off, v;		/* Size, offset and value	*/
+	int32	n;			/* Size of this fill		*/
+	int32	total;			/* Bytes checked in dst		*/
+	unsigned char *to;		/* Start of the fill		*/
+	int32	bad;			/* Wrong bytes seen		*/
+
+	bad = 0;
+	for (s = 0; s < nsizes; s++) {
+		n = sizes[s];
+		total = n + MEMT_MAXOFF + 2 * MEMT_GUARD;
+		for (off = 0; off < MEMT_MAXOFF; off++) {
+			for (v = 0; v < sizeof(values) / sizeof(values[0]);
+								v++) {
+				to = dst + MEMT_GUARD + off;
+				memt_fill(dst, total, n + off + v);
+				memcpy(ref, dst, total);
+				memset(ref + MEMT_GUARD + off, values[v], n);
+				if ( (xinu_memset(to, values[v], n) != to) ||
+				     (memcmp(dst, ref, total) != 0) ) {
+					if (bad++ == 0) {
+						printf("memset fails: size %d, "
+							"offset %d, value %d\n",
+							n, off, values[v]);
+					}
+				}
+			}
+		}
+	}
+	check(bad == 0);
+}
+
+/*------------------------------------------------------------------------
+ * memt_memcmp - compare blocks at every pair of alignments that are
+ *		   equal, or differ at one position in either direction
+ *------------------------------------------------------------------------
+ */
+static	void	memt_memcmp(void)
+{
+	int32	s, o1, o2;		/* Size and the two offsets	*/
+	int32	n;			/* Size of this comparison	*/
+	int32	pos;			/* Position of the difference	*/
+	int32	step;			/* Distance between positions	*/
+	unsigned char *a, *b;		/* Blocks compared		*/
+	int32	bad;			/* Wrong results seen		*/
+	int32	reported;		/* A failure has been printed	*/
+
+	bad = reported = 0;
+	for (s = 0; s < nsizes; s++) {
+		n = sizes[s];
+
+		/* Try a difference at every position of a short block	*/
+		/*   and at a few spread over a long one		*/
+
+		step = (n <= 64) ? 1 : n / 7;
+		for (o1 = 0; o1 < MEMT_MAXOFF; o1++) {
+			for (o2 = 0; o2 < MEMT_MAXOFF; o2++) {
+				a = src + MEMT_GUARD + o1;
+				b = dst + MEMT_GUARD + o2;
+				memt_fill(a, n, 3);
+				memt_fill(b, n, 3);
+				if (xinu_memcmp(a, b, n) != 0) {
+					bad++;
+				}
+				for (pos = 0; pos < n; pos += step) {
+					bad += memt_differ(a, b, n, pos);
+				}
+				if (n > 0) {
+					bad += memt_differ(a, b, n, n - 1);
+				}
+				if ( (bad > 0) && !reported ) {
+					printf("memcmp fails: size %d, "
+						"offsets %d, %d\n", n, o1, o2);
+					reported = 1;
+				}
+			}
+		}
+	}
+	check(bad == 0);
+}
+
+/*------------------------------------------------------------------------
+ * memt_differ - make two equal blocks differ at one position and return
+ *		   the number of wrong results memcmp gives for them
+ *------------------------------------------------------------------------
+ */
+static	int32	memt_differ(
+		  unsigned char	*a,	/* First block			*/
+		  unsigned char	*b,	/* Second block, equal to a	*/
+		  int32		n,	/* Size of the blocks		*/
+		  int32		pos	/* Position of the difference	*/
+		)
+{
+	unsigned char save, next;	/* Bytes changed in both blocks	*/
+	int32	bad;			/* Wrong results		*/
+
+	/* A byte 0x80 and up must compare as larger (the bytes are	*/
+	/*   unsigned), and a later difference in the other direction	*/
+	/*   must not count						*/
+
+	save = a[pos];
+	a[pos] = 0x80;
+	b[pos] = 0x7f;
+	if (pos + 1 < n) {
+		next = a[pos + 1];
+		a[pos + 1] = 0x00;
+		b[pos + 1] = 0xff;
+	}
+	bad = 0;
+	if (memt_sign(xinu_memcmp(a, b, n)) != 1) {
+		bad++;
+	}
+	if (memt_sign(xinu_memcmp(b, a, n)) != -1) {
+		bad++;
+	}
+	a[pos] = b[pos] = save;
+	if (pos + 1 < n) {
+		a[pos + 1] = b[pos + 1] = next;
+	}
+	return bad;
+}
+
+/*------------------------------------------------------------------------
+ * memt_sign - return -1, 0 or 1 for a negative, zero or positive value
+ *------------------------------------------------------------------------
+ */
+static	int32	memt_sign(
+		  int32		v	/* Value			*/
+		)
+{
+	return (v > 0) - (v < 0);
+}
@@ -0,0 +1,223 @@
+/* test_rbtree.c - main, rbt_order, rbt_random, rbt_valid, rbt_height */
+
+#include "hosttest.h"
+#include <xinu.h>
+
+#define	RBT_NODES	2000		/* Nodes of the random test	*/
+#define	RBT_KEYS	500		/* Key range (so keys repeat)	*/
+
+struct	rbtitem	{			/* Entry stored in a test tree	*/
+	struct	rbnode	node;		/* Node of the tree		*/
+	int32	stored;			/* Nonzero while in the tree	*/
+	uint32	seq;			/* Order of insertion		*/
+};
+
+static	struct	rbtitem	items[RBT_NODES];
+
+static	void	rbt_order(void);
+static	void	rbt_random(void);
+static	int32	rbt_valid(struct rbtree *, uint32);
+static	int32	rbt_height(struct rbnode *, int32 *);
+
+/*------------------------------------------------------------------------
+ * main - check the red-black tree in lib/rbtree.c
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	rbt_order();
+	rbt_random();
+	return test_done("test_rbtree");
+}
+
+/*------------------------------------------------------------------------
+ * rbt_order - insert ascending and descending keys (the cases that
+ *		 unbalance a plain search tree) and walk the result
+ *------------------------------------------------------------------------
+ */
+static	void	rbt_order(void)
+{
+	struct	rbtree	rt;		/* Tree under test		*/
+	struct	rbnode	*node;		/* Node of a walk		*/
+	uint32	i;			/* Index of a node		*/
+
+	rb_init(&rt);
+	check(rb_isempty(&rt));
+	check(rb_first(&rt) == NULL);
+	check(rb_last(&rt) == NULL);
+	check(rb_ceil(&rt, 0) == NULL);
+
+	for (i = 0; i < RBT_NODES; i++) {
+		items[i].node.rbkey = i;
+		rb_insert(&rt, &items[i].node);
+	}
+	check(rbt_valid(&rt, RBT_NODES));
+	for (i = 0, node = rb_first(&rt); node != NULL;
+					i++, node = rb_next(node)) {
+		check(node == &items[i].node);
+	}
+	check(i == RBT_NODES);
+	for (i = 0; i < RBT_NODES; i++) {
+		rb_remove(&rt, &items[i].node);
+	}
+	check(rb_isempty(&rt) && rt.rbcount == 0);
+
+	for (i = 0; i < RBT_NODES; i++) {
+		items[i].node.rbkey = RBT_NODES - i;
+		rb_insert(&rt, &items[i].node);
+	}
+	check(rbt_valid(&rt, RBT_NODES));
+	for (i = 0, node = rb_last(&rt); node != NULL;
+					i++, node = rb_prev(node)) {
+		check(node == &items[i].node);
+	}
+	check(i == RBT_NODES);
+	check(rb_ceil(&rt, RBT_NODES + 1) == NULL);
+	check(rb_ceil(&rt, 0) == &items[RBT_NODES - 1].node);
+}
+
+/*------------------------------------------------------------------------
+ * rbt_random - insert and remove random, repeating keys, checking the
+ *		  tree against the entries after every step
+ *------------------------------------------------------------------------
+ */
+static	void	rbt_random(void)
+{
+	struct	rbtree	rt;		/* Tree under test		*/
+	struct	rbnode	*node;		/* Result of a lookup		*/
+	struct	rbnode	*want;		/* Expected result		*/
+	struct	rbtitem	*item;		/* Entry changed in this step	*/
+	uint32	nstored;		/* Entries in the tree		*/
+	uint32	seq;			/* Next insertion number	*/
+	uint32	step;			/* Step of the test		*/
+	uint32	key;			/* Key looked up		*/
+	uint32	i;			/* Index of an entry		*/
+
+	rb_init(&rt);
+	nstored = seq = 0;
+	for (i = 0; i < RBT_NODES; i++) {
+		items[i].stored = 0;
+	}
+	for (step = 0; step < 20000; step++) {
+		item = &items[test_rand() % RBT_NODES];
+		if (item->stored) {
+			rb_remove(&rt, &item->node);
+			item->stored = 0;
+			nstored--;
+		} else {
+			item->node.rbkey = test_rand() % RBT_KEYS;
+			item->seq = seq++;
+			rb_insert(&rt, &item->node);
+			item->stored = 1;
+			nstored++;
+		}
+		if ((step % 16) != 0) {
+			continue;
+		}
+		check(rbt_valid(&rt, nstored));
+
+		/* rb_ceil and rb_find return the earliest entry with	*/
+		/*   the smallest key at least as large as the one given */
+
+		key = test_rand() % (RBT_KEYS + 1);
+		want = NULL;
+		for (i = 0; i < RBT_NODES; i++) {
+			if (!items[i].stored || items[i].node.rbkey < key) {
+				continue;
+			}
+			if ( (want == NULL) ||
+			     (items[i].node.rbkey < want->rbkey) ||
+			     ((items[i].node.rbkey == want->rbkey) &&
+			      (items[i].seq <
+			       ((struct rbtitem *)want)->seq)) ) {
+				want = &items[i].node;
+			}
+		}
+		node = rb_ceil(&rt, key);
+		check(node == want);
+		node = rb_find(&rt, key);
+		check(node == ((want != NULL && want->rbkey == key) ?
+							want : NULL));
+	}
+}
+
+/*------------------------------------------------------------------------
+ * rbt_valid - check the links, order and colors of a tree and that it
+ *		 holds the given number of nodes
+ *------------------------------------------------------------------------
+ */
+static	int32	rbt_valid(
+		  struct rbtree	*rt,	/* Tree to check		*/
+		  uint32	count	/* Nodes it should hold		*/
+		)
+{
+	struct	rbnode	*node;		/* Node of the walk		*/
+	struct	rbnode	*prev;		/* Node before it		*/
+	int32	ok;			/* No fault found so far	*/
+	uint32	n;			/* Nodes seen			*/
+
+	ok = 1;
+	if (rt->rbroot != NULL) {
+		if ( (rt->rbroot->rbparent != NULL) ||
+		     (rt->rbroot->rbcolor != RB_BLACK) ) {
+			ok = 0;
+		}
+		rbt_height(rt->rbroot, &ok);
+	}
+
+	/* Keys ascend, and equal keys keep the order of insertion */
+
+	n = 0;
+	prev = NULL;
+	for (node = rb_first(rt); node != NULL; node = rb_next(node)) {
+		if ( (prev != NULL) && ((prev->rbkey > node->rbkey) ||
+		     ((prev->rbkey == node->rbkey) &&
+		      (((struct rbtitem *)prev)->seq >
+		       ((struct rbtitem *)node)->seq))) ) {
+			ok = 0;
+		}
+		if ( (prev != NULL) && (rb_prev(node) != prev) ) {
+			ok = 0;
+		}
+		prev = node;
+		n++;
+	}
+	if ( (prev != rb_last(rt)) || (n != count) ||
+	     (rt->rbcount != count) ) {
+		ok = 0;
+	}
+	return ok;
+}
+
+/*------------------------------------------------------------------------
+ * rbt_height - return the black height of a subtree, clearing *ok if
+ *		  a child link, a red node or a black height is wrong
+ *------------------------------------------------------------------------
+ */
+static	int32	rbt_height(
+		  struct rbnode	*node,	/* Root of the subtree		*/
+		  int32		*ok	/* Cleared on a fault		*/
+		)
+{
+	int32	left, right;		/* Black heights of the children*/
+
+	if (node == NULL) {
+		return 1;
+	}
+	if ( ((node->rbleft != NULL) && (node->rbleft->rbparent != node)) ||
+	     ((node->rbright != NULL) && (node->rbright->rbparent != node)) ) {
+		*ok = 0;
+	}
+	if ( (node->rbcolor == RB_RED) &&
+	     (((node->rbleft != NULL) && (node->rbleft->rbcolor == RB_RED)) ||
+	      ((node->rbright != NULL) &&
+	       (node->rbright->rbcolor == RB_RED))) ) {
+		*ok = 0;
+	}
+	left = rbt_height(node->rbleft, ok);
+	right = rbt_height(node->rbright, ok);
+	if (left != right) {
+		*ok = 0;
+	}
+	return left + (node->rbcolor == RB_BLACK);
+}
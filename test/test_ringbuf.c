@@ -0,0 +1,145 @@
+/* test_ringbuf.c - main, rgt_basic, rgt_wrap, rgt_threads, rgt_producer */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "hosttest.h"
+#include <xinu.h>
+
+#define	RGT_SIZE	64		/* Elements of the test ring	*/
+#define	RGT_ITEMS	2000000		/* Items the two threads pass	*/
+
+static	void	*slots[RGT_SIZE];
+
+static	void	rgt_basic(void);
+static	void	rgt_wrap(void);
+static	void	rgt_threads(void);
+static	void	*rgt_producer(void *);
+
+/*------------------------------------------------------------------------
+ * main - check the ring buffer in lib/ringbuf.c
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	rgt_basic();
+	rgt_wrap();
+	rgt_threads();
+	return test_done("test_ringbuf");
+}
+
+/*------------------------------------------------------------------------
+ * rgt_basic - fill a ring, overfill it and drain it
+ *------------------------------------------------------------------------
+ */
+static	void	rgt_basic(void)
+{
+	struct	ringbuf	rg;		/* Ring under test		*/
+	uintptr_t i;			/* Item				*/
+
+	check(rg_init(&rg, slots, 0) == SYSERR);
+	check(rg_init(&rg, slots, 48) == SYSERR);
+	check(rg_init(&rg, slots, RGT_SIZE) == OK);
+	check(rg_isempty(&rg) && !rg_isfull(&rg));
+	check(rg_get(&rg) == NULL);
+	check(rg_peek(&rg) == NULL);
+
+	for (i = 1; i <= RGT_SIZE; i++) {
+		check(rg_put(&rg, (void *)i) == OK);
+		check(rg_count(&rg) == i);
+	}
+	check(rg_isfull(&rg));
+	check(rg_put(&rg, (void *)1) == SYSERR);
+	check(rg_count(&rg) == RGT_SIZE);
+	for (i = 1; i <= RGT_SIZE; i++) {
+		check(rg_peek(&rg) == (void *)i);
+		check(rg_get(&rg) == (void *)i);
+	}
+	check(rg_isempty(&rg));
+	check(rg_get(&rg) == NULL);
+}
+
+/*------------------------------------------------------------------------
+ * rgt_wrap - pass items while the indexes wrap past 2^32
+ *------------------------------------------------------------------------
+ */
+static	void	rgt_wrap(void)
+{
+	struct	ringbuf	rg;		/* Ring under test		*/
+	uintptr_t put, got;		/* Next items in and out	*/
+
+	rg_init(&rg, slots, RGT_SIZE);
+	rg.rghead = rg.rgtail = 0xffffffff - 100;
+	put = got = 1;
+	while (got < 1000) {
+		while (rg_put(&rg, (void *)put) == OK) {
+			put++;
+		}
+		check(rg_count(&rg) == RGT_SIZE);
+		check(rg_isfull(&rg));
+
+		/* Take out a varying number, so the fill level moves */
+
+		while (!rg_isempty(&rg) && (got % 37) != 0) {
+			check(rg_get(&rg) == (void *)got);
+			got++;
+		}
+		if (!rg_isempty(&rg)) {
+			check(rg_get(&rg) == (void *)got);
+			got++;
+		}
+	}
+	check(rg.rghead < 0x1000);	/* The indexes did wrap	*/
+}
+
+/*------------------------------------------------------------------------
+ * rgt_threads - have one thread put a sequence while this one takes
+ *		   it, and check that nothing is lost, repeated or
+ *		   reordered
+ *------------------------------------------------------------------------
+ */
+static	void	rgt_threads(void)
+{
+	static	struct	ringbuf	rg;	/* Ring shared by the threads	*/
+	pthread_t producer;		/* Thread that puts items	*/
+	uintptr_t want;			/* Next item expected		*/
+	uintptr_t item;			/* Item taken			*/
+	int32	bad;			/* Items out of sequence	*/
+
+	rg_init(&rg, slots, RGT_SIZE);
+	pthread_create(&producer, NULL, rgt_producer, &rg);
+	bad = 0;
+	for (want = 1; want <= RGT_ITEMS; ) {
+		item = (uintptr_t)rg_get(&rg);
+		if (item == 0) {
+			sched_yield();
+			continue;
+		}
+		if (item != want) {
+			bad++;
+		}
+		want++;
+	}
+	pthread_join(producer, NULL);
+	check(bad == 0);
+	check(rg_isempty(&rg));
+}
+
+/*------------------------------------------------------------------------
+ * rgt_producer - put the items 1..RGT_ITEMS, retrying when full
+ *------------------------------------------------------------------------
+ */
+static	void	*rgt_producer(
+		  void		*arg	/* Ring to put into		*/
+		)
+{
+	struct	ringbuf	*rg = arg;	/* Ring to put into		*/
+	uintptr_t i;			/* Item				*/
+
+	for (i = 1; i <= RGT_ITEMS; i++) {
+		while (rg_put(rg, (void *)i) != OK) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,225 @@
+/* test_str.c - main, strt_region, strt_random, strt_place, strt_report */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "hosttest.h"
+#include "xinulib.h"
+
+#define	STRT_ROUNDS	300000		/* Random cases			*/
+#define	STRT_MAXLEN	300		/* Longest string		*/
+
+/* This test needs no kernel types, so it leaves out <xinu.h>, whose	*/
+/*   kernel.h clashes with the host's unistd.h			*/
+
+/* The strings are placed in regions followed by an inaccessible	*/
+/*   page, often so that they end on its boundary: a word read	*/
+/*   that strays past the end of a string faults there		*/
+
+static	char	*rega, *regb;		/* Ends of the two regions	*/
+static	int	bad[6];			/* Failures per function	*/
+
+static	char	*strt_region(void);
+static	void	strt_random(char *, int);
+static	char	*strt_place(char *, const char *, int);
+static	void	strt_report(int, const char *, const char *,
+				const char *, int);
+
+/*------------------------------------------------------------------------
+ * main - check the word-at-a-time string routines in lib/ against
+ *	    the byte-at-a-time versions they replaced, on random strings
+ *	    at random alignments
+ *------------------------------------------------------------------------
+ */
+int	main(void)
+{
+	char	s1[STRT_MAXLEN + 1];	/* First string			*/
+	char	s2[STRT_MAXLEN + 1];	/* Second string		*/
+	char	want[2 * STRT_MAXLEN];	/* Expected strncpy result	*/
+	char	*p1, *p2;		/* Strings placed in regions	*/
+	char	*d;			/* Destination of strncpy	*/
+	int	len1, len2;		/* Lengths of the strings	*/
+	int	n;			/* Limit of strncmp and strncpy	*/
+	int	c;			/* Character searched for	*/
+	int	round;			/* Case number			*/
+	int	i;			/* Index into a buffer		*/
+
+	rega = strt_region();
+	regb = strt_region();
+	for (round = 0; round < STRT_ROUNDS; round++) {
+
+		/* Short strings are the common case, so favour them */
+
+		len1 = test_rand() % (test_rand() % STRT_MAXLEN + 1);
+		strt_random(s1, len1);
+		p1 = strt_place(rega, s1, len1 + 1);
+
+		if (xinu_strlen(p1) != ref_strlen(p1)) {
+			strt_report(0, "strlen", p1, NULL, 0);
+		}
+
+		switch (test_rand() % 3) {
+		case 0:	c = (len1 > 0) ? p1[test_rand() % len1] : 'a';
+			break;
+		case 1:	c = 0;
+			break;
+		default: c = test_rand() & 0xff;
+		}
+		if (xinu_strchr(p1, c) != ref_strchr(p1, c)) {
+			strt_report(1, "strchr", p1, NULL, c);
+		}
+
+		/* memchr searches bytes that may include zeros */
+
+		n = test_rand() % (STRT_MAXLEN + 1);
+		p2 = regb - n - (test_rand() & 1) * (test_rand() % 8);
+		for (i = 0; i < n; i++) {
+			p2[i] = ((test_rand() % 8) == 0) ? 0 : s1[i % (len1 + 1)];
+		}
+		if (xinu_memchr(p2, c, n) != ref_memchr(p2, c, n)) {
+			strt_report(5, "memchr", NULL, NULL, n);
+		}
+
+		/* A second string that matches the first, differs in	*/
+		/*   one byte, ends early or goes on longer		*/
+
+		memcpy(s2, s1, len1 + 1);
+		len2 = len1;
+		switch (test_rand() % 4) {
+		case 0:	break;
+		case 1:	if (len1 > 0) {
+				s2[test_rand() % len1] =
+						"ab\x01\x7f\x80\xff"[test_rand() % 6];
+			}
+			break;
+		case 2:	len2 = test_rand() % (len1 + 1);
+			s2[len2] = '\0';
+			break;
+		default: len2 = len1 + test_rand() % (STRT_MAXLEN - len1 + 1);
+			strt_random(s2 + len1, len2 - len1);
+		}
+		p2 = strt_place(regb, s2, len2 + 1);
+		if ( (xinu_strcmp(p1, p2) != ref_strcmp(p1, p2)) ||
+		     (xinu_strcmp(p2, p1) != ref_strcmp(p2, p1)) ) {
+			strt_report(2, "strcmp", p1, p2, 0);
+		}
+		n = test_rand() % (len1 + 10);
+		if ( (xinu_strncmp(p1, p2, n) != ref_strncmp(p1, p2, n)) ||
+		     (xinu_strncmp(p2, p1, n) != ref_strncmp(p2, p1, n)) ) {
+			strt_report(3, "strncmp", p1, p2, n);
+		}
+
+		/* strncpy into a filled buffer, ending at the guard	*/
+		/*   page or a few bytes before it			*/
+
+		n = test_rand() % (len1 + 16);
+		d = regb - n - (test_rand() & 1) * (test_rand() % 8);
+		memset(d, 0xee, regb - d);
+		memset(want, 0xee, regb - d);
+		ref_strncpy(want, p1, n);
+		if ( (xinu_strncpy(d, p1, n) != d) ||
+		     (memcmp(d, want, regb - d) != 0) ) {
+			strt_report(4, "strncpy", p1, NULL, n);
+		}
+	}
+	check(bad[0] == 0);
+	check(bad[1] == 0);
+	check(bad[2] == 0);
+	check(bad[3] == 0);
+	check(bad[4] == 0);
+	check(bad[5] == 0);
+	return test_done("test_str");
+}
+
+/*------------------------------------------------------------------------
+ * strt_region - map two pages followed by an inaccessible one and
+ *		   return the address of the inaccessible page
+ *------------------------------------------------------------------------
+ */
+static	char	*strt_region(void)
+{
+	long	pg;			/* Page size			*/
+	char	*base;			/* Start of the mapping		*/
+
+	pg = sysconf(_SC_PAGESIZE);
+	base = mmap(NULL, 3 * pg, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		perror("mmap");
+		_exit(1);
+	}
+	mprotect(base + 2 * pg, pg, PROT_NONE);
+	return base + 2 * pg;
+}
+
+/*------------------------------------------------------------------------
+ * strt_random - fill a string with nonzero bytes, mostly a few values
+ *		   (so that strings often match) including ones with the
+ *		   top bit set
+ *------------------------------------------------------------------------
+ */
+static	void	strt_random(
+		  char		*s,	/* String to fill		*/
+		  int		len	/* Its length			*/
+		)
+{
+	int	i;			/* Index into s			*/
+
+	for (i = 0; i < len; i++) {
+		if ((test_rand() % 4) == 0) {
+			s[i] = (char)(test_rand() % 255 + 1);
+		} else {
+			s[i] = "ab\x01\x7f\x80\xff"[test_rand() % 6];
+		}
+	}
+	s[len] = '\0';
+}
+
+/*------------------------------------------------------------------------
+ * strt_place - copy len bytes to a region, either ending on its guard
+ *		  page or at a random place before it, and return the copy
+ *------------------------------------------------------------------------
+ */
+static	char	*strt_place(
+		  char		*end,	/* Guard page of the region	*/
+		  const char	*s,	/* Bytes to copy		*/
+		  int		len	/* Number of bytes		*/
+		)
+{
+	char	*p;			/* Place of the copy		*/
+
+	if ((test_rand() & 1) == 0) {
+		p = end - len;
+	} else {
+		p = end - len - 1 - test_rand() % 64;
+	}
+	memcpy(p, s, len);
+	return p;
+}
+
+/*------------------------------------------------------------------------
+ * strt_report - count a failure and print the first of each function
+ *------------------------------------------------------------------------
+ */
+static	void	strt_report(
+		  int		fn,	/* Index of the function	*/
+		  const char	*name,	/* Its name			*/
+		  const char	*s1,	/* First string, or NULL	*/
+		  const char	*s2,	/* Second string, or NULL	*/
+		  int		arg	/* Other argument		*/
+		)
+{
+	if (bad[fn]++ != 0) {
+		return;
+	}
+	printf("%s fails: arg %d", name, arg);
+	if (s1 != NULL) {
+		printf(", s1 at offset %d (\"%.40s\")",
+			(int)((unsigned long)s1 & 3), s1);
+	}
+	if (s2 != NULL) {
+		printf(", s2 at offset %d (\"%.40s\")",
+			(int)((unsigned long)s2 & 3), s2);
+	}
+	printf("\n");
+}